@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "bench_util.h"
+
+/* Nesting depth of the nested workload. */
+#define NEST_DEPTH      48
+
+/* Length of the literals of the long string workload. */
+#define LONG_STR_LEN    2048
+
+static
+const char * const
+names[] = {
+    "alpha", "beta_value", "gamma_total", "delta", "counter", "idx",
+    "user_name", "request_count", "x", "tmp_buffer_size", "result",
+};
+
+u64
+Bench_Now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (u64)ts.tv_sec * 1000000000UL + (u64)ts.tv_nsec;
+}
+
+/**
+ * @brief Steps a xorshift generator, the state must not be zero.
+ */
+u64
+Bench_NextRand(
+    u64 * state
+) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+static
+bool
+PushName(
+    FlexBuf * out,
+    u64 * state
+) {
+    const char * name = names[Bench_NextRand(state) % (sizeof(names) /
+        sizeof(names[0]))];
+
+    return FlexBuf_PushStr(out, name) &&
+        FlexBuf_PushByte(out, '_') &&
+        FlexBuf_PushUInt(out, Bench_NextRand(state) % 1000);
+}
+
+/**
+ * @brief Appends an assignment of arithmetic on long names.
+ */
+bool
+Bench_GenIdents(
+    FlexBuf * out,
+    u64 * state
+) {
+    return PushName(out, state) &&
+        FlexBuf_PushStr(out, " = ") &&
+        PushName(out, state) &&
+        FlexBuf_PushStr(out, " + ") &&
+        PushName(out, state) &&
+        FlexBuf_PushStr(out, " * ") &&
+        PushName(out, state) &&
+        FlexBuf_PushStr(out, ";\n");
+}
+
+/**
+ * @brief Appends assignments of a number, a short string and a boolean,
+ *        with an occasional integer too large for a machine word.
+ */
+bool
+Bench_GenLiterals(
+    FlexBuf * out,
+    u64 * state
+) {
+    u64 rnd = Bench_NextRand(state);
+
+    if (FlexBuf_PushStr(out, "n = ") == false ||
+        FlexBuf_PushUInt(out, rnd % 1000000) == false ||
+        FlexBuf_PushStr(out, "; s = \"item ") == false ||
+        FlexBuf_PushUInt(out, rnd % 97) == false ||
+        FlexBuf_PushStr(out, rnd % 2 ? "\"; b = true;" :
+            "\"; b = false;") == false) {
+
+        return false;
+    }
+
+    if (rnd % 16 == 0 &&
+        FlexBuf_PushStr(out, " big = 123456789012345678901234567890;") ==
+            false) {
+
+        return false;
+    }
+
+    return FlexBuf_PushByte(out, '\n');
+}
+
+/**
+ * @brief Appends a deeply parenthesized expression inside deeply nested
+ *        blocks.
+ */
+bool
+Bench_GenNested(
+    FlexBuf * out,
+    u64 * state
+) {
+    usize depth = 1 + Bench_NextRand(state) % NEST_DEPTH;
+
+    for (usize i = 0; i < depth; i++) {
+        if (FlexBuf_PushStr(out, "if x { ") == false) {
+            return false;
+        }
+    }
+
+    if (FlexBuf_PushStr(out, "y = ") == false ||
+        FlexBuf_PushDupByte(out, '(', depth) == false ||
+        FlexBuf_PushByte(out, '1') == false) {
+
+        return false;
+    }
+
+    for (usize i = 0; i < depth; i++) {
+        if (FlexBuf_PushStr(out, " + 1)") == false) {
+            return false;
+        }
+    }
+
+    if (FlexBuf_PushStr(out, "; ") == false) {
+        return false;
+    }
+
+    for (usize i = 0; i < depth; i++) {
+        if (FlexBuf_PushStr(out, "} ") == false) {
+            return false;
+        }
+    }
+
+    return FlexBuf_PushByte(out, '\n');
+}
+
+/**
+ * @brief Appends an assignment of a long string literal.
+ */
+bool
+Bench_GenLongStrings(
+    FlexBuf * out,
+    u64 * state
+) {
+    if (FlexBuf_PushStr(out, "s = \"") == false) {
+        return false;
+    }
+
+    u8 * tail = FlexBuf_ReserveTail(out, LONG_STR_LEN);
+    if (tail == NULL) {
+        return false;
+    }
+
+    for (usize i = 0; i < LONG_STR_LEN; i++) {
+        tail[i] = (u8)('a' + Bench_NextRand(state) % 26);
+    }
+
+    FlexBuf_Commit(out, LONG_STR_LEN);
+
+    return FlexBuf_PushStr(out, "\";\n");
+}
+
+/**
+ * @brief Appends a line of one of the identifier, literal and nested
+ *        workloads, picked at random.
+ */
+bool
+Bench_GenMixed(
+    FlexBuf * out,
+    u64 * state
+) {
+    static const BenchGenFn GENS[] = {
+        Bench_GenIdents,
+        Bench_GenLiterals,
+        Bench_GenNested,
+    };
+
+    return GENS[Bench_NextRand(state) % (sizeof(GENS) / sizeof(GENS[0]))](
+        out, state);
+}
+
+void
+Bench_PrintHead(
+    const BenchCol * cols,
+    usize num_cols
+) {
+    const char * sep = "";
+
+    for (usize i = 0; i < num_cols; i++) {
+        if (cols[i].head != NULL) {
+            printf("%s%*s", sep, cols[i].width, cols[i].head);
+            sep = " ";
+        }
+    }
+
+    printf("\n");
+}
+
+void
+Bench_PrintRow(
+    const BenchCol * cols,
+    usize num_cols,
+    const void * row
+) {
+    const char * sep = "";
+
+    for (usize i = 0; i < num_cols; i++) {
+        const BenchCol * col = cols + i;
+        const u8 * field = (const u8 *)row + col->off;
+
+        if (col->head == NULL) {
+            continue;
+        }
+
+        printf("%s", sep);
+        sep = " ";
+
+        switch (col->type) {
+        case BenchType_Str:
+            printf("%*s", col->width, *(const char * const *)field);
+            break;
+
+        case BenchType_Size:
+            printf("%*zu", col->width, *(const usize *)field);
+            break;
+
+        case BenchType_U64:
+            printf("%*llu", col->width,
+                (unsigned long long)*(const u64 *)field);
+            break;
+
+        case BenchType_Double:
+            printf("%*.*f", col->width, col->prec, *(const double *)field);
+            break;
+        }
+    }
+
+    printf("\n");
+}
+
+/**
+ * @brief Prints rows of results as a table, one column per field with a
+ *        heading.
+ */
+void
+Bench_PrintTable(
+    const BenchCol * cols,
+    usize num_cols,
+    const void * rows,
+    usize row_size,
+    usize num_rows
+) {
+    Bench_PrintHead(cols, num_cols);
+
+    for (usize i = 0; i < num_rows; i++) {
+        Bench_PrintRow(cols, num_cols, (const u8 *)rows + i * row_size);
+    }
+}
+
+/**
+ * @brief Prints rows of results as a JSON object of the parameters and a
+ *        list under `list_key`, one object per row of the fields with a key.
+ */
+void
+Bench_PrintJson(
+    const BenchParam * params,
+    usize num_params,
+    const char * list_key,
+    const BenchCol * cols,
+    usize num_cols,
+    const void * rows,
+    usize row_size,
+    usize num_rows
+) {
+    printf("{\n");
+
+    for (usize i = 0; i < num_params; i++) {
+        printf("  \"%s\": %zu,\n", params[i].key, params[i].val);
+    }
+
+    printf("  \"%s\": [\n", list_key);
+
+    for (usize i = 0; i < num_rows; i++) {
+        const u8 * row = (const u8 *)rows + i * row_size;
+        const char * sep = "";
+
+        printf("    {");
+
+        for (usize j = 0; j < num_cols; j++) {
+            const BenchCol * col = cols + j;
+            const u8 * field = row + col->off;
+
+            if (col->key == NULL) {
+                continue;
+            }
+
+            printf("%s\"%s\": ", sep, col->key);
+            sep = ", ";
+
+            switch (col->type) {
+            case BenchType_Str:
+                printf("\"%s\"", *(const char * const *)field);
+                break;
+
+            case BenchType_Size:
+                printf("%zu", *(const usize *)field);
+                break;
+
+            case BenchType_U64:
+                printf("%llu", (unsigned long long)*(const u64 *)field);
+                break;
+
+            case BenchType_Double:
+                printf("%.3f", *(const double *)field);
+                break;
+            }
+        }
+
+        printf("}%s\n", i + 1 < num_rows ? "," : "");
+    }
+
+    printf("  ]\n}\n");
+}
\ No newline at end of file
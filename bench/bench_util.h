@@ -0,0 +1,124 @@
+#ifndef __ME_BENCH_BENCH_UTIL_H__
+#define __ME_BENCH_BENCH_UTIL_H__
+
+#include <stddef.h>
+
+#include "menos.h"
+#include "util/flex_buf.h"
+
+/* Seed of the generated workloads, so runs are comparable across commits. */
+#define BENCH_SEED      88172645463325252UL
+
+typedef enum _BenchType {
+    BenchType_Str,      /* `const char *` */
+    BenchType_Size,     /* `usize` */
+    BenchType_U64,      /* `u64` */
+    BenchType_Double,   /* `double` */
+} BenchType;
+
+/* Column of a report, read from a field of each result row. */
+typedef struct _BenchCol {
+
+    /* Heading in the table, or `NULL` to leave the column out of it. */
+    const char * head;
+
+    /* Key in JSON, or `NULL` to leave the column out of it. */
+    const char * key;
+
+    BenchType type;
+
+    /* Offset of the field in a row. */
+    usize off;
+
+    /* Width in the table, negative to align left. */
+    int width;
+
+    /* Digits after the point of a double in the table. */
+    int prec;
+} BenchCol;
+
+/* Column of `field` in rows of type `row`. */
+#define BENCH_COL(row, field, head, key, type, width, prec)              \
+    {head, key, BenchType_##type, offsetof(row, field), width, prec}
+
+/* Top-level value of a JSON report. */
+typedef struct _BenchParam {
+    const char * key;
+    usize val;
+} BenchParam;
+
+typedef bool (* BenchGenFn)(FlexBuf * out, u64 * state);
+
+u64
+Bench_Now(void);
+
+u64
+Bench_NextRand(
+    u64 * state
+);
+
+bool
+Bench_GenIdents(
+    FlexBuf * out,
+    u64 * state
+);
+
+bool
+Bench_GenLiterals(
+    FlexBuf * out,
+    u64 * state
+);
+
+bool
+Bench_GenNested(
+    FlexBuf * out,
+    u64 * state
+);
+
+bool
+Bench_GenLongStrings(
+    FlexBuf * out,
+    u64 * state
+);
+
+bool
+Bench_GenMixed(
+    FlexBuf * out,
+    u64 * state
+);
+
+void
+Bench_PrintHead(
+    const BenchCol * cols,
+    usize num_cols
+);
+
+void
+Bench_PrintRow(
+    const BenchCol * cols,
+    usize num_cols,
+    const void * row
+);
+
+void
+Bench_PrintTable(
+    const BenchCol * cols,
+    usize num_cols,
+    const void * rows,
+    usize row_size,
+    usize num_rows
+);
+
+void
+Bench_PrintJson(
+    const BenchParam * params,
+    usize num_params,
+    const char * list_key,
+    const BenchCol * cols,
+    usize num_cols,
+    const void * rows,
+    usize row_size,
+    usize num_rows
+);
+
+#endif
\ No newline at end of file
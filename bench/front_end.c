@@ -0,0 +1,356 @@
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_util.h"
+#include "menos.h"
+#include "lexer/lexer.h"
+#include "memory/allocate.h"
+#include "parser/parser.h"
+#include "util/flex_buf.h"
+#include "util/trace.h"
+
+/* Measures the throughput of the front end on synthetic scripts.
+
+   Each workload is generated from a fixed seed, so runs are comparable
+   across commits. Every workload is scanned from a buffer and from a file,
+   then parsed from its tokens, each phase repeated and timed as a whole.
+
+   The peak resident set of each workload is measured on its own, from a
+   reset of the high-water mark when it starts, and reads 0 where Linux's
+   `/proc/self/clear_refs` is unavailable. Allocations are counted per
+   thread, so they do not depend on `ME_MEM_STATS`.
+
+   With `--trace` the stages record trace events, written to the file as
+   Chrome trace JSON when the run ends.
+
+   Usage: front_end [--json] [--size KIB] [--iters N] [--trace FILE] */
+
+#define DEF_SIZE_KIB    1024
+#define DEF_ITERS       5
+
+typedef struct _Workload {
+    const char * name;
+    BenchGenFn gen;
+} Workload;
+
+typedef struct _Result {
+    const char * name;
+    usize bytes;
+    usize num_toks;
+    usize num_nodes;
+    double scan_buf_mbps;
+    double scan_file_mbps;
+    double toks_per_sec;
+    double nodes_per_sec;
+    double allocs_per_kib;
+    usize peak_rss_kib;
+} Result;
+
+static
+const Workload
+workloads[] = {
+    {"idents", Bench_GenIdents},
+    {"literals", Bench_GenLiterals},
+    {"nested", Bench_GenNested},
+    {"long_strings", Bench_GenLongStrings},
+};
+
+static
+const BenchCol
+cols[] = {
+    BENCH_COL(Result, name, "workload", "name", Str, -14, 0),
+    BENCH_COL(Result, bytes, "bytes", "bytes", Size, 9, 0),
+    BENCH_COL(Result, num_toks, NULL, "tokens", Size, 0, 0),
+    BENCH_COL(Result, num_nodes, NULL, "nodes", Size, 0, 0),
+    BENCH_COL(Result, scan_buf_mbps, "buf_mbps", "scan_buf_mb_per_s",
+        Double, 10, 1),
+    BENCH_COL(Result, scan_file_mbps, "file_mbps", "scan_file_mb_per_s",
+        Double, 10, 1),
+    BENCH_COL(Result, toks_per_sec, "toks_per_s", "tokens_per_s",
+        Double, 12, 0),
+    BENCH_COL(Result, nodes_per_sec, "nodes_per_s", "nodes_per_s",
+        Double, 12, 0),
+    BENCH_COL(Result, allocs_per_kib, "allocs_kib", "allocs_per_kib",
+        Double, 10, 1),
+    BENCH_COL(Result, peak_rss_kib, "peak_rss_kib", "peak_rss_kib",
+        Size, 12, 0),
+};
+
+/* Resets the peak resident set of the process to the current one, after
+   handing the memory of earlier workloads back to the system. */
+static
+bool
+ResetPeakRss(void) {
+    MeMem_FlushCaches();
+    malloc_trim(0);
+
+    FILE * file = fopen("/proc/self/clear_refs", "w");
+    if (file == NULL) {
+        return false;
+    }
+
+    bool res = fputs("5", file) >= 0;
+
+    return fclose(file) == 0 && res;
+}
+
+/* Peak resident set since the last reset, 0 if it cannot be read. */
+static
+usize
+PeakRssKib(void) {
+    char line[128];
+    usize kib = 0;
+
+    FILE * file = fopen("/proc/self/status", "r");
+    if (file == NULL) {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (strncmp(line, "VmHWM:", 6) == 0) {
+            kib = (usize)strtoul(line + 6, NULL, 10);
+            break;
+        }
+    }
+
+    fclose(file);
+
+    return kib;
+}
+
+static
+bool
+WriteFile(
+    const char * path,
+    const u8 * buf,
+    usize len
+) {
+    FILE * file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+
+    bool res = fwrite(buf, 1, len, file) == len;
+
+    return fclose(file) == 0 && res;
+}
+
+static
+double
+PerSec(
+    double amount,
+    u64 ns
+) {
+    return ns == 0 ? 0.0 : amount * 1e9 / (double)ns;
+}
+
+/* Generates a workload and measures it, `false` on any failure. */
+static
+bool
+RunWorkload(
+    const Workload * wl,
+    usize size,
+    usize iters,
+    Result * res
+) {
+    u64 state = BENCH_SEED;
+    char path[] = "/tmp/menos_bench_XXXXXX";
+    bool ok = false;
+    LexOut * lo = NULL;
+    Parser * par = NULL;
+    bool peak_reset = ResetPeakRss();
+
+    FlexBuf * src = FlexBuf_New();
+    if (src == NULL) {
+        goto Exit;
+    }
+
+    while (FlexBuf_Size(src) < size) {
+        if (wl->gen(src, &state) == false) {
+            goto FreeSrc;
+        }
+    }
+
+    const u8 * buf = FlexBuf_Data(src);
+    const usize len = FlexBuf_Size(src);
+
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        goto FreeSrc;
+    }
+
+    close(fd);
+
+    if (WriteFile(path, buf, len) == false) {
+        goto RemoveFile;
+    }
+
+    Lexer * lex = Lexer_New();
+    if (lex == NULL) {
+        goto RemoveFile;
+    }
+
+    u64 scan_buf_ns = 0;
+    u64 scan_file_ns = 0;
+    u64 parse_ns = 0;
+
+    for (usize i = 0; i < iters; i++) {
+        u64 start = Bench_Now();
+
+        if (Lexer_ScanBuf(lex, buf, len, &lo) == false) {
+            goto FreeLexer;
+        }
+
+        scan_buf_ns += Bench_Now() - start;
+
+        res->num_toks = TokSeq_Count(LexOut_Tokens(lo));
+        LexOut_Free(lo);
+        lo = NULL;
+
+        start = Bench_Now();
+
+        if (Lexer_ScanFile(lex, path, &lo) == false) {
+            goto FreeLexer;
+        }
+
+        scan_file_ns += Bench_Now() - start;
+
+        LexOut_Free(lo);
+        lo = NULL;
+    }
+
+    /* One more scan and parse, for the allocation count. */
+    u64 num_allocs = MeMem_ThreadAllocs();
+
+    if (Lexer_ScanBuf(lex, buf, len, &lo) == false) {
+        goto FreeLexer;
+    }
+
+    for (usize i = 0; i < iters; i++) {
+        AstNode * tree;
+
+        par = Parser_New();
+        if (par == NULL) {
+            goto FreeLexOut;
+        }
+
+        u64 start = Bench_Now();
+
+        Parser_Link(par, lo);
+        if (Parser_Parse(par, &tree) == false) {
+            goto FreeParser;
+        }
+
+        parse_ns += Bench_Now() - start;
+
+        if (i == 0) {
+            num_allocs = MeMem_ThreadAllocs() - num_allocs;
+            res->num_nodes = AstNode_CountTree(tree);
+        }
+
+        AstNode_FreeTree(tree);
+        Parser_Free(par);
+        par = NULL;
+    }
+
+    res->name = wl->name;
+    res->bytes = len;
+    res->scan_buf_mbps = PerSec((double)len * iters / 1e6, scan_buf_ns);
+    res->scan_file_mbps = PerSec((double)len * iters / 1e6, scan_file_ns);
+    res->toks_per_sec = PerSec((double)res->num_toks * iters, scan_buf_ns);
+    res->nodes_per_sec = PerSec((double)res->num_nodes * iters, parse_ns);
+    res->allocs_per_kib = (double)num_allocs * 1024.0 / (double)len;
+    res->peak_rss_kib = peak_reset ? PeakRssKib() : 0;
+
+    ok = true;
+
+FreeParser:
+    if (par != NULL) {
+        Parser_Free(par);
+    }
+
+FreeLexOut:
+    if (lo != NULL) {
+        LexOut_Free(lo);
+    }
+
+FreeLexer:
+    Lexer_Free(lex);
+
+RemoveFile:
+    unlink(path);
+
+FreeSrc:
+    FlexBuf_Free(src);
+
+Exit:
+    return ok;
+}
+
+int
+main(
+    int argc,
+    char ** argv
+) {
+    const usize NUM_WORKLOADS = sizeof(workloads) / sizeof(workloads[0]);
+    Result results[sizeof(workloads) / sizeof(workloads[0])];
+    usize size = DEF_SIZE_KIB * 1024;
+    usize iters = DEF_ITERS;
+    bool json = false;
+    const char * trace_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size = (usize)strtoul(argv[++i], NULL, 10) * 1024;
+        } else if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+            iters = (usize)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--json] [--size KIB] [--iters N] "
+                "[--trace FILE]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (iters == 0) {
+        iters = 1;
+    }
+
+    if (trace_path != NULL) {
+        Trace_Enable(true);
+    }
+
+    for (usize i = 0; i < NUM_WORKLOADS; i++) {
+        if (RunWorkload(workloads + i, size, iters, results + i) == false) {
+            fprintf(stderr, "workload %s failed\n", workloads[i].name);
+            return EXIT_FAILURE;
+        }
+    }
+
+    const BenchParam params[] = {
+        {"iters", iters},
+    };
+
+    if (json) {
+        Bench_PrintJson(params, sizeof(params) / sizeof(params[0]),
+            "workloads", cols,
+            sizeof(cols) / sizeof(cols[0]), results, sizeof(Result),
+            NUM_WORKLOADS);
+    } else {
+        Bench_PrintTable(cols, sizeof(cols) / sizeof(cols[0]), results,
+            sizeof(Result), NUM_WORKLOADS);
+    }
+
+    if (trace_path != NULL && Trace_WriteFile(trace_path) == false) {
+        fprintf(stderr, "cannot write trace to %s\n", trace_path);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_util.h"
+#include "menos.h"
+#include "memory/gc.h"
+
+/* Reports the pause times of the heap against the size of its old
+   generation, for each way of collecting it.
+
+   A table of lists is built in the old generation, then the mutator keeps
+   unlinking old cells and linking young ones, so that the live size stays
+   the same while both generations fill with garbage. Each safepoint that
+   does collection work is timed. */
+
+/* Cells are a little over 128 bytes with their header. */
+#define CELL_PAD 96
+
+#define NUM_SLOTS 4096
+
+/* Mutator operations between safepoints. */
+#define POLL_INTERVAL 16
+
+/* Heap sizes in MiB, when none are given. */
+static const usize DEF_SIZES[] = {8, 16, 32, 64};
+
+typedef struct _Cell {
+    struct _Cell * next;
+    u8 pad[CELL_PAD];
+} Cell;
+
+typedef struct _Mode {
+    const char * name;
+    usize budget;
+    bool background;
+} Mode;
+
+static
+const Mode
+modes[] = {
+    {"stop-the-world", 0, false},
+    {"incremental", 64 * 1024, false},
+    {"incremental+bg", 64 * 1024, true},
+};
+
+static
+void
+Cell_Trace(
+    Gc * gc,
+    void * obj,
+    usize size,
+    GcVisitFn visit
+) {
+    (void)size;
+
+    visit(gc, (void **)&((Cell *)obj)->next);
+}
+
+static
+void
+Table_Trace(
+    Gc * gc,
+    void * obj,
+    usize size,
+    GcVisitFn visit
+) {
+    Cell ** slots = (Cell **)obj;
+
+    for (usize i = 0; i < size / sizeof(Cell *); i++) {
+        visit(gc, (void **)(slots + i));
+    }
+}
+
+static
+const GcType
+cell_type = {
+    "cell",
+    Cell_Trace,
+};
+
+static
+const GcType
+table_type = {
+    "table",
+    Table_Trace,
+};
+
+static
+void
+VisitRoots(
+    Gc * gc,
+    void * ctx,
+    GcVisitFn visit
+) {
+    visit(gc, (void **)ctx);
+}
+
+/* Pauses of one mode at one heap size. */
+typedef struct _Row {
+    usize heap_mib;
+    const char * mode;
+    usize pauses;
+    usize majors;
+    double max_us;
+    double p99_us;
+} Row;
+
+static
+const BenchCol
+cols[] = {
+    BENCH_COL(Row, heap_mib, "heap_mib", NULL, Size, 8, 0),
+    BENCH_COL(Row, mode, "mode", NULL, Str, -16, 0),
+    BENCH_COL(Row, pauses, "pauses", NULL, Size, 8, 0),
+    BENCH_COL(Row, majors, "majors", NULL, Size, 8, 0),
+    BENCH_COL(Row, max_us, "max_us", NULL, Double, 12, 1),
+    BENCH_COL(Row, p99_us, "p99_us", NULL, Double, 12, 1),
+};
+
+static
+int
+ComparePause(
+    const void * a,
+    const void * b
+) {
+    u64 x = *(const u64 *)a;
+    u64 y = *(const u64 *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* Builds the table and churns it, reports the pauses on one line. */
+static
+bool
+RunMode(
+    const Mode * mode,
+    usize heap_mib
+) {
+    Cell ** table = NULL;
+    usize num_cells = heap_mib * 1024 * 1024 / (sizeof(Cell) + 32);
+    usize num_ops = num_cells * 8;
+    usize cap = num_ops / POLL_INTERVAL + 1;
+    usize num_pauses = 0;
+    u64 state = BENCH_SEED;
+    GcStats stats;
+    bool res = false;
+
+    u64 * pauses = (u64 *)malloc(sizeof(u64) * cap);
+    if (pauses == NULL) {
+        goto Exit;
+    }
+
+    Gc * gc = Gc_New(4 * 1024 * 1024);
+    if (gc == NULL) {
+        goto FreePauses;
+    }
+
+    Gc_SetRoots(gc, VisitRoots, &table);
+    Gc_SetStepBudget(gc, mode->budget);
+    Gc_SetBackgroundSweep(gc, mode->background);
+
+    table = (Cell **)Gc_AllocOld(gc, &table_type,
+        sizeof(Cell *) * NUM_SLOTS);
+    if (table == NULL) {
+        goto FreeGc;
+    }
+
+    for (usize i = 0; i < num_cells; i++) {
+        Cell * cell = (Cell *)Gc_AllocOld(gc, &cell_type, sizeof(Cell));
+        if (cell == NULL) {
+            goto FreeGc;
+        }
+
+        cell->next = table[i % NUM_SLOTS];
+        table[i % NUM_SLOTS] = cell;
+    }
+
+    if (Gc_Collect(gc, true) == false) {
+        goto FreeGc;
+    }
+
+    Gc_Stats(gc, &stats);
+    usize num_major = stats.num_major;
+    usize last = stats.num_pauses;
+
+    for (usize i = 0; i < num_ops; i++) {
+        usize from = Bench_NextRand(&state) % NUM_SLOTS;
+        usize to = Bench_NextRand(&state) % NUM_SLOTS;
+
+        if (table[from] != NULL) {
+            table[from] = table[from]->next;
+            Gc_WriteBarrier(gc, table, table[from]);
+        }
+
+        Cell * cell = (Cell *)Gc_Alloc(gc, &cell_type, sizeof(Cell));
+        if (cell == NULL) {
+            goto FreeGc;
+        }
+
+        cell->next = table[to];
+        Gc_WriteBarrier(gc, cell, table[to]);
+        table[to] = cell;
+        Gc_WriteBarrier(gc, table, cell);
+
+        if ((i + 1) % POLL_INTERVAL != 0) {
+            continue;
+        }
+
+        u64 start = Bench_Now();
+
+        if (Gc_Poll(gc) == false) {
+            goto FreeGc;
+        }
+
+        u64 pause = Bench_Now() - start;
+
+        Gc_Stats(gc, &stats);
+        if (stats.num_pauses != last) {
+            pauses[num_pauses] = pause;
+            num_pauses += 1;
+            last = stats.num_pauses;
+        }
+    }
+
+    qsort(pauses, num_pauses, sizeof(u64), ComparePause);
+
+    u64 max = num_pauses == 0 ? 0 : pauses[num_pauses - 1];
+    u64 p99 = num_pauses == 0 ? 0 : pauses[num_pauses * 99 / 100];
+
+    Row row = {
+        heap_mib, mode->name, num_pauses, stats.num_major - num_major,
+        (double)max / 1000.0, (double)p99 / 1000.0,
+    };
+
+    Bench_PrintRow(cols, sizeof(cols) / sizeof(cols[0]), &row);
+
+    res = true;
+
+FreeGc:
+    Gc_Free(gc);
+
+FreePauses:
+    free(pauses);
+
+Exit:
+    return res;
+}
+
+int
+main(
+    int argc,
+    char ** argv
+) {
+    Bench_PrintHead(cols, sizeof(cols) / sizeof(cols[0]));
+
+    usize num_sizes = argc > 1 ?
+        (usize)(argc - 1) : sizeof(DEF_SIZES) / sizeof(DEF_SIZES[0]);
+
+    for (usize i = 0; i < num_sizes; i++) {
+        usize heap_mib = argc > 1 ?
+            (usize)strtoul(argv[i + 1], NULL, 10) : DEF_SIZES[i];
+
+        for (usize j = 0; j < sizeof(modes) / sizeof(modes[0]); j++) {
+            if (RunMode(modes + j, heap_mib) == false) {
+                fprintf(stderr, "out of memory\n");
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
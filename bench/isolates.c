@@ -0,0 +1,313 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_util.h"
+#include "menos.h"
+#include "lexer/lexer.h"
+#include "memory/allocate.h"
+#include "memory/pool.h"
+#include "parser/parser.h"
+#include "runtime/interp.h"
+
+/* Measures how running scripts scales with threads, each thread running an
+   isolate of its own: an interpreter with its own heap, globals and memory
+   pool, all loading one program compiled once.
+
+   For each thread count from 1 to N, doubling, every thread runs the
+   program a fixed number of times, so linear scaling keeps the wall time
+   flat. The fastest of the iterations is kept.
+
+   Usage: isolates [--json] [--threads N] [--runs N] [--iters N] */
+
+#define DEF_RUNS        20
+#define DEF_ITERS       3
+
+static
+const char *
+SCRIPT =
+    "fn fib(n) {\n"
+    "    if n < 2 { return n; }\n"
+    "    return fib(n - 1) + fib(n - 2);\n"
+    "}\n"
+    "fn build(n, s) {\n"
+    "    if n == 0 { return s; }\n"
+    "    return build(n - 1, s + \"ab\");\n"
+    "}\n"
+    "r = fib(18);\n"
+    "s = build(500, \"\");\n";
+
+/* The value of `r` after a run. */
+#define SCRIPT_RESULT   2584
+
+typedef struct _Worker {
+    pthread_t thread;
+    const InterpProg * prog;
+    pthread_barrier_t * start;
+    usize runs;
+    bool ok;
+} Worker;
+
+typedef struct _Result {
+    usize threads;
+    u64 best_ns;
+    double best_ms;
+    double runs_per_s;
+    double speedup;
+    double efficiency;
+} Result;
+
+static
+const BenchCol
+cols[] = {
+    BENCH_COL(Result, threads, "threads", "threads", Size, 8, 0),
+    BENCH_COL(Result, best_ns, NULL, "best_ns", U64, 0, 0),
+    BENCH_COL(Result, best_ms, "best_ms", NULL, Double, 10, 2),
+    BENCH_COL(Result, runs_per_s, "runs_per_s", "runs_per_s", Double, 12, 1),
+    BENCH_COL(Result, speedup, "speedup", "speedup", Double, 8, 2),
+    BENCH_COL(Result, efficiency, "efficiency", NULL, Double, 10, 2),
+};
+
+static
+void *
+RunWorker(
+    void * arg
+) {
+    Worker * worker = (Worker *)arg;
+    Interp * interp = NULL;
+
+    MemPool * pool = MemPool_New();
+    if (pool != NULL) {
+        const MemAllocator * prev = MeMem_Use(MemPool_Allocator(pool));
+        interp = Interp_New();
+        MeMem_Use(prev);
+    }
+
+    /* Setting up the isolate is left out of the measurement. */
+    pthread_barrier_wait(worker->start);
+
+    if (interp == NULL) {
+        goto FreePool;
+    }
+
+    worker->ok = true;
+
+    for (usize i = 0; i < worker->runs && worker->ok; i++) {
+        Value * r;
+
+        worker->ok = Interp_LoadProg(interp, worker->prog) &&
+            Interp_Run(interp) &&
+            (r = Interp_Global(interp, "r"), r->tag == ValTag_Num) &&
+            r->ext.num == SCRIPT_RESULT;
+    }
+
+    Interp_Free(interp);
+
+FreePool:
+    if (pool != NULL) {
+        MemPool_Free(pool);
+    }
+
+    return NULL;
+}
+
+/* Runs the program on a number of threads, `false` on any failure. */
+static
+bool
+RunThreads(
+    const InterpProg * prog,
+    usize threads,
+    usize runs,
+    usize iters,
+    Result * res
+) {
+    Worker * workers = (Worker *)calloc(threads, sizeof(Worker));
+    if (workers == NULL) {
+        return false;
+    }
+
+    bool ok = true;
+
+    res->threads = threads;
+    res->best_ns = UINT64_MAX;
+
+    for (usize i = 0; i < iters && ok; i++) {
+        pthread_barrier_t start;
+        usize num_started = 0;
+
+        if (pthread_barrier_init(&start, NULL, (unsigned)threads + 1) != 0) {
+            ok = false;
+            break;
+        }
+
+        for (usize j = 0; j < threads; j++) {
+            workers[j].prog = prog;
+            workers[j].start = &start;
+            workers[j].runs = runs;
+            workers[j].ok = false;
+
+            if (pthread_create(&workers[j].thread, NULL, RunWorker,
+                workers + j) != 0) {
+
+                break;
+            }
+
+            num_started++;
+        }
+
+        /* The barrier cannot be released without every thread. */
+        if (num_started < threads) {
+            fprintf(stderr, "cannot start %zu threads\n", threads);
+            exit(EXIT_FAILURE);
+        }
+
+        pthread_barrier_wait(&start);
+        u64 begin = Bench_Now();
+
+        for (usize j = 0; j < threads; j++) {
+            pthread_join(workers[j].thread, NULL);
+            ok = ok && workers[j].ok;
+        }
+
+        u64 ns = Bench_Now() - begin;
+        if (ns < res->best_ns) {
+            res->best_ns = ns;
+        }
+
+        pthread_barrier_destroy(&start);
+    }
+
+    free(workers);
+
+    res->runs_per_s = (double)(threads * runs) * 1e9 / (double)res->best_ns;
+
+    return ok;
+}
+
+int
+main(
+    int argc,
+    char ** argv
+) {
+    Result results[64];
+    usize num_results = 0;
+    usize max_threads = 0;
+    usize runs = DEF_RUNS;
+    usize iters = DEF_ITERS;
+    bool json = false;
+    int res = EXIT_FAILURE;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            max_threads = (usize)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = (usize)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+            iters = (usize)strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--json] [--threads N] [--runs N] "
+                "[--iters N]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (max_threads == 0) {
+        long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        max_threads = num_cpus > 0 ? (usize)num_cpus : 1;
+    }
+
+    if (iters == 0) {
+        iters = 1;
+    }
+
+    Lexer * lex = Lexer_New();
+    Parser * par = Parser_New();
+    InterpProg * prog = InterpProg_New();
+    LexOut * lo = NULL;
+    AstNode * tree = NULL;
+
+    if (lex == NULL ||
+        par == NULL ||
+        prog == NULL ||
+        Lexer_ScanBuf(lex, SCRIPT, strlen(SCRIPT), &lo) == false) {
+
+        fprintf(stderr, "cannot scan the script\n");
+        goto Exit;
+    }
+
+    Parser_Link(par, lo);
+
+    if (Parser_Parse(par, &tree) == false ||
+        InterpProg_Compile(prog, tree) == false) {
+
+        fprintf(stderr, "cannot compile the script\n");
+        goto Exit;
+    }
+
+    for (usize threads = 1; num_results < 64; threads *= 2) {
+        if (threads > max_threads) {
+            threads = max_threads;
+        }
+
+        Result * r = results + num_results;
+
+        if (RunThreads(prog, threads, runs, iters, r) == false) {
+            fprintf(stderr, "run on %zu threads failed\n", threads);
+            goto Exit;
+        }
+
+        /* Every thread does the work of the single thread. */
+        r->best_ms = (double)r->best_ns / 1e6;
+        r->speedup = (double)threads * (double)results[0].best_ns /
+            (double)r->best_ns;
+        r->efficiency = r->speedup / (double)threads;
+        num_results++;
+
+        if (threads == max_threads) {
+            break;
+        }
+    }
+
+    const BenchParam params[] = {
+        {"runs_per_thread", runs},
+        {"iters", iters},
+    };
+
+    if (json) {
+        Bench_PrintJson(params, sizeof(params) / sizeof(params[0]),
+            "results", cols, sizeof(cols) / sizeof(cols[0]), results,
+            sizeof(Result), num_results);
+    } else {
+        Bench_PrintTable(cols, sizeof(cols) / sizeof(cols[0]), results,
+            sizeof(Result), num_results);
+    }
+
+    res = EXIT_SUCCESS;
+
+Exit:
+    if (prog != NULL) {
+        InterpProg_Free(prog);
+    }
+
+    if (tree != NULL) {
+        AstNode_FreeTree(tree);
+    }
+
+    if (lo != NULL) {
+        LexOut_Free(lo);
+    }
+
+    if (par != NULL) {
+        Parser_Free(par);
+    }
+
+    if (lex != NULL) {
+        Lexer_Free(lex);
+    }
+
+    return res;
+}
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_util.h"
+#include "menos.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "util/flex_buf.h"
+#include "util/sched.h"
+
+/* Measures how lexing and parsing a batch of scripts scales with the
+   workers of the work-stealing scheduler.
+
+   The batch is generated from a fixed seed, mixing the lines of the
+   identifier, literal and nested workloads of `front_end`. For each worker
+   count from 1 to N, doubling, every script is scanned and parsed once per
+   iteration through `Sched_ParallelFor`, one script per part, and the
+   fastest iteration is kept.
+
+   Usage: sched_scaling [--json] [--workers N] [--scripts N] [--size KIB]
+                        [--iters N] [--pin] */
+
+#define DEF_SCRIPTS     256
+#define DEF_SIZE_KIB    32
+#define DEF_ITERS       5
+
+typedef struct _Batch {
+    FlexBuf ** srcs;
+    usize num;
+    usize bytes;
+
+    /* Scripts that failed to scan or parse, `0` on a sound run. */
+    atomic_size_t num_failed;
+} Batch;
+
+typedef struct _Result {
+    usize workers;
+    u64 best_ns;
+    double best_ms;
+    double mbps;
+    double speedup;
+    double efficiency;
+} Result;
+
+static
+const BenchCol
+cols[] = {
+    BENCH_COL(Result, workers, "workers", "workers", Size, 8, 0),
+    BENCH_COL(Result, best_ns, NULL, "best_ns", U64, 0, 0),
+    BENCH_COL(Result, best_ms, "best_ms", NULL, Double, 10, 2),
+    BENCH_COL(Result, mbps, "mbps", "mb_per_s", Double, 10, 1),
+    BENCH_COL(Result, speedup, "speedup", "speedup", Double, 8, 2),
+    BENCH_COL(Result, efficiency, "efficiency", NULL, Double, 10, 2),
+};
+
+static
+void
+ScanAndParse(
+    void * ctx,
+    usize begin,
+    usize end
+) {
+    Batch * batch = (Batch *)ctx;
+
+    Lexer * lex = Lexer_New();
+    Parser * par = Parser_New();
+
+    for (usize i = begin; i < end; i++) {
+        FlexBuf * src = batch->srcs[i];
+        LexOut * lo;
+        AstNode * tree;
+
+        if (lex == NULL || par == NULL) {
+            atomic_fetch_add(&batch->num_failed, 1);
+            continue;
+        }
+
+        Lexer_Reset(lex);
+        Parser_Reset(par);
+
+        if (Lexer_ScanBuf(lex, FlexBuf_Data(src), FlexBuf_Size(src),
+            &lo) == false) {
+
+            atomic_fetch_add(&batch->num_failed, 1);
+            continue;
+        }
+
+        Parser_Link(par, lo);
+
+        if (Parser_Parse(par, &tree)) {
+            AstNode_FreeTree(tree);
+        } else {
+            atomic_fetch_add(&batch->num_failed, 1);
+        }
+
+        LexOut_Free(lo);
+    }
+
+    if (par != NULL) {
+        Parser_Free(par);
+    }
+
+    if (lex != NULL) {
+        Lexer_Free(lex);
+    }
+}
+
+static
+bool
+Batch_Init(
+    Batch * batch,
+    usize num,
+    usize size
+) {
+    u64 state = BENCH_SEED;
+
+    batch->srcs = (FlexBuf **)calloc(num, sizeof(FlexBuf *));
+    if (batch->srcs == NULL) {
+        return false;
+    }
+
+    batch->num = num;
+    batch->bytes = 0;
+    atomic_init(&batch->num_failed, 0);
+
+    for (usize i = 0; i < num; i++) {
+        batch->srcs[i] = FlexBuf_New();
+        if (batch->srcs[i] == NULL) {
+            return false;
+        }
+
+        while (FlexBuf_Size(batch->srcs[i]) < size) {
+            if (Bench_GenMixed(batch->srcs[i], &state) == false) {
+                return false;
+            }
+        }
+
+        batch->bytes += FlexBuf_Size(batch->srcs[i]);
+    }
+
+    return true;
+}
+
+static
+void
+Batch_Fini(
+    Batch * batch
+) {
+    for (usize i = 0; i < batch->num; i++) {
+        if (batch->srcs[i] != NULL) {
+            FlexBuf_Free(batch->srcs[i]);
+        }
+    }
+
+    free(batch->srcs);
+}
+
+/* Runs the batch on a number of workers, `false` on any failure. */
+static
+bool
+RunWorkers(
+    Batch * batch,
+    usize workers,
+    usize iters,
+    bool pin,
+    Result * res
+) {
+    Sched * sched = Sched_New(workers, pin);
+    if (sched == NULL) {
+        return false;
+    }
+
+    res->workers = workers;
+    res->best_ns = UINT64_MAX;
+
+    for (usize i = 0; i < iters; i++) {
+        u64 start = Bench_Now();
+
+        Sched_ParallelFor(sched, 0, batch->num, 1, ScanAndParse, batch);
+
+        u64 ns = Bench_Now() - start;
+        if (ns < res->best_ns) {
+            res->best_ns = ns;
+        }
+    }
+
+    Sched_Free(sched);
+
+    res->mbps = (double)batch->bytes * 1e3 / (double)res->best_ns;
+
+    return atomic_load(&batch->num_failed) == 0;
+}
+
+int
+main(
+    int argc,
+    char ** argv
+) {
+    Result results[64];
+    usize num_results = 0;
+    usize max_workers = 0;
+    usize num_scripts = DEF_SCRIPTS;
+    usize size = DEF_SIZE_KIB * 1024;
+    usize iters = DEF_ITERS;
+    bool json = false;
+    bool pin = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--pin") == 0) {
+            pin = true;
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            max_workers = (usize)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--scripts") == 0 && i + 1 < argc) {
+            num_scripts = (usize)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size = (usize)strtoul(argv[++i], NULL, 10) * 1024;
+        } else if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+            iters = (usize)strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--json] [--workers N] "
+                "[--scripts N] [--size KIB] [--iters N] [--pin]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (max_workers == 0) {
+        long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        max_workers = num_cpus > 0 ? (usize)num_cpus : 1;
+    }
+
+    if (iters == 0) {
+        iters = 1;
+    }
+
+    Batch batch;
+    if (Batch_Init(&batch, num_scripts, size) == false) {
+        fprintf(stderr, "cannot generate the scripts\n");
+        return EXIT_FAILURE;
+    }
+
+    for (usize workers = 1; num_results < 64; workers *= 2) {
+        if (workers > max_workers) {
+            workers = max_workers;
+        }
+
+        Result * res = results + num_results;
+
+        if (RunWorkers(&batch, workers, iters, pin, res) == false) {
+            fprintf(stderr, "run on %zu workers failed\n", workers);
+            Batch_Fini(&batch);
+            return EXIT_FAILURE;
+        }
+
+        res->best_ms = (double)res->best_ns / 1e6;
+        res->speedup = (double)results[0].best_ns / (double)res->best_ns;
+        res->efficiency = res->speedup / (double)workers;
+        num_results++;
+
+        if (workers == max_workers) {
+            break;
+        }
+    }
+
+    const BenchParam params[] = {
+        {"scripts", batch.num},
+        {"bytes", batch.bytes},
+        {"iters", iters},
+    };
+
+    if (json) {
+        Bench_PrintJson(params, sizeof(params) / sizeof(params[0]), "runs",
+            cols, sizeof(cols) / sizeof(cols[0]), results, sizeof(Result),
+            num_results);
+    } else {
+        Bench_PrintTable(cols, sizeof(cols) / sizeof(cols[0]), results,
+            sizeof(Result), num_results);
+    }
+
+    Batch_Fini(&batch);
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,424 @@
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_util.h"
+#include "menos.h"
+#include "lexer/lexer.h"
+#include "parser/code_cache.h"
+#include "parser/parser.h"
+#include "runtime/interp.h"
+#include "runtime/snapshot.h"
+#include "util/flex_buf.h"
+
+/* Measures how long a new worker takes to be ready to serve, that is to
+   hold the program and the globals its initialization computes:
+
+   - cold: scans, parses, loads and runs the script.
+   - cached: finds the tree in a code cache, loads and runs it.
+   - snapshot: loads a snapshot file and restores it.
+   - restore: restores a snapshot already loaded, as workers sharing one
+     would.
+
+   The script defines a number of functions, each computing a global at
+   initialization. The fastest of the iterations is kept.
+
+   Usage: startup [--json] [--funcs N] [--iters N] */
+
+#define DEF_FUNCS       200
+#define DEF_ITERS       20
+
+#define NUM_RESULTS     4
+
+typedef struct _Result {
+    const char * name;
+    u64 best_ns;
+    double best_ms;
+    double speedup;
+} Result;
+
+static
+const BenchCol
+cols[] = {
+    BENCH_COL(Result, name, "start", "name", Str, 10, 0),
+    BENCH_COL(Result, best_ns, NULL, "best_ns", U64, 0, 0),
+    BENCH_COL(Result, best_ms, "best_ms", NULL, Double, 10, 3),
+    BENCH_COL(Result, speedup, "speedup", "speedup", Double, 8, 2),
+};
+
+/* Writes a script of `num_funcs` functions and the globals they set. */
+static
+bool
+MakeScript(
+    usize num_funcs,
+    FlexBuf * buf
+) {
+    for (usize i = 0; i < num_funcs; i++) {
+        if (FlexBuf_PushFmt(buf,
+            "fn f%zu(n, acc) {\n"
+            "    if n == 0 { return acc; }\n"
+            "    match n %% 4 {\n"
+            "        0 { acc = acc * 3 + %zu; }\n"
+            "        1 { acc = acc + n; }\n"
+            "        else { acc = (acc * 7 + 1) %% 1000003; }\n"
+            "    }\n"
+            "    return f%zu(n - 1, acc);\n"
+            "}\n"
+            "g%zu = f%zu(100, %zu);\n"
+            "s%zu = \"name of \" + \"global %zu\";\n",
+            i, i, i, i, i, i, i, i) == false) {
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Starts a worker from the source, `false` on any failure. */
+static
+bool
+StartCold(
+    FlexBuf * src
+) {
+    Lexer * lex = Lexer_New();
+    Parser * par = Parser_New();
+    Interp * interp = Interp_New();
+    LexOut * lo = NULL;
+    AstNode * tree = NULL;
+    bool ok = false;
+
+    if (lex == NULL ||
+        par == NULL ||
+        interp == NULL ||
+        Lexer_ScanBuf(lex, (const char *)FlexBuf_Data(src),
+            FlexBuf_Size(src), &lo) == false) {
+
+        goto Exit;
+    }
+
+    Parser_Link(par, lo);
+
+    ok = Parser_Parse(par, &tree) &&
+        Interp_Load(interp, tree) &&
+        Interp_Run(interp) &&
+        Interp_Global(interp, "g0")->tag == ValTag_Num;
+
+Exit:
+    if (interp != NULL) {
+        Interp_Free(interp);
+    }
+
+    if (tree != NULL) {
+        AstNode_FreeTree(tree);
+    }
+
+    if (lo != NULL) {
+        LexOut_Free(lo);
+    }
+
+    if (par != NULL) {
+        Parser_Free(par);
+    }
+
+    if (lex != NULL) {
+        Lexer_Free(lex);
+    }
+
+    return ok;
+}
+
+/* Starts a worker from the tree of the source in a code cache. */
+static
+bool
+StartCached(
+    FlexBuf * src,
+    CodeCache * cache
+) {
+    AstNode * tree;
+    bool ok = false;
+
+    if (CodeCache_Load(cache, FlexBuf_Data(src), FlexBuf_Size(src),
+            &tree) == false) {
+
+        return false;
+    }
+
+    Interp * interp = Interp_New();
+    if (interp != NULL) {
+        ok = Interp_Load(interp, tree) &&
+            Interp_Run(interp) &&
+            Interp_Global(interp, "g0")->tag == ValTag_Num;
+
+        Interp_Free(interp);
+    }
+
+    AstNode_FreeTree(tree);
+
+    return ok;
+}
+
+/* Starts a worker from a snapshot, loaded unless `snap` is given. */
+static
+bool
+StartFromSnapshot(
+    const char * path,
+    Snapshot * snap
+) {
+    Snapshot * own_snap = NULL;
+    bool ok = false;
+
+    if (snap == NULL) {
+        own_snap = Snapshot_Load(path);
+        if (own_snap == NULL) {
+            return false;
+        }
+
+        snap = own_snap;
+    }
+
+    Interp * interp = Interp_New();
+    if (interp != NULL) {
+        ok = Snapshot_Restore(snap, interp) &&
+            Interp_Global(interp, "g0")->tag == ValTag_Num;
+
+        Interp_Free(interp);
+    }
+
+    if (own_snap != NULL) {
+        Snapshot_Free(own_snap);
+    }
+
+    return ok;
+}
+
+/* Saves the snapshot of the initialized script and caches its tree. */
+static
+bool
+SaveSnapshot(
+    FlexBuf * src,
+    const char * path,
+    CodeCache * cache
+) {
+    Lexer * lex = Lexer_New();
+    Parser * par = Parser_New();
+    Interp * interp = Interp_New();
+    LexOut * lo = NULL;
+    AstNode * tree = NULL;
+    bool ok = false;
+
+    if (lex == NULL ||
+        par == NULL ||
+        interp == NULL ||
+        Lexer_ScanBuf(lex, (const char *)FlexBuf_Data(src),
+            FlexBuf_Size(src), &lo) == false) {
+
+        goto Exit;
+    }
+
+    Parser_Link(par, lo);
+
+    ok = Parser_Parse(par, &tree) &&
+        CodeCache_Store(cache, FlexBuf_Data(src), FlexBuf_Size(src), tree) &&
+        Interp_Load(interp, tree) &&
+        Interp_Run(interp) &&
+        Snapshot_Save(interp, path);
+
+Exit:
+    if (interp != NULL) {
+        Interp_Free(interp);
+    }
+
+    if (tree != NULL) {
+        AstNode_FreeTree(tree);
+    }
+
+    if (lo != NULL) {
+        LexOut_Free(lo);
+    }
+
+    if (par != NULL) {
+        Parser_Free(par);
+    }
+
+    if (lex != NULL) {
+        Lexer_Free(lex);
+    }
+
+    return ok;
+}
+
+/* Removes the files of a directory. */
+static
+void
+RemoveEntries(
+    const char * dir
+) {
+    char path[512];
+
+    DIR * d = opendir(dir);
+    if (d == NULL) {
+        return;
+    }
+
+    for (struct dirent * ent; (ent = readdir(d)) != NULL;) {
+        if (ent->d_name[0] != '.') {
+            snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+            unlink(path);
+        }
+    }
+
+    closedir(d);
+}
+
+int
+main(
+    int argc,
+    char ** argv
+) {
+    Result results[NUM_RESULTS] = {
+        { "cold", UINT64_MAX, 0.0, 0.0 },
+        { "cached", UINT64_MAX, 0.0, 0.0 },
+        { "snapshot", UINT64_MAX, 0.0, 0.0 },
+        { "restore", UINT64_MAX, 0.0, 0.0 },
+    };
+    char dir[] = "/tmp/menos-startup-XXXXXX";
+    char path[64];
+    char cache_dir[64];
+    usize num_funcs = DEF_FUNCS;
+    usize iters = DEF_ITERS;
+    bool json = false;
+    int res = EXIT_FAILURE;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--funcs") == 0 && i + 1 < argc) {
+            num_funcs = (usize)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+            iters = (usize)strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--json] [--funcs N] [--iters N]\n",
+                argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (num_funcs == 0) {
+        num_funcs = 1;
+    }
+
+    if (iters == 0) {
+        iters = 1;
+    }
+
+    FlexBuf * src = FlexBuf_New();
+    if (src == NULL ||
+        MakeScript(num_funcs, src) == false) {
+
+        fprintf(stderr, "cannot make the script\n");
+        goto Exit;
+    }
+
+    if (mkdtemp(dir) == NULL) {
+        fprintf(stderr, "cannot make a temporary directory\n");
+        goto Exit;
+    }
+
+    snprintf(path, sizeof(path), "%s/startup.snap", dir);
+    snprintf(cache_dir, sizeof(cache_dir), "%s/cache", dir);
+
+    CodeCache * cache = CodeCache_New(cache_dir);
+    if (cache == NULL) {
+        fprintf(stderr, "cannot open the code cache\n");
+        goto RemoveDir;
+    }
+
+    if (SaveSnapshot(src, path, cache) == false) {
+        fprintf(stderr, "cannot save the snapshot\n");
+        goto FreeCache;
+    }
+
+    Snapshot * snap = Snapshot_Load(path);
+    if (snap == NULL) {
+        fprintf(stderr, "cannot load the snapshot\n");
+        goto RemoveFile;
+    }
+
+    for (usize i = 0; i < iters; i++) {
+        u64 ns[NUM_RESULTS];
+        bool ok = true;
+
+        u64 begin = Bench_Now();
+        ok = ok && StartCold(src);
+        ns[0] = Bench_Now() - begin;
+
+        begin = Bench_Now();
+        ok = ok && StartCached(src, cache);
+        ns[1] = Bench_Now() - begin;
+
+        begin = Bench_Now();
+        ok = ok && StartFromSnapshot(path, NULL);
+        ns[2] = Bench_Now() - begin;
+
+        begin = Bench_Now();
+        ok = ok && StartFromSnapshot(path, snap);
+        ns[3] = Bench_Now() - begin;
+
+        if (ok == false) {
+            fprintf(stderr, "worker failed to start\n");
+            goto FreeSnap;
+        }
+
+        for (usize j = 0; j < NUM_RESULTS; j++) {
+            if (ns[j] < results[j].best_ns) {
+                results[j].best_ns = ns[j];
+            }
+        }
+    }
+
+    for (usize i = 0; i < NUM_RESULTS; i++) {
+        results[i].best_ms = (double)results[i].best_ns / 1e6;
+        results[i].speedup = (double)results[0].best_ns /
+            (double)results[i].best_ns;
+    }
+
+    const BenchParam params[] = {
+        {"funcs", num_funcs},
+        {"iters", iters},
+    };
+
+    if (json) {
+        Bench_PrintJson(params, sizeof(params) / sizeof(params[0]),
+            "results", cols, sizeof(cols) / sizeof(cols[0]), results,
+            sizeof(Result), NUM_RESULTS);
+    } else {
+        Bench_PrintTable(cols, sizeof(cols) / sizeof(cols[0]), results,
+            sizeof(Result), NUM_RESULTS);
+    }
+
+    res = EXIT_SUCCESS;
+
+FreeSnap:
+    Snapshot_Free(snap);
+
+RemoveFile:
+    unlink(path);
+
+FreeCache:
+    CodeCache_Free(cache);
+    RemoveEntries(cache_dir);
+    rmdir(cache_dir);
+
+RemoveDir:
+    rmdir(dir);
+
+Exit:
+    if (src != NULL) {
+        FlexBuf_Free(src);
+    }
+
+    return res;
+}
\ No newline at end of file
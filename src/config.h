@@ -1,4 +1,108 @@
 #ifndef __ME_CONFIG_H__
 #define __ME_CONFIG_H__
 
+/* The number of value slots preallocated for the call stack. */
+#define ME_CALL_STACK_MAX_SLOTS     (64 * 1024)
+
+/* The maximum depth of non-tail calls. */
+#define ME_CALL_STACK_MAX_FRAMES    1024
+
+/* Whether the template JIT is built, it only targets x86-64 Linux. */
+#ifndef ME_JIT_ENABLED
+#if defined(__x86_64__) && defined(__linux__)
+#define ME_JIT_ENABLED              1
+#else
+#define ME_JIT_ENABLED              0
+#endif
+#endif
+
+/* The number of evaluations after which a root expression is compiled. */
+#define ME_JIT_HOT_THRESHOLD        64
+
+/* The number of bailouts after which compiled code is abandoned. */
+#define ME_JIT_MAX_BAILOUTS         16
+
+/* The size of the nursery of each interpreter heap, in bytes. */
+#define ME_GC_NURSERY_SIZE          (1024 * 1024)
+
+/* The number of minor collections an object survives before promotion. */
+#define ME_GC_PROMOTE_AGE           2
+
+/* The old generation size below which no major collection is triggered. */
+#define ME_GC_OLD_MIN_BYTES         (4 * 1024 * 1024)
+
+/* The old generation may grow to this percentage of its live size before the
+   next major collection. */
+#define ME_GC_OLD_GROWTH_PERCENT    200
+
+/* The bytes of objects visited by each step of an incremental major
+   collection, `0` collects the old generation in a single pause. */
+#ifndef ME_GC_STEP_BUDGET
+#define ME_GC_STEP_BUDGET           0
+#endif
+
+/* The size of the slabs that memory pools carve small blocks from. */
+#define ME_POOL_SLAB_SIZE           (64 * 1024)
+
+/* The number of freed blocks each thread keeps for reuse in the cache of
+   each small object type, `0` disables the caches. */
+#ifndef ME_MEM_CACHE_MAX
+#define ME_MEM_CACHE_MAX            256
+#endif
+
+/* Whether allocations are accounted per subsystem, see `MeMem_Stats`. */
+#ifndef ME_MEM_STATS
+#define ME_MEM_STATS                1
+#endif
+
+/* The live bytes each thread accounts before adding them to the counters
+   shared by all threads, which bounds how much a peak may be missed by. */
+#ifndef ME_MEM_STATS_BATCH
+#define ME_MEM_STATS_BATCH          (64 * 1024)
+#endif
+
+/* A FlexBuf out of room grows to this percentage of its capacity. */
+#ifndef ME_FLEX_BUF_GROWTH_PERCENT
+#define ME_FLEX_BUF_GROWTH_PERCENT  200
+#endif
+
+/* Whether pipeline stages record trace events once `Trace_Enable` is
+   called, `0` compiles the probes out. */
+#ifndef ME_TRACE
+#define ME_TRACE                    1
+#endif
+
+/* The number of trace events each thread keeps before overwriting the
+   oldest, a power of two. */
+#ifndef ME_TRACE_RING_SIZE
+#define ME_TRACE_RING_SIZE          4096
+#endif
+
+/* The default frequency of the profiler samples, in samples per second of
+   CPU time, off any round number to avoid beating with periodic work. */
+#define ME_PROF_HZ                  997
+
+/* The number of samples the profiler keeps, later ones are dropped. */
+#define ME_PROF_MAX_SAMPLES         16384
+
+/* The number of innermost frames each profiler sample records. */
+#define ME_PROF_MAX_DEPTH           64
+
+/* The expected source bytes per token, scanning a whole buffer reserves
+   room for its estimated tokens up front. */
+#define ME_LEX_BYTES_PER_TOKEN      4
+
+/* The most tokens reserved up front, larger inputs grow from there. */
+#define ME_LEX_RESERVE_MAX          1024
+
+/* Strings up to this length are concatenated by copying, longer ones form
+   ropes whose end leaves grow up to it. */
+#define ME_STR_LEAF_MAX             128
+
+/* The most bits a power of integers may take, larger ones fail as running
+   out of memory before any of the work is done. */
+#ifndef ME_BIGINT_MAX_BITS
+#define ME_BIGINT_MAX_BITS          (16 * 1024 * 1024)
+#endif
+
 #endif
\ No newline at end of file
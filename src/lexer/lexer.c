@@ -1,10 +1,18 @@
+#include <limits.h>
 #include <string.h>
 
 #include "lexer.h"
 #include "token.h"
+#include "config.h"
 #include "memory/allocate.h"
 #include "util/fixed_buf.h"
 #include "util/flex_buf.h"
+#include "util/big_int.h"
+#include "util/metrics.h"
+#include "util/trace.h"
+
+_Static_assert(TOK_NUM_TAGS <= METRICS_MAX_TAGS,
+    "metrics must count every token tag");
 
 const char *
 LexErr_ToStr(
@@ -91,6 +99,12 @@ typedef enum _FsmRes {
 
 typedef struct _Lexer {
 
+    /* Allocator of the memory taken while scanning. */
+    const MemAllocator * alloc;
+
+    /* Metrics filled in while scanning, may be `NULL`. */
+    Metrics * metrics;
+
     /* Input-related attributes. */
     struct {
         FixedBuf * src;
@@ -99,6 +113,11 @@ typedef struct _Lexer {
     FsmStat stat;
     FlexBuf * str;
     usize num;
+
+    /* Whether the current number literal overflowed `num`, its digits are
+       then collected in `str`. */
+    bool num_big;
+
     TokSeq * seq;
 
     struct {
@@ -122,41 +141,42 @@ typedef struct _KwTokEnt {
     TokTag tag;
 } KwTokEnt;
 
-/* Keyword token map. */
+/* Keyword token map, read-only so that lexers on any thread share it. */
 static
-KwTokEnt *
+const KwTokEnt * const
 kw_tok_map[] = {
-    (KwTokEnt[]) { { NULL, 0 } },
-    (KwTokEnt[]) { { NULL, 0 } },
-    (KwTokEnt[]) {
+    (const KwTokEnt[]) { { NULL, 0 } },
+    (const KwTokEnt[]) { { NULL, 0 } },
+    (const KwTokEnt[]) {
+        { "fn", TokTag_Fn },
         { "if", TokTag_If },
         { "or", TokTag_Or },
         { NULL, 0 },
     },
-    (KwTokEnt[]) {
+    (const KwTokEnt[]) {
         { "and", TokTag_And },
         { "for", TokTag_For },
         { "let", TokTag_Let },
         { "not", TokTag_Not },
         { NULL, 0 },
     },
-    (KwTokEnt[]) {
+    (const KwTokEnt[]) {
         { "else", TokTag_Else },
         { "true", TokTag_True },
         { NULL, 0 },
     },
-    (KwTokEnt[]) {
+    (const KwTokEnt[]) {
         { "break", TokTag_Break },
         { "false", TokTag_False },
         { "match", TokTag_Match },
         { "while", TokTag_While },
         { NULL, 0 },
     },
-    (KwTokEnt[]) {
+    (const KwTokEnt[]) {
         { "return", TokTag_Return },
         { NULL, 0 },
     },
-    (KwTokEnt[]) {
+    (const KwTokEnt[]) {
         { "continue", TokTag_Continue },
         { NULL, 0 },
     },
@@ -174,6 +194,9 @@ max_kw_tok_len = num_kw_tok_ents - 1;
 
 Lexer *
 Lexer_New(void) {
+    MemTag prev_tag = MeMem_SetTag(MemTag_Lexer);
+    Lexer * lex = NULL;
+
     FixedBuf * in_src = FixedBuf_NewWithLen(0);
     if (in_src == NULL) {
         goto Exit;
@@ -189,21 +212,28 @@ Lexer_New(void) {
         goto FreeStr;
     }
 
+    MeMem_SetTag(MemTag_ErrMsg);
     FlexBuf * err_msg = FlexBuf_New();
+    MeMem_SetTag(MemTag_Lexer);
+
     if (err_msg == NULL) {
         goto FreeSeq;
     }
 
-    Lexer * lex = (Lexer *)MeMem_Malloc(sizeof(Lexer));
+    lex = (Lexer *)MeMem_Malloc(sizeof(Lexer));
     if (lex == NULL) {
         goto FreeErrMsg;
     }
 
+    lex->alloc = MeMem_Current();
+    lex->metrics = NULL;
+
     lex->in.src = in_src;
 
     lex->stat = FsmStat_Idle;
     lex->str = str;
     lex->num = 0;
+    lex->num_big = false;
     lex->seq = seq;
 
     lex->tok.row = 0;
@@ -216,7 +246,7 @@ Lexer_New(void) {
     lex->err.line_no = 0;
     lex->err.col_no = 0;
 
-    return lex;
+    goto Exit;
 
 FreeErrMsg:
     FlexBuf_Free(err_msg);
@@ -231,7 +261,26 @@ FreeSrc:
     FixedBuf_Free(in_src);
 
 Exit:
-    return NULL;
+    MeMem_SetTag(prev_tag);
+
+    return lex;
+}
+
+static
+bool
+Lexer_PushToken(
+    Lexer * lex,
+    Token * tok
+) {
+    if (TokSeq_Push(lex->seq, tok) == false) {
+        return false;
+    }
+
+    if (lex->metrics != NULL) {
+        lex->metrics->toks[tok->tag] += 1;
+    }
+
+    return true;
 }
 
 static
@@ -242,7 +291,7 @@ PushNormalToken(
 ) {
     Token tok;
     Token_Init(&tok, tag, lex->tok.row, lex->tok.off, lex->tok.len);
-    return TokSeq_Push(lex->seq, &tok);
+    return Lexer_PushToken(lex, &tok);
 }
 
 static
@@ -258,7 +307,7 @@ NameToKeyword(
         return false;
     }
 
-    KwTokEnt * ent = kw_tok_map[len];
+    const KwTokEnt * ent = kw_tok_map[len];
     while (ent->str != NULL) {
         if (memcmp(buf, ent->str, len) == 0) {
             *tag = ent->tag;
@@ -285,7 +334,10 @@ PushNameToken(
     FixedBuf * str = NULL;
 
     if (NameToKeyword(name_buf, name_len, &tok.tag) == false) {
+        MemTag prev_tag = MeMem_SetTag(MemTag_Token);
         str = FlexBuf_ToFixedBuf(lex->str);
+        MeMem_SetTag(prev_tag);
+
         if (str == NULL) {
             goto Exit;
         }
@@ -293,7 +345,7 @@ PushNameToken(
         tok.ext.name.str = str;
     }
 
-    if (TokSeq_Push(lex->seq, &tok) == false) {
+    if (Lexer_PushToken(lex, &tok) == false) {
         goto Exit;
     }
 
@@ -315,8 +367,35 @@ PushNumberToken(
     Token tok;
     Token_Init(&tok, TokTag_NumLit, lex->tok.row, lex->tok.off, lex->tok.len);
     tok.ext.num_lit.val = lex->num;
+    tok.ext.num_lit.big = NULL;
+
+    if (lex->num_big) {
+        MemTag prev_tag = MeMem_SetTag(MemTag_Token);
+        tok.ext.num_lit.big = BigInt_NewFromDec(FlexBuf_Data(lex->str),
+            FlexBuf_Size(lex->str));
+        MeMem_SetTag(prev_tag);
+
+        if (tok.ext.num_lit.big == NULL) {
+            goto Exit;
+        }
+
+        FlexBuf_Clear(lex->str);
+        lex->num_big = false;
+    }
+
+    if (Lexer_PushToken(lex, &tok) == false) {
+        goto FreeBig;
+    }
+
+    return true;
 
-    return TokSeq_Push(lex->seq, &tok);
+FreeBig:
+    if (tok.ext.num_lit.big != NULL) {
+        BigInt_Free(tok.ext.num_lit.big);
+    }
+
+Exit:
+    return false;
 }
 
 static
@@ -324,7 +403,10 @@ bool
 PushStringLiteralToken(
     Lexer * lex
 ) {
+    MemTag prev_tag = MeMem_SetTag(MemTag_Token);
     FixedBuf * _str = FlexBuf_ToFixedBuf(lex->str);
+    MeMem_SetTag(prev_tag);
+
     if (_str == NULL) {
         goto Exit;
     }
@@ -333,7 +415,7 @@ PushStringLiteralToken(
     Token_Init(&tok, TokTag_StrLit, lex->tok.row, lex->tok.off, lex->tok.len);
     tok.ext.str_lit.str = _str;
 
-    if (TokSeq_Push(lex->seq, &tok) == false) {
+    if (Lexer_PushToken(lex, &tok) == false) {
         goto FreeStr;
     }
 
@@ -346,6 +428,18 @@ Exit:
     return false;
 }
 
+static
+inline
+bool
+IsNameByte(
+    u8 byte
+) {
+    return (byte >= '0' && byte <= '9') ||
+           (byte >= 'A' && byte <= 'Z') ||
+           (byte >= 'a' && byte <= 'z') ||
+           byte == '_';
+}
+
 #define RAISE_NO_ENOUGH_MEMORY_ERROR()  \
     lex->err.type = LexErr_NoEnoughMemory;  \
     return FsmRes_Error;
@@ -466,6 +560,7 @@ Lexer_FeedByte_Idle(
         case '%': tag = TokTag_Percent; break;
         case '^': tag = TokTag_Exponent; break;
         case ';': tag = TokTag_Semicolon; break;
+        case ',': tag = TokTag_Comma; break;
         default: found = false; break;
         }
 
@@ -515,10 +610,7 @@ Lexer_FeedByte_Name(
 ) {
 
     /* If this is a remaining character of a name. */
-    if ((byte >= '0' && byte <= '9') ||
-        (byte >= 'A' && byte <= 'Z') ||
-        (byte >= 'a' && byte <= 'z') ||
-        byte == '_') {
+    if (IsNameByte(byte)) {
 
         /* Push this character to the string buffer. */
         if (FlexBuf_PushByte(lex->str, byte) == false) {
@@ -550,8 +642,24 @@ Lexer_FeedByte_Num(
 
     /* If this is the remaining character of a number. */
     if (byte >= '0' && byte <= '9') {
-        lex->num *= 10;
-        lex->num += byte - '0';
+        usize digit = byte - '0';
+
+        if (lex->num_big) {
+            if (FlexBuf_PushByte(lex->str, byte) == false) {
+                RAISE_NO_ENOUGH_MEMORY_ERROR();
+            }
+        } else if (lex->num > (SSIZE_MAX - digit) / 10) {
+
+            /* Too large for `ssize`, keep the digits for a big integer. */
+            FlexBuf_Clear(lex->str);
+            if (FlexBuf_PushFmt(lex->str, "%zu%c", lex->num, byte) == false) {
+                RAISE_NO_ENOUGH_MEMORY_ERROR();
+            }
+
+            lex->num_big = true;
+        } else {
+            lex->num = lex->num * 10 + digit;
+        }
 
         lex->tok.len++;
 
@@ -936,10 +1044,20 @@ Lexer_FeedEol(
     return res;
 }
 
+/**
+ * @brief Describes a byte for diagnostics.
+ *
+ * @param byte The byte.
+ * @param buf A buffer the description may be written to, so that lexers on
+ *            other threads do not share it.
+ *
+ * @return The description, either `buf` or a string literal.
+ */
 static
 const char *
 ByteToStr(
-    u8 byte
+    u8 byte,
+    char buf[8]
 ) {
     if (byte < 0x20) {
         switch (byte) {
@@ -961,15 +1079,21 @@ ByteToStr(
         if (byte == '\'') {
             return "'\\''";
         } else {
-            static char buf[4] = { '\'', ' ', '\'', '\0' };
-            buf[1] = byte;
+            buf[0] = '\'';
+            buf[1] = (char)byte;
+            buf[2] = '\'';
+            buf[3] = '\0';
             return buf;
         }
     } else if (byte > 0x7F) {
-        const char TABLE[] = "01234567890ABCDEF";
-        static char buf[7] = { '\'', '\\', 'x', '0', '0', '\'', '\0' };
+        const char TABLE[] = "0123456789ABCDEF";
+        buf[0] = '\'';
+        buf[1] = '\\';
+        buf[2] = 'x';
         buf[3] = TABLE[byte >> 4];
         buf[4] = TABLE[byte & 0x0F];
+        buf[5] = '\'';
+        buf[6] = '\0';
         return buf;
     } else {
         return "DEL";
@@ -986,6 +1110,7 @@ Lexer_SetErrorInfo(
     FlexBuf * msg = lex->err.msg;
     const LexErr err = lex->err.type;
     const char * const err_msg = LexErr_ToStr(err);
+    char byte_buf[8];
 
     usize row_no = lex->tok.row + 1;
     usize col_no = lex->tok.col + 1;
@@ -1003,7 +1128,8 @@ Lexer_SetErrorInfo(
         FlexBuf_PushFmt(msg, "%.*s:%zu:%zu: %s: %s %s",
             (int)FixedBuf_Size(lex->in.src),
             (char *)FixedBuf_Data(lex->in.src),
-            row_no, col_no, PREFIX, err_msg, ByteToStr(byte));
+            row_no, col_no, PREFIX, err_msg,
+            ByteToStr(byte, byte_buf));
         break;
     }
 
@@ -1011,13 +1137,94 @@ Lexer_SetErrorInfo(
     lex->err.col_no = col_no;
 }
 
+static
+void
+Lexer_SetNoEnoughMemoryError(
+    Lexer * lex
+) {
+    lex->err.type = LexErr_NoEnoughMemory;
+    Lexer_SetErrorInfo(lex, 0);
+}
+
+/**
+ * @brief Copies the run of bytes continuing the current name or string
+ *        literal into the string buffer at once.
+ *
+ * The run stops before the first byte the state machine has to handle, so
+ * the result is the same as feeding the bytes one by one.
+ *
+ * @return The number of bytes consumed, or `(usize)-1` if memory allocation
+ *         fails.
+ */
+static
+usize
+Lexer_FeedRun(
+    Lexer * lex,
+    const u8 * buf,
+    usize len
+) {
+    usize run = 0;
+
+    if (lex->stat == FsmStat_Name) {
+        while (run < len && IsNameByte(buf[run])) {
+            run++;
+        }
+    } else if (lex->stat == FsmStat_StrLit) {
+        while (run < len &&
+               buf[run] != '"' &&
+               buf[run] != '\r' &&
+               buf[run] != '\n') {
+            run++;
+        }
+    }
+
+    if (run == 0) {
+        return 0;
+    }
+
+    u8 * tail = FlexBuf_ReserveTail(lex->str, run);
+    if (tail == NULL) {
+        return (usize)-1;
+    }
+
+    memcpy(tail, buf, run);
+    FlexBuf_Commit(lex->str, run);
+
+    lex->tok.len += run;
+    lex->tok.col += run;
+
+    return run;
+}
+
+static
 bool
-Lexer_Feed(
+Lexer_FeedBytes(
     Lexer * lex,
     const void * buf,
     usize len
 ) {
+    if (lex->metrics != NULL) {
+        lex->metrics->bytes_scanned += len;
+    }
+
     for (usize i = 0; i < len; i++) {
+
+        /* Names and string literals are copied a run at a time. */
+        if (lex->stat == FsmStat_Name ||
+            lex->stat == FsmStat_StrLit) {
+
+            usize run = Lexer_FeedRun(lex, (const u8 *)buf + i, len - i);
+            if (run == (usize)-1) {
+                Lexer_SetNoEnoughMemoryError(lex);
+                return false;
+            }
+
+            i += run;
+            if (i == len) {
+                break;
+            }
+        }
+
         u8 byte = ((const u8 *)buf)[i];
 
         while (true) {
@@ -1036,6 +1243,28 @@ Lexer_Feed(
     return true;
 }
 
+bool
+Lexer_Feed(
+    Lexer * lex,
+    const void * buf,
+    usize len
+) {
+    const MemAllocator * prev = MeMem_Use(lex->alloc);
+    MemTag prev_tag = MeMem_SetTag(MemTag_Lexer);
+    MetricsSpan span;
+
+    bool traced = Trace_Begin("Lexer_Feed");
+    Metrics_Begin(lex->metrics, &span);
+    bool res = Lexer_FeedBytes(lex, buf, len);
+    Metrics_End(lex->metrics, MetricsPhase_Lex, &span);
+    Trace_End("Lexer_Feed", traced);
+
+    MeMem_SetTag(prev_tag);
+    MeMem_Use(prev);
+
+    return res;
+}
+
 static
 void
 Lexer_ResetFsmInfo(
@@ -1046,6 +1275,7 @@ Lexer_ResetFsmInfo(
     lex->stat = FsmStat_Idle;
     FlexBuf_Clear(lex->str);
     lex->num = 0;
+    lex->num_big = false;
     TokSeq_Clear(lex->seq);
 }
 
@@ -1071,8 +1301,9 @@ Lexer_ResetErrorInfo(
     lex->err.col_no = 0;
 }
 
+static
 bool
-Lexer_Finalize(
+Lexer_FinalizeSeq(
     Lexer * lex,
     TokSeq ** seq
 ) {
@@ -1092,16 +1323,19 @@ Lexer_Finalize(
     lex->tok.len = 0;
 
     if (PushNormalToken(lex, TokTag_Eof) == false) {
+        Lexer_SetNoEnoughMemoryError(lex);
         return false;
     }
 
     TokSeq * new_seq = TokSeq_New();
     if (new_seq == NULL) {
+        Lexer_SetNoEnoughMemoryError(lex);
         return false;
     }
 
     FlexBuf_Clear(lex->str);
     lex->num = 0;
+    lex->num_big = false;
 
     TokSeq * res_seq = lex->seq;
     lex->seq = new_seq;
@@ -1113,6 +1347,27 @@ Lexer_Finalize(
     return true;
 }
 
+bool
+Lexer_Finalize(
+    Lexer * lex,
+    TokSeq ** seq
+) {
+    const MemAllocator * prev = MeMem_Use(lex->alloc);
+    MemTag prev_tag = MeMem_SetTag(MemTag_Lexer);
+    MetricsSpan span;
+
+    bool traced = Trace_Begin("Lexer_Finalize");
+    Metrics_Begin(lex->metrics, &span);
+    bool res = Lexer_FinalizeSeq(lex, seq);
+    Metrics_End(lex->metrics, MetricsPhase_Lex, &span);
+    Trace_End("Lexer_Finalize", traced);
+
+    MeMem_SetTag(prev_tag);
+    MeMem_Use(prev);
+
+    return res;
+}
+
 static
 bool
 Lexer_FeedAndFinalize(
@@ -1127,10 +1382,22 @@ Lexer_FeedAndFinalize(
     FixedBuf * old_src = lex->in.src;
     lex->in.src = src;
 
+    /* The whole input is known, so room for its estimated tokens is
+       reserved at once rather than grown token by token. The estimate is
+       capped, as a large input would otherwise take its worst case up
+       front, and only a hint: a failed reserve leaves the normal growth. */
+    usize num_toks = len / ME_LEX_BYTES_PER_TOKEN + 1;
+
+    if (num_toks > ME_LEX_RESERVE_MAX) {
+        num_toks = ME_LEX_RESERVE_MAX;
+    }
+
+    TokSeq_Reserve(lex->seq, num_toks);
+
     /* Feed and finalize. */
     TokSeq * seq = NULL;
-    if (Lexer_Feed(lex, buf, len) == false ||
-        Lexer_Finalize(lex, &seq) == false) {
+    if (Lexer_FeedBytes(lex, buf, len) == false ||
+        Lexer_FinalizeSeq(lex, &seq) == false) {
 
         goto SwapSrc;
     }
@@ -1138,6 +1405,7 @@ Lexer_FeedAndFinalize(
     /* Generate lexer output. */
     LexOut * new_lo = LexOut_New(src, seq);
     if (new_lo == NULL) {
+        Lexer_SetNoEnoughMemoryError(lex);
         goto FreeSeq;
     }
 
@@ -1157,15 +1425,18 @@ SwapSrc:
     return false;
 }
 
+static
 bool
-Lexer_ScanBuf(
+Lexer_ScanBufWithSrc(
     Lexer * lex,
+    const char * name,
     const void * buf,
     usize len,
     LexOut ** lo
 ) {
-    FixedBuf * src = FixedBuf_NewFromStr("<buffer>");
+    FixedBuf * src = FixedBuf_NewFromStr(name);
     if (src == NULL) {
+        Lexer_SetNoEnoughMemoryError(lex);
         goto Exit;
     }
 
@@ -1183,7 +1454,59 @@ Exit:
 }
 
 bool
-Lexer_ScanFile(
+Lexer_ScanBuf(
+    Lexer * lex,
+    const void * buf,
+    usize len,
+    LexOut ** lo
+) {
+    const MemAllocator * prev = MeMem_Use(lex->alloc);
+    MemTag prev_tag = MeMem_SetTag(MemTag_Lexer);
+    MetricsSpan span;
+
+    bool traced = Trace_Begin("Lexer_ScanBuf");
+    Metrics_Begin(lex->metrics, &span);
+    bool res = Lexer_ScanBufWithSrc(lex, "<buffer>", buf, len, lo);
+    Metrics_End(lex->metrics, MetricsPhase_Lex, &span);
+    Trace_End("Lexer_ScanBuf", traced);
+
+    MeMem_SetTag(prev_tag);
+    MeMem_Use(prev);
+
+    return res;
+}
+
+/**
+ * @brief Scans a buffer holding the contents of a named source, such as a
+ *        file read beforehand, diagnostics then refer to the name.
+ */
+bool
+Lexer_ScanSrc(
+    Lexer * lex,
+    const char * name,
+    const void * buf,
+    usize len,
+    LexOut ** lo
+) {
+    const MemAllocator * prev = MeMem_Use(lex->alloc);
+    MemTag prev_tag = MeMem_SetTag(MemTag_Lexer);
+    MetricsSpan span;
+
+    bool traced = Trace_Begin("Lexer_ScanSrc");
+    Metrics_Begin(lex->metrics, &span);
+    bool res = Lexer_ScanBufWithSrc(lex, name, buf, len, lo);
+    Metrics_End(lex->metrics, MetricsPhase_Lex, &span);
+    Trace_End("Lexer_ScanSrc", traced);
+
+    MeMem_SetTag(prev_tag);
+    MeMem_Use(prev);
+
+    return res;
+}
+
+static
+bool
+Lexer_ScanFileWithSrc(
     Lexer * lex,
     const char * path,
     LexOut ** lo
@@ -1198,6 +1521,7 @@ Lexer_ScanFile(
 
     FixedBuf * src = FixedBuf_NewFromStr(path);
     if (src == NULL) {
+        Lexer_SetNoEnoughMemoryError(lex);
         goto FreeFileData;
     }
 
@@ -1219,6 +1543,52 @@ Exit:
     return false;
 }
 
+bool
+Lexer_ScanFile(
+    Lexer * lex,
+    const char * path,
+    LexOut ** lo
+) {
+    const MemAllocator * prev = MeMem_Use(lex->alloc);
+    MemTag prev_tag = MeMem_SetTag(MemTag_Lexer);
+    MetricsSpan span;
+
+    bool traced = Trace_Begin("Lexer_ScanFile");
+    Metrics_Begin(lex->metrics, &span);
+    bool res = Lexer_ScanFileWithSrc(lex, path, lo);
+    Metrics_End(lex->metrics, MetricsPhase_Lex, &span);
+    Trace_End("Lexer_ScanFile", traced);
+
+    MeMem_SetTag(prev_tag);
+    MeMem_Use(prev);
+
+    return res;
+}
+
+/**
+ * @brief Sets the allocator of the memory the lexer takes while scanning,
+ *        which defaults to the allocator in scope when it was created.
+ */
+void
+Lexer_SetAllocator(
+    Lexer * lex,
+    const MemAllocator * alloc
+) {
+    lex->alloc = alloc;
+}
+
+/**
+ * @brief Installs metrics the lexer adds its time, bytes and tokens to, or
+ *        `NULL` to stop collecting them.
+ */
+void
+Lexer_SetMetrics(
+    Lexer * lex,
+    Metrics * metrics
+) {
+    lex->metrics = metrics;
+}
+
 LexErr
 Lexer_ErrorType(
     Lexer * lex
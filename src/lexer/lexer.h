@@ -3,6 +3,7 @@
 
 #include "menos.h"
 #include "lexer/token.h"
+#include "memory/allocate.h"
 
 typedef enum _LexErr {
     LexErr_Ok,
@@ -40,6 +41,8 @@ LexOut_Free(
 
 typedef struct _Lexer Lexer;
 
+typedef struct _Metrics Metrics;
+
 Lexer *
 Lexer_New(void);
 
@@ -64,6 +67,15 @@ Lexer_ScanBuf(
     LexOut ** lo
 );
 
+bool
+Lexer_ScanSrc(
+    Lexer * lex,
+    const char * name,
+    const void * buf,
+    usize len,
+    LexOut ** lo
+);
+
 bool
 Lexer_ScanFile(
     Lexer * lex,
@@ -71,6 +83,18 @@ Lexer_ScanFile(
     LexOut ** lo
 );
 
+void
+Lexer_SetAllocator(
+    Lexer * lex,
+    const MemAllocator * alloc
+);
+
+void
+Lexer_SetMetrics(
+    Lexer * lex,
+    Metrics * metrics
+);
+
 LexErr
 Lexer_ErrorType(
     Lexer * lex
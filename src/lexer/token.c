@@ -1,3 +1,4 @@
+#include <stdint.h>
 #include <string.h>
 
 #include "token.h"
@@ -25,6 +26,7 @@ TokTag_ToStr(
     case TokTag_Break: return "break";
     case TokTag_Continue: return "continue";
     case TokTag_Return: return "return";
+    case TokTag_Fn: return "fn";
     case TokTag_Assign: return "=";
     case TokTag_Plus: return "+";
     case TokTag_Minus: return "-";
@@ -45,6 +47,7 @@ TokTag_ToStr(
     case TokTag_LeftBrace: return "{";
     case TokTag_RightBrace: return "}";
     case TokTag_Semicolon: return ";";
+    case TokTag_Comma: return ",";
     case TokTag_Name: return "Name";
     case TokTag_NumLit: return "NumericLiteral";
     case TokTag_StrLit: return "StringLiteral";
@@ -88,58 +91,81 @@ Token_Length(
     return tok->len;
 }
 
+/* Appends the ` @row:col+len>` suffix of a token. */
+static
+bool
+Token_PushPosAsStr(
+    Token * tok,
+    FlexBuf * buf
+) {
+    return FlexBuf_PushBuf(buf, " @", 2) &&
+        FlexBuf_PushUInt(buf, tok->row) &&
+        FlexBuf_PushByte(buf, ':') &&
+        FlexBuf_PushUInt(buf, tok->col) &&
+        FlexBuf_PushByte(buf, '+') &&
+        FlexBuf_PushUInt(buf, tok->len) &&
+        FlexBuf_PushByte(buf, '>');
+}
+
+/**
+ * @brief Formats a token as a string and appends it to a FlexBuf.
+ *
+ * Tokens are dumped in bulk, so they are appended piece by piece rather
+ * than through `FlexBuf_PushFmt`.
+ */
 bool
 Token_PushAsStr(
     Token * tok,
     FlexBuf * buf
 ) {
-    do {
-        switch (tok->tag) {
-        case TokTag_Name:
-            return FlexBuf_PushFmt(buf, "<%s \"%.*s\" @%zu:%zu+%zu>",
-                TokTag_ToStr(tok->tag),
-                FixedBuf_Size(tok->ext.name.str),
-                FixedBuf_Data(tok->ext.name.str),
-                tok->row, tok->col, tok->len);
-
-        case TokTag_NumLit:
-            return FlexBuf_PushFmt(buf, "<%s %zu @%zu:%zu+%zu>",
-                TokTag_ToStr(tok->tag),
-                tok->ext.num_lit.val,
-                tok->row, tok->col, tok->len);
-
-        case TokTag_StrLit: {
-            FixedBuf * escaped_str =
-                FixedBuf_Escape(tok->ext.str_lit.str);
-            if (escaped_str == NULL) {
-                return false;
-            }
+    const char * str = TokTag_ToStr(tok->tag);
 
-            bool res = FlexBuf_PushFmt(buf, "<%s \"%.*s\" @%zu:%zu+%zu>",
-                TokTag_ToStr(tok->tag),
-                FixedBuf_Size(escaped_str),
-                FixedBuf_Data(escaped_str),
-                tok->row, tok->col, tok->len);
+    switch (tok->tag) {
+    case TokTag_Name:
+        return FlexBuf_PushByte(buf, '<') &&
+            FlexBuf_PushStr(buf, str) &&
+            FlexBuf_PushBuf(buf, " \"", 2) &&
+            FlexBuf_PushBuf(buf, FixedBuf_Data(tok->ext.name.str),
+                FixedBuf_Size(tok->ext.name.str)) &&
+            FlexBuf_PushByte(buf, '"') &&
+            Token_PushPosAsStr(tok, buf);
 
-            FixedBuf_Free(escaped_str);
+    case TokTag_NumLit:
+        if (FlexBuf_PushByte(buf, '<') == false ||
+            FlexBuf_PushStr(buf, str) == false ||
+            FlexBuf_PushByte(buf, ' ') == false) {
 
-            return res;
+            return false;
         }
 
-        default:
-            break;
+        if (tok->ext.num_lit.big != NULL) {
+            return BigInt_PushAsStr(tok->ext.num_lit.big, buf) &&
+                Token_PushPosAsStr(tok, buf);
         }
-    } while (false);
 
-    if (tok->tag == TokTag_Eof) {
-        const char * str = TokTag_ToStr(tok->tag);
-        return FlexBuf_PushFmt(buf, "<Keyword %s @%zu:%zu+%zu>",
-            str, tok->row, tok->col, tok->len);
-    }
+        return FlexBuf_PushUInt(buf, tok->ext.num_lit.val) &&
+            Token_PushPosAsStr(tok, buf);
 
-    const char * str = TokTag_ToStr(tok->tag);
-    return FlexBuf_PushFmt(buf, "<Keyword '%s' @%zu:%zu+%zu>",
-        str, tok->row, tok->col, tok->len);
+    case TokTag_StrLit:
+        return FlexBuf_PushByte(buf, '<') &&
+            FlexBuf_PushStr(buf, str) &&
+            FlexBuf_PushBuf(buf, " \"", 2) &&
+            FlexBuf_PushEscaped(buf, FixedBuf_Data(tok->ext.str_lit.str),
+                FixedBuf_Size(tok->ext.str_lit.str)) &&
+            FlexBuf_PushByte(buf, '"') &&
+            Token_PushPosAsStr(tok, buf);
+
+    case TokTag_Eof:
+        return FlexBuf_PushStr(buf, "<Keyword ") &&
+            FlexBuf_PushStr(buf, str) &&
+            Token_PushPosAsStr(tok, buf);
+
+    default:
+        return FlexBuf_PushStr(buf, "<Keyword '") &&
+            FlexBuf_PushStr(buf, str) &&
+            FlexBuf_PushByte(buf, '\'') &&
+            Token_PushPosAsStr(tok, buf);
+    }
 }
 
 static
@@ -159,6 +185,7 @@ Token_Free(
     case TokTag_Break:
     case TokTag_Continue:
     case TokTag_Return:
+    case TokTag_Fn:
     case TokTag_Assign:
     case TokTag_Plus:
     case TokTag_Minus:
@@ -177,6 +204,7 @@ Token_Free(
     case TokTag_LeftBrace:
     case TokTag_RightBrace:
     case TokTag_Semicolon:
+    case TokTag_Comma:
         break;
 
     case TokTag_Name:
@@ -184,6 +212,9 @@ Token_Free(
         break;
 
     case TokTag_NumLit:
+        if (tok->ext.num_lit.big != NULL) {
+            BigInt_Free(tok->ext.num_lit.big);
+        }
         break;
 
     case TokTag_StrLit:
@@ -200,14 +231,22 @@ typedef struct _TokSeq {
     usize num;
 } TokSeq;
 
+/* Headers are recycled by the thread freeing them. */
+static
+_Thread_local MemCache
+tok_seq_cache = MEM_CACHE_INIT(sizeof(TokSeq));
+
 TokSeq *
 TokSeq_New(void) {
+    MemTag prev_tag = MeMem_SetTag(MemTag_Token);
+    TokSeq * seq = NULL;
+
     FlexBuf * buf = FlexBuf_New();
     if (buf == NULL) {
         goto Exit;
     }
 
-    TokSeq * seq = (TokSeq *)MeMem_Malloc(sizeof(TokSeq));
+    seq = (TokSeq *)MeMem_CacheAlloc(&tok_seq_cache);
     if (seq == NULL) {
         goto FreeFlexBuf;
     }
@@ -215,13 +254,15 @@ TokSeq_New(void) {
     seq->buf = buf;
     seq->num = 0;
 
-    return seq;
+    goto Exit;
 
 FreeFlexBuf:
     FlexBuf_Free(buf);
 
 Exit:
-    return NULL;
+    MeMem_SetTag(prev_tag);
+
+    return seq;
 }
 
 bool
@@ -238,6 +279,23 @@ TokSeq_Push(
     return true;
 }
 
+/**
+ * @brief Reserves room for at least `num` more tokens in a TokSeq.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+TokSeq_Reserve(
+    TokSeq * seq,
+    usize num
+) {
+    if (num > SIZE_MAX / sizeof(Token)) {
+        return false;
+    }
+
+    return FlexBuf_Reserve(seq->buf, num * sizeof(Token));
+}
+
 Token *
 TokSeq_Data(
     TokSeq * seq
@@ -264,13 +322,6 @@ TokSeq_At(
     return (Token *)FlexBuf_Data(seq->buf) + idx;
 }
 
-bool
-TokSeq_Compact(
-    TokSeq * seq
-) {
-    return FlexBuf_Compact(seq->buf);
-}
-
 /**
  * @brief Formats a TokSeq object as a string and appends it to a FlexBuf.
  *
@@ -382,5 +433,5 @@ TokSeq_Free(
 ) {
     TokSeq_FreeTokens(seq);
     FlexBuf_Free(seq->buf);
-    MeMem_Free(seq);
+    MeMem_CacheFree(&tok_seq_cache, seq);
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "menos.h"
 #include "util/fixed_buf.h"
 #include "util/flex_buf.h"
+#include "util/big_int.h"
 
 /* Token tag, the type of token. */
 typedef enum _TokTag {
@@ -23,6 +24,7 @@ typedef enum _TokTag {
     TokTag_Break,
     TokTag_Continue,
     TokTag_Return,
+    TokTag_Fn,
 
     /* Symbols. */
     TokTag_Assign,
@@ -45,6 +47,7 @@ typedef enum _TokTag {
     TokTag_RightBrace,
     TokTag_LeftBrace,
     TokTag_Semicolon,
+    TokTag_Comma,
 
     TokTag_Name,
     TokTag_NumLit,
@@ -53,6 +56,8 @@ typedef enum _TokTag {
     TokTag_Eof,
 } TokTag;
 
+#define TOK_NUM_TAGS    (TokTag_Eof + 1)
+
 const char *
 TokTag_ToStr(
     TokTag tag
@@ -86,8 +91,11 @@ typedef struct _Token {
         /* Number literal token. */
         struct {
 
-            /* Number value. */
+            /* Number value, only valid if `big` is `NULL`. */
             usize val;
+
+            /* Owned value of a literal that does not fit in `ssize`. */
+            BigInt * big;
         } num_lit;
 
         /* String literal token. */
@@ -141,6 +149,12 @@ TokSeq_Push(
     Token * tok
 );
 
+bool
+TokSeq_Reserve(
+    TokSeq * seq,
+    usize num
+);
+
 Token *
 TokSeq_Data(
     TokSeq * seq
@@ -157,11 +171,6 @@ TokSeq_At(
     usize idx
 );
 
-bool
-TokSeq_Compact(
-    TokSeq * seq
-);
-
 bool
 TokSeq_PushAsStr(
     TokSeq * seq,
@@ -1,18 +1,739 @@
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 
 #include "allocate.h"
+#include "config.h"
 
+/* Prefix of every block, it records the allocator owning the block so that
+   it is released by that allocator wherever it is freed. */
+typedef struct _MemHdr {
+    _Alignas(max_align_t) const MemAllocator * alloc;
+    u64 size : 56;
+    u64 tag : 8;
+} MemHdr;
+
+/* The largest block, its size must fit in the header. */
+#define MEM_MAX_SIZE (((u64)1 << 56) - 1 - sizeof(MemHdr))
+
+const char *
+MemTag_ToStr(
+    MemTag tag
+) {
+    switch (tag) {
+    case MemTag_Other: return "other";
+    case MemTag_Lexer: return "lexer";
+    case MemTag_Token: return "token";
+    case MemTag_Ast: return "ast";
+    case MemTag_Buffer: return "buffer";
+    case MemTag_ErrMsg: return "error message";
+    case MemTag_Runtime: return "runtime";
+    }
+}
+
+/* Blocks allocated by the current thread, see `MeMem_ThreadAllocs`. */
+static
+_Thread_local u64
+thread_allocs = 0;
+
+/* Subsystem new allocations of the current thread are accounted to. */
+static
+_Thread_local MemTag
+scoped_tag = MemTag_Other;
+
+/**
+ * @brief Sets the subsystem the following allocations of the current thread
+ *        are accounted to.
+ *
+ * @return The previous tag, to be restored with another call.
+ */
+MemTag
+MeMem_SetTag(
+    MemTag tag
+) {
+    MemTag prev = scoped_tag;
+
+    scoped_tag = tag;
+
+    return prev;
+}
+
+/**
+ * @brief Sets the tag unless a more specific one than `MemTag_Other` is
+ *        already in scope.
+ */
+MemTag
+MeMem_SetTagIfOther(
+    MemTag tag
+) {
+    MemTag prev = scoped_tag;
+
+    if (prev == MemTag_Other) {
+        scoped_tag = tag;
+    }
+
+    return prev;
+}
+
+MemTag
+MeMem_TagOf(
+    void * ptr
+) {
+    return (MemTag)((MemHdr *)ptr - 1)->tag;
+}
+
+#if ME_MEM_STATS
+
+/* Counters of one subsystem in a shard. */
+typedef struct _MemTagShard {
+    atomic_uint_least64_t num_allocs;
+    atomic_uint_least64_t num_frees;
+    atomic_uint_least64_t hist[MEM_NUM_BUCKETS];
+
+    /* Live bytes not yet added to the shared counters, negative when more
+       was freed than allocated. */
+    atomic_llong pending;
+} MemTagShard;
+
+/* Counters of one thread, so that threads allocating at once do not write
+   to the same cache lines. */
+typedef struct _MemShard {
+    MemTagShard tags[MEM_NUM_TAGS];
+    struct _MemShard * next;
+} MemShard;
+
+/* Counters shared by every thread, updated once per
+   `ME_MEM_STATS_BATCH` bytes of a shard. */
+typedef struct _MemTagCounters {
+    atomic_size_t live_bytes;
+    atomic_size_t peak_bytes;
+} MemTagCounters;
+
+static
+MemTagCounters
+tag_counters[MEM_NUM_TAGS];
+
+/* Shard of the threads that cannot allocate one of their own. */
+static
+MemShard
+shared_shard;
+
+/* Shards of the live threads, and the counts of the exited ones. */
+static
+MemShard *
+shards = &shared_shard;
+
+static
+MemTagStats
+retired[MEM_NUM_TAGS];
+
+static
+pthread_mutex_t
+shard_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static
+_Thread_local MemShard *
+thread_shard = NULL;
+
+static
+pthread_key_t
+shard_key;
+
+static
+pthread_once_t
+shard_key_once = PTHREAD_ONCE_INIT;
+
+static
+void
+MemTagShard_Flush(
+    MemTagShard * ts,
+    MemTag tag
+) {
+    MemTagCounters * cnt = tag_counters + tag;
+
+    long long delta = atomic_exchange_explicit(&ts->pending, 0,
+        memory_order_relaxed);
+
+    usize live = atomic_fetch_add_explicit(&cnt->live_bytes, (usize)delta,
+        memory_order_relaxed) + (usize)delta;
+    usize peak = atomic_load_explicit(&cnt->peak_bytes, memory_order_relaxed);
+
+    while (delta > 0 &&
+        live > peak &&
+        atomic_compare_exchange_weak_explicit(&cnt->peak_bytes, &peak, live,
+            memory_order_relaxed, memory_order_relaxed) == false) {
+    }
+}
+
+/**
+ * @brief Folds the shard of an exiting thread into the retired counts.
+ */
+static
+void
+MemShard_OnThreadExit(
+    void * arg
+) {
+    MemShard * shard = (MemShard *)arg;
+
+    pthread_mutex_lock(&shard_lock);
+
+    for (usize i = 0; i < MEM_NUM_TAGS; i++) {
+        MemTagShard * ts = shard->tags + i;
+
+        MemTagShard_Flush(ts, (MemTag)i);
+
+        retired[i].num_allocs += atomic_load(&ts->num_allocs);
+        retired[i].num_frees += atomic_load(&ts->num_frees);
+
+        for (usize j = 0; j < MEM_NUM_BUCKETS; j++) {
+            retired[i].hist[j] += atomic_load(ts->hist + j);
+        }
+    }
+
+    MemShard ** link = &shards;
+
+    while (*link != shard) {
+        link = &(*link)->next;
+    }
+
+    *link = shard->next;
+
+    pthread_mutex_unlock(&shard_lock);
+
+    free(shard);
+    thread_shard = NULL;
+}
+
+static
+void
+MemShard_CreateKey(void) {
+    pthread_key_create(&shard_key, MemShard_OnThreadExit);
+}
+
+static
+MemShard *
+MemShard_OfThread(void) {
+    if (thread_shard != NULL) {
+        return thread_shard;
+    }
+
+    /* Zeroed atomics are valid counters. */
+    MemShard * shard = (MemShard *)calloc(1, sizeof(MemShard));
+    if (shard == NULL) {
+        return &shared_shard;
+    }
+
+    pthread_once(&shard_key_once, MemShard_CreateKey);
+
+    if (pthread_setspecific(shard_key, shard) != 0) {
+        free(shard);
+        return &shared_shard;
+    }
+
+    pthread_mutex_lock(&shard_lock);
+    shard->next = shards;
+    shards = shard;
+    pthread_mutex_unlock(&shard_lock);
+
+    thread_shard = shard;
+
+    return shard;
+}
+
+static
+usize
+MemStats_Bucket(
+    usize size
+) {
+    if (size <= 16) {
+        return 0;
+    }
+
+    usize bucket = (usize)(sizeof(unsigned long long) * 8 -
+        __builtin_clzll((unsigned long long)(size - 1))) - 4;
+
+    return bucket < MEM_NUM_BUCKETS ? bucket : MEM_NUM_BUCKETS - 1;
+}
+
+/**
+ * @brief Adds to the pending live bytes of a shard and returns the sum.
+ *
+ * The shard of a thread is only written by that thread, so a relaxed load
+ * and store keep it exact without the locked add, which only the shared
+ * shard needs. Readers still see whole values.
+ */
+static
+inline
+long long
+MemTagShard_AddPending(
+    MemTagShard * ts,
+    long long delta,
+    bool shared
+) {
+    if (shared) {
+        return atomic_fetch_add_explicit(&ts->pending, delta,
+            memory_order_relaxed) + delta;
+    }
+
+    long long pending = atomic_load_explicit(&ts->pending,
+        memory_order_relaxed) + delta;
+    atomic_store_explicit(&ts->pending, pending, memory_order_relaxed);
+
+    return pending;
+}
+
+/**
+ * @brief Increments a counter of a shard, see `MemTagShard_AddPending`.
+ */
+static
+inline
+void
+MemTagShard_Bump(
+    atomic_uint_least64_t * cnt,
+    bool shared
+) {
+    if (shared) {
+        atomic_fetch_add_explicit(cnt, 1, memory_order_relaxed);
+        return;
+    }
+
+    atomic_store_explicit(cnt,
+        atomic_load_explicit(cnt, memory_order_relaxed) + 1,
+        memory_order_relaxed);
+}
+
+static
+void
+MemStats_OnAlloc(
+    MemTag tag,
+    usize size
+) {
+    MemShard * shard = MemShard_OfThread();
+    MemTagShard * ts = shard->tags + tag;
+    bool shared = shard == &shared_shard;
+
+    long long pending = MemTagShard_AddPending(ts, (long long)size, shared);
+
+    if (pending >= ME_MEM_STATS_BATCH) {
+        MemTagShard_Flush(ts, tag);
+    }
+
+    MemTagShard_Bump(&ts->num_allocs, shared);
+    MemTagShard_Bump(ts->hist + MemStats_Bucket(size), shared);
+}
+
+static
+void
+MemStats_OnFree(
+    MemTag tag,
+    usize size
+) {
+    MemShard * shard = MemShard_OfThread();
+    MemTagShard * ts = shard->tags + tag;
+    bool shared = shard == &shared_shard;
+
+    long long pending = MemTagShard_AddPending(ts, -(long long)size, shared);
+
+    if (pending <= -ME_MEM_STATS_BATCH) {
+        MemTagShard_Flush(ts, tag);
+    }
+
+    MemTagShard_Bump(&ts->num_frees, shared);
+}
+
+/**
+ * @brief Sums the live bytes of a subsystem over the shared counters and
+ *        the shards, with the shard lock held.
+ */
+static
+usize
+MemStats_LiveBytes(
+    MemTag tag
+) {
+    usize live = atomic_load(&tag_counters[tag].live_bytes);
+
+    for (MemShard * shard = shards; shard != NULL; shard = shard->next) {
+        live += (usize)atomic_load(&shard->tags[tag].pending);
+    }
+
+    return live;
+}
+
+#else
+
+#define MemStats_OnAlloc(tag, size) ((void)0)
+#define MemStats_OnFree(tag, size) ((void)0)
+
+#endif
+
+/**
+ * @brief Takes a snapshot of the memory accounting of every subsystem.
+ *
+ * Counters are read one by one while other threads may allocate, so the
+ * snapshot is only consistent when they are quiet. Live bytes are exact,
+ * peaks may miss up to `ME_MEM_STATS_BATCH` bytes per thread.
+ */
+void
+MeMem_Stats(
+    MemStats * stats
+) {
+#if ME_MEM_STATS
+    pthread_mutex_lock(&shard_lock);
+#endif
+
+    for (usize i = 0; i < MEM_NUM_TAGS; i++) {
+        MemTagStats * dst = stats->tags + i;
+
+#if ME_MEM_STATS
+        *dst = retired[i];
+
+        dst->live_bytes = MemStats_LiveBytes((MemTag)i);
+        dst->peak_bytes = atomic_load(&tag_counters[i].peak_bytes);
+
+        if (dst->peak_bytes < dst->live_bytes) {
+            dst->peak_bytes = dst->live_bytes;
+        }
+
+        for (MemShard * shard = shards; shard != NULL; shard = shard->next) {
+            MemTagShard * ts = shard->tags + i;
+
+            dst->num_allocs += atomic_load(&ts->num_allocs);
+            dst->num_frees += atomic_load(&ts->num_frees);
+
+            for (usize j = 0; j < MEM_NUM_BUCKETS; j++) {
+                dst->hist[j] += atomic_load(ts->hist + j);
+            }
+        }
+#else
+        *dst = (MemTagStats){ 0 };
+#endif
+    }
+
+#if ME_MEM_STATS
+    pthread_mutex_unlock(&shard_lock);
+#endif
+}
+
+/**
+ * @brief Lowers the peak of every subsystem to its live bytes, to measure
+ *        the peak of the work that follows.
+ */
+void
+MeMem_ResetPeaks(void) {
+#if ME_MEM_STATS
+    pthread_mutex_lock(&shard_lock);
+
+    for (usize i = 0; i < MEM_NUM_TAGS; i++) {
+        atomic_store(&tag_counters[i].peak_bytes,
+            MemStats_LiveBytes((MemTag)i));
+    }
+
+    pthread_mutex_unlock(&shard_lock);
+#endif
+}
+
+
+/**
+ * @brief Returns the number of blocks the current thread has allocated,
+ *        whether or not accounting is built in.
+ *
+ * It only grows, so the blocks allocated by a piece of work are the
+ * difference of two readings.
+ */
+u64
+MeMem_ThreadAllocs(void) {
+    return thread_allocs;
+}
+
+static
 void *
-MeMem_Malloc(usize size) {
+MemLibc_Alloc(
+    void * ctx,
+    usize size
+) {
+    (void)ctx;
+
     return malloc(size);
 }
 
+static
 void *
-MeMem_Realloc(void * ptr, usize size) {
+MemLibc_Realloc(
+    void * ctx,
+    void * ptr,
+    usize old_size,
+    usize size
+) {
+    (void)ctx;
+    (void)old_size;
+
     return realloc(ptr, size);
 }
 
+static
 void
-MeMem_Free(void * ptr) {
+MemLibc_Free(
+    void * ctx,
+    void * ptr,
+    usize size
+) {
+    (void)ctx;
+    (void)size;
+
     free(ptr);
+}
+
+const MemAllocator
+mem_libc_allocator = {
+    .alloc = MemLibc_Alloc,
+    .realloc = MemLibc_Realloc,
+    .free = MemLibc_Free,
+    .ctx = NULL,
+};
+
+static
+const MemAllocator *
+default_alloc = &mem_libc_allocator;
+
+/* Allocator installed for the scope of the current thread, see
+   `MeMem_Use`. */
+static
+_Thread_local const MemAllocator *
+scoped_alloc = NULL;
+
+/**
+ * @brief Installs the allocator used when no allocator is in scope.
+ *
+ * Blocks are always released by the allocator they come from, so the
+ * allocator may change while blocks are live. It must not change while
+ * other threads allocate.
+ *
+ * @param alloc The allocator, or `NULL` for the C library.
+ */
+void
+MeMem_SetAllocator(
+    const MemAllocator * alloc
+) {
+    default_alloc = alloc != NULL ? alloc : &mem_libc_allocator;
+}
+
+/**
+ * @brief Installs an allocator for the allocations of the current thread.
+ *
+ * @param alloc The allocator, or `NULL` for the default allocator.
+ *
+ * @return The allocator previously in scope, to be restored with another
+ *         call.
+ */
+const MemAllocator *
+MeMem_Use(
+    const MemAllocator * alloc
+) {
+    const MemAllocator * prev = scoped_alloc;
+
+    scoped_alloc = alloc;
+
+    return prev;
+}
+
+const MemAllocator *
+MeMem_Current(void) {
+    return scoped_alloc != NULL ? scoped_alloc : default_alloc;
+}
+
+/**
+ * @brief Allocates a block accounted to a given subsystem rather than to
+ *        the one in scope.
+ */
+void *
+MeMem_MallocTagged(usize size, MemTag tag) {
+    if (size > MEM_MAX_SIZE) {
+        return NULL;
+    }
+
+    const MemAllocator * alloc = MeMem_Current();
+
+    MemHdr * hdr = (MemHdr *)alloc->alloc(alloc->ctx, sizeof(MemHdr) + size);
+    if (hdr == NULL) {
+        return NULL;
+    }
+
+    hdr->alloc = alloc;
+    hdr->size = size;
+    hdr->tag = tag;
+
+    thread_allocs += 1;
+    MemStats_OnAlloc(tag, size);
+
+    return hdr + 1;
+}
+
+void *
+MeMem_Malloc(usize size) {
+    return MeMem_MallocTagged(size, scoped_tag);
+}
+
+void *
+MeMem_Realloc(void * ptr, usize size) {
+    if (ptr == NULL) {
+        return MeMem_Malloc(size);
+    }
+
+    if (size > MEM_MAX_SIZE) {
+        return NULL;
+    }
+
+    MemHdr * hdr = (MemHdr *)ptr - 1;
+    const MemAllocator * alloc = hdr->alloc;
+    usize old_size = hdr->size;
+
+    /* The block keeps its tag. */
+    hdr = (MemHdr *)alloc->realloc(alloc->ctx, hdr,
+        sizeof(MemHdr) + old_size, sizeof(MemHdr) + size);
+    if (hdr == NULL) {
+        return NULL;
+    }
+
+    hdr->size = size;
+
+    MemStats_OnFree((MemTag)hdr->tag, old_size);
+    MemStats_OnAlloc((MemTag)hdr->tag, size);
+
+    return hdr + 1;
+}
+
+void
+MeMem_Free(void * ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    MemHdr * hdr = (MemHdr *)ptr - 1;
+    const MemAllocator * alloc = hdr->alloc;
+
+    MemStats_OnFree((MemTag)hdr->tag, hdr->size);
+
+    alloc->free(alloc->ctx, hdr, sizeof(MemHdr) + hdr->size);
+}
+
+/* Caches of the current thread holding blocks. */
+static
+_Thread_local MemCache *
+thread_caches = NULL;
+
+static
+pthread_key_t
+cache_key;
+
+static
+pthread_once_t
+cache_key_once = PTHREAD_ONCE_INIT;
+
+static
+void
+MemCache_OnThreadExit(
+    void * arg
+) {
+    (void)arg;
+
+    MeMem_FlushCaches();
+}
+
+static
+void
+MemCache_CreateKey(void) {
+    pthread_key_create(&cache_key, MemCache_OnThreadExit);
+}
+
+/**
+ * @brief Allocates a block of the size of a cache, reusing a block freed to
+ *        the cache by the current thread if one fits the allocator in scope.
+ */
+void *
+MeMem_CacheAlloc(
+    MemCache * cache
+) {
+    void * ptr = cache->head;
+
+    if (ptr == NULL ||
+        ((MemHdr *)ptr - 1)->alloc != MeMem_Current()) {
+
+        return MeMem_Malloc(cache->size);
+    }
+
+    cache->head = *(void **)ptr;
+    cache->num -= 1;
+
+    /* Cached blocks are accounted as freed. */
+    MemHdr * hdr = (MemHdr *)ptr - 1;
+    hdr->tag = scoped_tag;
+
+    thread_allocs += 1;
+    MemStats_OnAlloc((MemTag)hdr->tag, hdr->size);
+
+    return ptr;
+}
+
+/**
+ * @brief Frees a block allocated with `MeMem_CacheAlloc`.
+ *
+ * Only blocks of the default allocator are kept, up to
+ * `ME_MEM_CACHE_MAX` per cache, so that the blocks of custom allocators
+ * return to them at once.
+ */
+void
+MeMem_CacheFree(
+    MemCache * cache,
+    void * ptr
+) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    MemHdr * hdr = (MemHdr *)ptr - 1;
+
+    if (hdr->alloc != default_alloc ||
+        hdr->size != cache->size ||
+        cache->num >= ME_MEM_CACHE_MAX) {
+
+        MeMem_Free(ptr);
+        return;
+    }
+
+    if (cache->linked == false) {
+        pthread_once(&cache_key_once, MemCache_CreateKey);
+        pthread_setspecific(cache_key, &thread_caches);
+
+        cache->next = thread_caches;
+        thread_caches = cache;
+        cache->linked = true;
+    }
+
+    MemStats_OnFree((MemTag)hdr->tag, hdr->size);
+
+    *(void **)ptr = cache->head;
+    cache->head = ptr;
+    cache->num += 1;
+}
+
+/**
+ * @brief Frees the blocks held by the caches of the current thread, which
+ *        happens when the thread exits.
+ */
+void
+MeMem_FlushCaches(void) {
+    for (MemCache * cache = thread_caches;
+         cache != NULL;
+         cache = cache->next) {
+
+        while (cache->head != NULL) {
+            MemHdr * hdr = (MemHdr *)cache->head - 1;
+            const MemAllocator * alloc = hdr->alloc;
+
+            cache->head = *(void **)cache->head;
+            alloc->free(alloc->ctx, hdr, sizeof(MemHdr) + hdr->size);
+        }
+
+        cache->num = 0;
+    }
 }
\ No newline at end of file
@@ -3,13 +3,131 @@
 
 #include "menos.h"
 
+/* Allocator interface, every function receives the `ctx` of the allocator.
+   Sizes passed to `realloc` and `free` are the ones the memory was last
+   allocated with. */
+typedef struct _MemAllocator {
+    void * (* alloc)(void * ctx, usize size);
+    void * (* realloc)(void * ctx, void * ptr, usize old_size, usize size);
+    void (* free)(void * ctx, void * ptr, usize size);
+    void * ctx;
+} MemAllocator;
+
+/* Subsystem an allocation is accounted to. */
+typedef enum _MemTag {
+    MemTag_Other,
+    MemTag_Lexer,
+    MemTag_Token,
+    MemTag_Ast,
+    MemTag_Buffer,
+    MemTag_ErrMsg,
+    MemTag_Runtime,
+} MemTag;
+
+#define MEM_NUM_TAGS        7
+
+/* Size histogram buckets, bucket `i` counts sizes up to `16 << i` bytes and
+   the last one all larger sizes. */
+#define MEM_NUM_BUCKETS     16
+
+typedef struct _MemTagStats {
+    usize live_bytes;
+    usize peak_bytes;
+    u64 num_allocs;
+    u64 num_frees;
+    u64 hist[MEM_NUM_BUCKETS];
+} MemTagStats;
+
+/* Accounting snapshot, all zero unless built with `ME_MEM_STATS`. */
+typedef struct _MemStats {
+    MemTagStats tags[MEM_NUM_TAGS];
+} MemStats;
+
+const char *
+MemTag_ToStr(
+    MemTag tag
+);
+
+/* The allocator backed by the C library. */
+extern const MemAllocator mem_libc_allocator;
+
+void
+MeMem_SetAllocator(
+    const MemAllocator * alloc
+);
+
+const MemAllocator *
+MeMem_Use(
+    const MemAllocator * alloc
+);
+
+const MemAllocator *
+MeMem_Current(void);
+
+MemTag
+MeMem_SetTag(
+    MemTag tag
+);
+
+MemTag
+MeMem_SetTagIfOther(
+    MemTag tag
+);
+
+MemTag
+MeMem_TagOf(
+    void * ptr
+);
+
+void
+MeMem_Stats(
+    MemStats * stats
+);
+
+void
+MeMem_ResetPeaks(void);
+
+u64
+MeMem_ThreadAllocs(void);
+
 void *
 MeMem_Malloc(usize size);
 
+void *
+MeMem_MallocTagged(usize size, MemTag tag);
+
 void *
 MeMem_Realloc(void * ptr, usize size);
 
 void
 MeMem_Free(void * ptr);
 
+/* Cache of freed blocks of one size, it must be declared `_Thread_local`
+   and initialized with `MEM_CACHE_INIT`. */
+typedef struct _MemCache {
+    usize size;
+    usize num;
+    void * head;
+
+    /* Link in the list of caches flushed when the thread exits. */
+    struct _MemCache * next;
+    bool linked;
+} MemCache;
+
+#define MEM_CACHE_INIT(size) { (size), 0, NULL, NULL, false }
+
+void *
+MeMem_CacheAlloc(
+    MemCache * cache
+);
+
+void
+MeMem_CacheFree(
+    MemCache * cache,
+    void * ptr
+);
+
+void
+MeMem_FlushCaches(void);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,1263 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "gc.h"
+#include "allocate.h"
+#include "config.h"
+
+/* Alignment of object payloads. */
+#define GC_ALIGN 16
+
+/* The number of bytes an object takes in the heap, header included. */
+#define GC_TOTAL_SIZE(size) \
+    (sizeof(GcHeader) + (((size) + GC_ALIGN - 1) & ~(usize)(GC_ALIGN - 1)))
+
+#define GC_HEADER(obj) ((GcHeader *)(obj) - 1)
+
+#define GC_PAYLOAD(hdr) ((void *)((hdr) + 1))
+
+typedef enum _GcGen {
+    GcGen_Young,
+    GcGen_Old,
+} GcGen;
+
+/* Phase of the major collection cycle. */
+typedef enum _GcPhase {
+    GcPhase_Idle,
+
+    /* Objects reached since the cycle started are marked, those whose
+       references are still to be visited are in the mark stack. */
+    GcPhase_Mark,
+
+    /* Unmarked old objects are being freed. */
+    GcPhase_Sweep,
+} GcPhase;
+
+/* Object header, right before the payload. */
+typedef struct _GcHeader {
+    const GcType * type;
+
+    /* Payload size in bytes. */
+    usize size;
+
+    union {
+
+        /* Old objects, the next object of the old generation. */
+        struct _GcHeader * next;
+
+        /* Evacuated young objects, the new payload address. */
+        void * fwd;
+    } link;
+
+    /* The epoch of the last major collection that reached the object. */
+    u32 mark;
+
+    u8 gen;
+
+    /* The number of minor collections survived. */
+    u8 age;
+
+    /* Whether the object is in the remembered set. */
+    bool remembered;
+
+    bool forwarded;
+} GcHeader;
+
+_Static_assert(sizeof(GcHeader) % GC_ALIGN == 0,
+    "object payloads must stay aligned");
+
+/* Bump-pointer region. */
+typedef struct _GcSpace {
+    u8 * base;
+    u8 * top;
+    u8 * end;
+} GcSpace;
+
+/* Growable stack of object headers. */
+typedef struct _GcStack {
+    GcHeader ** buf;
+    usize len;
+    usize cap;
+} GcStack;
+
+/* Sweeps a detached list of old objects on a thread of its own. Only the
+   headers of the objects are touched, which the mutator never writes outside
+   of the mark phase, and only unmarked objects are freed. */
+typedef struct _GcSweeper {
+    pthread_t thread;
+
+    /* Whether the thread runs or has results to collect. */
+    bool active;
+
+    /* Set by the thread when the fields below hold its results. */
+    atomic_bool done;
+
+    u32 epoch;
+
+    /* The detached objects, then the surviving ones. */
+    GcHeader * objs;
+
+    /* The link ending the survivors. */
+    GcHeader ** tail;
+
+    /* The size of the detached objects, kept for the statistics. */
+    usize bytes;
+
+    usize live_bytes;
+    usize freed_bytes;
+} GcSweeper;
+
+typedef struct _Gc {
+
+    /* Young generation, all spaces are carved out of one block. */
+    struct {
+        u8 * block;
+        GcSpace eden;
+
+        /* Survivor semispaces, `surv[cur]` holds the survivors. */
+        GcSpace surv[2];
+        usize cur;
+    } young;
+
+    /* Old generation, individually allocated objects. */
+    struct {
+        GcHeader * objs;
+        usize bytes;
+
+        /* Occupancy that triggers the next major collection. */
+        usize threshold;
+    } old;
+
+    /* Old objects that may reference young ones. */
+    GcStack remset;
+
+    /* Spare remembered set, swapped in during minor collections. */
+    GcStack remset_spare;
+
+    /* Young objects whose references are still to be visited. */
+    GcStack gray;
+
+    /* Marked objects whose references are still to be marked, young ones
+       are updated when they move. */
+    GcStack marks;
+
+    GcPhase phase;
+
+    /* Work done by each incremental step, in bytes of objects visited, `0`
+       for stop-the-world major collections. */
+    usize budget;
+
+    /* Sweep position, the link to the next object to look at. */
+    GcHeader ** sweep;
+
+    bool background;
+    GcSweeper sweeper;
+
+    struct {
+        GcRootFn fn;
+        void * ctx;
+    } roots;
+
+    u32 epoch;
+
+    bool minor_pending;
+    bool major_pending;
+
+    /* Set when memory ran out at a point where it could not be reported,
+       the heap must be freed. */
+    bool failed;
+
+    /* Whether the last traced object still references young objects. */
+    bool has_young;
+
+    GcStats stats;
+} Gc;
+
+static
+bool
+GcStack_Push(
+    GcStack * stack,
+    GcHeader * hdr
+) {
+    if (stack->len == stack->cap) {
+        usize cap = stack->cap == 0 ? 64 : stack->cap * 2;
+
+        GcHeader ** buf = (GcHeader **)MeMem_Realloc(stack->buf,
+            sizeof(GcHeader *) * cap);
+        if (buf == NULL) {
+            return false;
+        }
+
+        stack->buf = buf;
+        stack->cap = cap;
+    }
+
+    stack->buf[stack->len] = hdr;
+    stack->len += 1;
+
+    return true;
+}
+
+static
+u64
+Gc_Now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (u64)ts.tv_sec * 1000000000UL + (u64)ts.tv_nsec;
+}
+
+static
+void
+GcSpace_Init(
+    GcSpace * space,
+    u8 * base,
+    usize size
+) {
+    space->base = base;
+    space->top = base;
+    space->end = base + size;
+}
+
+static
+usize
+GcSpace_Used(
+    GcSpace * space
+) {
+    return (usize)(space->top - space->base);
+}
+
+static
+bool
+GcSpace_Contains(
+    GcSpace * space,
+    void * ptr
+) {
+    return (u8 *)ptr >= space->base && (u8 *)ptr < space->top;
+}
+
+/**
+ * @brief Creates a generational heap.
+ *
+ * New objects are bump-allocated in a nursery of `nursery_size` bytes, and
+ * the survivors of minor collections are copied between two semispaces of an
+ * eighth of that size until they are promoted. Promoted objects form the old
+ * generation, which is collected by mark-sweep.
+ *
+ * Collections only happen in `Gc_Poll` and `Gc_Collect`, so that references
+ * held on the C stack stay valid between safepoints. When the nursery fills
+ * up, objects are allocated in the old generation until the next safepoint.
+ *
+ * The old generation is collected in a single pause unless a step budget is
+ * set with `Gc_SetStepBudget`.
+ *
+ * @param nursery_size The size of the nursery in bytes.
+ *
+ * @return A pointer to the new heap, or `NULL` if memory allocation fails.
+ */
+Gc *
+Gc_New(
+    usize nursery_size
+) {
+    usize eden_size = nursery_size & ~(usize)(GC_ALIGN - 1);
+    usize surv_size = (nursery_size / 8) & ~(usize)(GC_ALIGN - 1);
+
+    u8 * block = (u8 *)MeMem_Malloc(eden_size + surv_size * 2);
+    if (block == NULL) {
+        goto Exit;
+    }
+
+    Gc * gc = (Gc *)MeMem_Malloc(sizeof(Gc));
+    if (gc == NULL) {
+        goto FreeBlock;
+    }
+
+    memset(gc, 0, sizeof(Gc));
+
+    gc->young.block = block;
+    GcSpace_Init(&gc->young.eden, block, eden_size);
+    GcSpace_Init(&gc->young.surv[0], block + eden_size, surv_size);
+    GcSpace_Init(&gc->young.surv[1], block + eden_size + surv_size,
+        surv_size);
+    gc->young.cur = 0;
+
+    gc->old.objs = NULL;
+    gc->old.bytes = 0;
+    gc->old.threshold = ME_GC_OLD_MIN_BYTES;
+
+    gc->epoch = 0;
+    gc->phase = GcPhase_Idle;
+    gc->budget = ME_GC_STEP_BUDGET;
+    gc->background = false;
+
+    return gc;
+
+FreeBlock:
+    MeMem_Free(block);
+
+Exit:
+    return NULL;
+}
+
+/**
+ * @brief Sets the work done by each step of an incremental major collection.
+ *
+ * Marking and sweeping then proceed by steps at safepoints, each visiting
+ * about `budget` bytes of objects, the mutator running in between. Only the
+ * final remark, which revisits the roots and the young survivors, is done in
+ * one pause, whose length is bounded by the nursery size.
+ *
+ * @param budget The budget in bytes, `0` for stop-the-world collections.
+ */
+void
+Gc_SetStepBudget(
+    Gc * gc,
+    usize budget
+) {
+    gc->budget = budget;
+}
+
+/**
+ * @brief Sets whether incremental collections sweep on a background thread.
+ *
+ * The unmarked old objects are then freed while the mutator runs, instead of
+ * by steps. Sweeping falls back to steps if the thread cannot be started.
+ */
+void
+Gc_SetBackgroundSweep(
+    Gc * gc,
+    bool enabled
+) {
+    gc->background = enabled;
+}
+
+/**
+ * @brief Sets the function visiting the roots of the heap.
+ *
+ * The roots must cover every reference the mutator holds outside of the heap
+ * at a safepoint.
+ */
+void
+Gc_SetRoots(
+    Gc * gc,
+    GcRootFn fn,
+    void * ctx
+) {
+    gc->roots.fn = fn;
+    gc->roots.ctx = ctx;
+}
+
+static
+void
+Gc_InitHeader(
+    GcHeader * hdr,
+    const GcType * type,
+    usize size,
+    GcGen gen
+) {
+    hdr->type = type;
+    hdr->size = size;
+    hdr->link.next = NULL;
+    hdr->mark = 0;
+    hdr->gen = gen;
+    hdr->age = 0;
+    hdr->remembered = false;
+    hdr->forwarded = false;
+}
+
+/**
+ * @brief Adds an object to the old generation. Objects created during a
+ *        major collection are marked, so that they survive it.
+ */
+static
+void
+Gc_LinkOld(
+    Gc * gc,
+    GcHeader * hdr
+) {
+    if (gc->phase != GcPhase_Idle) {
+        hdr->mark = gc->epoch;
+    }
+
+    hdr->link.next = gc->old.objs;
+    gc->old.objs = hdr;
+
+    gc->old.bytes += GC_TOTAL_SIZE(hdr->size);
+    if (gc->old.bytes >= gc->old.threshold) {
+        gc->major_pending = true;
+    }
+}
+
+/**
+ * @brief Allocates an object in the old generation.
+ *
+ * Old objects never move, which suits long-lived tables whose address is
+ * kept outside of the heap. Stores of references into such objects must go
+ * through `Gc_WriteBarrier`.
+ *
+ * @return A pointer to the zeroed payload, or `NULL` if memory allocation
+ *         fails.
+ */
+void *
+Gc_AllocOld(
+    Gc * gc,
+    const GcType * type,
+    usize size
+) {
+    usize total = GC_TOTAL_SIZE(size);
+
+    GcHeader * hdr = (GcHeader *)MeMem_Malloc(total);
+    if (hdr == NULL) {
+        return NULL;
+    }
+
+    Gc_InitHeader(hdr, type, size, GcGen_Old);
+    Gc_LinkOld(gc, hdr);
+
+    gc->stats.bytes_allocated += total;
+
+    memset(GC_PAYLOAD(hdr), 0, size);
+
+    return GC_PAYLOAD(hdr);
+}
+
+/**
+ * @brief Allocates an object in the nursery.
+ *
+ * The payload is zeroed if the type has references, otherwise it is left to
+ * the caller to fill. The object is old if the nursery is full, so stores
+ * into it must go through `Gc_WriteBarrier` as for any other object.
+ *
+ * @return A pointer to the payload, or `NULL` if memory allocation fails.
+ */
+void *
+Gc_Alloc(
+    Gc * gc,
+    const GcType * type,
+    usize size
+) {
+    GcSpace * eden = &gc->young.eden;
+    usize total = GC_TOTAL_SIZE(size);
+
+    if (total > (usize)(eden->end - eden->top)) {
+        gc->minor_pending = true;
+        return Gc_AllocOld(gc, type, size);
+    }
+
+    GcHeader * hdr = (GcHeader *)eden->top;
+    eden->top += total;
+
+    Gc_InitHeader(hdr, type, size, GcGen_Young);
+
+    gc->stats.bytes_allocated += total;
+
+    if (type->trace != NULL) {
+        memset(GC_PAYLOAD(hdr), 0, size);
+    }
+
+    return GC_PAYLOAD(hdr);
+}
+
+/**
+ * @brief Marks an object, queueing it for tracing.
+ */
+static
+void
+Gc_Shade(
+    Gc * gc,
+    GcHeader * hdr
+) {
+    hdr->mark = gc->epoch;
+
+    if (hdr->type->trace != NULL &&
+        GcStack_Push(&gc->marks, hdr) == false) {
+
+        gc->failed = true;
+    }
+}
+
+/**
+ * @brief Records a store of `ref` into the object `obj`.
+ *
+ * Old objects referencing young ones are remembered, so that minor
+ * collections find those references without scanning the old generation.
+ * While marking, stored objects are marked, so that no object reached only
+ * through an already traced one is missed.
+ */
+void
+Gc_WriteBarrier(
+    Gc * gc,
+    void * obj,
+    void * ref
+) {
+    if (ref == NULL) {
+        return;
+    }
+
+    GcHeader * hdr = GC_HEADER(obj);
+    GcHeader * ref_hdr = GC_HEADER(ref);
+
+    if (hdr->gen != GcGen_Old) {
+        return;
+    }
+
+    if (gc->phase == GcPhase_Mark &&
+        ref_hdr->mark != gc->epoch) {
+
+        Gc_Shade(gc, ref_hdr);
+    }
+
+    if (ref_hdr->gen == GcGen_Old ||
+        hdr->remembered) {
+
+        return;
+    }
+
+    if (GcStack_Push(&gc->remset, hdr) == false) {
+        gc->failed = true;
+        return;
+    }
+
+    hdr->remembered = true;
+}
+
+/**
+ * @brief Copies a young object out of the nursery or the from-space.
+ *
+ * The copy goes to the to-space until the object is old enough or the
+ * to-space is full, then to the old generation.
+ */
+static
+void
+Gc_Evacuate(
+    Gc * gc,
+    void ** ref
+) {
+    void * obj = *ref;
+    if (obj == NULL) {
+        return;
+    }
+
+    GcHeader * hdr = GC_HEADER(obj);
+    GcSpace * to = &gc->young.surv[1 - gc->young.cur];
+
+    if (hdr->gen != GcGen_Young) {
+        return;
+    }
+
+    if (hdr->forwarded) {
+        *ref = hdr->link.fwd;
+        gc->has_young |= GC_HEADER(*ref)->gen == GcGen_Young;
+        return;
+    }
+
+    /* Already copied, the slot has been visited before. */
+    if (GcSpace_Contains(to, hdr)) {
+        gc->has_young = true;
+        return;
+    }
+
+    usize total = GC_TOTAL_SIZE(hdr->size);
+    GcHeader * copy;
+
+    if (hdr->age + 1 < ME_GC_PROMOTE_AGE &&
+        total <= (usize)(to->end - to->top)) {
+
+        copy = (GcHeader *)to->top;
+        to->top += total;
+
+        memcpy(copy, hdr, total);
+        copy->age += 1;
+
+        gc->has_young = true;
+    } else {
+        copy = (GcHeader *)MeMem_Malloc(total);
+        if (copy == NULL) {
+            gc->failed = true;
+            return;
+        }
+
+        memcpy(copy, hdr, total);
+        copy->gen = GcGen_Old;
+        copy->mark = 0;
+        Gc_LinkOld(gc, copy);
+
+        gc->stats.bytes_promoted += total;
+
+        /* Its references may be the only ones to unmarked objects. */
+        if (gc->phase == GcPhase_Mark &&
+            copy->type->trace != NULL &&
+            GcStack_Push(&gc->marks, copy) == false) {
+
+            gc->failed = true;
+        }
+    }
+
+    copy->forwarded = false;
+    copy->remembered = false;
+
+    hdr->forwarded = true;
+    hdr->link.fwd = GC_PAYLOAD(copy);
+
+    *ref = GC_PAYLOAD(copy);
+
+    if (copy->type->trace != NULL &&
+        GcStack_Push(&gc->gray, copy) == false) {
+
+        gc->failed = true;
+    }
+}
+
+/**
+ * @brief Visits the references of an object, remembering it if it is old
+ *        and still references young objects afterwards.
+ */
+static
+void
+Gc_ScanEvacuated(
+    Gc * gc,
+    GcHeader * hdr
+) {
+    gc->has_young = false;
+    hdr->type->trace(gc, GC_PAYLOAD(hdr), hdr->size, Gc_Evacuate);
+
+    if (hdr->gen == GcGen_Old &&
+        gc->has_young &&
+        hdr->remembered == false) {
+
+        if (GcStack_Push(&gc->remset, hdr) == false) {
+            gc->failed = true;
+            return;
+        }
+
+        hdr->remembered = true;
+    }
+}
+
+/**
+ * @brief Empties the nursery and the from-space, copying the objects
+ *        reachable from the roots and the remembered set.
+ */
+static
+void
+Gc_Minor(
+    Gc * gc
+) {
+    GcSpace * eden = &gc->young.eden;
+    GcSpace * from = &gc->young.surv[gc->young.cur];
+    GcSpace * to = &gc->young.surv[1 - gc->young.cur];
+    usize young_before = GcSpace_Used(eden) + GcSpace_Used(from);
+    u64 promoted_before = gc->stats.bytes_promoted;
+
+    to->top = to->base;
+    gc->gray.len = 0;
+
+    /* Old objects are remembered again if they still need to be. */
+    GcStack remset = gc->remset;
+    gc->remset = gc->remset_spare;
+    gc->remset.len = 0;
+
+    if (gc->roots.fn != NULL) {
+        gc->roots.fn(gc, gc->roots.ctx, Gc_Evacuate);
+    }
+
+    /* Marked young objects keep their mark when copied. */
+    if (gc->phase == GcPhase_Mark) {
+        usize len = gc->marks.len;
+
+        for (usize i = 0; i < len; i++) {
+            void * obj = GC_PAYLOAD(gc->marks.buf[i]);
+
+            Gc_Evacuate(gc, &obj);
+            gc->marks.buf[i] = GC_HEADER(obj);
+        }
+    }
+
+    for (usize i = 0; i < remset.len; i++) {
+        remset.buf[i]->remembered = false;
+        Gc_ScanEvacuated(gc, remset.buf[i]);
+    }
+
+    remset.len = 0;
+    gc->remset_spare = remset;
+
+    while (gc->gray.len != 0) {
+        gc->gray.len -= 1;
+        Gc_ScanEvacuated(gc, gc->gray.buf[gc->gray.len]);
+    }
+
+    eden->top = eden->base;
+    from->top = from->base;
+    gc->young.cur = 1 - gc->young.cur;
+
+    usize survived = GcSpace_Used(to) +
+        (usize)(gc->stats.bytes_promoted - promoted_before);
+
+    gc->stats.bytes_freed += young_before - survived;
+    gc->stats.num_minor += 1;
+    gc->minor_pending = false;
+}
+
+static
+void
+Gc_Mark(
+    Gc * gc,
+    void ** ref
+) {
+    void * obj = *ref;
+    if (obj == NULL) {
+        return;
+    }
+
+    GcHeader * hdr = GC_HEADER(obj);
+
+    if (hdr->mark != gc->epoch) {
+        Gc_Shade(gc, hdr);
+    }
+}
+
+/**
+ * @brief Starts a major collection cycle by marking the objects referenced
+ *        by the roots.
+ */
+static
+void
+Gc_StartMark(
+    Gc * gc
+) {
+    gc->epoch += 1;
+    if (gc->epoch == 0) {
+        gc->epoch = 1;
+    }
+
+    gc->marks.len = 0;
+    gc->phase = GcPhase_Mark;
+
+    if (gc->roots.fn != NULL) {
+        gc->roots.fn(gc, gc->roots.ctx, Gc_Mark);
+    }
+}
+
+/**
+ * @brief Traces marked objects until the mark stack is empty or `budget`
+ *        bytes of objects are visited.
+ *
+ * @return `true` if the mark stack is empty, `false` otherwise.
+ */
+static
+bool
+Gc_Drain(
+    Gc * gc,
+    usize budget
+) {
+    usize work = 0;
+
+    while (gc->failed == false &&
+           gc->marks.len != 0) {
+
+        if (work >= budget) {
+            return false;
+        }
+
+        gc->marks.len -= 1;
+
+        GcHeader * hdr = gc->marks.buf[gc->marks.len];
+        hdr->type->trace(gc, GC_PAYLOAD(hdr), hdr->size, Gc_Mark);
+
+        work += GC_TOTAL_SIZE(hdr->size);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Marks the objects referenced by young survivors, whose stores are
+ *        not covered by the write barrier.
+ *
+ * Runs right after a minor collection, when the survivor space holds every
+ * young object left.
+ */
+static
+void
+Gc_MarkSurvivors(
+    Gc * gc
+) {
+    GcSpace * surv = &gc->young.surv[gc->young.cur];
+    u8 * ptr = surv->base;
+
+    while (ptr < surv->top) {
+        GcHeader * hdr = (GcHeader *)ptr;
+
+        if (hdr->type->trace != NULL) {
+            hdr->type->trace(gc, GC_PAYLOAD(hdr), hdr->size, Gc_Mark);
+        }
+
+        ptr += GC_TOTAL_SIZE(hdr->size);
+    }
+}
+
+static
+void *
+Gc_SweepThread(
+    void * arg
+) {
+    GcSweeper * sweeper = (GcSweeper *)arg;
+    GcHeader * hdr = sweeper->objs;
+    GcHeader * live = NULL;
+    GcHeader ** tail = &live;
+
+    sweeper->live_bytes = 0;
+    sweeper->freed_bytes = 0;
+
+    while (hdr != NULL) {
+        GcHeader * next = hdr->link.next;
+        usize total = GC_TOTAL_SIZE(hdr->size);
+
+        if (hdr->mark == sweeper->epoch) {
+            *tail = hdr;
+            tail = &hdr->link.next;
+            sweeper->live_bytes += total;
+        } else {
+            sweeper->freed_bytes += total;
+            MeMem_Free(hdr);
+        }
+
+        hdr = next;
+    }
+
+    *tail = NULL;
+
+    sweeper->objs = live;
+    sweeper->tail = tail == &live ? &sweeper->objs : tail;
+
+    atomic_store(&sweeper->done, true);
+
+    return NULL;
+}
+
+/**
+ * @brief Hands the old generation over to the sweeper thread, new old
+ *        objects starting a list of their own.
+ *
+ * @return `true` if the thread started, `false` otherwise.
+ */
+static
+bool
+Gc_StartSweeper(
+    Gc * gc
+) {
+    GcSweeper * sweeper = &gc->sweeper;
+
+    sweeper->epoch = gc->epoch;
+    sweeper->objs = gc->old.objs;
+    sweeper->bytes = gc->old.bytes;
+    atomic_store(&sweeper->done, false);
+
+    if (pthread_create(&sweeper->thread, NULL,
+        Gc_SweepThread, sweeper) != 0) {
+
+        return false;
+    }
+
+    sweeper->active = true;
+
+    gc->old.objs = NULL;
+    gc->old.bytes = 0;
+
+    return true;
+}
+
+/**
+ * @brief Ends a major collection cycle, the old generation may now grow to
+ *        a multiple of its live size.
+ */
+static
+void
+Gc_EndCycle(
+    Gc * gc
+) {
+    gc->old.threshold = gc->old.bytes / 100 * ME_GC_OLD_GROWTH_PERCENT;
+    if (gc->old.threshold < ME_GC_OLD_MIN_BYTES) {
+        gc->old.threshold = ME_GC_OLD_MIN_BYTES;
+    }
+
+    gc->phase = GcPhase_Idle;
+    gc->stats.num_major += 1;
+    gc->major_pending = false;
+}
+
+/**
+ * @brief Waits for the sweeper thread and takes the survivors back.
+ */
+static
+void
+Gc_JoinSweeper(
+    Gc * gc
+) {
+    GcSweeper * sweeper = &gc->sweeper;
+
+    pthread_join(sweeper->thread, NULL);
+    sweeper->active = false;
+
+    *sweeper->tail = gc->old.objs;
+    gc->old.objs = sweeper->objs;
+    gc->old.bytes += sweeper->live_bytes;
+    gc->stats.bytes_freed += sweeper->freed_bytes;
+
+    Gc_EndCycle(gc);
+}
+
+/**
+ * @brief Completes the marking, in one pause, and starts sweeping.
+ *
+ * Runs right after a minor collection. The roots and the survivors are
+ * marked again since their stores are not covered by the write barrier.
+ *
+ * @param background Whether to sweep on a background thread.
+ */
+static
+void
+Gc_FinishMark(
+    Gc * gc,
+    bool background
+) {
+    if (gc->roots.fn != NULL) {
+        gc->roots.fn(gc, gc->roots.ctx, Gc_Mark);
+    }
+
+    Gc_MarkSurvivors(gc);
+    Gc_Drain(gc, SIZE_MAX);
+
+    /* The marks are incomplete, nothing can be freed safely. */
+    if (gc->failed) {
+        return;
+    }
+
+    usize len = 0;
+
+    for (usize i = 0; i < gc->remset.len; i++) {
+        GcHeader * hdr = gc->remset.buf[i];
+        if (hdr->mark == gc->epoch) {
+            gc->remset.buf[len] = hdr;
+            len += 1;
+        }
+    }
+
+    gc->remset.len = len;
+
+    gc->phase = GcPhase_Sweep;
+    gc->sweep = &gc->old.objs;
+
+    if (background) {
+        Gc_StartSweeper(gc);
+    }
+}
+
+/**
+ * @brief Frees unmarked old objects until the end of the old generation or
+ *        until `budget` bytes of objects are visited.
+ *
+ * Objects created while sweeping are marked, and linked before the sweep
+ * position or at it.
+ */
+static
+void
+Gc_Sweep(
+    Gc * gc,
+    usize budget
+) {
+    usize work = 0;
+
+    while (*gc->sweep != NULL) {
+        if (work >= budget) {
+            return;
+        }
+
+        GcHeader * hdr = *gc->sweep;
+        usize total = GC_TOTAL_SIZE(hdr->size);
+
+        work += total;
+
+        if (hdr->mark == gc->epoch) {
+            gc->sweep = &hdr->link.next;
+            continue;
+        }
+
+        *gc->sweep = hdr->link.next;
+        gc->old.bytes -= total;
+        gc->stats.bytes_freed += total;
+
+        MeMem_Free(hdr);
+    }
+
+    Gc_EndCycle(gc);
+}
+
+/**
+ * @brief Runs a whole major collection cycle, right after a minor one.
+ */
+static
+void
+Gc_Major(
+    Gc * gc
+) {
+    Gc_StartMark(gc);
+    Gc_FinishMark(gc, false);
+
+    if (gc->failed == false) {
+        Gc_Sweep(gc, SIZE_MAX);
+    }
+}
+
+/**
+ * @brief Completes the major collection cycle in progress, right after a
+ *        minor collection.
+ */
+static
+void
+Gc_FinishCycle(
+    Gc * gc
+) {
+    if (gc->phase == GcPhase_Mark) {
+        Gc_FinishMark(gc, false);
+    }
+
+    if (gc->failed ||
+        gc->phase != GcPhase_Sweep) {
+
+        return;
+    }
+
+    if (gc->sweeper.active) {
+        Gc_JoinSweeper(gc);
+    } else {
+        Gc_Sweep(gc, SIZE_MAX);
+    }
+}
+
+/**
+ * @brief Does one step of the major collection cycle in progress.
+ */
+static
+void
+Gc_Step(
+    Gc * gc
+) {
+    usize budget = gc->budget == 0 ? SIZE_MAX : gc->budget;
+
+    gc->stats.num_steps += 1;
+
+    if (gc->phase == GcPhase_Mark) {
+        if (Gc_Drain(gc, budget)) {
+            Gc_Minor(gc);
+            Gc_FinishMark(gc, gc->background);
+        }
+    } else if (gc->sweeper.active) {
+        if (atomic_load(&gc->sweeper.done)) {
+            Gc_JoinSweeper(gc);
+        }
+    } else {
+        Gc_Sweep(gc, budget);
+    }
+}
+
+static
+void
+Gc_RecordPause(
+    Gc * gc,
+    u64 start
+) {
+    u64 pause = Gc_Now() - start;
+
+    gc->stats.num_pauses += 1;
+    gc->stats.total_pause_ns += pause;
+    if (pause > gc->stats.max_pause_ns) {
+        gc->stats.max_pause_ns = pause;
+    }
+}
+
+/**
+ * @brief Collects the heap in one pause.
+ *
+ * A minor collection always runs first. A major collection cycle in progress
+ * is completed, and a whole one follows if `major` is set or the old
+ * generation has outgrown its threshold. Objects may move, the references
+ * reported by the roots are updated.
+ *
+ * @return `true` on success, `false` if memory ran out, after which the heap
+ *         can only be freed.
+ */
+bool
+Gc_Collect(
+    Gc * gc,
+    bool major
+) {
+    if (gc->failed) {
+        return false;
+    }
+
+    u64 start = Gc_Now();
+
+    Gc_Minor(gc);
+
+    if (gc->failed == false &&
+        gc->phase != GcPhase_Idle) {
+
+        Gc_FinishCycle(gc);
+    }
+
+    if (gc->failed == false &&
+        (major || gc->major_pending)) {
+
+        Gc_Major(gc);
+    }
+
+    Gc_RecordPause(gc, start);
+
+    return gc->failed == false;
+}
+
+/**
+ * @brief Safepoint, collects the heap if an allocation asked for it and
+ *        advances the major collection cycle in progress.
+ *
+ * @return `true` on success, `false` if memory ran out, after which the heap
+ *         can only be freed.
+ */
+bool
+Gc_Poll(
+    Gc * gc
+) {
+    if (gc->failed) {
+        return false;
+    }
+
+    if (gc->phase == GcPhase_Idle &&
+        gc->minor_pending == false &&
+        gc->major_pending == false) {
+
+        return true;
+    }
+
+    u64 start = Gc_Now();
+
+    if (gc->phase != GcPhase_Idle) {
+        Gc_Step(gc);
+    }
+
+    bool major = gc->major_pending && gc->phase == GcPhase_Idle;
+
+    /* Stop-the-world major collections need a minor one right before. */
+    if (gc->failed == false &&
+        (gc->minor_pending || (major && gc->budget == 0))) {
+
+        Gc_Minor(gc);
+    }
+
+    if (gc->failed == false && major) {
+        if (gc->budget == 0) {
+            Gc_Major(gc);
+        } else {
+            Gc_StartMark(gc);
+        }
+    }
+
+    Gc_RecordPause(gc, start);
+
+    return gc->failed == false;
+}
+
+void
+Gc_Stats(
+    Gc * gc,
+    GcStats * stats
+) {
+    *stats = gc->stats;
+
+    stats->young_bytes = GcSpace_Used(&gc->young.eden) +
+        GcSpace_Used(&gc->young.surv[gc->young.cur]);
+    stats->old_bytes = gc->old.bytes;
+
+    if (gc->sweeper.active) {
+        stats->old_bytes += gc->sweeper.bytes;
+    }
+}
+
+static
+void
+Gc_FreeOld(
+    Gc * gc
+) {
+    if (gc->sweeper.active) {
+        Gc_JoinSweeper(gc);
+    }
+
+    GcHeader * hdr = gc->old.objs;
+
+    while (hdr != NULL) {
+        GcHeader * next = hdr->link.next;
+        MeMem_Free(hdr);
+        hdr = next;
+    }
+
+    gc->old.objs = NULL;
+    gc->old.bytes = 0;
+}
+
+/**
+ * @brief Frees every object at once, for when nothing references the heap
+ *        anymore. The statistics are kept, and a failed heap is usable again.
+ */
+void
+Gc_Clear(
+    Gc * gc
+) {
+    gc->stats.bytes_freed += GcSpace_Used(&gc->young.eden) +
+        GcSpace_Used(&gc->young.surv[gc->young.cur]) + gc->old.bytes;
+
+    Gc_FreeOld(gc);
+    gc->old.threshold = ME_GC_OLD_MIN_BYTES;
+
+    gc->young.eden.top = gc->young.eden.base;
+    gc->young.surv[0].top = gc->young.surv[0].base;
+    gc->young.surv[1].top = gc->young.surv[1].base;
+
+    gc->remset.len = 0;
+    gc->gray.len = 0;
+    gc->marks.len = 0;
+    gc->phase = GcPhase_Idle;
+
+    gc->minor_pending = false;
+    gc->major_pending = false;
+    gc->failed = false;
+}
+
+void
+Gc_Free(
+    Gc * gc
+) {
+    Gc_FreeOld(gc);
+
+    if (gc->remset.buf != NULL) {
+        MeMem_Free(gc->remset.buf);
+    }
+
+    if (gc->remset_spare.buf != NULL) {
+        MeMem_Free(gc->remset_spare.buf);
+    }
+
+    if (gc->gray.buf != NULL) {
+        MeMem_Free(gc->gray.buf);
+    }
+
+    if (gc->marks.buf != NULL) {
+        MeMem_Free(gc->marks.buf);
+    }
+
+    MeMem_Free(gc->young.block);
+    MeMem_Free(gc);
+}
\ No newline at end of file
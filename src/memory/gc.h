@@ -0,0 +1,121 @@
+#ifndef __ME_MEMORY_GC_H__
+#define __ME_MEMORY_GC_H__
+
+#include "menos.h"
+
+typedef struct _Gc Gc;
+
+/* Called by tracers for every reference slot, the slot is updated when the
+   referenced object moves. */
+typedef void (* GcVisitFn)(Gc * gc, void ** ref);
+
+/* Object type descriptor. */
+typedef struct _GcType {
+    const char * name;
+
+    /* Visits the reference slots of an object, `NULL` for objects without
+       references. */
+    void (* trace)(Gc * gc, void * obj, usize size, GcVisitFn visit);
+} GcType;
+
+/* Visits the reference slots held outside of the heap. */
+typedef void (* GcRootFn)(Gc * gc, void * ctx, GcVisitFn visit);
+
+/* Collection statistics. */
+typedef struct _GcStats {
+    usize num_minor;
+    usize num_major;
+
+    /* The number of incremental major collection steps. */
+    usize num_steps;
+
+    /* The number of safepoints that did collection work. */
+    usize num_pauses;
+
+    /* Pause times in nanoseconds. */
+    u64 total_pause_ns;
+    u64 max_pause_ns;
+
+    /* Cumulative byte counts. */
+    u64 bytes_allocated;
+    u64 bytes_promoted;
+    u64 bytes_freed;
+
+    /* Current heap occupancy in bytes. */
+    usize young_bytes;
+    usize old_bytes;
+} GcStats;
+
+Gc *
+Gc_New(
+    usize nursery_size
+);
+
+void
+Gc_SetStepBudget(
+    Gc * gc,
+    usize budget
+);
+
+void
+Gc_SetBackgroundSweep(
+    Gc * gc,
+    bool enabled
+);
+
+void
+Gc_SetRoots(
+    Gc * gc,
+    GcRootFn fn,
+    void * ctx
+);
+
+void *
+Gc_Alloc(
+    Gc * gc,
+    const GcType * type,
+    usize size
+);
+
+void *
+Gc_AllocOld(
+    Gc * gc,
+    const GcType * type,
+    usize size
+);
+
+void
+Gc_WriteBarrier(
+    Gc * gc,
+    void * obj,
+    void * ref
+);
+
+bool
+Gc_Poll(
+    Gc * gc
+);
+
+bool
+Gc_Collect(
+    Gc * gc,
+    bool major
+);
+
+void
+Gc_Clear(
+    Gc * gc
+);
+
+void
+Gc_Stats(
+    Gc * gc,
+    GcStats * stats
+);
+
+void
+Gc_Free(
+    Gc * gc
+);
+
+#endif
\ No newline at end of file
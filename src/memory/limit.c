@@ -0,0 +1,162 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "limit.h"
+
+typedef struct _MemLimit {
+    MemAllocator alloc;
+    const MemAllocator * parent;
+    usize limit;
+
+    /* Blocks may be freed by other threads, as by a background sweeper. */
+    atomic_size_t used;
+} MemLimit;
+
+/**
+ * @brief Accounts for `size` more bytes if they fit in the limit.
+ */
+static
+bool
+Limit_Reserve(
+    MemLimit * lim,
+    usize size
+) {
+    usize used = atomic_load(&lim->used);
+
+    do {
+        if (size > lim->limit - used) {
+            return false;
+        }
+    } while (atomic_compare_exchange_weak(&lim->used, &used,
+        used + size) == false);
+
+    return true;
+}
+
+static
+void
+Limit_Release(
+    MemLimit * lim,
+    usize size
+) {
+    atomic_fetch_sub(&lim->used, size);
+}
+
+static
+void *
+Limit_Alloc(
+    void * ctx,
+    usize size
+) {
+    MemLimit * lim = (MemLimit *)ctx;
+
+    if (Limit_Reserve(lim, size) == false) {
+        return NULL;
+    }
+
+    void * ptr = lim->parent->alloc(lim->parent->ctx, size);
+    if (ptr == NULL) {
+        Limit_Release(lim, size);
+    }
+
+    return ptr;
+}
+
+static
+void *
+Limit_Realloc(
+    void * ctx,
+    void * ptr,
+    usize old_size,
+    usize size
+) {
+    MemLimit * lim = (MemLimit *)ctx;
+
+    if (size > old_size &&
+        Limit_Reserve(lim, size - old_size) == false) {
+
+        return NULL;
+    }
+
+    void * new_ptr = lim->parent->realloc(lim->parent->ctx, ptr,
+        old_size, size);
+
+    if (new_ptr == NULL) {
+        if (size > old_size) {
+            Limit_Release(lim, size - old_size);
+        }
+    } else if (size < old_size) {
+        Limit_Release(lim, old_size - size);
+    }
+
+    return new_ptr;
+}
+
+static
+void
+Limit_Free(
+    void * ctx,
+    void * ptr,
+    usize size
+) {
+    MemLimit * lim = (MemLimit *)ctx;
+
+    lim->parent->free(lim->parent->ctx, ptr, size);
+    Limit_Release(lim, size);
+}
+
+/**
+ * @brief Creates an allocator enforcing a hard limit on the bytes it has
+ *        handed out.
+ *
+ * Allocations past the limit fail as if memory were exhausted, so lexers,
+ * parsers and interpreters using the allocator report their out of memory
+ * errors.
+ *
+ * @param parent The allocator blocks come from, or `NULL` for the C library.
+ * @param limit The limit in bytes, block headers included.
+ *
+ * @return A pointer to the allocator, or `NULL` if memory allocation fails.
+ */
+MemLimit *
+MemLimit_New(
+    const MemAllocator * parent,
+    usize limit
+) {
+    MemLimit * lim = (MemLimit *)malloc(sizeof(MemLimit));
+    if (lim == NULL) {
+        return NULL;
+    }
+
+    lim->alloc.alloc = Limit_Alloc;
+    lim->alloc.realloc = Limit_Realloc;
+    lim->alloc.free = Limit_Free;
+    lim->alloc.ctx = lim;
+
+    lim->parent = parent != NULL ? parent : &mem_libc_allocator;
+    lim->limit = limit;
+    atomic_init(&lim->used, 0);
+
+    return lim;
+}
+
+const MemAllocator *
+MemLimit_Allocator(
+    MemLimit * lim
+) {
+    return &lim->alloc;
+}
+
+usize
+MemLimit_Used(
+    MemLimit * lim
+) {
+    return atomic_load(&lim->used);
+}
+
+void
+MemLimit_Free(
+    MemLimit * lim
+) {
+    free(lim);
+}
\ No newline at end of file
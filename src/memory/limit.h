@@ -0,0 +1,32 @@
+#ifndef __ME_MEMORY_LIMIT_H__
+#define __ME_MEMORY_LIMIT_H__
+
+#include "menos.h"
+#include "allocate.h"
+
+/* Allocator failing once the bytes it has handed out would exceed a limit,
+   blocks come from a parent allocator. */
+typedef struct _MemLimit MemLimit;
+
+MemLimit *
+MemLimit_New(
+    const MemAllocator * parent,
+    usize limit
+);
+
+const MemAllocator *
+MemLimit_Allocator(
+    MemLimit * lim
+);
+
+usize
+MemLimit_Used(
+    MemLimit * lim
+);
+
+void
+MemLimit_Free(
+    MemLimit * lim
+);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+#include "config.h"
+
+/* Size classes step by 16 bytes up to 128, then by a quarter of the power of
+   two below them. */
+#define POOL_QUANTUM        16
+#define POOL_NUM_SMALL      8
+#define POOL_SMALL_MAX      (POOL_QUANTUM * POOL_NUM_SMALL)
+#define POOL_NUM_CLASSES    28
+#define POOL_MAX_SIZE       4096
+
+/* Free block, linked through its first bytes. */
+typedef struct _PoolBlock {
+    struct _PoolBlock * next;
+} PoolBlock;
+
+/* Slab header, the blocks of one size class follow it. */
+typedef struct _PoolSlab {
+    struct _PoolSlab * next;
+    _Alignas(max_align_t) u8 data[];
+} PoolSlab;
+
+typedef struct _PoolClass {
+    PoolBlock * free;
+
+    /* Unused tail of the newest slab of the class. */
+    u8 * cur;
+    u8 * end;
+} PoolClass;
+
+typedef struct _MemPool {
+    MemAllocator alloc;
+
+    /* Blocks may be freed by other threads, as by a background sweeper. */
+    pthread_mutex_t lock;
+
+    PoolSlab * slabs;
+    PoolClass classes[POOL_NUM_CLASSES];
+} MemPool;
+
+static
+usize
+Pool_ClassOf(
+    usize size
+) {
+    if (size <= POOL_SMALL_MAX) {
+        return size == 0 ? 0 : (size - 1) / POOL_QUANTUM;
+    }
+
+    /* Position of the highest bit of `size - 1`, at least 7. */
+    usize lg = (usize)(sizeof(unsigned long) * 8 - 1 -
+        __builtin_clzl((unsigned long)(size - 1)));
+    usize base = (usize)1 << lg;
+
+    return POOL_NUM_SMALL + (lg - 7) * 4 + (size - 1 - base) / (base / 4);
+}
+
+static
+usize
+Pool_ClassSize(
+    usize cls
+) {
+    if (cls < POOL_NUM_SMALL) {
+        return (cls + 1) * POOL_QUANTUM;
+    }
+
+    usize base = (usize)POOL_SMALL_MAX << ((cls - POOL_NUM_SMALL) / 4);
+
+    return base + ((cls - POOL_NUM_SMALL) % 4 + 1) * (base / 4);
+}
+
+static
+void *
+Pool_AllocClass(
+    MemPool * pool,
+    usize cls
+) {
+    PoolClass * pc = pool->classes + cls;
+    usize size = Pool_ClassSize(cls);
+    void * ptr = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+
+    if (pc->free != NULL) {
+        ptr = pc->free;
+        pc->free = pc->free->next;
+        goto Unlock;
+    }
+
+    if ((usize)(pc->end - pc->cur) < size) {
+        PoolSlab * slab = (PoolSlab *)malloc(ME_POOL_SLAB_SIZE);
+        if (slab == NULL) {
+            goto Unlock;
+        }
+
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+
+        /* The rest of the previous slab is dropped, less than a block. */
+        pc->cur = slab->data;
+        pc->end = (u8 *)slab + ME_POOL_SLAB_SIZE;
+    }
+
+    ptr = pc->cur;
+    pc->cur += size;
+
+Unlock:
+    pthread_mutex_unlock(&pool->lock);
+
+    return ptr;
+}
+
+static
+void
+Pool_FreeClass(
+    MemPool * pool,
+    void * ptr,
+    usize cls
+) {
+    PoolBlock * block = (PoolBlock *)ptr;
+
+    pthread_mutex_lock(&pool->lock);
+
+    block->next = pool->classes[cls].free;
+    pool->classes[cls].free = block;
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static
+void *
+Pool_Alloc(
+    void * ctx,
+    usize size
+) {
+    if (size > POOL_MAX_SIZE) {
+        return malloc(size);
+    }
+
+    return Pool_AllocClass((MemPool *)ctx, Pool_ClassOf(size));
+}
+
+static
+void
+Pool_Free(
+    void * ctx,
+    void * ptr,
+    usize size
+) {
+    if (size > POOL_MAX_SIZE) {
+        free(ptr);
+        return;
+    }
+
+    Pool_FreeClass((MemPool *)ctx, ptr, Pool_ClassOf(size));
+}
+
+static
+void *
+Pool_Realloc(
+    void * ctx,
+    void * ptr,
+    usize old_size,
+    usize size
+) {
+    if (old_size > POOL_MAX_SIZE &&
+        size > POOL_MAX_SIZE) {
+
+        return realloc(ptr, size);
+    }
+
+    if (old_size <= POOL_MAX_SIZE &&
+        size <= POOL_MAX_SIZE &&
+        Pool_ClassOf(old_size) == Pool_ClassOf(size)) {
+
+        return ptr;
+    }
+
+    void * new_ptr = Pool_Alloc(ctx, size);
+    if (new_ptr == NULL) {
+        return NULL;
+    }
+
+    memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+    Pool_Free(ctx, ptr, old_size);
+
+    return new_ptr;
+}
+
+/**
+ * @brief Creates a pool of small blocks in the style of jemalloc.
+ *
+ * Blocks up to 4 KiB are rounded up to one of 28 size classes and served
+ * from per-class free lists, which are refilled from slabs of
+ * `ME_POOL_SLAB_SIZE` bytes. Larger blocks come from the C library.
+ *
+ * @return A pointer to the pool, or `NULL` if memory allocation fails.
+ */
+MemPool *
+MemPool_New(void) {
+    MemPool * pool = (MemPool *)malloc(sizeof(MemPool));
+    if (pool == NULL) {
+        goto Exit;
+    }
+
+    if (pthread_mutex_init(&pool->lock, NULL) != 0) {
+        goto FreePool;
+    }
+
+    pool->alloc.alloc = Pool_Alloc;
+    pool->alloc.realloc = Pool_Realloc;
+    pool->alloc.free = Pool_Free;
+    pool->alloc.ctx = pool;
+
+    pool->slabs = NULL;
+
+    for (usize i = 0; i < POOL_NUM_CLASSES; i++) {
+        pool->classes[i].free = NULL;
+        pool->classes[i].cur = NULL;
+        pool->classes[i].end = NULL;
+    }
+
+    return pool;
+
+FreePool:
+    free(pool);
+
+Exit:
+    return NULL;
+}
+
+const MemAllocator *
+MemPool_Allocator(
+    MemPool * pool
+) {
+    return &pool->alloc;
+}
+
+/**
+ * @brief Releases the pool with all of its slabs.
+ *
+ * Small blocks still allocated from the pool are released with it, large
+ * blocks must have been freed before.
+ */
+void
+MemPool_Free(
+    MemPool * pool
+) {
+    PoolSlab * slab = pool->slabs;
+
+    while (slab != NULL) {
+        PoolSlab * next = slab->next;
+        free(slab);
+        slab = next;
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
\ No newline at end of file
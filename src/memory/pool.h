@@ -0,0 +1,24 @@
+#ifndef __ME_MEMORY_POOL_H__
+#define __ME_MEMORY_POOL_H__
+
+#include "menos.h"
+#include "allocate.h"
+
+/* Allocator serving small blocks from size classes carved out of slabs, the
+   slabs are only returned when the pool is freed. */
+typedef struct _MemPool MemPool;
+
+MemPool *
+MemPool_New(void);
+
+const MemAllocator *
+MemPool_Allocator(
+    MemPool * pool
+);
+
+void
+MemPool_Free(
+    MemPool * pool
+);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "stats.h"
+
+static
+bool
+MemStats_PushHist(
+    const MemTagStats * tag_stats,
+    FlexBuf * buf
+) {
+    for (usize i = 0; i < MEM_NUM_BUCKETS; i++) {
+        if (tag_stats->hist[i] == 0) {
+            continue;
+        }
+
+        bool ok;
+
+        if (i + 1 < MEM_NUM_BUCKETS) {
+            ok = FlexBuf_PushFmt(buf, "    <=%zu: %llu\n", (usize)16 << i,
+                (unsigned long long)tag_stats->hist[i]);
+        } else {
+            ok = FlexBuf_PushFmt(buf, "    >%zu: %llu\n", (usize)16 << (i - 1),
+                (unsigned long long)tag_stats->hist[i]);
+        }
+
+        if (ok == false) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Appends a report of the memory accounting of every subsystem that
+ *        allocated, with its size histogram.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+MemStats_PushAsStr(
+    const MemStats * stats,
+    FlexBuf * buf
+) {
+    for (usize i = 0; i < MEM_NUM_TAGS; i++) {
+        const MemTagStats * tag_stats = stats->tags + i;
+
+        if (tag_stats->num_allocs == 0) {
+            continue;
+        }
+
+        if (FlexBuf_PushFmt(buf,
+            "%s: live %zu, peak %zu, allocs %llu, frees %llu\n",
+            MemTag_ToStr((MemTag)i),
+            tag_stats->live_bytes, tag_stats->peak_bytes,
+            (unsigned long long)tag_stats->num_allocs,
+            (unsigned long long)tag_stats->num_frees) == false) {
+
+            return false;
+        }
+
+        if (MemStats_PushHist(tag_stats, buf) == false) {
+            return false;
+        }
+    }
+
+    return true;
+}
\ No newline at end of file
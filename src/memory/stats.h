@@ -0,0 +1,14 @@
+#ifndef __ME_MEMORY_STATS_H__
+#define __ME_MEMORY_STATS_H__
+
+#include "menos.h"
+#include "allocate.h"
+#include "util/flex_buf.h"
+
+bool
+MemStats_PushAsStr(
+    const MemStats * stats,
+    FlexBuf * buf
+);
+
+#endif
\ No newline at end of file
@@ -21,4 +21,8 @@ typedef int64_t     s64;
 typedef size_t      usize;
 typedef ssize_t     ssize;
 
+/* Branch hints for the fast paths of hot functions. */
+#define ME_LIKELY(x)        __builtin_expect(!!(x), 1)
+#define ME_UNLIKELY(x)      __builtin_expect(!!(x), 0)
+
 #endif
\ No newline at end of file
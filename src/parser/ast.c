@@ -1,4 +1,7 @@
+#include <stdint.h>
+
 #include "ast.h"
+#include "match_tab.h"
 #include "memory/allocate.h"
 
 const char *
@@ -10,6 +13,7 @@ AstTag_ToStr(
     case AstTag_NumLit: return "NumericLiteral";
     case AstTag_BoolLit: return "BooleanLiteral";
     case AstTag_Var: return "Variable";
+    case AstTag_Call: return "Call";
 
     case AstTag_LogNotOp: return "LogicalNot";
     case AstTag_LogOrOp:  return "LogicalOr";
@@ -35,15 +39,32 @@ AstTag_ToStr(
     case AstTag_AsgnStmt: return "Assignment";
     case AstTag_IfStmt: return "If";
     case AstTag_IfElseStmt: return "IfElse";
+    case AstTag_MatchArm: return "MatchArm";
+    case AstTag_MatchStmt: return "Match";
     case AstTag_BlockStmt: return "Block";
+    case AstTag_ExprStmt: return "Expression";
+    case AstTag_RetStmt: return "Return";
+    case AstTag_FuncDef: return "FunctionDefinition";
 
     case AstTag_Prog: return "Program";
     }
 }
 
+/* Nodes are recycled by the thread freeing them. */
+static
+_Thread_local MemCache
+ast_node_cache = MEM_CACHE_INIT(sizeof(AstNode));
+
 AstNode *
 AstNode_New(void) {
-    return (AstNode *)MeMem_Malloc(sizeof(AstNode));
+    AstNode * node = (AstNode *)MeMem_CacheAlloc(&ast_node_cache);
+
+    if (node != NULL) {
+        node->row = 0;
+        node->col = 0;
+    }
+
+    return node;
 }
 
 AstNode *
@@ -107,9 +128,44 @@ AstNode_NewNumLit(
 
     node->tag = AstTag_NumLit;
     node->ext.num_lit.num = num;
+    node->ext.num_lit.big = NULL;
+
+    return node;
+
+Exit:
+    return NULL;
+}
+
+/**
+ * @brief Creates a numeric literal that does not fit in `ssize`.
+ *
+ * @param big A pointer to the value, which is cloned.
+ *
+ * @return A pointer to the new node, or `NULL` if memory allocation fails.
+ */
+AstNode *
+AstNode_NewBigNumLit(
+    BigInt * big
+) {
+    BigInt * _big = BigInt_Clone(big);
+    if (_big == NULL) {
+        goto Exit;
+    }
+
+    AstNode * node = AstNode_New();
+    if (node == NULL) {
+        goto FreeBig;
+    }
+
+    node->tag = AstTag_NumLit;
+    node->ext.num_lit.num = 0;
+    node->ext.num_lit.big = _big;
 
     return node;
 
+FreeBig:
+    BigInt_Free(_big);
+
 Exit:
     return NULL;
 }
@@ -148,6 +204,8 @@ AstNode_NewVar(
 
     node->tag = AstTag_Var;
     node->ext.var.str = _str;
+    node->ext.var.local = false;
+    node->ext.var.slot = 0;
 
     return node;
 
@@ -158,6 +216,36 @@ Exit:
     return NULL;
 }
 
+AstNode *
+AstNode_NewCall(
+    FixedBuf * name,
+    AstSeq * args
+) {
+    FixedBuf * _name = FixedBuf_Clone(name);
+    if (_name == NULL) {
+        goto Exit;
+    }
+
+    AstNode * node = AstNode_New();
+    if (node == NULL) {
+        goto FreeName;
+    }
+
+    node->tag = AstTag_Call;
+    node->ext.call.name = _name;
+    node->ext.call.args = args;
+    node->ext.call.func = NULL;
+    node->ext.call.tail = false;
+
+    return node;
+
+FreeName:
+    FixedBuf_Free(_name);
+
+Exit:
+    return NULL;
+}
+
 AstNode *
 AstNode_NewUnaOp(
     AstTag tag,
@@ -279,6 +367,154 @@ Exit:
     return NULL;
 }
 
+AstNode *
+AstNode_NewMatchArm(
+    AstNode * key,
+    AstNode * body
+) {
+    AstNode * node = AstNode_New();
+    if (node == NULL) {
+        goto Exit;
+    }
+
+    node->tag = AstTag_MatchArm;
+    node->ext.match_arm.key = key;
+    node->ext.match_arm.body = body;
+
+    return node;
+
+Exit:
+    return NULL;
+}
+
+/**
+ * @brief Creates a match statement node and compiles its dispatch table.
+ *
+ * @param subj A pointer to the subject expression.
+ * @param arms A pointer to the sequence of `AstTag_MatchArm` nodes.
+ * @param else_br A pointer to the else-branch, or `NULL` if there is none.
+ * @param dup A pointer to receive the index of the first arm whose key
+ *            repeats that of an earlier arm, or `MATCH_TAB_NO_DUP`.
+ *
+ * @return A pointer to the new node, or `NULL` if two arms have the same key
+ *         or memory allocation fails. The ownership of the children is only
+ *         taken on success.
+ */
+AstNode *
+AstNode_NewMatchStmt(
+    AstNode * subj,
+    AstSeq * arms,
+    AstNode * else_br,
+    usize * dup
+) {
+    MatchTab * tab = MatchTab_New(arms, dup);
+    if (tab == NULL) {
+        goto Exit;
+    }
+
+    AstNode * node = AstNode_New();
+    if (node == NULL) {
+        goto FreeTab;
+    }
+
+    node->tag = AstTag_MatchStmt;
+    node->ext.match_stmt.subj = subj;
+    node->ext.match_stmt.arms = arms;
+    node->ext.match_stmt.else_br = else_br;
+    node->ext.match_stmt.tab = tab;
+
+    return node;
+
+FreeTab:
+    MatchTab_Free(tab);
+
+Exit:
+    return NULL;
+}
+
+AstNode *
+AstNode_NewExprStmt(
+    AstNode * expr
+) {
+    AstNode * node = AstNode_New();
+    if (node == NULL) {
+        goto Exit;
+    }
+
+    node->tag = AstTag_ExprStmt;
+    node->ext.expr_stmt.expr = expr;
+
+    return node;
+
+Exit:
+    return NULL;
+}
+
+AstNode *
+AstNode_NewRetStmt(
+    AstNode * val
+) {
+    AstNode * node = AstNode_New();
+    if (node == NULL) {
+        goto Exit;
+    }
+
+    node->tag = AstTag_RetStmt;
+    node->ext.ret_stmt.val = val;
+
+    return node;
+
+Exit:
+    return NULL;
+}
+
+AstNode *
+AstNode_NewFuncDef(
+    FixedBuf * name,
+    AstSeq * params,
+    AstNode * body
+) {
+    FixedBuf * _name = FixedBuf_Clone(name);
+    if (_name == NULL) {
+        goto Exit;
+    }
+
+    AstNode * node = AstNode_New();
+    if (node == NULL) {
+        goto FreeName;
+    }
+
+    node->tag = AstTag_FuncDef;
+    node->ext.func_def.name = _name;
+    node->ext.func_def.params = params;
+    node->ext.func_def.body = body;
+    node->ext.func_def.num_slots = 0;
+
+    return node;
+
+FreeName:
+    FixedBuf_Free(_name);
+
+Exit:
+    return NULL;
+}
+
+/* Appends `<label "str">`, nodes are dumped in bulk so this skips parsing
+   a format for each. */
+static
+bool
+AstNode_PushStrAsStr(
+    FlexBuf * buf,
+    const char * label,
+    FixedBuf * str
+) {
+    return FlexBuf_PushByte(buf, '<') &&
+        FlexBuf_PushStr(buf, label) &&
+        FlexBuf_PushBuf(buf, " \"", 2) &&
+        FlexBuf_PushBuf(buf, FixedBuf_Data(str), FixedBuf_Size(str)) &&
+        FlexBuf_PushBuf(buf, "\">", 2);
+}
+
 bool
 AstNode_PushAsStr_Recur(
     AstNode * node,
@@ -295,21 +531,34 @@ AstNode_PushAsStr_Recur(
     }
 
     switch (node->tag) {
-    case AstTag_StrLit: {
-        const u8 * const str_buf = FixedBuf_Data(node->ext.str_lit.str);
-        const usize str_len = FixedBuf_Size(node->ext.str_lit.str);
-        if (FlexBuf_PushFmt(buf, "<%s \"%.*s\">",
-            label, str_len, str_buf) == false) {
+    case AstTag_StrLit:
+        if (AstNode_PushStrAsStr(buf, label,
+            node->ext.str_lit.str) == false) {
 
             return false;
         }
 
         break;
-    }
 
     case AstTag_NumLit:
-        if (FlexBuf_PushFmt(buf, "<%s %zd>",
-            label, node->ext.num_lit.num) == false) {
+        if (node->ext.num_lit.big != NULL) {
+            if (FlexBuf_PushByte(buf, '<') == false ||
+                FlexBuf_PushStr(buf, label) == false ||
+                FlexBuf_PushByte(buf, ' ') == false ||
+                BigInt_PushAsStr(node->ext.num_lit.big, buf) == false ||
+                FlexBuf_PushByte(buf, '>') == false) {
+
+                return false;
+            }
+
+            break;
+        }
+
+        if (FlexBuf_PushByte(buf, '<') == false ||
+            FlexBuf_PushStr(buf, label) == false ||
+            FlexBuf_PushByte(buf, ' ') == false ||
+            FlexBuf_PushInt(buf, node->ext.num_lit.num) == false ||
+            FlexBuf_PushByte(buf, '>') == false) {
 
             return false;
         }
@@ -317,28 +566,48 @@ AstNode_PushAsStr_Recur(
         break;
 
     case AstTag_BoolLit:
-        if (FlexBuf_PushFmt(buf, "<%s %s>",
-            label, node->ext.bool_lit.val ? "true" : "false") == false) {
+        if (FlexBuf_PushByte(buf, '<') == false ||
+            FlexBuf_PushStr(buf, label) == false ||
+            FlexBuf_PushStr(buf,
+                node->ext.bool_lit.val ? " true>" : " false>") == false) {
 
             return false;
         }
 
         break;
 
-    case AstTag_Var: {
-        const u8 * const str_buf = FixedBuf_Data(node->ext.var.str);
-        const usize str_len = FixedBuf_Size(node->ext.var.str);
-        if (FlexBuf_PushFmt(buf, "<%s \"%.*s\">",
-            label, str_len, str_buf) == false) {
+    case AstTag_Var:
+        if (AstNode_PushStrAsStr(buf, label,
+            node->ext.var.str) == false) {
+
+            return false;
+        }
+
+        break;
+
+    case AstTag_Call:
+        if (AstNode_PushStrAsStr(buf, label,
+            node->ext.call.name) == false) {
+
+            return false;
+        }
+
+        break;
+
+    case AstTag_FuncDef:
+        if (AstNode_PushStrAsStr(buf, label,
+            node->ext.func_def.name) == false) {
 
             return false;
         }
 
         break;
-    }
 
     default:
-        if (FlexBuf_PushFmt(buf, "<%s>", label) == false) {
+        if (FlexBuf_PushByte(buf, '<') == false ||
+            FlexBuf_PushStr(buf, label) == false ||
+            FlexBuf_PushByte(buf, '>') == false) {
+
             return false;
         }
 
@@ -359,6 +628,16 @@ AstNode_PushAsStr_Recur(
     case AstTag_Var:
         break;
 
+    case AstTag_Call: {
+        AstNode ** buf_nodes = AstSeq_Data(node->ext.call.args);
+        usize num_nodes = AstSeq_Count(node->ext.call.args);
+        for (usize i = 0; i < num_nodes; i++) {
+            AstNode_PushAsStr_Recur(buf_nodes[i], buf, ind, dep);
+        }
+
+        break;
+    }
+
     case AstTag_LogNotOp:
 
     case AstTag_UnaPlusOp:
@@ -402,6 +681,47 @@ AstNode_PushAsStr_Recur(
         AstNode_PushAsStr_Recur(node->ext.if_else_stmt.else_br, buf, ind, dep);
         break;
 
+    case AstTag_MatchArm:
+        AstNode_PushAsStr_Recur(node->ext.match_arm.key, buf, ind, dep);
+        AstNode_PushAsStr_Recur(node->ext.match_arm.body, buf, ind, dep);
+        break;
+
+    case AstTag_MatchStmt: {
+        AstNode ** buf_arms = AstSeq_Data(node->ext.match_stmt.arms);
+        usize num_arms = AstSeq_Count(node->ext.match_stmt.arms);
+        AstNode_PushAsStr_Recur(node->ext.match_stmt.subj, buf, ind, dep);
+        for (usize i = 0; i < num_arms; i++) {
+            AstNode_PushAsStr_Recur(buf_arms[i], buf, ind, dep);
+        }
+        if (node->ext.match_stmt.else_br != NULL) {
+            AstNode_PushAsStr_Recur(node->ext.match_stmt.else_br,
+                buf, ind, dep);
+        }
+
+        break;
+    }
+
+    case AstTag_ExprStmt:
+        AstNode_PushAsStr_Recur(node->ext.expr_stmt.expr, buf, ind, dep);
+        break;
+
+    case AstTag_RetStmt:
+        if (node->ext.ret_stmt.val != NULL) {
+            AstNode_PushAsStr_Recur(node->ext.ret_stmt.val, buf, ind, dep);
+        }
+        break;
+
+    case AstTag_FuncDef: {
+        AstNode ** buf_nodes = AstSeq_Data(node->ext.func_def.params);
+        usize num_nodes = AstSeq_Count(node->ext.func_def.params);
+        for (usize i = 0; i < num_nodes; i++) {
+            AstNode_PushAsStr_Recur(buf_nodes[i], buf, ind, dep);
+        }
+        AstNode_PushAsStr_Recur(node->ext.func_def.body, buf, ind, dep);
+
+        break;
+    }
+
     case AstTag_BlockStmt:
 
     case AstTag_Prog: {
@@ -431,6 +751,193 @@ AstNode_PushAsStr(
     return AstNode_PushAsStr_Recur(node, buf, ind, &dep);
 }
 
+static
+usize
+AstNode_Census_Recur(
+    AstNode * node,
+    u64 * counts,
+    usize * num
+);
+
+static
+usize
+AstSeq_Census_Recur(
+    AstSeq * seq,
+    u64 * counts,
+    usize * num
+) {
+    AstNode ** buf_nodes = AstSeq_Data(seq);
+    usize depth = 0;
+
+    for (usize i = 0; i < AstSeq_Count(seq); i++) {
+        usize sub = AstNode_Census_Recur(buf_nodes[i], counts, num);
+
+        if (sub > depth) {
+            depth = sub;
+        }
+    }
+
+    return depth;
+}
+
+/* Counts the nodes of a subtree into `num` and by tag into `counts`, if
+   given, and returns the depth of the subtree. */
+static
+usize
+AstNode_Census_Recur(
+    AstNode * node,
+    u64 * counts,
+    usize * num
+) {
+    /* Child nodes, those absent are `NULL`. */
+    AstNode * kids[3] = { NULL, NULL, NULL };
+    AstSeq * seq = NULL;
+    usize depth = 0;
+
+    *num += 1;
+
+    if (counts != NULL) {
+        counts[node->tag] += 1;
+    }
+
+    switch (node->tag) {
+    case AstTag_StrLit:
+    case AstTag_NumLit:
+    case AstTag_BoolLit:
+    case AstTag_Var:
+        break;
+
+    case AstTag_Call:
+        seq = node->ext.call.args;
+        break;
+
+    case AstTag_LogNotOp:
+
+    case AstTag_UnaPlusOp:
+    case AstTag_UnaMinusOp:
+        kids[0] = node->ext.una_op.opd;
+        break;
+
+    case AstTag_LogOrOp:
+    case AstTag_LogAndOp:
+
+    case AstTag_RelEquOp:
+    case AstTag_RelNeqOp:
+    case AstTag_RelLtOp:
+    case AstTag_RelLteOp:
+    case AstTag_RelGtOp:
+    case AstTag_RelGteOp:
+
+    case AstTag_BinMulOp:
+    case AstTag_BinDivOp:
+    case AstTag_BinAddOp:
+    case AstTag_BinSubOp:
+    case AstTag_BinModOp:
+    case AstTag_BinExpOp:
+        kids[0] = node->ext.bin_op.lhs;
+        kids[1] = node->ext.bin_op.rhs;
+        break;
+
+    case AstTag_AsgnStmt:
+        kids[0] = node->ext.asgn_stmt.lhs;
+        kids[1] = node->ext.asgn_stmt.rhs;
+        break;
+
+    case AstTag_IfStmt:
+        kids[0] = node->ext.if_stmt.cond;
+        kids[1] = node->ext.if_stmt.then_br;
+        break;
+
+    case AstTag_IfElseStmt:
+        kids[0] = node->ext.if_else_stmt.cond;
+        kids[1] = node->ext.if_else_stmt.then_br;
+        kids[2] = node->ext.if_else_stmt.else_br;
+        break;
+
+    case AstTag_MatchArm:
+        kids[0] = node->ext.match_arm.key;
+        kids[1] = node->ext.match_arm.body;
+        break;
+
+    case AstTag_MatchStmt:
+        kids[0] = node->ext.match_stmt.subj;
+        kids[1] = node->ext.match_stmt.else_br;
+        seq = node->ext.match_stmt.arms;
+        break;
+
+    case AstTag_ExprStmt:
+        kids[0] = node->ext.expr_stmt.expr;
+        break;
+
+    case AstTag_RetStmt:
+        kids[0] = node->ext.ret_stmt.val;
+        break;
+
+    case AstTag_FuncDef:
+        seq = node->ext.func_def.params;
+        kids[0] = node->ext.func_def.body;
+        break;
+
+    case AstTag_BlockStmt:
+
+    case AstTag_Prog:
+        seq = node->ext.block.seq;
+        break;
+    }
+
+    for (usize i = 0; i < 3; i++) {
+        if (kids[i] != NULL) {
+            usize sub = AstNode_Census_Recur(kids[i], counts, num);
+
+            if (sub > depth) {
+                depth = sub;
+            }
+        }
+    }
+
+    if (seq != NULL) {
+        usize sub = AstSeq_Census_Recur(seq, counts, num);
+
+        if (sub > depth) {
+            depth = sub;
+        }
+    }
+
+    return depth + 1;
+}
+
+/**
+ * @brief Counts the nodes of a tree by tag.
+ *
+ * @param counts Counters indexed by `AstTag`, `AST_NUM_TAGS` of them, which
+ *               the counts are added to.
+ *
+ * @return The depth of the tree, the root being at depth 1.
+ */
+usize
+AstNode_Census(
+    AstNode * node,
+    u64 * counts
+) {
+    usize num = 0;
+
+    return AstNode_Census_Recur(node, counts, &num);
+}
+
+/**
+ * @brief Counts the nodes of a tree, including its root.
+ */
+usize
+AstNode_CountTree(
+    AstNode * node
+) {
+    usize num = 0;
+
+    AstNode_Census_Recur(node, NULL, &num);
+
+    return num;
+}
+
 void
 AstNode_FreeInner(
     AstNode * node
@@ -438,6 +945,8 @@ AstNode_FreeInner(
     switch (node->tag) {
     case AstTag_StrLit: FixedBuf_Free(node->ext.str_lit.str); break;
     case AstTag_Var: FixedBuf_Free(node->ext.var.str); break;
+    case AstTag_Call: FixedBuf_Free(node->ext.call.name); break;
+    case AstTag_FuncDef: FixedBuf_Free(node->ext.func_def.name); break;
     default: break;
     }
 }
@@ -447,7 +956,7 @@ AstNode_Free(
     AstNode * node
 ) {
     AstNode_FreeInner(node);
-    MeMem_Free(node);
+    MeMem_CacheFree(&ast_node_cache, node);
 }
 
 void
@@ -460,6 +969,11 @@ AstNode_FreeTree(
         break;
 
     case AstTag_NumLit:
+        if (node->ext.num_lit.big != NULL) {
+            BigInt_Free(node->ext.num_lit.big);
+        }
+        break;
+
     case AstTag_BoolLit:
         break;
 
@@ -467,6 +981,11 @@ AstNode_FreeTree(
         FixedBuf_Free(node->ext.var.str);
         break;
 
+    case AstTag_Call:
+        FixedBuf_Free(node->ext.call.name);
+        AstSeq_Free(node->ext.call.args);
+        break;
+
     case AstTag_LogNotOp:
 
     case AstTag_UnaPlusOp:
@@ -510,6 +1029,36 @@ AstNode_FreeTree(
         AstNode_FreeTree(node->ext.if_else_stmt.else_br);
         break;
 
+    case AstTag_MatchArm:
+        AstNode_FreeTree(node->ext.match_arm.key);
+        AstNode_FreeTree(node->ext.match_arm.body);
+        break;
+
+    case AstTag_MatchStmt:
+        MatchTab_Free(node->ext.match_stmt.tab);
+        AstNode_FreeTree(node->ext.match_stmt.subj);
+        AstSeq_Free(node->ext.match_stmt.arms);
+        if (node->ext.match_stmt.else_br != NULL) {
+            AstNode_FreeTree(node->ext.match_stmt.else_br);
+        }
+        break;
+
+    case AstTag_ExprStmt:
+        AstNode_FreeTree(node->ext.expr_stmt.expr);
+        break;
+
+    case AstTag_RetStmt:
+        if (node->ext.ret_stmt.val != NULL) {
+            AstNode_FreeTree(node->ext.ret_stmt.val);
+        }
+        break;
+
+    case AstTag_FuncDef:
+        FixedBuf_Free(node->ext.func_def.name);
+        AstSeq_Free(node->ext.func_def.params);
+        AstNode_FreeTree(node->ext.func_def.body);
+        break;
+
     case AstTag_BlockStmt:
 
     case AstTag_Prog:
@@ -517,7 +1066,7 @@ AstNode_FreeTree(
         break;
     }
 
-    MeMem_Free(node);
+    MeMem_CacheFree(&ast_node_cache, node);
 }
 
 typedef struct _AstSeq {
@@ -525,6 +1074,10 @@ typedef struct _AstSeq {
     usize num_nodes;
 } AstSeq;
 
+static
+_Thread_local MemCache
+ast_seq_cache = MEM_CACHE_INIT(sizeof(AstSeq));
+
 AstSeq *
 AstSeq_New(void) {
     FlexBuf * buf = FlexBuf_New();
@@ -532,7 +1085,7 @@ AstSeq_New(void) {
         goto Exit;
     }
 
-    AstSeq * seq = (AstSeq *)MeMem_Malloc(sizeof(AstSeq));
+    AstSeq * seq = (AstSeq *)MeMem_CacheAlloc(&ast_seq_cache);
     if (seq == NULL) {
         goto FreeFlexBuf;
     }
@@ -563,6 +1116,23 @@ AstSeq_Push(
     return true;
 }
 
+/**
+ * @brief Reserves room for at least `num` more nodes in an AstSeq.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+AstSeq_Reserve(
+    AstSeq * seq,
+    usize num
+) {
+    if (num > SIZE_MAX / sizeof(AstNode *)) {
+        return false;
+    }
+
+    return FlexBuf_Reserve(seq->buf_nodes, num * sizeof(AstNode *));
+}
+
 AstNode **
 AstSeq_Data(
     AstSeq * seq
@@ -648,5 +1218,5 @@ AstSeq_Free(
 ) {
     AstSeq_FreeNodes(seq);
     FlexBuf_Free(seq->buf_nodes);
-    MeMem_Free(seq);
+    MeMem_CacheFree(&ast_seq_cache, seq);
 }
\ No newline at end of file
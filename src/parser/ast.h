@@ -4,12 +4,14 @@
 #include "menos.h"
 #include "util/fixed_buf.h"
 #include "util/flex_buf.h"
+#include "util/big_int.h"
 
 typedef enum _AstTag {
     AstTag_StrLit,      /* String literal. */
     AstTag_NumLit,      /* Numeric literal. */
     AstTag_BoolLit,     /* Boolean literal. */
     AstTag_Var,         /* Variable. */
+    AstTag_Call,        /* Function call. */
 
     AstTag_LogNotOp,    /* Logical NOT. */
     AstTag_LogOrOp,     /* Logical OR. */
@@ -35,15 +37,29 @@ typedef enum _AstTag {
     AstTag_AsgnStmt,
     AstTag_IfStmt,      /* If statement. */
     AstTag_IfElseStmt,  /* If-else statement. */
+    AstTag_MatchArm,    /* Match arm. */
+    AstTag_MatchStmt,   /* Match statement. */
     AstTag_BlockStmt,
+    AstTag_ExprStmt,    /* Expression statement. */
+    AstTag_RetStmt,     /* Return statement. */
+    AstTag_FuncDef,     /* Function definition. */
 
     AstTag_Prog,
 } AstTag;
 
+#define AST_NUM_TAGS    (AstTag_Prog + 1)
+
+const char *
+AstTag_ToStr(
+    AstTag tag
+);
+
 typedef struct _AstNode AstNode;
 
 typedef struct _AstSeq AstSeq;
 
+typedef struct _MatchTab MatchTab;
+
 AstNode *
 AstNode_New(void);
 
@@ -60,6 +76,11 @@ AstNode_NewNumLit(
     ssize num
 );
 
+AstNode *
+AstNode_NewBigNumLit(
+    BigInt * big
+);
+
 AstNode *
 AstNode_NewBoolLit(
     bool val
@@ -70,6 +91,12 @@ AstNode_NewVar(
     FixedBuf * str
 );
 
+AstNode *
+AstNode_NewCall(
+    FixedBuf * name,
+    AstSeq * args
+);
+
 AstNode *
 AstNode_NewUnaOp(
     AstTag tag,
@@ -108,6 +135,37 @@ AstNode_NewIfElseStmt(
     AstNode * else_br
 );
 
+AstNode *
+AstNode_NewMatchArm(
+    AstNode * key,
+    AstNode * body
+);
+
+AstNode *
+AstNode_NewMatchStmt(
+    AstNode * subj,
+    AstSeq * arms,
+    AstNode * else_br,
+    usize * dup
+);
+
+AstNode *
+AstNode_NewExprStmt(
+    AstNode * expr
+);
+
+AstNode *
+AstNode_NewRetStmt(
+    AstNode * val
+);
+
+AstNode *
+AstNode_NewFuncDef(
+    FixedBuf * name,
+    AstSeq * params,
+    AstNode * body
+);
+
 bool
 AstNode_PushAsStr(
     AstNode * node,
@@ -115,6 +173,17 @@ AstNode_PushAsStr(
     ssize ind
 );
 
+usize
+AstNode_CountTree(
+    AstNode * node
+);
+
+usize
+AstNode_Census(
+    AstNode * node,
+    u64 * counts
+);
+
 void
 AstNode_Free(
     AstNode * node
@@ -128,13 +197,23 @@ AstNode_FreeTree(
 typedef struct _AstNode {
     AstTag tag;
 
+    /* Position of the first token, set on statements, match arms and
+       function definitions only. */
+    usize row;
+    usize col;
+
     union {
         struct {
             FixedBuf * str;
         } str_lit;
 
         struct {
+
+            /* Value, only valid if `big` is `NULL`. */
             ssize num;
+
+            /* Owned value of a literal that does not fit in `ssize`. */
+            BigInt * big;
         } num_lit;
 
         struct {
@@ -143,8 +222,17 @@ typedef struct _AstNode {
 
         struct {
             FixedBuf * str;
+            bool local;         /* Frame slot or global slot. */
+            usize slot;         /* Slot index, set by the resolver. */
         } var;
 
+        struct {
+            FixedBuf * name;    /* Callee name. */
+            AstSeq * args;      /* Argument expressions. */
+            AstNode * func;     /* Callee definition, set by the resolver. */
+            bool tail;          /* Whether it is a tail call. */
+        } call;
+
         struct {
             AstNode * opd;
         } una_op;
@@ -152,6 +240,9 @@ typedef struct _AstNode {
         struct {
             AstNode * lhs;
             AstNode * rhs;
+
+            /* Root expression index, set by the resolver. */
+            usize chunk;
         } bin_op;
 
         struct {
@@ -165,6 +256,18 @@ typedef struct _AstNode {
             AstNode * else_br;  /* else-branch. */
         } if_else_stmt;
 
+        struct {
+            AstNode * key;      /* Literal key. */
+            AstNode * body;     /* Arm body. */
+        } match_arm;
+
+        struct {
+            AstNode * subj;     /* Subject expression. */
+            AstSeq * arms;      /* Literal arms. */
+            AstNode * else_br;  /* else-branch, may be NULL. */
+            MatchTab * tab;     /* Dispatch table of the arms. */
+        } match_stmt;
+
         struct {
             AstNode * lhs;
             AstNode * rhs;
@@ -173,6 +276,21 @@ typedef struct _AstNode {
         struct {
             AstSeq * seq;
         } block;
+
+        struct {
+            AstNode * expr;
+        } expr_stmt;
+
+        struct {
+            AstNode * val;      /* Returned expression, may be NULL. */
+        } ret_stmt;
+
+        struct {
+            FixedBuf * name;    /* Function name. */
+            AstSeq * params;    /* Parameter variables. */
+            AstNode * body;     /* Function body. */
+            usize num_slots;    /* Frame size, set by the resolver. */
+        } func_def;
     } ext;
 } AstNode;
 
@@ -185,6 +303,12 @@ AstSeq_Push(
     AstNode * node
 );
 
+bool
+AstSeq_Reserve(
+    AstSeq * seq,
+    usize num
+);
+
 AstNode **
 AstSeq_Data(
     AstSeq * seq
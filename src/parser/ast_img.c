@@ -0,0 +1,967 @@
+#include <string.h>
+
+#include "ast_img.h"
+#include "memory/allocate.h"
+#include "util/hash.h"
+
+/* An image holds the nodes of a tree in post-order, so that children come
+   before their parents and the root is the last node. References between
+   nodes are node indices, sequences are runs of indices in a table of
+   references and names and literals are offsets into a pool of bytes. The
+   image is position-independent and loading it relocates the references
+   into pointers to new nodes.
+
+   Layout: `ImgHdr`, `ImgNode[num_nodes]`, `u64[num_refs]`, pool. */
+
+typedef struct _ImgHdr {
+    u64 num_nodes;
+    u64 num_refs;
+    u64 pool_size;
+} ImgHdr;
+
+/* Node record, the meaning of the references depends on the tag. */
+typedef struct _ImgNode {
+    u32 tag;
+
+    /* Value of a boolean literal, or whether a numeric literal is big. */
+    u32 flag;
+
+    u64 row;
+    u64 col;
+    u64 refs[3];
+} ImgNode;
+
+/* Reference to an absent child. */
+#define IMG_NONE ((u64)-1)
+
+/* Tags by the positions they may take. */
+#define TAG_BIT(tag)    ((u64)1 << (tag))
+
+#define LIT_TAGS                                                    \
+    (TAG_BIT(AstTag_StrLit) | TAG_BIT(AstTag_NumLit) |              \
+     TAG_BIT(AstTag_BoolLit))
+
+#define EXPR_TAGS                                                   \
+    (TAG_BIT(AstTag_BinExpOp + 1) - TAG_BIT(AstTag_StrLit))
+
+#define STMT_TAGS                                                   \
+    (TAG_BIT(AstTag_AsgnStmt) | TAG_BIT(AstTag_IfStmt) |            \
+     TAG_BIT(AstTag_IfElseStmt) | TAG_BIT(AstTag_MatchStmt) |       \
+     TAG_BIT(AstTag_BlockStmt) | TAG_BIT(AstTag_ExprStmt) |         \
+     TAG_BIT(AstTag_RetStmt))
+
+typedef struct _ImgWriter {
+    FlexBuf * nodes;
+    FlexBuf * refs;
+    FlexBuf * pool;
+    u64 num_nodes;
+} ImgWriter;
+
+typedef struct _ImgReader {
+    const u8 * nodes;
+    const u8 * refs;
+    const u8 * pool;
+    ImgHdr hdr;
+
+    /* Nodes built so far and not yet taken by a parent. */
+    AstNode ** table;
+} ImgReader;
+
+/**
+ * @brief Returns the fingerprint of the image layout, which differs between
+ *        builds that cannot load the images of each other.
+ */
+u64
+AstImg_Fingerprint(void) {
+    const u64 PARTS[] = {
+        AST_IMG_VERSION,
+        AST_NUM_TAGS,
+        sizeof(ImgNode),
+        sizeof(usize),
+
+        /* Images hold integers in the byte order of the host. */
+        (u64)0x0102030405060708UL,
+    };
+
+    return Hash_Fnv1a((const u8 *)PARTS, sizeof(PARTS));
+}
+
+static
+bool
+ImgWriter_PushBytes(
+    ImgWriter * w,
+    const u8 * buf,
+    usize len,
+    u64 * off
+) {
+    u64 len_64 = len;
+
+    *off = FlexBuf_Size(w->pool);
+
+    return FlexBuf_PushBuf(w->pool, &len_64, sizeof(u64)) &&
+        FlexBuf_PushBuf(w->pool, buf, len);
+}
+
+static
+bool
+ImgWriter_PushStr(
+    ImgWriter * w,
+    FixedBuf * str,
+    u64 * off
+) {
+    return ImgWriter_PushBytes(w, FixedBuf_Data(str), FixedBuf_Size(str),
+        off);
+}
+
+static
+bool
+ImgWriter_PushNode(
+    ImgWriter * w,
+    AstNode * node,
+    u64 * idx
+);
+
+static
+bool
+ImgWriter_PushOpt(
+    ImgWriter * w,
+    AstNode * node,
+    u64 * idx
+) {
+    if (node == NULL) {
+        *idx = IMG_NONE;
+        return true;
+    }
+
+    return ImgWriter_PushNode(w, node, idx);
+}
+
+/**
+ * @brief Writes the nodes of a sequence, then the run of their indices.
+ */
+static
+bool
+ImgWriter_PushSeq(
+    ImgWriter * w,
+    AstSeq * seq,
+    u64 * off
+) {
+    AstNode ** buf_nodes = AstSeq_Data(seq);
+    u64 num_nodes = AstSeq_Count(seq);
+    bool res = false;
+
+    u64 * idxs = (u64 *)MeMem_Malloc(sizeof(u64) * (num_nodes + 1));
+    if (idxs == NULL) {
+        goto Exit;
+    }
+
+    idxs[0] = num_nodes;
+
+    for (usize i = 0; i < num_nodes; i++) {
+        if (ImgWriter_PushNode(w, buf_nodes[i], idxs + i + 1) == false) {
+            goto FreeIdxs;
+        }
+    }
+
+    *off = FlexBuf_Size(w->refs) / sizeof(u64);
+    res = FlexBuf_PushBuf(w->refs, idxs, sizeof(u64) * (num_nodes + 1));
+
+FreeIdxs:
+    MeMem_Free(idxs);
+
+Exit:
+    return res;
+}
+
+static
+bool
+ImgWriter_PushNode(
+    ImgWriter * w,
+    AstNode * node,
+    u64 * idx
+) {
+    ImgNode rec;
+    bool res = true;
+
+    memset(&rec, 0, sizeof(ImgNode));
+    rec.tag = (u32)node->tag;
+    rec.row = node->row;
+    rec.col = node->col;
+
+    switch (node->tag) {
+    case AstTag_StrLit:
+        res = ImgWriter_PushStr(w, node->ext.str_lit.str, rec.refs);
+        break;
+
+    case AstTag_NumLit:
+        if (node->ext.num_lit.big == NULL) {
+            rec.refs[0] = (u64)node->ext.num_lit.num;
+            break;
+        }
+
+        FlexBuf * dec = FlexBuf_New();
+        if (dec == NULL) {
+            return false;
+        }
+
+        rec.flag = 1;
+        res = BigInt_PushAsStr(node->ext.num_lit.big, dec) &&
+            ImgWriter_PushBytes(w, FlexBuf_Data(dec), FlexBuf_Size(dec),
+                rec.refs);
+
+        FlexBuf_Free(dec);
+        break;
+
+    case AstTag_BoolLit:
+        rec.flag = node->ext.bool_lit.val ? 1 : 0;
+        break;
+
+    case AstTag_Var:
+        res = ImgWriter_PushStr(w, node->ext.var.str, rec.refs);
+        break;
+
+    case AstTag_Call:
+        res = ImgWriter_PushStr(w, node->ext.call.name, rec.refs) &&
+            ImgWriter_PushSeq(w, node->ext.call.args, rec.refs + 1);
+        break;
+
+    case AstTag_LogNotOp:
+
+    case AstTag_UnaPlusOp:
+    case AstTag_UnaMinusOp:
+        res = ImgWriter_PushNode(w, node->ext.una_op.opd, rec.refs);
+        break;
+
+    case AstTag_LogOrOp:
+    case AstTag_LogAndOp:
+
+    case AstTag_RelEquOp:
+    case AstTag_RelNeqOp:
+    case AstTag_RelLtOp:
+    case AstTag_RelLteOp:
+    case AstTag_RelGtOp:
+    case AstTag_RelGteOp:
+
+    case AstTag_BinAddOp:
+    case AstTag_BinSubOp:
+    case AstTag_BinMulOp:
+    case AstTag_BinDivOp:
+    case AstTag_BinModOp:
+    case AstTag_BinExpOp:
+        res = ImgWriter_PushNode(w, node->ext.bin_op.lhs, rec.refs) &&
+            ImgWriter_PushNode(w, node->ext.bin_op.rhs, rec.refs + 1);
+        break;
+
+    case AstTag_AsgnStmt:
+        res = ImgWriter_PushNode(w, node->ext.asgn_stmt.lhs, rec.refs) &&
+            ImgWriter_PushNode(w, node->ext.asgn_stmt.rhs, rec.refs + 1);
+        break;
+
+    case AstTag_IfStmt:
+        res = ImgWriter_PushNode(w, node->ext.if_stmt.cond, rec.refs) &&
+            ImgWriter_PushNode(w, node->ext.if_stmt.then_br, rec.refs + 1);
+        break;
+
+    case AstTag_IfElseStmt:
+        res = ImgWriter_PushNode(w,
+                node->ext.if_else_stmt.cond, rec.refs) &&
+            ImgWriter_PushNode(w,
+                node->ext.if_else_stmt.then_br, rec.refs + 1) &&
+            ImgWriter_PushNode(w,
+                node->ext.if_else_stmt.else_br, rec.refs + 2);
+        break;
+
+    case AstTag_MatchArm:
+        res = ImgWriter_PushNode(w, node->ext.match_arm.key, rec.refs) &&
+            ImgWriter_PushNode(w, node->ext.match_arm.body, rec.refs + 1);
+        break;
+
+    case AstTag_MatchStmt:
+        res = ImgWriter_PushNode(w,
+                node->ext.match_stmt.subj, rec.refs) &&
+            ImgWriter_PushSeq(w,
+                node->ext.match_stmt.arms, rec.refs + 1) &&
+            ImgWriter_PushOpt(w,
+                node->ext.match_stmt.else_br, rec.refs + 2);
+        break;
+
+    case AstTag_BlockStmt:
+    case AstTag_Prog:
+        res = ImgWriter_PushSeq(w, node->ext.block.seq, rec.refs);
+        break;
+
+    case AstTag_ExprStmt:
+        res = ImgWriter_PushNode(w, node->ext.expr_stmt.expr, rec.refs);
+        break;
+
+    case AstTag_RetStmt:
+        res = ImgWriter_PushOpt(w, node->ext.ret_stmt.val, rec.refs);
+        break;
+
+    case AstTag_FuncDef:
+        res = ImgWriter_PushStr(w, node->ext.func_def.name, rec.refs) &&
+            ImgWriter_PushSeq(w, node->ext.func_def.params, rec.refs + 1) &&
+            ImgWriter_PushNode(w, node->ext.func_def.body, rec.refs + 2);
+        break;
+    }
+
+    if (res == false ||
+        FlexBuf_PushBuf(w->nodes, &rec, sizeof(ImgNode)) == false) {
+
+        return false;
+    }
+
+    *idx = w->num_nodes;
+    w->num_nodes += 1;
+
+    return true;
+}
+
+/**
+ * @brief Appends the image of a program to a FlexBuf.
+ *
+ * Only the syntax is kept, what the resolver sets is not.
+ *
+ * @param tree A pointer to the program node.
+ * @param buf A pointer to the FlexBuf.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+AstImg_Push(
+    AstNode * tree,
+    FlexBuf * buf
+) {
+    ImgWriter w;
+    bool res = false;
+    u64 root;
+
+    w.num_nodes = 0;
+
+    w.nodes = FlexBuf_New();
+    if (w.nodes == NULL) {
+        goto Exit;
+    }
+
+    w.refs = FlexBuf_New();
+    if (w.refs == NULL) {
+        goto FreeNodes;
+    }
+
+    w.pool = FlexBuf_New();
+    if (w.pool == NULL) {
+        goto FreeRefs;
+    }
+
+    if (ImgWriter_PushNode(&w, tree, &root) == false) {
+        goto FreePool;
+    }
+
+    ImgHdr hdr;
+    hdr.num_nodes = w.num_nodes;
+    hdr.num_refs = FlexBuf_Size(w.refs) / sizeof(u64);
+    hdr.pool_size = FlexBuf_Size(w.pool);
+
+    res = FlexBuf_Reserve(buf, sizeof(ImgHdr) + FlexBuf_Size(w.nodes) +
+            FlexBuf_Size(w.refs) + FlexBuf_Size(w.pool)) &&
+        FlexBuf_PushBuf(buf, &hdr, sizeof(ImgHdr)) &&
+        FlexBuf_PushBuf(buf, FlexBuf_Data(w.nodes), FlexBuf_Size(w.nodes)) &&
+        FlexBuf_PushBuf(buf, FlexBuf_Data(w.refs), FlexBuf_Size(w.refs)) &&
+        FlexBuf_PushBuf(buf, FlexBuf_Data(w.pool), FlexBuf_Size(w.pool));
+
+FreePool:
+    FlexBuf_Free(w.pool);
+
+FreeRefs:
+    FlexBuf_Free(w.refs);
+
+FreeNodes:
+    FlexBuf_Free(w.nodes);
+
+Exit:
+    return res;
+}
+
+static
+u64
+ImgReader_Ref(
+    ImgReader * r,
+    u64 off
+) {
+    u64 ref;
+    memcpy(&ref, r->refs + off * sizeof(u64), sizeof(u64));
+
+    return ref;
+}
+
+/**
+ * @brief Finds the bytes at an offset of the pool.
+ *
+ * @return A pointer to the bytes, or `NULL` if they overrun the pool.
+ */
+static
+const u8 *
+ImgReader_Bytes(
+    ImgReader * r,
+    u64 off,
+    usize * len
+) {
+    u64 len_64;
+
+    if (off > r->hdr.pool_size ||
+        r->hdr.pool_size - off < sizeof(u64)) {
+
+        return NULL;
+    }
+
+    memcpy(&len_64, r->pool + off, sizeof(u64));
+
+    if (len_64 > r->hdr.pool_size - off - sizeof(u64)) {
+        return NULL;
+    }
+
+    *len = (usize)len_64;
+
+    return r->pool + off + sizeof(u64);
+}
+
+static
+FixedBuf *
+ImgReader_Str(
+    ImgReader * r,
+    u64 off
+) {
+    usize len;
+
+    const u8 * buf = ImgReader_Bytes(r, off, &len);
+    if (buf == NULL) {
+        return NULL;
+    }
+
+    return FixedBuf_NewFromBuf(buf, len);
+}
+
+/**
+ * @brief Looks up a child built before the node at `limit`, which must have
+ *        one of the given tags and not be taken by another parent.
+ *
+ * @return A pointer to the child, or `NULL` if the reference is invalid.
+ */
+static
+AstNode *
+ImgReader_Peek(
+    ImgReader * r,
+    u64 idx,
+    u64 limit,
+    u64 tags
+) {
+    if (idx >= limit ||
+        r->table[idx] == NULL ||
+        (TAG_BIT(r->table[idx]->tag) & tags) == 0) {
+
+        return NULL;
+    }
+
+    return r->table[idx];
+}
+
+/**
+ * @brief Builds a sequence, taking its nodes at once.
+ */
+static
+AstSeq *
+ImgReader_Seq(
+    ImgReader * r,
+    u64 off,
+    u64 limit,
+    u64 tags
+) {
+    if (off >= r->hdr.num_refs) {
+        return NULL;
+    }
+
+    u64 num_nodes = ImgReader_Ref(r, off);
+    if (num_nodes > r->hdr.num_refs - off - 1) {
+        return NULL;
+    }
+
+    AstSeq * seq = AstSeq_New();
+    if (seq == NULL) {
+        goto Exit;
+    }
+
+    if (AstSeq_Reserve(seq, num_nodes) == false) {
+        goto FreeSeq;
+    }
+
+    for (u64 i = 0; i < num_nodes; i++) {
+        u64 idx = ImgReader_Ref(r, off + 1 + i);
+
+        AstNode * node = ImgReader_Peek(r, idx, limit, tags);
+        if (node == NULL ||
+            AstSeq_Push(seq, node) == false) {
+
+            goto FreeSeq;
+        }
+
+        r->table[idx] = NULL;
+    }
+
+    return seq;
+
+FreeSeq:
+    AstSeq_Free(seq);
+
+Exit:
+    return NULL;
+}
+
+/**
+ * @brief Builds a numeric literal, checking that big values are decimal
+ *        and indeed do not fit in `ssize`.
+ */
+static
+AstNode *
+ImgReader_NumLit(
+    ImgReader * r,
+    const ImgNode * rec
+) {
+    if (rec->flag == 0) {
+        return AstNode_NewNumLit((ssize)rec->refs[0]);
+    }
+
+    usize len;
+    ssize num;
+
+    const u8 * buf = ImgReader_Bytes(r, rec->refs[0], &len);
+    if (buf == NULL ||
+        len == 0) {
+
+        return NULL;
+    }
+
+    for (usize i = 0; i < len; i++) {
+        if ((buf[i] < '0' || buf[i] > '9') &&
+            (i != 0 || buf[i] != '-' || len == 1)) {
+
+            return NULL;
+        }
+    }
+
+    BigInt * big = BigInt_NewFromDec(buf, len);
+    if (big == NULL) {
+        return NULL;
+    }
+
+    AstNode * node = NULL;
+
+    if (BigInt_ToSsize(big, &num) == false) {
+        node = AstNode_NewBigNumLit(big);
+    }
+
+    BigInt_Free(big);
+
+    return node;
+}
+
+/**
+ * @brief Creates a node that owns a name from the pool, as the constructors
+ *        would clone it.
+ */
+static
+AstNode *
+ImgReader_NamedNode(
+    ImgReader * r,
+    AstTag tag,
+    u64 off
+) {
+    FixedBuf * str = ImgReader_Str(r, off);
+    if (str == NULL) {
+        goto Exit;
+    }
+
+    /* Only string literals may be empty, the lexer never yields an empty
+       name. */
+    if (tag != AstTag_StrLit &&
+        FixedBuf_Size(str) == 0) {
+
+        goto FreeStr;
+    }
+
+    AstNode * node = AstNode_New();
+    if (node == NULL) {
+        goto FreeStr;
+    }
+
+    node->tag = tag;
+
+    switch (tag) {
+    case AstTag_StrLit:
+        node->ext.str_lit.str = str;
+        break;
+
+    case AstTag_Var:
+        node->ext.var.str = str;
+        node->ext.var.local = false;
+        node->ext.var.slot = 0;
+        break;
+
+    case AstTag_Call:
+        node->ext.call.name = str;
+        node->ext.call.args = NULL;
+        node->ext.call.func = NULL;
+        node->ext.call.tail = false;
+        break;
+
+    default:
+        node->ext.func_def.name = str;
+        node->ext.func_def.params = NULL;
+        node->ext.func_def.body = NULL;
+        node->ext.func_def.num_slots = 0;
+        break;
+    }
+
+    return node;
+
+FreeStr:
+    FixedBuf_Free(str);
+
+Exit:
+    return NULL;
+}
+
+/**
+ * @brief Builds the node of a record, taking its children from the table
+ *        on success.
+ *
+ * @return A pointer to the node, or `NULL` if the record is invalid or
+ *         memory allocation fails.
+ */
+static
+AstNode *
+ImgReader_Node(
+    ImgReader * r,
+    const ImgNode * rec,
+    u64 idx
+) {
+    const u64 * refs = rec->refs;
+    AstNode * kids[3] = { NULL, NULL, NULL };
+    AstNode * node = NULL;
+    AstSeq * seq = NULL;
+
+    if (rec->tag >= AST_NUM_TAGS) {
+        return NULL;
+    }
+
+    AstTag tag = (AstTag)rec->tag;
+
+    /* Direct children are looked up first and taken last, sequences are
+       taken as they are built. */
+    switch (tag) {
+    case AstTag_StrLit:
+    case AstTag_Var:
+        node = ImgReader_NamedNode(r, tag, refs[0]);
+        break;
+
+    case AstTag_NumLit:
+        node = ImgReader_NumLit(r, rec);
+        break;
+
+    case AstTag_BoolLit:
+        if (rec->flag <= 1) {
+            node = AstNode_NewBoolLit(rec->flag == 1);
+        }
+        break;
+
+    case AstTag_Call:
+        seq = ImgReader_Seq(r, refs[1], idx, EXPR_TAGS);
+        if (seq == NULL) {
+            break;
+        }
+
+        node = ImgReader_NamedNode(r, tag, refs[0]);
+        if (node != NULL) {
+            node->ext.call.args = seq;
+            seq = NULL;
+        }
+        break;
+
+    case AstTag_LogNotOp:
+
+    case AstTag_UnaPlusOp:
+    case AstTag_UnaMinusOp:
+        kids[0] = ImgReader_Peek(r, refs[0], idx, EXPR_TAGS);
+        if (kids[0] != NULL) {
+            node = AstNode_NewUnaOp(tag, kids[0]);
+        }
+        break;
+
+    case AstTag_LogOrOp:
+    case AstTag_LogAndOp:
+
+    case AstTag_RelEquOp:
+    case AstTag_RelNeqOp:
+    case AstTag_RelLtOp:
+    case AstTag_RelLteOp:
+    case AstTag_RelGtOp:
+    case AstTag_RelGteOp:
+
+    case AstTag_BinAddOp:
+    case AstTag_BinSubOp:
+    case AstTag_BinMulOp:
+    case AstTag_BinDivOp:
+    case AstTag_BinModOp:
+    case AstTag_BinExpOp:
+        kids[0] = ImgReader_Peek(r, refs[0], idx, EXPR_TAGS);
+        kids[1] = ImgReader_Peek(r, refs[1], idx, EXPR_TAGS);
+        if (kids[0] != NULL &&
+            kids[1] != NULL &&
+            kids[0] != kids[1]) {
+
+            node = AstNode_NewBinOp(tag, kids[0], kids[1]);
+        }
+        break;
+
+    case AstTag_AsgnStmt:
+        kids[0] = ImgReader_Peek(r, refs[0], idx, TAG_BIT(AstTag_Var));
+        kids[1] = ImgReader_Peek(r, refs[1], idx, EXPR_TAGS);
+        if (kids[0] != NULL &&
+            kids[1] != NULL &&
+            kids[0] != kids[1]) {
+
+            node = AstNode_NewAsgnStmt(kids[0], kids[1]);
+        }
+        break;
+
+    case AstTag_IfStmt:
+        kids[0] = ImgReader_Peek(r, refs[0], idx, EXPR_TAGS);
+        kids[1] = ImgReader_Peek(r, refs[1], idx, STMT_TAGS);
+        if (kids[0] != NULL &&
+            kids[1] != NULL) {
+
+            node = AstNode_NewIfStmt(kids[0], kids[1]);
+        }
+        break;
+
+    case AstTag_IfElseStmt:
+        kids[0] = ImgReader_Peek(r, refs[0], idx, EXPR_TAGS);
+        kids[1] = ImgReader_Peek(r, refs[1], idx, STMT_TAGS);
+        kids[2] = ImgReader_Peek(r, refs[2], idx, STMT_TAGS);
+        if (kids[0] != NULL &&
+            kids[1] != NULL &&
+            kids[2] != NULL &&
+            kids[1] != kids[2]) {
+
+            node = AstNode_NewIfElseStmt(kids[0], kids[1], kids[2]);
+        }
+        break;
+
+    case AstTag_MatchArm:
+        kids[0] = ImgReader_Peek(r, refs[0], idx, LIT_TAGS);
+        kids[1] = ImgReader_Peek(r, refs[1], idx, STMT_TAGS);
+        if (kids[0] != NULL &&
+            kids[1] != NULL) {
+
+            node = AstNode_NewMatchArm(kids[0], kids[1]);
+        }
+        break;
+
+    case AstTag_MatchStmt:
+        kids[0] = ImgReader_Peek(r, refs[0], idx, EXPR_TAGS);
+        if (kids[0] == NULL) {
+            break;
+        }
+
+        if (refs[2] != IMG_NONE) {
+            kids[2] = ImgReader_Peek(r, refs[2], idx, STMT_TAGS);
+            if (kids[2] == NULL) {
+                break;
+            }
+        }
+
+        seq = ImgReader_Seq(r, refs[1], idx, TAG_BIT(AstTag_MatchArm));
+        if (seq == NULL) {
+            break;
+        }
+
+        /* Arms of the same key are rejected with the table. */
+        usize dup;
+        node = AstNode_NewMatchStmt(kids[0], seq, kids[2], &dup);
+        if (node != NULL) {
+            seq = NULL;
+        }
+        break;
+
+    case AstTag_BlockStmt:
+    case AstTag_Prog:
+        seq = ImgReader_Seq(r, refs[0], idx, tag == AstTag_Prog ?
+            STMT_TAGS | TAG_BIT(AstTag_FuncDef) : STMT_TAGS);
+        if (seq == NULL) {
+            break;
+        }
+
+        node = AstNode_NewBlock(tag, seq);
+        if (node != NULL) {
+            seq = NULL;
+        }
+        break;
+
+    case AstTag_ExprStmt:
+        kids[0] = ImgReader_Peek(r, refs[0], idx, EXPR_TAGS);
+        if (kids[0] != NULL) {
+            node = AstNode_NewExprStmt(kids[0]);
+        }
+        break;
+
+    case AstTag_RetStmt:
+        if (refs[0] != IMG_NONE) {
+            kids[0] = ImgReader_Peek(r, refs[0], idx, EXPR_TAGS);
+            if (kids[0] == NULL) {
+                break;
+            }
+        }
+
+        node = AstNode_NewRetStmt(kids[0]);
+        break;
+
+    case AstTag_FuncDef:
+        kids[2] = ImgReader_Peek(r, refs[2], idx, STMT_TAGS);
+        if (kids[2] == NULL) {
+            break;
+        }
+
+        seq = ImgReader_Seq(r, refs[1], idx, TAG_BIT(AstTag_Var));
+        if (seq == NULL) {
+            break;
+        }
+
+        node = ImgReader_NamedNode(r, tag, refs[0]);
+        if (node != NULL) {
+            node->ext.func_def.params = seq;
+            node->ext.func_def.body = kids[2];
+            seq = NULL;
+        }
+        break;
+    }
+
+    /* Nodes of a sequence left unused are freed along with it. */
+    if (seq != NULL) {
+        AstSeq_Free(seq);
+    }
+
+    if (node == NULL) {
+        return NULL;
+    }
+
+    for (usize i = 0; i < 3; i++) {
+        if (kids[i] != NULL) {
+            r->table[refs[i]] = NULL;
+        }
+    }
+
+    node->row = (usize)rec->row;
+    node->col = (usize)rec->col;
+
+    return node;
+}
+
+/**
+ * @brief Builds a program from its image.
+ *
+ * The image is checked as it is read, so an image that is damaged or was
+ * not written by `AstImg_Push` fails to load rather than yields an invalid
+ * tree.
+ *
+ * @param buf A pointer to the image, with no alignment requirement.
+ * @param len The size of the image in bytes.
+ * @param tree A pointer to receive the program node, to be freed with
+ *             `AstNode_FreeTree`.
+ *
+ * @return `true` on success, `false` if the image is invalid or memory
+ *         allocation fails.
+ */
+bool
+AstImg_Load(
+    const u8 * buf,
+    usize len,
+    AstNode ** tree
+) {
+    ImgReader r;
+    bool res = false;
+
+    if (len < sizeof(ImgHdr)) {
+        goto Exit;
+    }
+
+    memcpy(&r.hdr, buf, sizeof(ImgHdr));
+
+    usize rest = len - sizeof(ImgHdr);
+
+    if (r.hdr.num_nodes == 0 ||
+        r.hdr.num_nodes > rest / sizeof(ImgNode)) {
+
+        goto Exit;
+    }
+
+    rest -= (usize)r.hdr.num_nodes * sizeof(ImgNode);
+
+    if (r.hdr.num_refs > rest / sizeof(u64)) {
+        goto Exit;
+    }
+
+    rest -= (usize)r.hdr.num_refs * sizeof(u64);
+
+    if (r.hdr.pool_size != rest) {
+        goto Exit;
+    }
+
+    r.nodes = buf + sizeof(ImgHdr);
+    r.refs = r.nodes + r.hdr.num_nodes * sizeof(ImgNode);
+    r.pool = r.refs + r.hdr.num_refs * sizeof(u64);
+
+    usize num_nodes = (usize)r.hdr.num_nodes;
+
+    r.table = (AstNode **)MeMem_Malloc(sizeof(AstNode *) * num_nodes);
+    if (r.table == NULL) {
+        goto Exit;
+    }
+
+    memset(r.table, 0, sizeof(AstNode *) * num_nodes);
+
+    for (usize i = 0; i < num_nodes; i++) {
+        ImgNode rec;
+        memcpy(&rec, r.nodes + i * sizeof(ImgNode), sizeof(ImgNode));
+
+        r.table[i] = ImgReader_Node(&r, &rec, i);
+        if (r.table[i] == NULL) {
+            goto FreeNodes;
+        }
+    }
+
+    /* Every node but the root belongs to a parent. */
+    if (r.table[num_nodes - 1]->tag != AstTag_Prog) {
+        goto FreeNodes;
+    }
+
+    for (usize i = 0; i + 1 < num_nodes; i++) {
+        if (r.table[i] != NULL) {
+            goto FreeNodes;
+        }
+    }
+
+    *tree = r.table[num_nodes - 1];
+    r.table[num_nodes - 1] = NULL;
+    res = true;
+
+FreeNodes:
+    for (usize i = 0; i < num_nodes; i++) {
+        if (r.table[i] != NULL) {
+            AstNode_FreeTree(r.table[i]);
+        }
+    }
+
+    MeMem_Free(r.table);
+
+Exit:
+    return res;
+}
\ No newline at end of file
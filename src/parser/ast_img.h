@@ -0,0 +1,28 @@
+#ifndef __ME_PARSER_AST_IMG_H__
+#define __ME_PARSER_AST_IMG_H__
+
+#include "menos.h"
+#include "ast.h"
+#include "util/flex_buf.h"
+
+/* Version of the image layout, bumped whenever images of older versions
+   can no longer be loaded. */
+#define AST_IMG_VERSION     1
+
+u64
+AstImg_Fingerprint(void);
+
+bool
+AstImg_Push(
+    AstNode * tree,
+    FlexBuf * buf
+);
+
+bool
+AstImg_Load(
+    const u8 * buf,
+    usize len,
+    AstNode ** tree
+);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,297 @@
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "code_cache.h"
+#include "ast_img.h"
+#include "memory/allocate.h"
+#include "util/flex_buf.h"
+#include "util/hash.h"
+#include "util/map_file.h"
+
+/* An entry is named after the hash of the source and the fingerprint, and
+   holds `CacheHdr`, the source, then the image of the tree. The source is
+   kept to tell apart sources of the same hash. */
+typedef struct _CacheHdr {
+    u8 magic[8];
+    u64 fingerprint;
+    u64 src_size;
+    u64 img_size;
+
+    /* Hash of the image. */
+    u64 hash;
+} CacheHdr;
+
+static const u8 CACHE_MAGIC[8] = { 'M', 'E', 'C', 'O', 'D', 'E', '0', '1' };
+
+/* The longest name of an entry, two hashes in hex and the suffix. */
+#define ENTRY_NAME_MAX  40
+
+typedef struct _CodeCache {
+    char * dir;
+
+    atomic_uint_least64_t hits;
+    atomic_uint_least64_t misses;
+    atomic_uint_least64_t stores;
+} CodeCache;
+
+/**
+ * @brief Returns the fingerprint of the parser and the image layout, entries
+ *        are only found by builds of the same fingerprint.
+ */
+u64
+CodeCache_Fingerprint(void) {
+    u64 parts[2] = { AstImg_Fingerprint(), CODE_CACHE_VERSION };
+
+    return Hash_Fnv1aWords((const u8 *)parts, sizeof(parts));
+}
+
+/**
+ * @brief Opens a cache directory, creating it if it does not exist.
+ *
+ * @param dir The path of the directory, whose parent must exist.
+ *
+ * @return A pointer to the cache, or `NULL` if the directory cannot be
+ *         created or memory allocation fails.
+ */
+CodeCache *
+CodeCache_New(
+    const char * dir
+) {
+    usize len = strlen(dir);
+
+    if (mkdir(dir, 0755) != 0 &&
+        errno != EEXIST) {
+
+        goto Exit;
+    }
+
+    CodeCache * cache = (CodeCache *)MeMem_Malloc(sizeof(CodeCache));
+    if (cache == NULL) {
+        goto Exit;
+    }
+
+    cache->dir = (char *)MeMem_Malloc(len + 1);
+    if (cache->dir == NULL) {
+        goto FreeCache;
+    }
+
+    memcpy(cache->dir, dir, len + 1);
+
+    atomic_init(&cache->hits, 0);
+    atomic_init(&cache->misses, 0);
+    atomic_init(&cache->stores, 0);
+
+    return cache;
+
+FreeCache:
+    MeMem_Free(cache);
+
+Exit:
+    return NULL;
+}
+
+/**
+ * @brief Makes the path of the entry of a source.
+ *
+ * @return A pointer to the path, to be freed with `MeMem_Free`, or `NULL`
+ *         if memory allocation fails.
+ */
+static
+char *
+CodeCache_EntryPath(
+    CodeCache * cache,
+    const u8 * src,
+    usize len
+) {
+    usize path_len = strlen(cache->dir) + 1 + ENTRY_NAME_MAX + 1;
+
+    char * path = (char *)MeMem_Malloc(path_len);
+    if (path == NULL) {
+        return NULL;
+    }
+
+    snprintf(path, path_len, "%s/%016llx%016llx.mec", cache->dir,
+        (unsigned long long)Hash_Fnv1aWords(src, len),
+        (unsigned long long)CodeCache_Fingerprint());
+
+    return path;
+}
+
+/**
+ * @brief Looks up the tree of a source.
+ *
+ * The entry is mapped and the tree is built from its image, with no
+ * scanning or parsing. Entries that are damaged, or were written by a
+ * different build, are not found.
+ *
+ * @param cache A pointer to the cache.
+ * @param src A pointer to the source.
+ * @param len The size of the source in bytes.
+ * @param tree A pointer to receive the program node on a hit, to be freed
+ *             with `AstNode_FreeTree`.
+ *
+ * @return `true` on a hit, `false` on a miss or if memory allocation fails.
+ */
+bool
+CodeCache_Load(
+    CodeCache * cache,
+    const u8 * src,
+    usize len,
+    AstNode ** tree
+) {
+    bool res = false;
+    CacheHdr hdr;
+
+    char * path = CodeCache_EntryPath(cache, src, len);
+    if (path == NULL) {
+        goto Exit;
+    }
+
+    MapFile * map = MapFile_Open(path);
+    if (map == NULL) {
+        goto FreePath;
+    }
+
+    const u8 * data = MapFile_Data(map);
+    usize size = MapFile_Size(map);
+
+    if (size < sizeof(CacheHdr)) {
+        goto CloseMap;
+    }
+
+    memcpy(&hdr, data, sizeof(CacheHdr));
+
+    usize rest = size - sizeof(CacheHdr);
+
+    if (memcmp(hdr.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        hdr.fingerprint != CodeCache_Fingerprint() ||
+        hdr.src_size != len ||
+        len > rest ||
+        hdr.img_size != rest - len) {
+
+        goto CloseMap;
+    }
+
+    const u8 * img = data + sizeof(CacheHdr) + len;
+
+    if (memcmp(data + sizeof(CacheHdr), src, len) != 0 ||
+        hdr.hash != Hash_Fnv1aWords(img, (usize)hdr.img_size)) {
+
+        goto CloseMap;
+    }
+
+    res = AstImg_Load(img, (usize)hdr.img_size, tree);
+
+CloseMap:
+    MapFile_Close(map);
+
+FreePath:
+    MeMem_Free(path);
+
+Exit:
+    atomic_fetch_add_explicit(res ? &cache->hits : &cache->misses, 1,
+        memory_order_relaxed);
+
+    return res;
+}
+
+/**
+ * @brief Stores the tree of a source.
+ *
+ * The entry is replaced atomically, so processes sharing the directory see
+ * either no entry or a whole one, and of concurrent stores of the same
+ * source the last one wins.
+ *
+ * @param cache A pointer to the cache.
+ * @param src A pointer to the source.
+ * @param len The size of the source in bytes.
+ * @param tree A pointer to the program node parsed from the source.
+ *
+ * @return `true` on success, `false` if memory allocation fails or the
+ *         entry cannot be written.
+ */
+bool
+CodeCache_Store(
+    CodeCache * cache,
+    const u8 * src,
+    usize len,
+    AstNode * tree
+) {
+    bool res = false;
+    CacheHdr hdr;
+
+    char * path = CodeCache_EntryPath(cache, src, len);
+    if (path == NULL) {
+        goto Exit;
+    }
+
+    FlexBuf * buf = FlexBuf_New();
+    if (buf == NULL) {
+        goto FreePath;
+    }
+
+    memset(&hdr, 0, sizeof(CacheHdr));
+
+    if (FlexBuf_PushBuf(buf, &hdr, sizeof(CacheHdr)) == false ||
+        FlexBuf_PushBuf(buf, src, len) == false ||
+        AstImg_Push(tree, buf) == false) {
+
+        goto FreeBuf;
+    }
+
+    u8 * data = FlexBuf_Data(buf);
+    usize size = FlexBuf_Size(buf);
+
+    memcpy(hdr.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    hdr.fingerprint = CodeCache_Fingerprint();
+    hdr.src_size = len;
+    hdr.img_size = size - sizeof(CacheHdr) - len;
+    hdr.hash = Hash_Fnv1aWords(data + sizeof(CacheHdr) + len,
+        (usize)hdr.img_size);
+
+    memcpy(data, &hdr, sizeof(CacheHdr));
+
+    res = MapFile_WriteAtomic(path, data, size);
+
+    if (res) {
+        atomic_fetch_add_explicit(&cache->stores, 1, memory_order_relaxed);
+    }
+
+FreeBuf:
+    FlexBuf_Free(buf);
+
+FreePath:
+    MeMem_Free(path);
+
+Exit:
+    return res;
+}
+
+/**
+ * @brief Returns the lookups and stores made through a cache so far.
+ */
+void
+CodeCache_Stats(
+    CodeCache * cache,
+    CodeCacheStats * stats
+) {
+    stats->hits = atomic_load_explicit(&cache->hits, memory_order_relaxed);
+    stats->misses = atomic_load_explicit(&cache->misses,
+        memory_order_relaxed);
+    stats->stores = atomic_load_explicit(&cache->stores,
+        memory_order_relaxed);
+}
+
+/**
+ * @brief Frees a cache, leaving its directory and entries in place.
+ */
+void
+CodeCache_Free(
+    CodeCache * cache
+) {
+    MeMem_Free(cache->dir);
+    MeMem_Free(cache);
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef __ME_PARSER_CODE_CACHE_H__
+#define __ME_PARSER_CODE_CACHE_H__
+
+#include "menos.h"
+#include "ast.h"
+
+/* Version of the trees the parser builds, bumped whenever the same source
+   parses into a different tree, so cached trees of older parsers are no
+   longer found. */
+#define CODE_CACHE_VERSION  1
+
+/* Directory of parsed programs keyed by their source, shared by threads and
+   processes. */
+typedef struct _CodeCache CodeCache;
+
+typedef struct _CodeCacheStats {
+    u64 hits;
+    u64 misses;
+    u64 stores;
+} CodeCacheStats;
+
+u64
+CodeCache_Fingerprint(void);
+
+CodeCache *
+CodeCache_New(
+    const char * dir
+);
+
+bool
+CodeCache_Load(
+    CodeCache * cache,
+    const u8 * src,
+    usize len,
+    AstNode ** tree
+);
+
+bool
+CodeCache_Store(
+    CodeCache * cache,
+    const u8 * src,
+    usize len,
+    AstNode * tree
+);
+
+void
+CodeCache_Stats(
+    CodeCache * cache,
+    CodeCacheStats * stats
+);
+
+void
+CodeCache_Free(
+    CodeCache * cache
+);
+
+#endif
\ No newline at end of file
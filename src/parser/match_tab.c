@@ -0,0 +1,567 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "match_tab.h"
+#include "memory/allocate.h"
+#include "util/hash.h"
+
+/* Sentinel arm index for the empty slots of a table. */
+#define NO_ARM ((usize)-1)
+
+/* Minimum number of filled slots per jump table slot, in percent. */
+#define MIN_DENSITY_PERCENT 50
+
+/* Sparse numeric entry. */
+typedef struct _NumEnt {
+    ssize key;
+    usize arm;
+} NumEnt;
+
+/* Big integer entry, the key is borrowed from the arm node. */
+typedef struct _BigEnt {
+    BigInt * key;
+    usize arm;
+} BigEnt;
+
+/* String hash entry, the key is borrowed from the arm node. */
+typedef struct _StrEnt {
+    u64 hash;
+    FixedBuf * key;
+    usize arm;
+} StrEnt;
+
+/* Dispatch table of a match statement. */
+typedef struct _MatchTab {
+
+    /* Numeric arms. */
+    struct {
+        MatchNumKind kind;
+
+        /* The smallest key, only used by the dense table. */
+        ssize min;
+
+        /* The number of jump table slots or sorted entries. */
+        usize len;
+
+        /* Jump table, `len` arm indices. */
+        usize * jmp;
+
+        /* Sorted entries, `len` of them. */
+        NumEnt * ents;
+    } num;
+
+    /* Arms of integer keys that do not fit in `ssize`, searched linearly
+       since such keys are rare. */
+    struct {
+        usize len;
+        BigEnt * ents;
+    } big;
+
+    /* Boolean arms, indexed by the value itself. */
+    usize bool_arms[2];
+
+    /* String arms, open addressing with linear probing. */
+    struct {
+
+        /* The number of slots, always a power of two. */
+        usize cap;
+
+        StrEnt * ents;
+    } str;
+} MatchTab;
+
+static
+int
+CompareNumEnt(
+    const void * ent_1,
+    const void * ent_2
+) {
+    const NumEnt * num_ent_1 = (const NumEnt *)ent_1;
+    const NumEnt * num_ent_2 = (const NumEnt *)ent_2;
+
+    if (num_ent_1->key != num_ent_2->key) {
+        return (num_ent_1->key > num_ent_2->key) -
+            (num_ent_1->key < num_ent_2->key);
+    }
+
+    return (num_ent_1->arm > num_ent_2->arm) -
+        (num_ent_1->arm < num_ent_2->arm);
+}
+
+static
+int
+CompareBigEnt(
+    const void * ent_1,
+    const void * ent_2
+) {
+    const BigEnt * big_ent_1 = (const BigEnt *)ent_1;
+    const BigEnt * big_ent_2 = (const BigEnt *)ent_2;
+
+    int res = BigInt_Compare(big_ent_1->key, big_ent_2->key);
+    if (res != 0) {
+        return res;
+    }
+
+    return (big_ent_1->arm > big_ent_2->arm) -
+        (big_ent_1->arm < big_ent_2->arm);
+}
+
+/* Keeps the first of the arms found to repeat a key, the one the parser
+   would meet first. */
+static
+void
+MatchTab_SetDup(
+    usize * dup,
+    usize arm
+) {
+    if (arm < *dup) {
+        *dup = arm;
+    }
+}
+
+static
+bool
+MatchTab_BuildNum(
+    MatchTab * tab,
+    AstNode ** buf_arms,
+    usize num_arms,
+    usize num_keys,
+    usize * dup
+) {
+    if (num_keys == 0) {
+        return true;
+    }
+
+    NumEnt * ents = (NumEnt *)MeMem_Malloc(sizeof(NumEnt) * num_keys);
+    if (ents == NULL) {
+        return false;
+    }
+
+    usize len = 0;
+
+    for (usize i = 0; i < num_arms; i++) {
+        AstNode * key = buf_arms[i]->ext.match_arm.key;
+        if (key->tag == AstTag_NumLit &&
+            key->ext.num_lit.big == NULL) {
+
+            ents[len].key = key->ext.num_lit.num;
+            ents[len].arm = i;
+            len += 1;
+        }
+    }
+
+    qsort(ents, len, sizeof(NumEnt), CompareNumEnt);
+
+    /* Equal keys are adjacent once sorted, in the order of their arms. */
+    for (usize i = 1; i < len; i++) {
+        if (ents[i].key == ents[i - 1].key) {
+            MatchTab_SetDup(dup, ents[i].arm);
+        }
+    }
+
+    ssize min = ents[0].key;
+    ssize max = ents[len - 1].key;
+    u64 range = (u64)max - (u64)min + 1;
+
+    /* Sparse keys, keep the sorted entries for binary search. The range
+       spans up to the whole of `u64`, so it is compared by division rather
+       than scaled up. */
+    if (range == 0 ||
+        range > (u64)len * 100 / MIN_DENSITY_PERCENT ||
+        range > SIZE_MAX / sizeof(usize)) {
+
+        tab->num.kind = MatchNumKind_Sparse;
+        tab->num.len = len;
+        tab->num.ents = ents;
+
+        return true;
+    }
+
+    usize * jmp = (usize *)MeMem_Malloc(sizeof(usize) * range);
+    if (jmp == NULL) {
+        MeMem_Free(ents);
+        return false;
+    }
+
+    for (usize i = 0; i < range; i++) {
+        jmp[i] = NO_ARM;
+    }
+
+    for (usize i = 0; i < len; i++) {
+        jmp[(u64)ents[i].key - (u64)min] = ents[i].arm;
+    }
+
+    MeMem_Free(ents);
+
+    tab->num.kind = MatchNumKind_Dense;
+    tab->num.min = min;
+    tab->num.len = (usize)range;
+    tab->num.jmp = jmp;
+
+    return true;
+}
+
+static
+bool
+MatchTab_BuildBig(
+    MatchTab * tab,
+    AstNode ** buf_arms,
+    usize num_arms,
+    usize num_keys,
+    usize * dup
+) {
+    if (num_keys == 0) {
+        return true;
+    }
+
+    BigEnt * ents = (BigEnt *)MeMem_Malloc(sizeof(BigEnt) * num_keys);
+    if (ents == NULL) {
+        return false;
+    }
+
+    usize len = 0;
+
+    for (usize i = 0; i < num_arms; i++) {
+        AstNode * key = buf_arms[i]->ext.match_arm.key;
+        if (key->tag == AstTag_NumLit &&
+            key->ext.num_lit.big != NULL) {
+
+            ents[len].key = key->ext.num_lit.big;
+            ents[len].arm = i;
+            len += 1;
+        }
+    }
+
+    qsort(ents, len, sizeof(BigEnt), CompareBigEnt);
+
+    for (usize i = 1; i < len; i++) {
+        if (BigInt_Compare(ents[i].key, ents[i - 1].key) == 0) {
+            MatchTab_SetDup(dup, ents[i].arm);
+        }
+    }
+
+    tab->big.len = len;
+    tab->big.ents = ents;
+
+    return true;
+}
+
+static
+bool
+MatchTab_BuildStr(
+    MatchTab * tab,
+    AstNode ** buf_arms,
+    usize num_arms,
+    usize num_keys,
+    usize * dup
+) {
+    if (num_keys == 0) {
+        return true;
+    }
+
+    /* Keep the load factor at or below one half. */
+    usize cap = 8;
+    while (cap < num_keys * 2) {
+        cap <<= 1;
+    }
+
+    StrEnt * ents = (StrEnt *)MeMem_Malloc(sizeof(StrEnt) * cap);
+    if (ents == NULL) {
+        return false;
+    }
+
+    for (usize i = 0; i < cap; i++) {
+        ents[i].key = NULL;
+    }
+
+    for (usize i = 0; i < num_arms; i++) {
+        AstNode * key = buf_arms[i]->ext.match_arm.key;
+        if (key->tag != AstTag_StrLit) {
+            continue;
+        }
+
+        FixedBuf * str = key->ext.str_lit.str;
+        usize len = FixedBuf_Size(str);
+        u64 hash = Hash_Fnv1a(FixedBuf_Data(str), len);
+        usize slot = (usize)hash & (cap - 1);
+        bool found = false;
+
+        /* Arms are inserted in order, so a key met while probing belongs
+           to an earlier arm. */
+        while (ents[slot].key != NULL) {
+            FixedBuf * ent_key = ents[slot].key;
+
+            if (ents[slot].hash == hash &&
+                FixedBuf_Size(ent_key) == len &&
+                (len == 0 ||
+                 memcmp(FixedBuf_Data(ent_key), FixedBuf_Data(str),
+                    len) == 0)) {
+
+                found = true;
+                break;
+            }
+
+            slot = (slot + 1) & (cap - 1);
+        }
+
+        if (found) {
+            MatchTab_SetDup(dup, i);
+            continue;
+        }
+
+        ents[slot].hash = hash;
+        ents[slot].key = str;
+        ents[slot].arm = i;
+    }
+
+    tab->str.cap = cap;
+    tab->str.ents = ents;
+
+    return true;
+}
+
+/**
+ * @brief Builds the dispatch table of a match statement.
+ *
+ * The arms are split by the type of their keys. Integer keys are compiled to
+ * a jump table when at least half of the key range is covered, otherwise to
+ * a sorted array searched in logarithmic time, and keys beyond `ssize` to a
+ * list searched linearly. Boolean keys are compiled to a two-slot jump table
+ * and string keys to an open-addressing hash table. Duplicate keys are
+ * found while building, by sorting the integer keys and by collisions in
+ * the hash table, so that checking them does not take quadratic time.
+ *
+ * @param arms The sequence of `AstTag_MatchArm` nodes. String keys are
+ *             borrowed, so the table must not outlive the arms.
+ * @param dup A pointer to receive the index of the first arm whose key
+ *            repeats that of an earlier arm, or `MATCH_TAB_NO_DUP`.
+ *
+ * @return A pointer to the new table, or `NULL` if two arms have the same
+ *         key or memory allocation fails.
+ */
+MatchTab *
+MatchTab_New(
+    AstSeq * arms,
+    usize * dup
+) {
+    *dup = MATCH_TAB_NO_DUP;
+
+    MatchTab * tab = (MatchTab *)MeMem_Malloc(sizeof(MatchTab));
+    if (tab == NULL) {
+        goto Exit;
+    }
+
+    tab->num.kind = MatchNumKind_None;
+    tab->num.min = 0;
+    tab->num.len = 0;
+    tab->num.jmp = NULL;
+    tab->num.ents = NULL;
+
+    tab->big.len = 0;
+    tab->big.ents = NULL;
+
+    tab->bool_arms[0] = NO_ARM;
+    tab->bool_arms[1] = NO_ARM;
+
+    tab->str.cap = 0;
+    tab->str.ents = NULL;
+
+    AstNode ** buf_arms = AstSeq_Data(arms);
+    usize num_arms = AstSeq_Count(arms);
+    usize num_num_keys = 0;
+    usize num_big_keys = 0;
+    usize num_str_keys = 0;
+
+    for (usize i = 0; i < num_arms; i++) {
+        AstNode * key = buf_arms[i]->ext.match_arm.key;
+
+        switch (key->tag) {
+        case AstTag_NumLit:
+            if (key->ext.num_lit.big != NULL) {
+                num_big_keys += 1;
+            } else {
+                num_num_keys += 1;
+            }
+            break;
+
+        case AstTag_StrLit:
+            num_str_keys += 1;
+            break;
+
+        case AstTag_BoolLit: {
+            usize * arm = tab->bool_arms + (key->ext.bool_lit.val ? 1 : 0);
+
+            if (*arm != NO_ARM) {
+                MatchTab_SetDup(dup, i);
+            } else {
+                *arm = i;
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    if (MatchTab_BuildNum(tab, buf_arms, num_arms, num_num_keys,
+            dup) == false ||
+        MatchTab_BuildBig(tab, buf_arms, num_arms, num_big_keys,
+            dup) == false ||
+        MatchTab_BuildStr(tab, buf_arms, num_arms, num_str_keys,
+            dup) == false ||
+        *dup != MATCH_TAB_NO_DUP) {
+
+        goto FreeTab;
+    }
+
+    return tab;
+
+FreeTab:
+    MatchTab_Free(tab);
+
+Exit:
+    return NULL;
+}
+
+MatchNumKind
+MatchTab_NumKind(
+    MatchTab * tab
+) {
+    return tab->num.kind;
+}
+
+bool
+MatchTab_FindNum(
+    MatchTab * tab,
+    ssize num,
+    usize * idx
+) {
+    switch (tab->num.kind) {
+    case MatchNumKind_None:
+        return false;
+
+    case MatchNumKind_Dense: {
+        u64 off = (u64)num - (u64)tab->num.min;
+        if (off >= tab->num.len ||
+            tab->num.jmp[off] == NO_ARM) {
+
+            return false;
+        }
+
+        *idx = tab->num.jmp[off];
+
+        return true;
+    }
+
+    case MatchNumKind_Sparse: {
+        usize lo = 0;
+        usize hi = tab->num.len;
+
+        while (lo < hi) {
+            usize mid = lo + (hi - lo) / 2;
+            ssize key = tab->num.ents[mid].key;
+
+            if (key == num) {
+                *idx = tab->num.ents[mid].arm;
+                return true;
+            } else if (key < num) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+
+        return false;
+    }
+    }
+
+    return false;
+}
+
+bool
+MatchTab_FindBig(
+    MatchTab * tab,
+    BigInt * big,
+    usize * idx
+) {
+    for (usize i = 0; i < tab->big.len; i++) {
+        if (BigInt_Compare(tab->big.ents[i].key, big) == 0) {
+            *idx = tab->big.ents[i].arm;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool
+MatchTab_FindBool(
+    MatchTab * tab,
+    bool val,
+    usize * idx
+) {
+    usize arm = tab->bool_arms[val ? 1 : 0];
+    if (arm == NO_ARM) {
+        return false;
+    }
+
+    *idx = arm;
+
+    return true;
+}
+
+bool
+MatchTab_FindStr(
+    MatchTab * tab,
+    const u8 * buf,
+    usize len,
+    usize * idx
+) {
+    if (tab->str.ents == NULL) {
+        return false;
+    }
+
+    usize cap = tab->str.cap;
+    u64 hash = Hash_Fnv1a(buf, len);
+    usize slot = (usize)hash & (cap - 1);
+
+    while (tab->str.ents[slot].key != NULL) {
+        StrEnt * ent = tab->str.ents + slot;
+
+        if (ent->hash == hash &&
+            FixedBuf_Size(ent->key) == len &&
+            (len == 0 || memcmp(FixedBuf_Data(ent->key), buf, len) == 0)) {
+
+            *idx = ent->arm;
+            return true;
+        }
+
+        slot = (slot + 1) & (cap - 1);
+    }
+
+    return false;
+}
+
+void
+MatchTab_Free(
+    MatchTab * tab
+) {
+    if (tab->num.jmp != NULL) {
+        MeMem_Free(tab->num.jmp);
+    }
+
+    if (tab->num.ents != NULL) {
+        MeMem_Free(tab->num.ents);
+    }
+
+    if (tab->big.ents != NULL) {
+        MeMem_Free(tab->big.ents);
+    }
+
+    if (tab->str.ents != NULL) {
+        MeMem_Free(tab->str.ents);
+    }
+
+    MeMem_Free(tab);
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef __ME_PARSER_MATCH_TAB_H__
+#define __ME_PARSER_MATCH_TAB_H__
+
+#include "menos.h"
+#include "ast.h"
+
+/* Dispatch strategy used for the numeric arms of a match statement. */
+typedef enum _MatchNumKind {
+    MatchNumKind_None,      /* No numeric arm. */
+    MatchNumKind_Dense,     /* Jump table indexed by `key - min`. */
+    MatchNumKind_Sparse,    /* Sorted keys, binary search. */
+} MatchNumKind;
+
+/* No two arms have the same key. */
+#define MATCH_TAB_NO_DUP ((usize)-1)
+
+MatchTab *
+MatchTab_New(
+    AstSeq * arms,
+    usize * dup
+);
+
+MatchNumKind
+MatchTab_NumKind(
+    MatchTab * tab
+);
+
+bool
+MatchTab_FindNum(
+    MatchTab * tab,
+    ssize num,
+    usize * idx
+);
+
+bool
+MatchTab_FindBig(
+    MatchTab * tab,
+    BigInt * big,
+    usize * idx
+);
+
+bool
+MatchTab_FindBool(
+    MatchTab * tab,
+    bool val,
+    usize * idx
+);
+
+bool
+MatchTab_FindStr(
+    MatchTab * tab,
+    const u8 * buf,
+    usize len,
+    usize * idx
+);
+
+void
+MatchTab_Free(
+    MatchTab * tab
+);
+
+#endif
\ No newline at end of file
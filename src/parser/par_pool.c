@@ -0,0 +1,434 @@
+#include <pthread.h>
+#include <unistd.h>
+
+#include "par_pool.h"
+#include "parser.h"
+#include "memory/allocate.h"
+#include "memory/pool.h"
+#include "util/trace.h"
+
+typedef struct _ParWorker {
+    ParPool * pool;
+    pthread_t thread;
+
+    /* Memory of the worker, its lexer and parser and what they output. */
+    MemPool * mem;
+    Lexer * lex;
+    Parser * par;
+} ParWorker;
+
+typedef struct _ParPool {
+    pthread_mutex_t lock;
+
+    /* Signaled when jobs are queued or the pool stops. */
+    pthread_cond_t work;
+
+    /* Signaled when the last pending job is done. */
+    pthread_cond_t idle;
+
+    /* Jobs not taken yet, in order of submission. */
+    ParJob * head;
+    ParJob * tail;
+
+    /* Jobs submitted and not done yet. */
+    usize pending;
+    bool stop;
+
+    ParWorker * workers;
+    usize num_workers;
+} ParPool;
+
+/**
+ * @brief Sets up a job for a source buffer or, if `buf` is `NULL`, for the
+ *        file at `path`. Both must outlive the job.
+ */
+void
+ParJob_Init(
+    ParJob * job,
+    const void * buf,
+    usize len,
+    const char * path
+) {
+    job->buf = buf;
+    job->len = len;
+    job->path = path;
+
+    job->ok = false;
+    job->lo = NULL;
+    job->tree = NULL;
+    job->err_msg = NULL;
+
+    job->done = NULL;
+    job->ctx = NULL;
+    job->next = NULL;
+}
+
+/**
+ * @brief Releases the output of a job, it may be called on any thread but
+ *        must be before the pool that ran the job is freed.
+ */
+void
+ParJob_Clear(
+    ParJob * job
+) {
+    if (job->tree != NULL) {
+        AstNode_FreeTree(job->tree);
+        job->tree = NULL;
+    }
+
+    if (job->lo != NULL) {
+        LexOut_Free(job->lo);
+        job->lo = NULL;
+    }
+
+    if (job->err_msg != NULL) {
+        FlexBuf_Free(job->err_msg);
+        job->err_msg = NULL;
+    }
+
+    job->ok = false;
+}
+
+static
+void
+ParJob_SetError(
+    ParJob * job,
+    FlexBuf * msg
+) {
+    job->err_msg = FlexBuf_New();
+    if (job->err_msg == NULL) {
+        return;
+    }
+
+    bool res;
+
+    /* Only reading the file fails without a message. */
+    if (FlexBuf_Size(msg) == 0) {
+        res = FlexBuf_PushFmt(job->err_msg, "cannot read file %s",
+            job->path);
+    } else {
+        res = FlexBuf_PushBuf(job->err_msg, FlexBuf_Data(msg),
+            FlexBuf_Size(msg));
+    }
+
+    if (res == false) {
+        FlexBuf_Free(job->err_msg);
+        job->err_msg = NULL;
+    }
+}
+
+static
+void
+ParWorker_Run(
+    ParWorker * worker,
+    ParJob * job
+) {
+    bool scanned;
+
+    Lexer_Reset(worker->lex);
+    Parser_Reset(worker->par);
+
+    if (job->buf != NULL) {
+        scanned = Lexer_ScanBuf(worker->lex, job->buf, job->len, &job->lo);
+    } else {
+        scanned = Lexer_ScanFile(worker->lex, job->path, &job->lo);
+    }
+
+    if (scanned == false) {
+        job->lo = NULL;
+        ParJob_SetError(job, Lexer_ErrorMessage(worker->lex));
+        return;
+    }
+
+    Parser_Link(worker->par, job->lo);
+
+    if (Parser_Parse(worker->par, &job->tree) == false) {
+        job->tree = NULL;
+        ParJob_SetError(job, Parser_ErrorMessage(worker->par));
+        return;
+    }
+
+    job->ok = true;
+}
+
+static
+void *
+ParWorker_Main(
+    void * arg
+) {
+    ParWorker * worker = (ParWorker *)arg;
+    ParPool * pool = worker->pool;
+
+    /* Everything the worker allocates comes from its own memory, so
+       workers never contend on an allocator. */
+    MeMem_Use(MemPool_Allocator(worker->mem));
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (true) {
+        while (pool->head == NULL && pool->stop == false) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+
+        if (pool->head == NULL) {
+            break;
+        }
+
+        ParJob * job = pool->head;
+        pool->head = job->next;
+        if (pool->head == NULL) {
+            pool->tail = NULL;
+        }
+
+        pthread_mutex_unlock(&pool->lock);
+
+        bool traced = Trace_Begin("ParPool_Job");
+        ParWorker_Run(worker, job);
+        Trace_End("ParPool_Job", traced);
+
+        if (job->done != NULL) {
+            job->done(job, job->ctx);
+        }
+
+        pthread_mutex_lock(&pool->lock);
+
+        if (--pool->pending == 0) {
+            pthread_cond_broadcast(&pool->idle);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+static
+bool
+ParWorker_Init(
+    ParWorker * worker,
+    ParPool * pool
+) {
+    worker->pool = pool;
+
+    worker->mem = MemPool_New();
+    if (worker->mem == NULL) {
+        goto Exit;
+    }
+
+    const MemAllocator * prev = MeMem_Use(MemPool_Allocator(worker->mem));
+
+    worker->lex = Lexer_New();
+    worker->par = worker->lex != NULL ? Parser_New() : NULL;
+
+    MeMem_Use(prev);
+
+    if (worker->par == NULL) {
+        goto FreeLexer;
+    }
+
+    return true;
+
+FreeLexer:
+    if (worker->lex != NULL) {
+        Lexer_Free(worker->lex);
+    }
+
+    MemPool_Free(worker->mem);
+
+Exit:
+    return false;
+}
+
+static
+void
+ParWorker_Fini(
+    ParWorker * worker
+) {
+    Parser_Free(worker->par);
+    Lexer_Free(worker->lex);
+    MemPool_Free(worker->mem);
+}
+
+/**
+ * @brief Stops and joins the first `num_started` workers, then releases
+ *        the first `num_ready` of them.
+ */
+static
+void
+ParPool_Shutdown(
+    ParPool * pool,
+    usize num_started,
+    usize num_ready
+) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (usize i = 0; i < num_started; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+
+    for (usize i = 0; i < num_ready; i++) {
+        ParWorker_Fini(pool->workers + i);
+    }
+}
+
+/**
+ * @brief Creates a pool of workers, each with a lexer and a parser ready
+ *        to take jobs.
+ *
+ * @param num_workers The number of worker threads, `0` for one per online
+ *        processor.
+ *
+ * @return A pointer to the pool, or `NULL` if memory allocation or thread
+ *         creation fails.
+ */
+ParPool *
+ParPool_New(
+    usize num_workers
+) {
+    usize num_ready = 0;
+    usize num_started = 0;
+
+    if (num_workers == 0) {
+        long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = num_cpus > 0 ? (usize)num_cpus : 1;
+    }
+
+    ParPool * pool = (ParPool *)MeMem_Malloc(sizeof(ParPool));
+    if (pool == NULL) {
+        goto Exit;
+    }
+
+    pool->workers = (ParWorker *)MeMem_Malloc(
+        sizeof(ParWorker) * num_workers);
+    if (pool->workers == NULL) {
+        goto FreePool;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    pool->head = NULL;
+    pool->tail = NULL;
+    pool->pending = 0;
+    pool->stop = false;
+    pool->num_workers = num_workers;
+
+    for (; num_ready < num_workers; num_ready++) {
+        if (ParWorker_Init(pool->workers + num_ready, pool) == false) {
+            goto Shutdown;
+        }
+    }
+
+    for (; num_started < num_workers; num_started++) {
+        ParWorker * worker = pool->workers + num_started;
+
+        if (pthread_create(&worker->thread, NULL,
+            ParWorker_Main, worker) != 0) {
+
+            goto Shutdown;
+        }
+    }
+
+    return pool;
+
+Shutdown:
+    ParPool_Shutdown(pool, num_started, num_ready);
+
+    pthread_cond_destroy(&pool->idle);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+    MeMem_Free(pool->workers);
+
+FreePool:
+    MeMem_Free(pool);
+
+Exit:
+    return NULL;
+}
+
+usize
+ParPool_NumWorkers(
+    ParPool * pool
+) {
+    return pool->num_workers;
+}
+
+/**
+ * @brief Queues jobs to be run by the workers, in order of submission.
+ *
+ * The jobs are linked into the queue in place, so they must stay alive
+ * until done. Once a job is done `done` is called with it on the worker
+ * thread, if not `NULL`, which may run concurrently with other calls.
+ */
+void
+ParPool_Submit(
+    ParPool * pool,
+    ParJob * jobs,
+    usize num_jobs,
+    ParJobFn done,
+    void * ctx
+) {
+    if (num_jobs == 0) {
+        return;
+    }
+
+    for (usize i = 0; i < num_jobs; i++) {
+        jobs[i].done = done;
+        jobs[i].ctx = ctx;
+        jobs[i].next = i + 1 < num_jobs ? jobs + i + 1 : NULL;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    if (pool->tail != NULL) {
+        pool->tail->next = jobs;
+    } else {
+        pool->head = jobs;
+    }
+
+    pool->tail = jobs + num_jobs - 1;
+    pool->pending += num_jobs;
+
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief Waits until every job submitted so far is done.
+ */
+void
+ParPool_Wait(
+    ParPool * pool
+) {
+    pthread_mutex_lock(&pool->lock);
+
+    while (pool->pending != 0) {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief Finishes the queued jobs, then stops the workers and releases
+ *        the pool with the memory of every worker.
+ *
+ * The output of every job run by the pool must have been released before,
+ * as it lives in the memory of the worker that ran the job.
+ */
+void
+ParPool_Free(
+    ParPool * pool
+) {
+    ParPool_Shutdown(pool, pool->num_workers, pool->num_workers);
+
+    pthread_cond_destroy(&pool->idle);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+    MeMem_Free(pool->workers);
+    MeMem_Free(pool);
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#ifndef __ME_PARSER_PAR_POOL_H__
+#define __ME_PARSER_PAR_POOL_H__
+
+#include "menos.h"
+#include "ast.h"
+#include "lexer/lexer.h"
+#include "util/flex_buf.h"
+
+/* A script to scan and parse, and what came of it. */
+typedef struct _ParJob {
+
+    /* Source, `len` bytes at `buf` or, if `buf` is `NULL`, the file at
+       `path`. */
+    const void * buf;
+    usize len;
+    const char * path;
+
+    /* Set once the job is done. On success `lo` and `tree` hold the
+       output, on failure `err_msg` holds the diagnostic if memory allowed.
+       The caller owns them, see `ParJob_Clear`. */
+    bool ok;
+    LexOut * lo;
+    AstNode * tree;
+    FlexBuf * err_msg;
+
+    /* Private to the pool, which queues the jobs without allocating. */
+    void (* done)(struct _ParJob * job, void * ctx);
+    void * ctx;
+    struct _ParJob * next;
+} ParJob;
+
+/* Called on the worker thread as soon as a job is done. */
+typedef void (* ParJobFn)(ParJob * job, void * ctx);
+
+/* Pool of threads scanning and parsing scripts, each with its own lexer,
+   parser and memory. */
+typedef struct _ParPool ParPool;
+
+void
+ParJob_Init(
+    ParJob * job,
+    const void * buf,
+    usize len,
+    const char * path
+);
+
+void
+ParJob_Clear(
+    ParJob * job
+);
+
+ParPool *
+ParPool_New(
+    usize num_workers
+);
+
+usize
+ParPool_NumWorkers(
+    ParPool * pool
+);
+
+void
+ParPool_Submit(
+    ParPool * pool,
+    ParJob * jobs,
+    usize num_jobs,
+    ParJobFn done,
+    void * ctx
+);
+
+void
+ParPool_Wait(
+    ParPool * pool
+);
+
+void
+ParPool_Free(
+    ParPool * pool
+);
+
+#endif
\ No newline at end of file
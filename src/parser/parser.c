@@ -1,6 +1,11 @@
 #include "parser.h"
 #include "memory/allocate.h"
 #include "rule.h"
+#include "util/metrics.h"
+#include "util/trace.h"
+
+_Static_assert(AST_NUM_TAGS <= METRICS_MAX_TAGS,
+    "metrics must count every node tag");
 
 const char *
 ParErr_ToStr(
@@ -10,11 +15,18 @@ ParErr_ToStr(
     case ParErr_Ok: return "Ok";
     case ParErr_NoEnoughMemory: return "No enough memory";
     case ParErr_UnexpectedToken: return "Unexpected token";
+    case ParErr_DuplicateMatchArm: return "Duplicate match arm";
     }
 }
 
 typedef struct _Parser {
 
+    /* Allocator of the memory taken while parsing. */
+    const MemAllocator * alloc;
+
+    /* Metrics filled in while parsing, may be `NULL`. */
+    Metrics * metrics;
+
     /* Pointer references. */
     LexOut * lo;
     TokSeq * seq;
@@ -33,7 +45,10 @@ typedef struct _Parser {
 
 Parser *
 Parser_New(void) {
+    MemTag prev_tag = MeMem_SetTag(MemTag_ErrMsg);
     FlexBuf * err_msg = FlexBuf_New();
+    MeMem_SetTag(prev_tag);
+
     if (err_msg == NULL) {
         goto Exit;
     }
@@ -43,6 +58,9 @@ Parser_New(void) {
         goto FreeErrMsg;
     }
 
+    par->alloc = MeMem_Current();
+    par->metrics = NULL;
+
     par->seq = NULL;
     par->num = 0;
     par->off = 0;
@@ -80,6 +98,14 @@ Parser_Peek(
     return TokSeq_At(par->seq, par->off);
 }
 
+Token *
+Parser_LookAhead(
+    Parser * par,
+    usize dist
+) {
+    return TokSeq_At(par->seq, par->off + dist);
+}
+
 bool
 Parser_Check(
     Parser * par,
@@ -178,6 +204,16 @@ Parser_SetErrorInfo(
             (char *)FixedBuf_Data(par->src),
             row_no, col_no, PREFIX, err_msg, TokTag_ToStr(tok->tag));
         break;
+
+    case ParErr_DuplicateMatchArm:
+        row_no = par->err.line_no;
+        col_no = par->err.col_no;
+
+        FlexBuf_PushFmt(msg, "%.*s:%zu:%zu: %s: %s",
+            (int)FixedBuf_Size(par->src),
+            (char *)FixedBuf_Data(par->src),
+            row_no, col_no, PREFIX, err_msg);
+        break;
     }
 
     par->err.line_no = row_no;
@@ -193,12 +229,60 @@ Parser_Parse(
         return false;
     }
 
+    const MemAllocator * prev = MeMem_Use(par->alloc);
+    MemTag prev_tag = MeMem_SetTag(MemTag_Ast);
+    bool res = true;
+    MetricsSpan span;
+
+    bool traced = Trace_Begin("Parser_Parse");
+    Metrics_Begin(par->metrics, &span);
+
     if (*tree = ParRule_Prog(par), par->err.type != ParErr_Ok) {
         Parser_SetErrorInfo(par);
-        return false;
+        res = false;
     }
 
-    return true;
+    Metrics_End(par->metrics, MetricsPhase_Parse, &span);
+    Trace_End("Parser_Parse", traced);
+
+    MeMem_SetTag(prev_tag);
+    MeMem_Use(prev);
+
+    /* Nodes are counted in a walk of the tree rather than as they are
+       created, which keeps the rules free of instrumentation. */
+    if (res && par->metrics != NULL) {
+        usize depth = AstNode_Census(*tree, par->metrics->nodes);
+
+        if (depth > par->metrics->max_depth) {
+            par->metrics->max_depth = depth;
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief Sets the allocator of the memory the parser takes while parsing,
+ *        which defaults to the allocator in scope when it was created.
+ */
+void
+Parser_SetAllocator(
+    Parser * par,
+    const MemAllocator * alloc
+) {
+    par->alloc = alloc;
+}
+
+/**
+ * @brief Installs metrics the parser adds its time, nodes and depth to, or
+ *        `NULL` to stop collecting them.
+ */
+void
+Parser_SetMetrics(
+    Parser * par,
+    Metrics * metrics
+) {
+    par->metrics = metrics;
 }
 
 void
@@ -215,6 +299,22 @@ Parser_SetUnexpectedTokenError(
     par->err.type = ParErr_UnexpectedToken;
 }
 
+/**
+ * @brief Sets a duplicate match arm error, reported at the key of the arm
+ *        rather than at the current token, since arms are only checked once
+ *        the statement is parsed.
+ */
+void
+Parser_SetDuplicateMatchArmError(
+    Parser * par,
+    usize row,
+    usize col
+) {
+    par->err.type = ParErr_DuplicateMatchArm;
+    par->err.line_no = row + 1;
+    par->err.col_no = col + 1;
+}
+
 bool
 Parser_Failed(
     Parser * par
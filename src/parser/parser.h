@@ -5,15 +5,19 @@
 #include "lexer/token.h"
 #include "lexer/lexer.h"
 #include "ast.h"
+#include "memory/allocate.h"
 
 typedef enum _ParErr {
     ParErr_Ok,
     ParErr_NoEnoughMemory,
     ParErr_UnexpectedToken,
+    ParErr_DuplicateMatchArm,
 } ParErr;
 
 typedef struct _Parser Parser;
 
+typedef struct _Metrics Metrics;
+
 Parser *
 Parser_New(void);
 
@@ -28,6 +32,12 @@ Parser_Peek(
     Parser * par
 );
 
+Token *
+Parser_LookAhead(
+    Parser * par,
+    usize dist
+);
+
 bool
 Parser_Check(
     Parser * par,
@@ -58,6 +68,18 @@ Parser_Parse(
     AstNode ** tree
 );
 
+void
+Parser_SetAllocator(
+    Parser * par,
+    const MemAllocator * alloc
+);
+
+void
+Parser_SetMetrics(
+    Parser * par,
+    Metrics * metrics
+);
+
 void
 Parser_SetNoEnoughMemoryError(
     Parser * par
@@ -68,6 +90,13 @@ Parser_SetUnexpectedTokenError(
     Parser * par
 );
 
+void
+Parser_SetDuplicateMatchArmError(
+    Parser * par,
+    usize row,
+    usize col
+);
+
 bool
 Parser_Failed(
     Parser * par
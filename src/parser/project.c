@@ -0,0 +1,574 @@
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "project.h"
+#include "parser.h"
+#include "memory/allocate.h"
+#include "util/hash.h"
+#include "util/trace.h"
+
+typedef struct _Project {
+
+    /* Files in order of addition, an array of `ProjFile`. */
+    FlexBuf * files;
+    usize num_unique;
+    bool built;
+
+    /* Cache of the trees, borrowed, may be `NULL`. */
+    CodeCache * cache;
+} Project;
+
+/* Hash of a file, sorted to find equal contents. */
+typedef struct _ProjKey {
+    u64 hash;
+    usize idx;
+} ProjKey;
+
+static
+ProjFile *
+Project_Files(
+    Project * proj
+) {
+    return (ProjFile *)FlexBuf_Data(proj->files);
+}
+
+Project *
+Project_New(void) {
+    Project * proj = (Project *)MeMem_Malloc(sizeof(Project));
+    if (proj == NULL) {
+        goto Exit;
+    }
+
+    proj->files = FlexBuf_New();
+    if (proj->files == NULL) {
+        goto FreeProj;
+    }
+
+    proj->num_unique = 0;
+    proj->built = false;
+    proj->cache = NULL;
+
+    return proj;
+
+FreeProj:
+    MeMem_Free(proj);
+
+Exit:
+    return NULL;
+}
+
+/**
+ * @brief Adds a file to the project, before it is built.
+ *
+ * @return `true` on success, `false` if the project was built already or
+ *         memory allocation fails.
+ */
+bool
+Project_AddFile(
+    Project * proj,
+    const char * path
+) {
+    ProjFile file;
+    usize len = strlen(path);
+
+    if (proj->built) {
+        return false;
+    }
+
+    file.path = (char *)MeMem_Malloc(len + 1);
+    if (file.path == NULL) {
+        return false;
+    }
+
+    memcpy(file.path, path, len + 1);
+
+    file.hash = 0;
+    file.dup_of = FlexBuf_Size(proj->files) / sizeof(ProjFile);
+    file.ok = false;
+    file.lo = NULL;
+    file.tree = NULL;
+    file.err_msg = NULL;
+    file.data = NULL;
+
+    if (FlexBuf_PushBuf(proj->files, &file, sizeof(ProjFile)) == false) {
+        MeMem_Free(file.path);
+        return false;
+    }
+
+    return true;
+}
+
+static
+bool
+Project_HasSuffix(
+    const char * name,
+    const char * suffix
+) {
+    usize name_len = strlen(name);
+    usize suffix_len = strlen(suffix);
+
+    return name_len >= suffix_len &&
+        memcmp(name + name_len - suffix_len, suffix, suffix_len) == 0;
+}
+
+/**
+ * @brief Adds the files under a directory whose names end with `suffix`,
+ *        or all of them if it is `NULL`, descending into subdirectories.
+ *
+ * Entries are added in the order of their names, so builds of the same
+ * tree list the files in the same order.
+ *
+ * @return `true` on success, `false` if a directory cannot be read, the
+ *         project was built already or memory allocation fails.
+ */
+bool
+Project_AddDir(
+    Project * proj,
+    const char * path,
+    const char * suffix
+) {
+    struct dirent ** entries;
+    bool res = true;
+
+    int num = scandir(path, &entries, NULL, alphasort);
+    if (num < 0) {
+        return false;
+    }
+
+    for (int i = 0; i < num; i++) {
+        const char * name = entries[i]->d_name;
+        struct stat st;
+
+        if (res == false ||
+            strcmp(name, ".") == 0 ||
+            strcmp(name, "..") == 0) {
+
+            continue;
+        }
+
+        usize len = strlen(path) + 1 + strlen(name) + 1;
+        char * sub = (char *)MeMem_Malloc(len);
+        if (sub == NULL) {
+            res = false;
+            continue;
+        }
+
+        snprintf(sub, len, "%s/%s", path, name);
+
+        if (stat(sub, &st) != 0) {
+            res = false;
+        } else if (S_ISDIR(st.st_mode)) {
+            res = Project_AddDir(proj, sub, suffix);
+        } else if (S_ISREG(st.st_mode) &&
+            (suffix == NULL || Project_HasSuffix(name, suffix))) {
+
+            res = Project_AddFile(proj, sub);
+        }
+
+        MeMem_Free(sub);
+    }
+
+    for (int i = 0; i < num; i++) {
+        free(entries[i]);
+    }
+
+    free(entries);
+
+    return res;
+}
+
+static
+void
+ProjFile_SetError(
+    ProjFile * file,
+    FlexBuf * msg
+) {
+    file->err_msg = FlexBuf_New();
+    if (file->err_msg == NULL) {
+        return;
+    }
+
+    bool res;
+
+    if (msg == NULL) {
+        res = FlexBuf_PushFmt(file->err_msg, "cannot read file %s",
+            file->path);
+    } else {
+        res = FlexBuf_PushBuf(file->err_msg, FlexBuf_Data(msg),
+            FlexBuf_Size(msg));
+    }
+
+    if (res == false) {
+        FlexBuf_Free(file->err_msg);
+        file->err_msg = NULL;
+    }
+}
+
+static
+void
+Project_ReadRange(
+    void * ctx,
+    usize begin,
+    usize end
+) {
+    ProjFile * files = Project_Files((Project *)ctx);
+
+    for (usize i = begin; i < end; i++) {
+        ProjFile * file = files + i;
+
+        file->data = FixedBuf_NewFromFile(file->path);
+        if (file->data == NULL) {
+            ProjFile_SetError(file, NULL);
+            continue;
+        }
+
+        file->hash = Hash_Fnv1a(FixedBuf_Data(file->data),
+            FixedBuf_Size(file->data));
+    }
+}
+
+static
+void
+Project_ParseRange(
+    void * ctx,
+    usize begin,
+    usize end
+) {
+    Project * proj = (Project *)ctx;
+    ProjFile * files = Project_Files(proj);
+
+    /* One lexer and parser serve the whole part. */
+    Lexer * lex = Lexer_New();
+    Parser * par = lex != NULL ? Parser_New() : NULL;
+
+    for (usize i = begin; i < end; i++) {
+        ProjFile * file = files + i;
+
+        if (file->data == NULL || file->dup_of != i) {
+            continue;
+        }
+
+        const u8 * data = FixedBuf_Data(file->data);
+        usize size = FixedBuf_Size(file->data);
+
+        if (proj->cache != NULL &&
+            CodeCache_Load(proj->cache, data, size, &file->tree)) {
+
+            file->ok = true;
+            continue;
+        }
+
+        if (par == NULL) {
+            continue;
+        }
+
+        Lexer_Reset(lex);
+        Parser_Reset(par);
+
+        if (Lexer_ScanSrc(lex, file->path, data, size, &file->lo) == false) {
+
+            file->lo = NULL;
+            ProjFile_SetError(file, Lexer_ErrorMessage(lex));
+            continue;
+        }
+
+        Parser_Link(par, file->lo);
+
+        if (Parser_Parse(par, &file->tree) == false) {
+            file->tree = NULL;
+            ProjFile_SetError(file, Parser_ErrorMessage(par));
+            continue;
+        }
+
+        /* The file is built even if the tree cannot be cached. */
+        if (proj->cache != NULL) {
+            CodeCache_Store(proj->cache, data, size, file->tree);
+        }
+
+        file->ok = true;
+    }
+
+    if (par != NULL) {
+        Parser_Free(par);
+    }
+
+    if (lex != NULL) {
+        Lexer_Free(lex);
+    }
+}
+
+static
+int
+ProjKey_Compare(
+    const void * lhs,
+    const void * rhs
+) {
+    const ProjKey * a = (const ProjKey *)lhs;
+    const ProjKey * b = (const ProjKey *)rhs;
+
+    if (a->hash != b->hash) {
+        return a->hash < b->hash ? -1 : 1;
+    }
+
+    return (a->idx > b->idx) - (a->idx < b->idx);
+}
+
+static
+bool
+ProjFile_SameData(
+    ProjFile * a,
+    ProjFile * b
+) {
+    return FixedBuf_Size(a->data) == FixedBuf_Size(b->data) &&
+        memcmp(FixedBuf_Data(a->data), FixedBuf_Data(b->data),
+            FixedBuf_Size(a->data)) == 0;
+}
+
+/**
+ * @brief Points every file at the first file with the same contents.
+ *
+ * Equal hashes are confirmed by comparing the contents, so a collision
+ * never merges different files.
+ */
+static
+bool
+Project_Dedupe(
+    Project * proj
+) {
+    ProjFile * files = Project_Files(proj);
+    usize num_files = Project_NumFiles(proj);
+    usize num_keys = 0;
+
+    ProjKey * keys = (ProjKey *)MeMem_Malloc(sizeof(ProjKey) * num_files);
+    if (keys == NULL) {
+        return false;
+    }
+
+    for (usize i = 0; i < num_files; i++) {
+        if (files[i].data != NULL) {
+            keys[num_keys].hash = files[i].hash;
+            keys[num_keys].idx = i;
+            num_keys++;
+        }
+    }
+
+    qsort(keys, num_keys, sizeof(ProjKey), ProjKey_Compare);
+
+    for (usize i = 0; i < num_keys; i++) {
+        ProjFile * file = files + keys[i].idx;
+
+        /* Earlier files of the run of equal hashes come first. */
+        for (usize j = i; j > 0 && keys[j - 1].hash == keys[i].hash; j--) {
+            ProjFile * prev = files + keys[j - 1].idx;
+
+            if (prev->dup_of == keys[j - 1].idx &&
+                ProjFile_SameData(prev, file)) {
+
+                file->dup_of = keys[j - 1].idx;
+            }
+        }
+
+        if (file->dup_of == keys[i].idx) {
+            proj->num_unique++;
+        }
+    }
+
+    MeMem_Free(keys);
+
+    return true;
+}
+
+static
+void
+Project_ParallelFor(
+    Project * proj,
+    Sched * sched,
+    SchedRangeFn fn
+) {
+    usize num_files = Project_NumFiles(proj);
+
+    if (sched != NULL) {
+        Sched_ParallelFor(sched, 0, num_files, 0, fn, proj);
+    } else {
+        fn(proj, 0, num_files);
+    }
+}
+
+/**
+ * @brief Sets the cache the trees of the files are looked up in before they
+ *        are scanned and parsed, and stored in after.
+ *
+ * The cache is borrowed and must outlive the build, it may be shared with
+ * other projects and processes.
+ */
+void
+Project_SetCache(
+    Project * proj,
+    CodeCache * cache
+) {
+    proj->cache = cache;
+}
+
+/**
+ * @brief Reads, scans and parses every file of the project, in parallel on
+ *        the workers of a scheduler if one is given.
+ *
+ * Files are read and hashed first. Only the first of the files with the
+ * same contents is then scanned and parsed, or found in the code cache if
+ * one is set, the others share its output.
+ *
+ * @return `true` if every file was built, `false` if any file failed, see
+ *         `Project_PushDiagnostics`, or memory allocation fails.
+ */
+bool
+Project_Build(
+    Project * proj,
+    Sched * sched
+) {
+    ProjFile * files = Project_Files(proj);
+    usize num_files = Project_NumFiles(proj);
+    bool res = true;
+
+    if (proj->built) {
+        return false;
+    }
+
+    proj->built = true;
+
+    bool traced = Trace_Begin("Project_Build");
+
+    Project_ParallelFor(proj, sched, Project_ReadRange);
+
+    if (Project_Dedupe(proj) == false) {
+        res = false;
+        goto FreeData;
+    }
+
+    Project_ParallelFor(proj, sched, Project_ParseRange);
+
+    for (usize i = 0; i < num_files; i++) {
+        ProjFile * file = files + i;
+
+        if (file->dup_of != i) {
+            file->ok = files[file->dup_of].ok;
+        }
+
+        if (file->ok == false) {
+            res = false;
+        }
+    }
+
+FreeData:
+    for (usize i = 0; i < num_files; i++) {
+        if (files[i].data != NULL) {
+            FixedBuf_Free(files[i].data);
+            files[i].data = NULL;
+        }
+    }
+
+    Trace_End("Project_Build", traced);
+
+    return res;
+}
+
+usize
+Project_NumFiles(
+    Project * proj
+) {
+    return FlexBuf_Size(proj->files) / sizeof(ProjFile);
+}
+
+const ProjFile *
+Project_File(
+    Project * proj,
+    usize idx
+) {
+    return Project_Files(proj) + idx;
+}
+
+/**
+ * @brief Returns the number of distinct contents among the files read.
+ */
+usize
+Project_NumUnique(
+    Project * proj
+) {
+    return proj->num_unique;
+}
+
+/**
+ * @brief Appends one line per failed file to a FlexBuf, in the order the
+ *        files were added.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+Project_PushDiagnostics(
+    Project * proj,
+    FlexBuf * buf
+) {
+    ProjFile * files = Project_Files(proj);
+    usize num_files = Project_NumFiles(proj);
+
+    for (usize i = 0; i < num_files; i++) {
+        ProjFile * file = files + i;
+        bool res;
+
+        if (file->ok) {
+            continue;
+        }
+
+        if (file->dup_of != i) {
+            res = FlexBuf_PushFmt(buf, "%s: same contents as %s\n",
+                file->path, files[file->dup_of].path);
+        } else if (file->err_msg != NULL) {
+            res = FlexBuf_PushBuf(buf, FlexBuf_Data(file->err_msg),
+                FlexBuf_Size(file->err_msg)) &&
+                FlexBuf_PushByte(buf, '\n');
+        } else {
+            res = FlexBuf_PushFmt(buf, "%s: not built\n", file->path);
+        }
+
+        if (res == false) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+Project_Free(
+    Project * proj
+) {
+    ProjFile * files = Project_Files(proj);
+    usize num_files = Project_NumFiles(proj);
+
+    for (usize i = 0; i < num_files; i++) {
+        ProjFile * file = files + i;
+
+        if (file->tree != NULL) {
+            AstNode_FreeTree(file->tree);
+        }
+
+        if (file->lo != NULL) {
+            LexOut_Free(file->lo);
+        }
+
+        if (file->err_msg != NULL) {
+            FlexBuf_Free(file->err_msg);
+        }
+
+        if (file->data != NULL) {
+            FixedBuf_Free(file->data);
+        }
+
+        MeMem_Free(file->path);
+    }
+
+    FlexBuf_Free(proj->files);
+    MeMem_Free(proj);
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#ifndef __ME_PARSER_PROJECT_H__
+#define __ME_PARSER_PROJECT_H__
+
+#include "menos.h"
+#include "ast.h"
+#include "code_cache.h"
+#include "lexer/lexer.h"
+#include "util/fixed_buf.h"
+#include "util/flex_buf.h"
+#include "util/sched.h"
+
+/* A file of a project, read-only to the caller. */
+typedef struct _ProjFile {
+    char * path;
+
+    /* Hash of the contents, valid if they were read. */
+    u64 hash;
+
+    /* Index of the first file with the same contents, the file itself if
+       none. A duplicate shares the output of that file. */
+    usize dup_of;
+
+    /* Whether the file was read, scanned and parsed, on failure `err_msg`
+       holds the diagnostic if memory allowed. */
+    bool ok;
+
+    /* Tokens, `NULL` if the tree was found in the code cache. */
+    LexOut * lo;
+    AstNode * tree;
+    FlexBuf * err_msg;
+
+    /* Contents, only held while building. */
+    FixedBuf * data;
+} ProjFile;
+
+/* Set of script files scanned and parsed together. */
+typedef struct _Project Project;
+
+Project *
+Project_New(void);
+
+bool
+Project_AddFile(
+    Project * proj,
+    const char * path
+);
+
+bool
+Project_AddDir(
+    Project * proj,
+    const char * path,
+    const char * suffix
+);
+
+void
+Project_SetCache(
+    Project * proj,
+    CodeCache * cache
+);
+
+bool
+Project_Build(
+    Project * proj,
+    Sched * sched
+);
+
+usize
+Project_NumFiles(
+    Project * proj
+);
+
+const ProjFile *
+Project_File(
+    Project * proj,
+    usize idx
+);
+
+usize
+Project_NumUnique(
+    Project * proj
+);
+
+bool
+Project_PushDiagnostics(
+    Project * proj,
+    FlexBuf * buf
+);
+
+void
+Project_Free(
+    Project * proj
+);
+
+#endif
\ No newline at end of file
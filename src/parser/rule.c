@@ -1,4 +1,6 @@
 #include "rule.h"
+#include "match_tab.h"
+#include "util/trace.h"
 
 static
 AstNode *
@@ -6,6 +8,133 @@ ParRule_Expr(
     Parser * par
 );
 
+/**
+ * @brief Creates the node of a numeric literal token.
+ *
+ * @param neg Whether the literal is negated. A negated big literal that fits
+ *            in `ssize` gets a plain value.
+ */
+static
+AstNode *
+ParRule_NewNumLit(
+    Token * tok,
+    bool neg
+) {
+    BigInt * big = tok->ext.num_lit.big;
+    if (big == NULL) {
+        ssize num = (ssize)tok->ext.num_lit.val;
+
+        return AstNode_NewNumLit(neg ? -num : num);
+    }
+
+    if (neg == false) {
+        return AstNode_NewBigNumLit(big);
+    }
+
+    BigInt * neg_big = BigInt_Neg(big);
+    if (neg_big == NULL) {
+        return NULL;
+    }
+
+    AstNode * node;
+    ssize num;
+
+    if (BigInt_ToSsize(neg_big, &num)) {
+        node = AstNode_NewNumLit(num);
+    } else {
+        node = AstNode_NewBigNumLit(neg_big);
+    }
+
+    BigInt_Free(neg_big);
+
+    return node;
+}
+
+static
+AstSeq *
+ParRule_Args(
+    Parser * par
+) {
+    AstSeq * seq = NULL;
+    AstNode * arg_node;
+
+    if (seq = AstSeq_New(), seq == NULL) {
+        Parser_SetNoEnoughMemoryError(par);
+        goto Exit;
+    }
+
+    if (Parser_Expect(par, TokTag_LeftParen) == NULL) {
+        Parser_SetUnexpectedTokenError(par);
+        goto FreeSeq;
+    }
+
+    if (Parser_Expect(par, TokTag_RightParen) != NULL) {
+        goto Exit;
+    }
+
+    do {
+        if (arg_node = ParRule_Expr(par), Parser_Failed(par)) {
+            goto FreeSeq;
+        }
+
+        if (AstSeq_Push(seq, arg_node) == false) {
+            Parser_SetNoEnoughMemoryError(par);
+            goto FreeArgNode;
+        }
+    } while (Parser_Expect(par, TokTag_Comma) != NULL);
+
+    if (Parser_Expect(par, TokTag_RightParen) == NULL) {
+        Parser_SetUnexpectedTokenError(par);
+        goto FreeSeq;
+    }
+
+    goto Exit;
+
+FreeArgNode:
+    AstNode_FreeTree(arg_node);
+
+FreeSeq:
+    AstSeq_Free(seq);
+    seq = NULL;
+
+Exit:
+    return seq;
+}
+
+static
+AstNode *
+ParRule_Call(
+    Parser * par
+) {
+    AstNode * call_node = NULL;
+    AstSeq * args;
+    Token * tok;
+
+    if (tok = Parser_Expect(par, TokTag_Name), tok == NULL) {
+        Parser_SetUnexpectedTokenError(par);
+        goto Exit;
+    }
+
+    if (args = ParRule_Args(par), Parser_Failed(par)) {
+        goto Exit;
+    }
+
+    if (call_node = AstNode_NewCall(tok->ext.name.str, args),
+        call_node == NULL) {
+
+        Parser_SetNoEnoughMemoryError(par);
+        goto FreeArgs;
+    }
+
+    goto Exit;
+
+FreeArgs:
+    AstSeq_Free(args);
+
+Exit:
+    return call_node;
+}
+
 static
 AstNode *
 ParRule_Base(
@@ -21,6 +150,11 @@ ParRule_Base(
 
     switch (tok->tag) {
     case TokTag_Name:
+        if (Parser_LookAhead(par, 1)->tag == TokTag_LeftParen) {
+            base_node = ParRule_Call(par);
+            break;
+        }
+
         if (base_node = AstNode_NewVar(tok->ext.name.str),
             base_node == NULL) {
 
@@ -45,7 +179,7 @@ ParRule_Base(
         break;
 
     case TokTag_NumLit:
-        if (base_node = AstNode_NewNumLit(tok->ext.num_lit.val),
+        if (base_node = ParRule_NewNumLit(tok, false),
             base_node == NULL) {
 
             Parser_SetNoEnoughMemoryError(par);
@@ -124,7 +258,7 @@ ParRule_Opd1(
 
         if (res_node = AstNode_New(), res_node == NULL) {
             Parser_SetNoEnoughMemoryError(par);
-            goto Exit;
+            goto FreeOpdNode;
         }
 
         if (tok->tag == TokTag_Plus) {
@@ -142,6 +276,9 @@ ParRule_Opd1(
 
     goto Exit;
 
+FreeOpdNode:
+    AstNode_FreeTree(opd_node);
+
 Exit:
     return res_node;
 }
@@ -187,7 +324,7 @@ FreeRhsNode:
     AstNode_FreeTree(rhs_node);
 
 FreeLhsNode:
-    AstNode_Free(lhs_node);
+    AstNode_FreeTree(lhs_node);
 
 Exit:
     return res_node;
@@ -244,7 +381,7 @@ FreeRhsNode:
     AstNode_FreeTree(rhs_node);
 
 FreeLhsNode:
-    AstNode_Free(lhs_node);
+    AstNode_FreeTree(lhs_node);
 
 Exit:
     return res_node;
@@ -298,7 +435,7 @@ FreeRhsNode:
     AstNode_FreeTree(rhs_node);
 
 FreeLhsNode:
-    AstNode_Free(lhs_node);
+    AstNode_FreeTree(lhs_node);
 
 Exit:
     return res_node;
@@ -357,7 +494,7 @@ FreeRhsNode:
     AstNode_FreeTree(rhs_node);
 
 FreeLhsNode:
-    AstNode_Free(lhs_node);
+    AstNode_FreeTree(lhs_node);
 
 Exit:
     return res_node;
@@ -411,7 +548,7 @@ FreeRhsNode:
     AstNode_FreeTree(rhs_node);
 
 FreeLhsNode:
-    AstNode_Free(lhs_node);
+    AstNode_FreeTree(lhs_node);
 
 Exit:
     return res_node;
@@ -458,7 +595,7 @@ FreeRhsNode:
     AstNode_FreeTree(rhs_node);
 
 FreeLhsNode:
-    AstNode_Free(lhs_node);
+    AstNode_FreeTree(lhs_node);
 
 Exit:
     return res_node;
@@ -505,7 +642,7 @@ FreeRhsNode:
     AstNode_FreeTree(rhs_node);
 
 FreeLhsNode:
-    AstNode_Free(lhs_node);
+    AstNode_FreeTree(lhs_node);
 
 Exit:
     return res_node;
@@ -557,14 +694,11 @@ ParRule_AsgnStmt(
         stmt_node == NULL) {
 
         Parser_SetNoEnoughMemoryError(par);
-        goto FreeStmtNode;
+        goto FreeRhsNode;
     }
 
     goto Exit;
 
-FreeStmtNode:
-    AstNode_FreeTree(stmt_node);
-
 FreeRhsNode:
     AstNode_FreeTree(rhs_node);
 
@@ -615,10 +749,11 @@ ParRule_Block(
     goto Exit;
 
 FreeStmtNode:
-    AstNode_Free(stmt_node);
+    AstNode_FreeTree(stmt_node);
 
 FreeSeq:
     AstSeq_Free(seq);
+    seq = NULL;
 
 Exit:
     return seq;
@@ -640,7 +775,7 @@ ParRule_BlockStmt(
         block_node == NULL) {
 
         Parser_SetNoEnoughMemoryError(par);
-        goto Exit;
+        goto FreeSeq;
     }
 
     goto Exit;
@@ -713,6 +848,390 @@ Exit:
     return stmt_node;
 }
 
+static
+AstNode *
+ParRule_MatchKey(
+    Parser * par
+) {
+    AstNode * key_node = NULL;
+    bool neg = false;
+    Token * tok;
+
+    if (Parser_Expect(par, TokTag_Minus) != NULL) {
+        neg = true;
+    }
+
+    if (tok = Parser_Peek(par), tok == NULL) {
+        Parser_SetUnexpectedTokenError(par);
+        goto Exit;
+    }
+
+    if (neg && tok->tag != TokTag_NumLit) {
+        Parser_SetUnexpectedTokenError(par);
+        goto Exit;
+    }
+
+    switch (tok->tag) {
+    case TokTag_NumLit:
+        if (key_node = ParRule_NewNumLit(tok, neg),
+            key_node == NULL) {
+
+            Parser_SetNoEnoughMemoryError(par);
+            goto Exit;
+        }
+
+        break;
+
+    case TokTag_StrLit:
+        if (key_node = AstNode_NewStrLit(tok->ext.str_lit.str),
+            key_node == NULL) {
+
+            Parser_SetNoEnoughMemoryError(par);
+            goto Exit;
+        }
+
+        break;
+
+    case TokTag_False:
+    case TokTag_True:
+        if (key_node = AstNode_NewBoolLit(tok->tag == TokTag_True),
+            key_node == NULL) {
+
+            Parser_SetNoEnoughMemoryError(par);
+            goto Exit;
+        }
+
+        break;
+
+    default:
+        Parser_SetUnexpectedTokenError(par);
+        goto Exit;
+    }
+
+    Parser_Consume(par);
+
+Exit:
+    return key_node;
+}
+
+static
+AstNode *
+ParRule_MatchArm(
+    Parser * par
+) {
+    AstNode * arm_node = NULL;
+    AstNode * key_node;
+    AstNode * body_node;
+
+    /* The arm is positioned at its key, where duplicates are reported. */
+    Token * tok = Parser_Peek(par);
+
+    if (key_node = ParRule_MatchKey(par), Parser_Failed(par)) {
+        goto Exit;
+    }
+
+    if (body_node = ParRule_BlockStmt(par), Parser_Failed(par)) {
+        goto FreeKeyNode;
+    }
+
+    if (arm_node = AstNode_NewMatchArm(key_node, body_node),
+        arm_node == NULL) {
+
+        Parser_SetNoEnoughMemoryError(par);
+        goto FreeBodyNode;
+    }
+
+    arm_node->row = tok->row;
+    arm_node->col = tok->col;
+
+    goto Exit;
+
+FreeBodyNode:
+    AstNode_FreeTree(body_node);
+
+FreeKeyNode:
+    AstNode_FreeTree(key_node);
+
+Exit:
+    return arm_node;
+}
+
+static
+AstNode *
+ParRule_MatchStmt(
+    Parser * par
+) {
+    AstNode * stmt_node = NULL;
+    AstNode * subj_node;
+    AstNode * arm_node;
+    AstNode * else_br_node = NULL;
+    AstSeq * arms;
+    usize dup;
+
+    if (Parser_Expect(par, TokTag_Match) == NULL) {
+        Parser_SetUnexpectedTokenError(par);
+        goto Exit;
+    }
+
+    if (subj_node = ParRule_Expr(par), Parser_Failed(par)) {
+        goto Exit;
+    }
+
+    if (arms = AstSeq_New(), arms == NULL) {
+        Parser_SetNoEnoughMemoryError(par);
+        goto FreeSubjNode;
+    }
+
+    if (Parser_Expect(par, TokTag_LeftBrace) == NULL) {
+        Parser_SetUnexpectedTokenError(par);
+        goto FreeArms;
+    }
+
+    while (Parser_Check(par, TokTag_RightBrace) == false &&
+           Parser_Check(par, TokTag_Else) == false) {
+
+        if (arm_node = ParRule_MatchArm(par), Parser_Failed(par)) {
+            goto FreeArms;
+        }
+
+        if (AstSeq_Push(arms, arm_node) == false) {
+            Parser_SetNoEnoughMemoryError(par);
+            goto FreeArmNode;
+        }
+    }
+
+    /* The optional else-branch must be the last one. */
+    if (Parser_Check(par, TokTag_Else)) {
+        Parser_Consume(par);
+
+        if (else_br_node = ParRule_BlockStmt(par), Parser_Failed(par)) {
+            else_br_node = NULL;
+            goto FreeArms;
+        }
+    }
+
+    if (Parser_Expect(par, TokTag_RightBrace) == NULL) {
+        Parser_SetUnexpectedTokenError(par);
+        goto FreeElseBrNode;
+    }
+
+    if (stmt_node = AstNode_NewMatchStmt(subj_node, arms, else_br_node,
+            &dup), stmt_node == NULL) {
+
+        if (dup != MATCH_TAB_NO_DUP) {
+            AstNode * dup_node = AstSeq_At(arms, dup);
+            Parser_SetDuplicateMatchArmError(par, dup_node->row,
+                dup_node->col);
+        } else {
+            Parser_SetNoEnoughMemoryError(par);
+        }
+
+        goto FreeElseBrNode;
+    }
+
+    goto Exit;
+
+FreeArmNode:
+    AstNode_FreeTree(arm_node);
+
+FreeElseBrNode:
+    if (else_br_node != NULL) {
+        AstNode_FreeTree(else_br_node);
+    }
+
+FreeArms:
+    AstSeq_Free(arms);
+
+FreeSubjNode:
+    AstNode_FreeTree(subj_node);
+
+Exit:
+    return stmt_node;
+}
+
+static
+AstNode *
+ParRule_ExprStmt(
+    Parser * par
+) {
+    AstNode * stmt_node = NULL;
+    AstNode * expr_node;
+
+    if (expr_node = ParRule_Expr(par), Parser_Failed(par)) {
+        goto Exit;
+    }
+
+    if (Parser_Expect(par, TokTag_Semicolon) == NULL) {
+        Parser_SetUnexpectedTokenError(par);
+        goto FreeExprNode;
+    }
+
+    if (stmt_node = AstNode_NewExprStmt(expr_node), stmt_node == NULL) {
+        Parser_SetNoEnoughMemoryError(par);
+        goto FreeExprNode;
+    }
+
+    goto Exit;
+
+FreeExprNode:
+    AstNode_FreeTree(expr_node);
+
+Exit:
+    return stmt_node;
+}
+
+static
+AstNode *
+ParRule_RetStmt(
+    Parser * par
+) {
+    AstNode * stmt_node = NULL;
+    AstNode * val_node = NULL;
+
+    if (Parser_Expect(par, TokTag_Return) == NULL) {
+        Parser_SetUnexpectedTokenError(par);
+        goto Exit;
+    }
+
+    if (Parser_Check(par, TokTag_Semicolon) == false) {
+        if (val_node = ParRule_Expr(par), Parser_Failed(par)) {
+            val_node = NULL;
+            goto Exit;
+        }
+    }
+
+    if (Parser_Expect(par, TokTag_Semicolon) == NULL) {
+        Parser_SetUnexpectedTokenError(par);
+        goto FreeValNode;
+    }
+
+    if (stmt_node = AstNode_NewRetStmt(val_node), stmt_node == NULL) {
+        Parser_SetNoEnoughMemoryError(par);
+        goto FreeValNode;
+    }
+
+    goto Exit;
+
+FreeValNode:
+    if (val_node != NULL) {
+        AstNode_FreeTree(val_node);
+    }
+
+Exit:
+    return stmt_node;
+}
+
+static
+AstSeq *
+ParRule_Params(
+    Parser * par
+) {
+    AstSeq * seq = NULL;
+    AstNode * param_node;
+    Token * tok;
+
+    if (seq = AstSeq_New(), seq == NULL) {
+        Parser_SetNoEnoughMemoryError(par);
+        goto Exit;
+    }
+
+    if (Parser_Expect(par, TokTag_LeftParen) == NULL) {
+        Parser_SetUnexpectedTokenError(par);
+        goto FreeSeq;
+    }
+
+    if (Parser_Expect(par, TokTag_RightParen) != NULL) {
+        goto Exit;
+    }
+
+    do {
+        if (tok = Parser_Expect(par, TokTag_Name), tok == NULL) {
+            Parser_SetUnexpectedTokenError(par);
+            goto FreeSeq;
+        }
+
+        if (param_node = AstNode_NewVar(tok->ext.name.str),
+            param_node == NULL) {
+
+            Parser_SetNoEnoughMemoryError(par);
+            goto FreeSeq;
+        }
+
+        if (AstSeq_Push(seq, param_node) == false) {
+            Parser_SetNoEnoughMemoryError(par);
+            goto FreeParamNode;
+        }
+    } while (Parser_Expect(par, TokTag_Comma) != NULL);
+
+    if (Parser_Expect(par, TokTag_RightParen) == NULL) {
+        Parser_SetUnexpectedTokenError(par);
+        goto FreeSeq;
+    }
+
+    goto Exit;
+
+FreeParamNode:
+    AstNode_FreeTree(param_node);
+
+FreeSeq:
+    AstSeq_Free(seq);
+    seq = NULL;
+
+Exit:
+    return seq;
+}
+
+static
+AstNode *
+ParRule_FuncDef(
+    Parser * par
+) {
+    AstNode * func_node = NULL;
+    AstNode * body_node;
+    AstSeq * params;
+    Token * fn_tok;
+    Token * tok;
+
+    if (fn_tok = Parser_Expect(par, TokTag_Fn), fn_tok == NULL) {
+        Parser_SetUnexpectedTokenError(par);
+        goto Exit;
+    }
+
+    if (tok = Parser_Expect(par, TokTag_Name), tok == NULL) {
+        Parser_SetUnexpectedTokenError(par);
+        goto Exit;
+    }
+
+    if (params = ParRule_Params(par), Parser_Failed(par)) {
+        goto Exit;
+    }
+
+    if (body_node = ParRule_BlockStmt(par), Parser_Failed(par)) {
+        goto FreeParams;
+    }
+
+    if (func_node = AstNode_NewFuncDef(tok->ext.name.str, params, body_node),
+        func_node == NULL) {
+
+        Parser_SetNoEnoughMemoryError(par);
+        goto FreeBodyNode;
+    }
+
+    func_node->row = fn_tok->row;
+    func_node->col = fn_tok->col;
+
+    goto Exit;
+
+FreeBodyNode:
+    AstNode_FreeTree(body_node);
+
+FreeParams:
+    AstSeq_Free(params);
+
+Exit:
+    return func_node;
+}
+
 static
 AstNode *
 ParRule_Stmt(
@@ -724,7 +1243,20 @@ ParRule_Stmt(
     tok = Parser_Peek(par);
     switch (tok->tag) {
     case TokTag_Name:
-        if (stmt_node = ParRule_AsgnStmt(par), Parser_Failed(par)) {
+        if (Parser_LookAhead(par, 1)->tag == TokTag_Assign) {
+            stmt_node = ParRule_AsgnStmt(par);
+        } else {
+            stmt_node = ParRule_ExprStmt(par);
+        }
+
+        if (Parser_Failed(par)) {
+            goto Exit;
+        }
+
+        break;
+
+    case TokTag_Return:
+        if (stmt_node = ParRule_RetStmt(par), Parser_Failed(par)) {
             goto Exit;
         }
 
@@ -737,6 +1269,13 @@ ParRule_Stmt(
 
         break;
 
+    case TokTag_Match:
+        if (stmt_node = ParRule_MatchStmt(par), Parser_Failed(par)) {
+            goto Exit;
+        }
+
+        break;
+
     case TokTag_LeftBrace:
         if (stmt_node = ParRule_BlockStmt(par), Parser_Failed(par)) {
             goto Exit;
@@ -749,6 +1288,9 @@ ParRule_Stmt(
         goto Exit;
     }
 
+    stmt_node->row = tok->row;
+    stmt_node->col = tok->col;
+
     goto Exit;
 
 Exit:
@@ -772,7 +1314,19 @@ ParRule_Prog(
     seq = prog_node->ext.block.seq;
 
     while (Parser_Check(par, TokTag_Eof) == false) {
-        if (stmt_node = ParRule_Stmt(par), Parser_Failed(par)) {
+
+        /* Functions can only be defined at the top level. */
+        if (Parser_Check(par, TokTag_Fn)) {
+            bool traced = Trace_Begin("ParRule_FuncDef");
+            stmt_node = ParRule_FuncDef(par);
+            Trace_End("ParRule_FuncDef", traced);
+        } else {
+            bool traced = Trace_Begin("ParRule_Stmt");
+            stmt_node = ParRule_Stmt(par);
+            Trace_End("ParRule_Stmt", traced);
+        }
+
+        if (Parser_Failed(par)) {
             goto FreeProgNode;
         }
 
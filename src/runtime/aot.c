@@ -0,0 +1,884 @@
+#include <stdio.h>
+
+#include "aot.h"
+
+/* Translator state. */
+typedef struct _AotGen {
+
+    /* Translated unit. */
+    FlexBuf * out;
+
+    /* Body of the function being translated. */
+    FlexBuf * body;
+
+    /* Function definitions, indexed by the number of their C function. */
+    FlexBuf * funcs;
+
+    /* Function being translated, `NULL` at the top level. */
+    AstNode * func;
+
+    /* Indentation level of the body. */
+    usize ind;
+
+    /* The number of temporaries used by the body. */
+    usize num_temps;
+
+    bool uses_top;
+    bool uses_leave;
+} AotGen;
+
+/* Appends an indented line to the body. */
+#define AOT_LINE(gen, ...) \
+    (Aot_Indent(gen) && \
+     FlexBuf_PushFmt((gen)->body, __VA_ARGS__) && \
+     FlexBuf_PushByte((gen)->body, '\n'))
+
+static
+bool
+Aot_Indent(
+    AotGen * gen
+) {
+    return FlexBuf_PushDupByte(gen->body, ' ', (gen->ind + 1) * 4);
+}
+
+/**
+ * @brief Returns the jump taken when an operation fails.
+ */
+static
+const char *
+Aot_Fail(
+    AotGen * gen
+) {
+    gen->uses_leave = true;
+
+    return "goto Leave;";
+}
+
+static
+void
+Aot_UseTemps(
+    AotGen * gen,
+    usize num
+) {
+    if (gen->num_temps < num) {
+        gen->num_temps = num;
+    }
+}
+
+static
+const char *
+Aot_TagName(
+    AstTag tag
+) {
+    switch (tag) {
+    case AstTag_LogNotOp: return "AstTag_LogNotOp";
+    case AstTag_RelEquOp: return "AstTag_RelEquOp";
+    case AstTag_RelNeqOp: return "AstTag_RelNeqOp";
+    case AstTag_RelLtOp: return "AstTag_RelLtOp";
+    case AstTag_RelLteOp: return "AstTag_RelLteOp";
+    case AstTag_RelGtOp: return "AstTag_RelGtOp";
+    case AstTag_RelGteOp: return "AstTag_RelGteOp";
+    case AstTag_UnaPlusOp: return "AstTag_UnaPlusOp";
+    case AstTag_UnaMinusOp: return "AstTag_UnaMinusOp";
+    case AstTag_BinAddOp: return "AstTag_BinAddOp";
+    case AstTag_BinSubOp: return "AstTag_BinSubOp";
+    case AstTag_BinMulOp: return "AstTag_BinMulOp";
+    case AstTag_BinDivOp: return "AstTag_BinDivOp";
+    case AstTag_BinModOp: return "AstTag_BinModOp";
+    case AstTag_BinExpOp: return "AstTag_BinExpOp";
+    default: return NULL;
+    }
+}
+
+/**
+ * @brief Formats an integer as a C constant expression of type `ssize`.
+ */
+static
+void
+Aot_FormatNum(
+    char * buf,
+    usize len,
+    ssize num
+) {
+    if (num == INT64_MIN) {
+        snprintf(buf, len, "(-9223372036854775807 - 1)");
+    } else {
+        snprintf(buf, len, "%zd", num);
+    }
+}
+
+/**
+ * @brief Appends a byte string as a C string literal.
+ */
+static
+bool
+Aot_PushCStr(
+    FlexBuf * buf,
+    const u8 * str,
+    usize len
+) {
+    if (FlexBuf_PushByte(buf, '"') == false) {
+        return false;
+    }
+
+    for (usize i = 0; i < len; i++) {
+        u8 byte = str[i];
+        bool res;
+
+        if (byte == '"' || byte == '\\') {
+            res = FlexBuf_PushByte(buf, '\\') && FlexBuf_PushByte(buf, byte);
+        } else if (byte >= 0x20 && byte <= 0x7E) {
+            res = FlexBuf_PushByte(buf, byte);
+        } else {
+            res = FlexBuf_PushFmt(buf, "\\%03o", byte);
+        }
+
+        if (res == false) {
+            return false;
+        }
+    }
+
+    return FlexBuf_PushByte(buf, '"');
+}
+
+static
+usize
+Aot_FuncIdx(
+    AotGen * gen,
+    AstNode * func
+) {
+    AstNode ** buf_funcs = (AstNode **)FlexBuf_Data(gen->funcs);
+    usize num_funcs = FlexBuf_Size(gen->funcs) / sizeof(AstNode *);
+
+    for (usize i = 0; i < num_funcs; i++) {
+        if (buf_funcs[i] == func) {
+            return i;
+        }
+    }
+
+    return num_funcs;
+}
+
+/**
+ * @brief Formats the C lvalue of a resolved variable.
+ */
+static
+void
+Aot_FormatVar(
+    char * buf,
+    usize len,
+    AstNode * var
+) {
+    snprintf(buf, len, "%c[%zu]",
+        var->ext.var.local ? 'l' : 'g', var->ext.var.slot);
+}
+
+/**
+ * @brief Appends the decimal digits of a big integer as a C string literal
+ *        followed by its length.
+ */
+static
+bool
+Aot_PushBigArgs(
+    FlexBuf * out,
+    BigInt * big
+) {
+    FlexBuf * digits = FlexBuf_New();
+    if (digits == NULL) {
+        return false;
+    }
+
+    bool res = BigInt_PushAsStr(big, digits) &&
+        Aot_PushCStr(out, FlexBuf_Data(digits), FlexBuf_Size(digits)) &&
+        FlexBuf_PushFmt(out, ", %zu", FlexBuf_Size(digits));
+
+    FlexBuf_Free(digits);
+
+    return res;
+}
+
+static
+bool
+Aot_EmitStr(
+    AotGen * gen,
+    FixedBuf * str,
+    usize dst
+) {
+    return Aot_Indent(gen) &&
+        FlexBuf_PushFmt(gen->body, "if (AotRt_Str(ctx, &t[%zu], ", dst) &&
+        Aot_PushCStr(gen->body, FixedBuf_Data(str), FixedBuf_Size(str)) &&
+        FlexBuf_PushFmt(gen->body, ", %zu) == false) %s\n",
+            FixedBuf_Size(str), Aot_Fail(gen));
+}
+
+/**
+ * @brief Translates an expression, its value ends up in temporary `dst`.
+ *
+ * Temporaries above `dst` are free for the subexpressions, and every
+ * temporary is nil again once its value is consumed.
+ */
+static
+bool
+Aot_EmitExpr(
+    AotGen * gen,
+    AstNode * node,
+    usize dst
+) {
+    Aot_UseTemps(gen, dst + 1);
+
+    switch (node->tag) {
+    case AstTag_StrLit:
+        return Aot_EmitStr(gen, node->ext.str_lit.str, dst);
+
+    case AstTag_NumLit: {
+        char num[32];
+
+        if (node->ext.num_lit.big != NULL) {
+            return Aot_Indent(gen) &&
+                FlexBuf_PushFmt(gen->body,
+                    "if (AotRt_BigLit(ctx, &t[%zu], ", dst) &&
+                Aot_PushBigArgs(gen->body, node->ext.num_lit.big) &&
+                FlexBuf_PushFmt(gen->body, ") == false) %s\n",
+                    Aot_Fail(gen));
+        }
+
+        Aot_FormatNum(num, sizeof(num), node->ext.num_lit.num);
+
+        return AOT_LINE(gen, "Value_InitNum(&t[%zu], %s);", dst, num);
+    }
+
+    case AstTag_BoolLit:
+        return AOT_LINE(gen, "Value_InitBool(&t[%zu], %s);",
+            dst, node->ext.bool_lit.val ? "true" : "false");
+
+    case AstTag_Var: {
+        char var[32];
+
+        Aot_FormatVar(var, sizeof(var), node);
+
+        return AOT_LINE(gen, "if (AotRt_Copy(ctx, &t[%zu], &%s) == false) %s",
+            dst, var, Aot_Fail(gen));
+    }
+
+    case AstTag_Call: {
+        AstNode ** buf_args = AstSeq_Data(node->ext.call.args);
+        usize num_args = AstSeq_Count(node->ext.call.args);
+
+        for (usize i = 0; i < num_args; i++) {
+            if (Aot_EmitExpr(gen, buf_args[i], dst + i) == false) {
+                return false;
+            }
+        }
+
+        return AOT_LINE(gen,
+            "if (f%zu(ctx, &t[%zu], &t[%zu]) == false) %s",
+            Aot_FuncIdx(gen, node->ext.call.func), dst, dst,
+            Aot_Fail(gen));
+    }
+
+    case AstTag_LogNotOp:
+
+    case AstTag_UnaPlusOp:
+    case AstTag_UnaMinusOp:
+        return Aot_EmitExpr(gen, node->ext.una_op.opd, dst) &&
+            AOT_LINE(gen, "if (AotRt_Unary(ctx, %s, &t[%zu]) == false) %s",
+                Aot_TagName(node->tag), dst, Aot_Fail(gen));
+
+    case AstTag_LogOrOp:
+    case AstTag_LogAndOp: {
+        bool is_or = node->tag == AstTag_LogOrOp;
+
+        if (Aot_EmitExpr(gen, node->ext.bin_op.lhs, dst) == false ||
+            AOT_LINE(gen, "if (AotRt_Cond(ctx, &t[%zu], &c) == false) %s",
+                dst, Aot_Fail(gen)) == false ||
+            AOT_LINE(gen, "if (%sc) {", is_or ? "" : "!") == false) {
+
+            return false;
+        }
+
+        gen->ind += 1;
+
+        if (AOT_LINE(gen, "Value_InitBool(&t[%zu], %s);",
+            dst, is_or ? "true" : "false") == false) {
+
+            return false;
+        }
+
+        gen->ind -= 1;
+
+        if (AOT_LINE(gen, "} else {") == false) {
+            return false;
+        }
+
+        gen->ind += 1;
+
+        if (Aot_EmitExpr(gen, node->ext.bin_op.rhs, dst) == false ||
+            AOT_LINE(gen, "if (AotRt_Cond(ctx, &t[%zu], &c) == false) %s",
+                dst, Aot_Fail(gen)) == false ||
+            AOT_LINE(gen, "Value_InitBool(&t[%zu], c);", dst) == false) {
+
+            return false;
+        }
+
+        gen->ind -= 1;
+
+        return AOT_LINE(gen, "}");
+    }
+
+    case AstTag_RelEquOp:
+    case AstTag_RelNeqOp:
+    case AstTag_RelLtOp:
+    case AstTag_RelLteOp:
+    case AstTag_RelGtOp:
+    case AstTag_RelGteOp:
+
+    case AstTag_BinAddOp:
+    case AstTag_BinSubOp:
+    case AstTag_BinMulOp:
+    case AstTag_BinDivOp:
+    case AstTag_BinModOp:
+    case AstTag_BinExpOp:
+        return Aot_EmitExpr(gen, node->ext.bin_op.lhs, dst) &&
+            Aot_EmitExpr(gen, node->ext.bin_op.rhs, dst + 1) &&
+            AOT_LINE(gen,
+                "if (AotRt_Binary(ctx, %s, &t[%zu], &t[%zu]) == false) %s",
+                Aot_TagName(node->tag), dst, dst + 1, Aot_Fail(gen));
+
+    default:
+        return false;
+    }
+}
+
+static
+bool
+Aot_EmitStmt(
+    AotGen * gen,
+    AstNode * node
+);
+
+static
+bool
+Aot_EmitBranch(
+    AotGen * gen,
+    AstNode * node
+) {
+    gen->ind += 1;
+
+    bool res = Aot_EmitStmt(gen, node);
+
+    gen->ind -= 1;
+
+    return res;
+}
+
+/**
+ * @brief Translates a match statement into a C switch selecting the arm,
+ *        leaving the jump tables to the C compiler.
+ */
+static
+bool
+Aot_EmitMatch(
+    AotGen * gen,
+    AstNode * node
+) {
+    AstNode ** buf_arms = AstSeq_Data(node->ext.match_stmt.arms);
+    usize num_arms = AstSeq_Count(node->ext.match_stmt.arms);
+    usize bool_arms[2] = { num_arms, num_arms };
+
+    if (Aot_EmitExpr(gen, node->ext.match_stmt.subj, 0) == false ||
+        AOT_LINE(gen, "arm = %zu;", num_arms) == false ||
+        AOT_LINE(gen, "switch (t[0].tag) {") == false ||
+        AOT_LINE(gen, "case ValTag_Num:") == false ||
+        AOT_LINE(gen, "    switch (t[0].ext.num) {") == false) {
+
+        return false;
+    }
+
+    for (usize i = 0; i < num_arms; i++) {
+        AstNode * key = buf_arms[i]->ext.match_arm.key;
+        char num[32];
+
+        if (key->tag == AstTag_BoolLit) {
+            bool_arms[key->ext.bool_lit.val ? 1 : 0] = i;
+        }
+
+        if (key->tag != AstTag_NumLit ||
+            key->ext.num_lit.big != NULL) {
+
+            continue;
+        }
+
+        Aot_FormatNum(num, sizeof(num), key->ext.num_lit.num);
+
+        if (AOT_LINE(gen, "    case %s: arm = %zu; break;", num, i) == false) {
+            return false;
+        }
+    }
+
+    if (AOT_LINE(gen, "    }") == false ||
+        AOT_LINE(gen, "    break;") == false ||
+        AOT_LINE(gen, "case ValTag_Bool:") == false ||
+        AOT_LINE(gen, "    arm = t[0].ext.val ? %zu : %zu;",
+            bool_arms[1], bool_arms[0]) == false ||
+        AOT_LINE(gen, "    break;") == false ||
+        AOT_LINE(gen, "case ValTag_Big:") == false) {
+
+        return false;
+    }
+
+    for (usize i = 0; i < num_arms; i++) {
+        AstNode * key = buf_arms[i]->ext.match_arm.key;
+        if (key->tag != AstTag_NumLit ||
+            key->ext.num_lit.big == NULL) {
+
+            continue;
+        }
+
+        if (Aot_Indent(gen) == false ||
+            FlexBuf_PushStr(gen->body, "    if (AotRt_BigEquals(&t[0], ") ==
+                false ||
+            Aot_PushBigArgs(gen->body, key->ext.num_lit.big) == false ||
+            FlexBuf_PushFmt(gen->body, ")) arm = %zu;\n", i) == false) {
+
+            return false;
+        }
+    }
+
+    if (AOT_LINE(gen, "    break;") == false ||
+        AOT_LINE(gen, "case ValTag_Str:") == false) {
+
+        return false;
+    }
+
+    for (usize i = 0; i < num_arms; i++) {
+        AstNode * key = buf_arms[i]->ext.match_arm.key;
+        if (key->tag != AstTag_StrLit) {
+            continue;
+        }
+
+        FixedBuf * str = key->ext.str_lit.str;
+
+        if (Aot_Indent(gen) == false ||
+            FlexBuf_PushStr(gen->body, "    if (AotRt_StrEquals(&t[0], ") ==
+                false ||
+            Aot_PushCStr(gen->body,
+                FixedBuf_Data(str), FixedBuf_Size(str)) == false ||
+            FlexBuf_PushFmt(gen->body, ", %zu)) arm = %zu;\n",
+                FixedBuf_Size(str), i) == false) {
+
+            return false;
+        }
+    }
+
+    if (AOT_LINE(gen, "    break;") == false ||
+        AOT_LINE(gen, "default:") == false ||
+        AOT_LINE(gen, "    break;") == false ||
+        AOT_LINE(gen, "}") == false ||
+        AOT_LINE(gen, "AotRt_Release(t, 1);") == false ||
+        AOT_LINE(gen, "switch (arm) {") == false) {
+
+        return false;
+    }
+
+    for (usize i = 0; i < num_arms; i++) {
+        if (AOT_LINE(gen, "case %zu:", i) == false ||
+            Aot_EmitBranch(gen, buf_arms[i]->ext.match_arm.body) == false ||
+            AOT_LINE(gen, "    break;") == false) {
+
+            return false;
+        }
+    }
+
+    if (node->ext.match_stmt.else_br != NULL) {
+        if (AOT_LINE(gen, "default:") == false ||
+            Aot_EmitBranch(gen, node->ext.match_stmt.else_br) == false ||
+            AOT_LINE(gen, "    break;") == false) {
+
+            return false;
+        }
+    }
+
+    return AOT_LINE(gen, "}");
+}
+
+/**
+ * @brief Translates a return, a returned call to the function itself
+ *        becomes a jump back to its first statement.
+ */
+static
+bool
+Aot_EmitRet(
+    AotGen * gen,
+    AstNode * node
+) {
+    AstNode * val = node->ext.ret_stmt.val;
+
+    if (val == NULL) {
+        gen->uses_leave = true;
+
+        return AOT_LINE(gen, "Value_InitNil(out);") &&
+            AOT_LINE(gen, "res = true;") &&
+            AOT_LINE(gen, "goto Leave;");
+    }
+
+    if (val->tag == AstTag_Call &&
+        val->ext.call.tail &&
+        val->ext.call.func == gen->func) {
+
+        AstNode ** buf_args = AstSeq_Data(val->ext.call.args);
+        usize num_args = AstSeq_Count(val->ext.call.args);
+
+        Aot_UseTemps(gen, 1);
+
+        for (usize i = 0; i < num_args; i++) {
+            if (Aot_EmitExpr(gen, buf_args[i], i) == false) {
+                return false;
+            }
+        }
+
+        gen->uses_top = true;
+
+        return AOT_LINE(gen, "AotRt_Release(l, %zu);",
+                gen->func->ext.func_def.num_slots) &&
+            AOT_LINE(gen, "AotRt_Move(l, t, %zu);", num_args) &&
+            AOT_LINE(gen, "if (AotRt_Poll(ctx) == false) %s",
+                Aot_Fail(gen)) &&
+            AOT_LINE(gen, "goto Top;");
+    }
+
+    gen->uses_leave = true;
+
+    return Aot_EmitExpr(gen, val, 0) &&
+        AOT_LINE(gen, "AotRt_Move(out, t, 1);") &&
+        AOT_LINE(gen, "res = true;") &&
+        AOT_LINE(gen, "goto Leave;");
+}
+
+static
+bool
+Aot_EmitStmt(
+    AotGen * gen,
+    AstNode * node
+) {
+    switch (node->tag) {
+    case AstTag_AsgnStmt: {
+        char var[32];
+
+        Aot_FormatVar(var, sizeof(var), node->ext.asgn_stmt.lhs);
+
+        return Aot_EmitExpr(gen, node->ext.asgn_stmt.rhs, 0) &&
+            AOT_LINE(gen, "AotRt_Store(&%s, t);", var);
+    }
+
+    case AstTag_IfStmt:
+        return Aot_EmitExpr(gen, node->ext.if_stmt.cond, 0) &&
+            AOT_LINE(gen, "if (AotRt_Cond(ctx, t, &c) == false) %s",
+                Aot_Fail(gen)) &&
+            AOT_LINE(gen, "if (c) {") &&
+            Aot_EmitBranch(gen, node->ext.if_stmt.then_br) &&
+            AOT_LINE(gen, "}");
+
+    case AstTag_IfElseStmt:
+        return Aot_EmitExpr(gen, node->ext.if_else_stmt.cond, 0) &&
+            AOT_LINE(gen, "if (AotRt_Cond(ctx, t, &c) == false) %s",
+                Aot_Fail(gen)) &&
+            AOT_LINE(gen, "if (c) {") &&
+            Aot_EmitBranch(gen, node->ext.if_else_stmt.then_br) &&
+            AOT_LINE(gen, "} else {") &&
+            Aot_EmitBranch(gen, node->ext.if_else_stmt.else_br) &&
+            AOT_LINE(gen, "}");
+
+    case AstTag_MatchStmt:
+        return Aot_EmitMatch(gen, node);
+
+    case AstTag_BlockStmt:
+    case AstTag_Prog: {
+        AstNode ** buf_nodes = AstSeq_Data(node->ext.block.seq);
+        usize num_nodes = AstSeq_Count(node->ext.block.seq);
+
+        for (usize i = 0; i < num_nodes; i++) {
+            if (Aot_EmitStmt(gen, buf_nodes[i]) == false) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    case AstTag_ExprStmt:
+        return Aot_EmitExpr(gen, node->ext.expr_stmt.expr, 0) &&
+            AOT_LINE(gen, "AotRt_Release(t, 1);");
+
+    case AstTag_RetStmt:
+        return Aot_EmitRet(gen, node);
+
+    case AstTag_FuncDef:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Translates a function, or the top-level statements if `func` is
+ *        `NULL`, into a C function.
+ */
+static
+bool
+Aot_EmitFunc(
+    AotGen * gen,
+    AstNode * func,
+    AstNode * body
+) {
+    FlexBuf * out = gen->out;
+
+    gen->func = func;
+    gen->num_temps = 1;
+    gen->uses_top = false;
+    gen->uses_leave = false;
+    FlexBuf_Clear(gen->body);
+
+    if (Aot_EmitStmt(gen, body) == false) {
+        return false;
+    }
+
+    usize num_temps = gen->num_temps;
+
+    if (func == NULL) {
+        if (FlexBuf_PushFmt(out,
+            "static\nbool\nRun(\n    AotCtx * ctx\n) {\n"
+            "    Value t[%zu];\n"
+            "    AotFrame fr;\n"
+            "    usize arm;\n"
+            "    bool c;\n"
+            "    bool res = false;\n\n"
+            "    (void)arm;\n"
+            "    (void)c;\n"
+            "    AotRt_Init(t, %zu);\n"
+            "    AotRt_PushFrame(ctx, &fr, NULL, 0, t, %zu);\n\n",
+            num_temps, num_temps, num_temps) == false) {
+
+            return false;
+        }
+    } else {
+        usize num_slots = func->ext.func_def.num_slots;
+        FixedBuf * name = func->ext.func_def.name;
+
+        if (FlexBuf_PushFmt(out,
+            "/* fn %.*s */\n"
+            "static\nbool\nf%zu(\n"
+            "    AotCtx * ctx,\n    Value * args,\n    Value * out\n) {\n"
+            "    Value l[%zu];\n"
+            "    Value t[%zu];\n"
+            "    AotFrame fr;\n"
+            "    usize arm;\n"
+            "    bool c;\n"
+            "    bool res = false;\n\n"
+            "    (void)arm;\n"
+            "    (void)c;\n"
+            "    AotRt_Init(l, %zu);\n"
+            "    AotRt_Init(t, %zu);\n"
+            "    AotRt_Move(l, args, %zu);\n"
+            "    AotRt_PushFrame(ctx, &fr, l, %zu, t, %zu);\n\n"
+            "    if (AotRt_Enter(ctx) == false) {\n"
+            "        goto Free;\n"
+            "    }\n\n",
+            (int)FixedBuf_Size(name), (char *)FixedBuf_Data(name),
+            Aot_FuncIdx(gen, func),
+            num_slots == 0 ? 1 : num_slots, num_temps,
+            num_slots, num_temps,
+            AstSeq_Count(func->ext.func_def.params),
+            num_slots, num_temps) == false) {
+
+            return false;
+        }
+
+        if (gen->uses_top &&
+            FlexBuf_PushStr(out, "Top:\n") == false) {
+
+            return false;
+        }
+    }
+
+    if (FlexBuf_Merge(out, gen->body) == false) {
+        return false;
+    }
+
+    if (func == NULL) {
+        return FlexBuf_PushFmt(out,
+            "    res = true;\n\n"
+            "%s"
+            "    AotRt_PopFrame(ctx, &fr);\n"
+            "    AotRt_Release(t, %zu);\n\n"
+            "    return res;\n"
+            "}\n\n",
+            gen->uses_leave ? "Leave:\n" : "", num_temps);
+    }
+
+    return FlexBuf_PushFmt(out,
+        "    Value_InitNil(out);\n"
+        "    res = true;\n\n"
+        "%s"
+        "    AotRt_Leave(ctx);\n\n"
+        "Free:\n"
+        "    AotRt_PopFrame(ctx, &fr);\n"
+        "    AotRt_Release(l, %zu);\n"
+        "    AotRt_Release(t, %zu);\n\n"
+        "    return res;\n"
+        "}\n\n",
+        gen->uses_leave ? "Leave:\n" : "",
+        func->ext.func_def.num_slots, num_temps);
+}
+
+static
+bool
+Aot_EmitGlobals(
+    Interp * interp,
+    FlexBuf * out
+) {
+    usize num_globs = Interp_GlobalCount(interp);
+
+    if (FlexBuf_PushFmt(out,
+        "static Value g[%zu];\n\n"
+        "static const char * const g_names[%zu] = {\n",
+        num_globs == 0 ? 1 : num_globs,
+        num_globs == 0 ? 1 : num_globs) == false) {
+
+        return false;
+    }
+
+    for (usize i = 0; i < num_globs; i++) {
+        FixedBuf * name = Interp_GlobalName(interp, i);
+
+        if (FlexBuf_PushStr(out, "    ") == false ||
+            Aot_PushCStr(out, FixedBuf_Data(name), FixedBuf_Size(name)) ==
+                false ||
+            FlexBuf_PushStr(out, ",\n") == false) {
+
+            return false;
+        }
+    }
+
+    if (num_globs == 0 &&
+        FlexBuf_PushStr(out, "    \"\",\n") == false) {
+
+        return false;
+    }
+
+    return FlexBuf_PushStr(out, "};\n\n");
+}
+
+/**
+ * @brief Translates the program loaded by an interpreter to a C unit.
+ *
+ * Each function becomes a C function taking ownership of its arguments, and
+ * values live in fixed-size arrays of locals and temporaries. Operators and
+ * value management go through the `AotRt_*` runtime, so the result matches
+ * the interpreter; returned calls of a function to itself are compiled to
+ * jumps. Locals and temporaries are registered as roots of the heap, which
+ * is collected at function entries and self-jumps, the only places where
+ * execution can loop. The unit exports an `AotProg` named by
+ * `AOT_PROG_SYMBOL` and is meant to be compiled to a shared object and
+ * loaded with `AotLib_Open`.
+ *
+ * @param interp A pointer to the interpreter, with a program loaded.
+ * @param out A pointer to the FlexBuf receiving the C source.
+ *
+ * @return `true` on success, `false` if no program is loaded or memory
+ *         allocation fails.
+ */
+bool
+Aot_Translate(
+    Interp * interp,
+    FlexBuf * out
+) {
+    bool res = false;
+
+    AstNode * prog = Interp_Program(interp);
+    if (prog == NULL) {
+        goto Exit;
+    }
+
+    FlexBuf * body = FlexBuf_New();
+    if (body == NULL) {
+        goto Exit;
+    }
+
+    FlexBuf * funcs = FlexBuf_New();
+    if (funcs == NULL) {
+        goto FreeBody;
+    }
+
+    AotGen gen;
+
+    gen.out = out;
+    gen.body = body;
+    gen.funcs = funcs;
+    gen.func = NULL;
+    gen.ind = 0;
+
+    AstNode ** buf_nodes = AstSeq_Data(prog->ext.block.seq);
+    usize num_nodes = AstSeq_Count(prog->ext.block.seq);
+
+    for (usize i = 0; i < num_nodes; i++) {
+        if (buf_nodes[i]->tag == AstTag_FuncDef &&
+            FlexBuf_PushBuf(funcs, buf_nodes + i, sizeof(AstNode *)) ==
+                false) {
+
+            goto FreeFuncs;
+        }
+    }
+
+    AstNode ** buf_funcs = (AstNode **)FlexBuf_Data(funcs);
+    usize num_funcs = FlexBuf_Size(funcs) / sizeof(AstNode *);
+
+    if (FlexBuf_PushStr(out,
+            "/* Translated from a menos program, do not edit. */\n\n"
+            "#include \"runtime/aot_rt.h\"\n\n") == false ||
+        Aot_EmitGlobals(interp, out) == false) {
+
+        goto FreeFuncs;
+    }
+
+    for (usize i = 0; i < num_funcs; i++) {
+        if (FlexBuf_PushFmt(out,
+            "static\nbool\nf%zu(\n"
+            "    AotCtx * ctx,\n    Value * args,\n    Value * out\n);\n\n",
+            i) == false) {
+
+            goto FreeFuncs;
+        }
+    }
+
+    for (usize i = 0; i < num_funcs; i++) {
+        if (Aot_EmitFunc(&gen, buf_funcs[i],
+            buf_funcs[i]->ext.func_def.body) == false) {
+
+            goto FreeFuncs;
+        }
+    }
+
+    if (Aot_EmitFunc(&gen, NULL, prog) == false ||
+        FlexBuf_PushFmt(out,
+            "const AotProg menos_aot_prog = {\n"
+            "    %zu,\n"
+            "    g_names,\n"
+            "    g,\n"
+            "    Run,\n"
+            "};", Interp_GlobalCount(interp)) == false) {
+
+        goto FreeFuncs;
+    }
+
+    res = true;
+
+FreeFuncs:
+    FlexBuf_Free(funcs);
+
+FreeBody:
+    FlexBuf_Free(body);
+
+Exit:
+    return res;
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#ifndef __ME_RUNTIME_AOT_H__
+#define __ME_RUNTIME_AOT_H__
+
+#include "menos.h"
+#include "util/flex_buf.h"
+#include "interp.h"
+
+bool
+Aot_Translate(
+    Interp * interp,
+    FlexBuf * out
+);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,449 @@
+#include <dlfcn.h>
+#include <string.h>
+
+#include "aot_rt.h"
+#include "config.h"
+#include "ops.h"
+#include "memory/allocate.h"
+
+typedef struct _AotLib {
+    void * handle;
+    const AotProg * prog;
+
+    /* Heap of the program, its globals outlive runs. */
+    Gc * gc;
+
+    /* Context of the active run, `NULL` between runs. */
+    AotCtx * ctx;
+} AotLib;
+
+void
+AotRt_Init(
+    Value * vals,
+    usize num
+) {
+    for (usize i = 0; i < num; i++) {
+        Value_InitNil(vals + i);
+    }
+}
+
+void
+AotRt_Release(
+    Value * vals,
+    usize num
+) {
+    for (usize i = 0; i < num; i++) {
+        Value_Release(vals + i);
+    }
+}
+
+/**
+ * @brief Moves values, leaving the source values as nil.
+ */
+void
+AotRt_Move(
+    Value * dst,
+    Value * src,
+    usize num
+) {
+    for (usize i = 0; i < num; i++) {
+        dst[i] = src[i];
+        Value_InitNil(src + i);
+    }
+}
+
+/**
+ * @brief Releases the value of a variable and moves a new one in.
+ */
+void
+AotRt_Store(
+    Value * dst,
+    Value * src
+) {
+    Value_Release(dst);
+    AotRt_Move(dst, src, 1);
+}
+
+bool
+AotRt_Str(
+    AotCtx * ctx,
+    Value * val,
+    const char * buf,
+    usize len
+) {
+    StrObj * str = StrObj_New(ctx->gc, (const u8 *)buf, len);
+    if (str == NULL) {
+        ctx->err = InterpErr_NoEnoughMemory;
+        return false;
+    }
+
+    Value_InitStr(val, str);
+
+    return true;
+}
+
+/**
+ * @brief Initializes a value from the decimal digits of an integer literal
+ *        that does not fit in `ssize`.
+ */
+bool
+AotRt_BigLit(
+    AotCtx * ctx,
+    Value * val,
+    const char * buf,
+    usize len
+) {
+    BigInt * big = BigInt_NewFromDec((const u8 *)buf, len);
+    if (big == NULL) {
+        ctx->err = InterpErr_NoEnoughMemory;
+        return false;
+    }
+
+    Value_InitBig(val, big);
+
+    return true;
+}
+
+bool
+AotRt_Copy(
+    AotCtx * ctx,
+    Value * dst,
+    Value * src
+) {
+    if (Value_Copy(dst, src) == false) {
+        ctx->err = InterpErr_NoEnoughMemory;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Reads the value of a condition, which must be a boolean.
+ */
+bool
+AotRt_Cond(
+    AotCtx * ctx,
+    Value * val,
+    bool * b
+) {
+    if (val->tag != ValTag_Bool) {
+        ctx->err = InterpErr_TypeMismatch;
+        return false;
+    }
+
+    *b = val->ext.val;
+
+    return true;
+}
+
+bool
+AotRt_Unary(
+    AotCtx * ctx,
+    AstTag tag,
+    Value * val
+) {
+    ctx->err = Ops_Unary(tag, val);
+
+    return ctx->err == InterpErr_Ok;
+}
+
+/**
+ * @brief Applies a binary operator, the result replaces the left operand and
+ *        both operands are released.
+ */
+bool
+AotRt_Binary(
+    AotCtx * ctx,
+    AstTag tag,
+    Value * lhs,
+    Value * rhs
+) {
+    Value res;
+
+    ctx->err = Ops_Binary(ctx->gc, tag, lhs, rhs, &res);
+
+    Value_Release(rhs);
+
+    if (ctx->err != InterpErr_Ok) {
+        return false;
+    }
+
+    AotRt_Store(lhs, &res);
+
+    return true;
+}
+
+bool
+AotRt_StrEquals(
+    Value * val,
+    const char * buf,
+    usize len
+) {
+    return StrObj_Equals(val->ext.str, (const u8 *)buf, len);
+}
+
+/**
+ * @brief Checks a big integer against the decimal digits of a match key.
+ *
+ * @return `true` if they are equal, `false` if not or if memory allocation
+ *         fails.
+ */
+bool
+AotRt_BigEquals(
+    Value * val,
+    const char * buf,
+    usize len
+) {
+    BigInt * key = BigInt_NewFromDec((const u8 *)buf, len);
+    if (key == NULL) {
+        return false;
+    }
+
+    bool res = BigInt_Compare(val->ext.big, key) == 0;
+
+    BigInt_Free(key);
+
+    return res;
+}
+
+/**
+ * @brief Registers the locals and temporaries of a function, which must be
+ *        initialized, as roots of the heap.
+ */
+void
+AotRt_PushFrame(
+    AotCtx * ctx,
+    AotFrame * frame,
+    Value * locals,
+    usize num_locals,
+    Value * temps,
+    usize num_temps
+) {
+    frame->prev = ctx->frames;
+    frame->locals = locals;
+    frame->num_locals = num_locals;
+    frame->temps = temps;
+    frame->num_temps = num_temps;
+
+    ctx->frames = frame;
+}
+
+void
+AotRt_PopFrame(
+    AotCtx * ctx,
+    AotFrame * frame
+) {
+    ctx->frames = frame->prev;
+}
+
+/**
+ * @brief Safepoint, collects the heap if needed.
+ */
+bool
+AotRt_Poll(
+    AotCtx * ctx
+) {
+    if (Gc_Poll(ctx->gc) == false) {
+        ctx->err = InterpErr_NoEnoughMemory;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Accounts for a call, failing at the same depth as the interpreter.
+ *
+ * Function entries are safepoints.
+ */
+bool
+AotRt_Enter(
+    AotCtx * ctx
+) {
+    if (ctx->depth == ME_CALL_STACK_MAX_FRAMES) {
+        ctx->err = InterpErr_StackOverflow;
+        return false;
+    }
+
+    if (AotRt_Poll(ctx) == false) {
+        return false;
+    }
+
+    ctx->depth += 1;
+
+    return true;
+}
+
+void
+AotRt_Leave(
+    AotCtx * ctx
+) {
+    ctx->depth -= 1;
+}
+
+Value *
+AotProg_Global(
+    const AotProg * prog,
+    const char * name
+) {
+    for (usize i = 0; i < prog->num_globals; i++) {
+        if (strcmp(prog->global_names[i], name) == 0) {
+            return prog->globals + i;
+        }
+    }
+
+    return NULL;
+}
+
+void
+AotProg_Reset(
+    const AotProg * prog
+) {
+    AotRt_Release(prog->globals, prog->num_globals);
+}
+
+/**
+ * @brief Visits the globals of a program and the frames of its active run.
+ */
+static
+void
+AotLib_VisitRoots(
+    Gc * gc,
+    void * ctx,
+    GcVisitFn visit
+) {
+    AotLib * lib = (AotLib *)ctx;
+
+    for (usize i = 0; i < lib->prog->num_globals; i++) {
+        Value_Visit(gc, lib->prog->globals + i, visit);
+    }
+
+    if (lib->ctx == NULL) {
+        return;
+    }
+
+    for (AotFrame * frame = lib->ctx->frames;
+         frame != NULL;
+         frame = frame->prev) {
+
+        for (usize i = 0; i < frame->num_locals; i++) {
+            Value_Visit(gc, frame->locals + i, visit);
+        }
+
+        for (usize i = 0; i < frame->num_temps; i++) {
+            Value_Visit(gc, frame->temps + i, visit);
+        }
+    }
+}
+
+/**
+ * @brief Loads a translated program compiled to a shared object.
+ *
+ * The shared object is expected to be built from the output of
+ * `Aot_Translate`, its references to the runtime are resolved against the
+ * loading executable.
+ *
+ * @param path The path of the shared object.
+ *
+ * @return A pointer to the loaded library, or `NULL` if it cannot be loaded
+ *         or has no program.
+ */
+AotLib *
+AotLib_Open(
+    const char * path
+) {
+    void * handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL) {
+        goto Exit;
+    }
+
+    const AotProg * prog = (const AotProg *)dlsym(handle, AOT_PROG_SYMBOL);
+    if (prog == NULL) {
+        goto CloseHandle;
+    }
+
+    Gc * gc = Gc_New(ME_GC_NURSERY_SIZE);
+    if (gc == NULL) {
+        goto CloseHandle;
+    }
+
+    AotLib * lib = (AotLib *)MeMem_Malloc(sizeof(AotLib));
+    if (lib == NULL) {
+        goto FreeGc;
+    }
+
+    lib->handle = handle;
+    lib->prog = prog;
+    lib->gc = gc;
+    lib->ctx = NULL;
+
+    Gc_SetRoots(gc, AotLib_VisitRoots, lib);
+
+    return lib;
+
+FreeGc:
+    Gc_Free(gc);
+
+CloseHandle:
+    dlclose(handle);
+
+Exit:
+    return NULL;
+}
+
+const AotProg *
+AotLib_Prog(
+    AotLib * lib
+) {
+    return lib->prog;
+}
+
+/**
+ * @brief Runs the top-level statements of a translated program.
+ *
+ * Globals keep their values from previous runs, as with `Interp_Run`.
+ *
+ * @param ctx A pointer to the context of the run, initialized here.
+ *
+ * @return `true` on success, `false` with the error in `ctx->err` otherwise.
+ */
+bool
+AotLib_Run(
+    AotLib * lib,
+    AotCtx * ctx
+) {
+    ctx->err = InterpErr_Ok;
+    ctx->depth = 0;
+    ctx->gc = lib->gc;
+    ctx->frames = NULL;
+
+    lib->ctx = ctx;
+
+    bool res = lib->prog->run(ctx);
+
+    lib->ctx = NULL;
+
+    return res;
+}
+
+void
+AotLib_GcStats(
+    AotLib * lib,
+    GcStats * stats
+) {
+    Gc_Stats(lib->gc, stats);
+}
+
+/**
+ * @brief Releases the globals of the program and unloads the library.
+ */
+void
+AotLib_Close(
+    AotLib * lib
+) {
+    AotProg_Reset(lib->prog);
+    dlclose(lib->handle);
+    Gc_Free(lib->gc);
+    MeMem_Free(lib);
+}
\ No newline at end of file
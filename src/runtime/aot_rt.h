@@ -0,0 +1,210 @@
+#ifndef __ME_RUNTIME_AOT_RT_H__
+#define __ME_RUNTIME_AOT_RT_H__
+
+#include "menos.h"
+#include "parser/ast.h"
+#include "interp.h"
+#include "memory/gc.h"
+#include "value.h"
+
+/* The symbol under which a translated unit exports its `AotProg`. */
+#define AOT_PROG_SYMBOL "menos_aot_prog"
+
+/* Values of an active translated function, registered for the collector. */
+typedef struct _AotFrame {
+    struct _AotFrame * prev;
+
+    Value * locals;
+    usize num_locals;
+
+    Value * temps;
+    usize num_temps;
+} AotFrame;
+
+/* Execution context of a translated program. */
+typedef struct _AotCtx {
+
+    /* The error of the last failed run. */
+    InterpErr err;
+
+    /* The number of active calls. */
+    usize depth;
+
+    /* Heap of the strings. */
+    Gc * gc;
+
+    /* Innermost active frame. */
+    AotFrame * frames;
+} AotCtx;
+
+/* Translated program, as exported by the generated unit. */
+typedef struct _AotProg {
+    usize num_globals;
+
+    /* Global names, indexed by slot. */
+    const char * const * global_names;
+
+    /* Global values, owned by the generated unit. */
+    Value * globals;
+
+    /* Runs the top-level statements. */
+    bool (* run)(AotCtx * ctx);
+} AotProg;
+
+/* Shared object holding a translated program. */
+typedef struct _AotLib AotLib;
+
+void
+AotRt_Init(
+    Value * vals,
+    usize num
+);
+
+void
+AotRt_Release(
+    Value * vals,
+    usize num
+);
+
+void
+AotRt_Move(
+    Value * dst,
+    Value * src,
+    usize num
+);
+
+void
+AotRt_Store(
+    Value * dst,
+    Value * src
+);
+
+bool
+AotRt_Str(
+    AotCtx * ctx,
+    Value * val,
+    const char * buf,
+    usize len
+);
+
+bool
+AotRt_BigLit(
+    AotCtx * ctx,
+    Value * val,
+    const char * buf,
+    usize len
+);
+
+bool
+AotRt_Copy(
+    AotCtx * ctx,
+    Value * dst,
+    Value * src
+);
+
+bool
+AotRt_Cond(
+    AotCtx * ctx,
+    Value * val,
+    bool * b
+);
+
+bool
+AotRt_Unary(
+    AotCtx * ctx,
+    AstTag tag,
+    Value * val
+);
+
+bool
+AotRt_Binary(
+    AotCtx * ctx,
+    AstTag tag,
+    Value * lhs,
+    Value * rhs
+);
+
+bool
+AotRt_StrEquals(
+    Value * val,
+    const char * buf,
+    usize len
+);
+
+bool
+AotRt_BigEquals(
+    Value * val,
+    const char * buf,
+    usize len
+);
+
+void
+AotRt_PushFrame(
+    AotCtx * ctx,
+    AotFrame * frame,
+    Value * locals,
+    usize num_locals,
+    Value * temps,
+    usize num_temps
+);
+
+void
+AotRt_PopFrame(
+    AotCtx * ctx,
+    AotFrame * frame
+);
+
+bool
+AotRt_Poll(
+    AotCtx * ctx
+);
+
+bool
+AotRt_Enter(
+    AotCtx * ctx
+);
+
+void
+AotRt_Leave(
+    AotCtx * ctx
+);
+
+Value *
+AotProg_Global(
+    const AotProg * prog,
+    const char * name
+);
+
+void
+AotProg_Reset(
+    const AotProg * prog
+);
+
+AotLib *
+AotLib_Open(
+    const char * path
+);
+
+const AotProg *
+AotLib_Prog(
+    AotLib * lib
+);
+
+bool
+AotLib_Run(
+    AotLib * lib,
+    AotCtx * ctx
+);
+
+void
+AotLib_GcStats(
+    AotLib * lib,
+    GcStats * stats
+);
+
+void
+AotLib_Close(
+    AotLib * lib
+);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include <stdatomic.h>
+#include <string.h>
+
+#include "frame.h"
+#include "memory/allocate.h"
+
+typedef struct _CallStack {
+
+    /* Slot area shared by all frames. */
+    struct {
+        Value * buf;
+        usize cap;
+        usize top;
+    } slot;
+
+    /* Frame area. */
+    struct {
+        Frame * buf;
+        usize cap;
+        usize top;
+    } frame;
+} CallStack;
+
+CallStack *
+CallStack_New(
+    usize max_slots,
+    usize max_frames
+) {
+    Value * slots = (Value *)MeMem_Malloc(sizeof(Value) * max_slots);
+    if (slots == NULL) {
+        goto Exit;
+    }
+
+    Frame * frames = (Frame *)MeMem_Malloc(sizeof(Frame) * max_frames);
+    if (frames == NULL) {
+        goto FreeSlots;
+    }
+
+    CallStack * stack = (CallStack *)MeMem_Malloc(sizeof(CallStack));
+    if (stack == NULL) {
+        goto FreeFrames;
+    }
+
+    stack->slot.buf = slots;
+    stack->slot.cap = max_slots;
+    stack->slot.top = 0;
+
+    stack->frame.buf = frames;
+    stack->frame.cap = max_frames;
+    stack->frame.top = 0;
+
+    return stack;
+
+FreeFrames:
+    MeMem_Free(frames);
+
+FreeSlots:
+    MeMem_Free(slots);
+
+Exit:
+    return NULL;
+}
+
+/**
+ * @brief Reserves nil-initialized slots on top of the call stack.
+ *
+ * Arguments of a call are evaluated straight into the reserved slots, which
+ * then become the first slots of the callee frame, so calls never allocate.
+ *
+ * @param stack A pointer to the call stack.
+ * @param num The number of slots to reserve.
+ * @param slots A pointer to receive the first reserved slot.
+ *
+ * @return `true` on success, `false` if the slot area is exhausted.
+ */
+bool
+CallStack_Reserve(
+    CallStack * stack,
+    usize num,
+    Value ** slots
+) {
+    if (num > stack->slot.cap - stack->slot.top) {
+        return false;
+    }
+
+    Value * buf = stack->slot.buf + stack->slot.top;
+    for (usize i = 0; i < num; i++) {
+        Value_InitNil(buf + i);
+    }
+
+    stack->slot.top += num;
+    *slots = buf;
+
+    return true;
+}
+
+/**
+ * @brief Releases the slots from `slots` up to the top of the call stack.
+ */
+void
+CallStack_Release(
+    CallStack * stack,
+    Value * slots
+) {
+    Value * end = stack->slot.buf + stack->slot.top;
+
+    for (Value * val = slots; val != end; val++) {
+        Value_Release(val);
+    }
+
+    stack->slot.top = (usize)(slots - stack->slot.buf);
+}
+
+/**
+ * @brief Pushes a frame whose slots have already been reserved.
+ *
+ * @return A pointer to the new frame, or `NULL` if the maximum depth is
+ *         reached.
+ */
+Frame *
+CallStack_Push(
+    CallStack * stack,
+    AstNode * func,
+    Value * slots
+) {
+    if (stack->frame.top == stack->frame.cap) {
+        return NULL;
+    }
+
+    Frame * frame = stack->frame.buf + stack->frame.top;
+    frame->func = func;
+    frame->slots = slots;
+    frame->stmt = NULL;
+
+    /* The profiler walks the frames from a signal handler, which must not
+       see the new frame before it is filled in. */
+    atomic_signal_fence(memory_order_release);
+
+    stack->frame.top += 1;
+
+    return frame;
+}
+
+/**
+ * @brief Pops the top frame and releases its slots.
+ */
+void
+CallStack_Pop(
+    CallStack * stack
+) {
+    stack->frame.top -= 1;
+    CallStack_Release(stack, stack->frame.buf[stack->frame.top].slots);
+}
+
+Frame *
+CallStack_Top(
+    CallStack * stack
+) {
+    if (stack->frame.top == 0) {
+        return NULL;
+    }
+
+    return stack->frame.buf + stack->frame.top - 1;
+}
+
+/**
+ * @brief Turns the top frame into a frame of another function.
+ *
+ * The slots of the current frame are released and the arguments, which have
+ * been evaluated into slots reserved right above it, are moved down to the
+ * frame base. The frame depth does not change.
+ *
+ * @param stack A pointer to the call stack.
+ * @param func A pointer to the callee definition.
+ * @param args A pointer to the reserved slots holding the arguments, they
+ *             must extend to the top of the slot area.
+ */
+void
+CallStack_TailCall(
+    CallStack * stack,
+    AstNode * func,
+    Value * args
+) {
+    Frame * frame = stack->frame.buf + stack->frame.top - 1;
+    Value * end = stack->slot.buf + stack->slot.top;
+    usize num = (usize)(end - args);
+
+    for (Value * val = frame->slots; val != args; val++) {
+        Value_Release(val);
+    }
+
+    memmove(frame->slots, args, sizeof(Value) * num);
+
+    stack->slot.top = (usize)(frame->slots - stack->slot.buf) + num;
+    frame->func = func;
+    frame->stmt = NULL;
+}
+
+/**
+ * @brief Visits the heap references of every slot in use, including the
+ *        slots reserved for arguments being evaluated.
+ */
+void
+CallStack_Visit(
+    CallStack * stack,
+    Gc * gc,
+    GcVisitFn visit
+) {
+    for (usize i = 0; i < stack->slot.top; i++) {
+        Value_Visit(gc, stack->slot.buf + i, visit);
+    }
+}
+
+/**
+ * @brief Returns the frame at a depth, the bottom one being at `0`.
+ */
+Frame *
+CallStack_At(
+    CallStack * stack,
+    usize idx
+) {
+    return stack->frame.buf + idx;
+}
+
+usize
+CallStack_Depth(
+    CallStack * stack
+) {
+    return stack->frame.top;
+}
+
+void
+CallStack_Clear(
+    CallStack * stack
+) {
+    CallStack_Release(stack, stack->slot.buf);
+    stack->frame.top = 0;
+}
+
+void
+CallStack_Free(
+    CallStack * stack
+) {
+    CallStack_Clear(stack);
+    MeMem_Free(stack->frame.buf);
+    MeMem_Free(stack->slot.buf);
+    MeMem_Free(stack);
+}
\ No newline at end of file
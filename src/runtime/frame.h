@@ -0,0 +1,95 @@
+#ifndef __ME_RUNTIME_FRAME_H__
+#define __ME_RUNTIME_FRAME_H__
+
+#include "menos.h"
+#include "parser/ast.h"
+#include "value.h"
+
+/* Call frame. */
+typedef struct _Frame {
+
+    /* Function definition being executed. */
+    AstNode * func;
+
+    /* The first slot of the frame, parameters come first. */
+    Value * slots;
+
+    /* Statement being executed, `NULL` until the first one starts. */
+    AstNode * stmt;
+} Frame;
+
+/* Call stack, frames and their slots live in two preallocated arrays. */
+typedef struct _CallStack CallStack;
+
+CallStack *
+CallStack_New(
+    usize max_slots,
+    usize max_frames
+);
+
+bool
+CallStack_Reserve(
+    CallStack * stack,
+    usize num,
+    Value ** slots
+);
+
+void
+CallStack_Release(
+    CallStack * stack,
+    Value * slots
+);
+
+Frame *
+CallStack_Push(
+    CallStack * stack,
+    AstNode * func,
+    Value * slots
+);
+
+void
+CallStack_Pop(
+    CallStack * stack
+);
+
+Frame *
+CallStack_Top(
+    CallStack * stack
+);
+
+void
+CallStack_TailCall(
+    CallStack * stack,
+    AstNode * func,
+    Value * args
+);
+
+void
+CallStack_Visit(
+    CallStack * stack,
+    Gc * gc,
+    GcVisitFn visit
+);
+
+Frame *
+CallStack_At(
+    CallStack * stack,
+    usize idx
+);
+
+usize
+CallStack_Depth(
+    CallStack * stack
+);
+
+void
+CallStack_Clear(
+    CallStack * stack
+);
+
+void
+CallStack_Free(
+    CallStack * stack
+);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,2198 @@
+#include <string.h>
+
+#include "interp.h"
+#include "config.h"
+#include "frame.h"
+#include "jit.h"
+#include "ops.h"
+#include "memory/allocate.h"
+#include "parser/match_tab.h"
+#include "util/metrics.h"
+#include "util/trace.h"
+
+const char *
+InterpErr_ToStr(
+    InterpErr err
+) {
+    switch (err) {
+    case InterpErr_Ok: return "Ok";
+    case InterpErr_NoEnoughMemory: return "No enough memory";
+    case InterpErr_UndefinedVariable: return "Undefined variable";
+    case InterpErr_UndefinedFunction: return "Undefined function";
+    case InterpErr_DuplicateFunction: return "Duplicate function";
+    case InterpErr_DuplicateParameter: return "Duplicate parameter";
+    case InterpErr_ArityMismatch: return "Arity mismatch";
+    case InterpErr_ReturnOutsideFunction: return "Return outside function";
+    case InterpErr_TypeMismatch: return "Type mismatch";
+    case InterpErr_DivisionByZero: return "Division by zero";
+    case InterpErr_StackOverflow: return "Stack overflow";
+    }
+}
+
+/* Statement execution result. */
+typedef enum _ExecRes {
+    ExecRes_Normal,
+    ExecRes_Return,
+    ExecRes_TailCall,
+    ExecRes_Error,
+} ExecRes;
+
+/* Root expression index of the expressions the JIT leaves alone. */
+#define NO_CHUNK ((usize)-1)
+
+/* Compilation state of a root expression. */
+typedef enum _ChunkStat {
+    ChunkStat_Cold,         /* Interpreted and counted. */
+    ChunkStat_Compiled,     /* Compiled, bailouts are counted. */
+    ChunkStat_Rejected,     /* Interpreted for good. */
+} ChunkStat;
+
+/* Hotness counter and compiled code of a root expression. */
+typedef struct _JitChunk {
+    ChunkStat stat;
+    u32 hits;
+    JitFn fn;
+} JitChunk;
+
+typedef struct _InterpProg {
+
+    /* Resolved tree, borrowed. */
+    AstNode * tree;
+
+    /* Names of the global variables borrowed from the tree, indexed by
+       slot. */
+    FlexBuf * glob_names;
+
+    /* Function definitions, borrowed from the tree. */
+    FlexBuf * funcs;
+
+    /* The number of root expressions numbered for the JIT. */
+    usize num_chunks;
+
+    struct {
+        InterpErr type;
+        FlexBuf * msg;
+    } err;
+} InterpProg;
+
+typedef struct _Interp {
+
+    /* Loaded program, borrowed unless it is `own_prog`. */
+    const InterpProg * prog;
+
+    /* Program compiled by `Interp_Load` for this interpreter alone. */
+    InterpProg * own_prog;
+
+    /* Global variables, named by the program. */
+    struct {
+        usize num;
+        Value * vals;
+    } glob;
+
+    CallStack * stack;
+
+    /* Heap of the strings, also holding the global table. */
+    Gc * gc;
+
+    /* Current frame, `NULL` at the top level. */
+    Frame * frame;
+
+    /* Statement being executed at the top level, `NULL` outside of
+       `Interp_Run`. */
+    AstNode * stmt;
+
+    /* Return value of the last finished call. */
+    Value ret;
+
+    /* Template JIT. */
+    struct {
+        bool enabled;
+        Jit * jit;
+
+        /* Indexed by the `bin_op.chunk` of root expressions. */
+        JitChunk * chunks;
+        usize num_chunks;
+        usize num_compiled;
+    } jit;
+
+    struct {
+        InterpErr type;
+        FlexBuf * msg;
+    } err;
+
+    /* Allocator of the memory taken while loading and running. */
+    const MemAllocator * alloc;
+
+    /* Metrics filled in while loading and running, may be `NULL`. */
+    Metrics * metrics;
+} Interp;
+
+/**
+ * @brief Visits the references held by the interpreter, which are the
+ *        global table, the call stack and the last returned value.
+ */
+static
+void
+Interp_VisitRoots(
+    Gc * gc,
+    void * ctx,
+    GcVisitFn visit
+) {
+    Interp * interp = (Interp *)ctx;
+
+    if (interp->glob.vals != NULL) {
+        visit(gc, (void **)&interp->glob.vals);
+    }
+
+    CallStack_Visit(interp->stack, gc, visit);
+    Value_Visit(gc, &interp->ret, visit);
+}
+
+Interp *
+Interp_New(void) {
+    MemTag prev_tag = MeMem_SetTag(MemTag_Runtime);
+    Interp * interp = NULL;
+
+    CallStack * stack = CallStack_New(
+        ME_CALL_STACK_MAX_SLOTS, ME_CALL_STACK_MAX_FRAMES);
+    if (stack == NULL) {
+        goto Exit;
+    }
+
+    Gc * gc = Gc_New(ME_GC_NURSERY_SIZE);
+    if (gc == NULL) {
+        goto FreeStack;
+    }
+
+    Jit * jit = Jit_New();
+    if (jit == NULL) {
+        goto FreeGc;
+    }
+
+    MeMem_SetTag(MemTag_ErrMsg);
+    FlexBuf * err_msg = FlexBuf_New();
+    MeMem_SetTag(MemTag_Runtime);
+
+    if (err_msg == NULL) {
+        goto FreeJit;
+    }
+
+    interp = (Interp *)MeMem_Malloc(sizeof(Interp));
+    if (interp == NULL) {
+        goto FreeErrMsg;
+    }
+
+    interp->prog = NULL;
+    interp->own_prog = NULL;
+
+    interp->glob.num = 0;
+    interp->glob.vals = NULL;
+
+    interp->stack = stack;
+    interp->gc = gc;
+    interp->frame = NULL;
+    interp->stmt = NULL;
+    Value_InitNil(&interp->ret);
+
+    interp->jit.enabled = ME_JIT_ENABLED;
+    interp->jit.jit = jit;
+    interp->jit.chunks = NULL;
+    interp->jit.num_chunks = 0;
+    interp->jit.num_compiled = 0;
+
+    interp->err.type = InterpErr_Ok;
+    interp->err.msg = err_msg;
+
+    interp->alloc = MeMem_Current();
+    interp->metrics = NULL;
+
+    Gc_SetRoots(gc, Interp_VisitRoots, interp);
+
+    goto Exit;
+
+FreeErrMsg:
+    FlexBuf_Free(err_msg);
+
+FreeJit:
+    Jit_Free(jit);
+
+FreeGc:
+    Gc_Free(gc);
+
+FreeStack:
+    CallStack_Free(stack);
+
+Exit:
+    MeMem_SetTag(prev_tag);
+
+    return interp;
+}
+
+static
+void
+InterpErr_PushMsg(
+    FlexBuf * msg,
+    InterpErr err,
+    FixedBuf * name
+) {
+    const char * PREFIX = "Interpreter error";
+
+    if (name == NULL) {
+        FlexBuf_PushFmt(msg, "%s: %s",
+            PREFIX, InterpErr_ToStr(err));
+    } else {
+        FlexBuf_PushFmt(msg, "%s: %s '%.*s'",
+            PREFIX, InterpErr_ToStr(err),
+            (int)FixedBuf_Size(name), (char *)FixedBuf_Data(name));
+    }
+}
+
+static
+void
+Interp_SetError(
+    Interp * interp,
+    InterpErr err,
+    FixedBuf * name
+) {
+    interp->err.type = err;
+    InterpErr_PushMsg(interp->err.msg, err, name);
+}
+
+static
+bool
+NameEquals(
+    FixedBuf * name_1,
+    FixedBuf * name_2
+) {
+    usize len = FixedBuf_Size(name_1);
+
+    return len == FixedBuf_Size(name_2) &&
+        memcmp(FixedBuf_Data(name_1), FixedBuf_Data(name_2), len) == 0;
+}
+
+/**
+ * @brief Looks up a name in a FlexBuf of borrowed FixedBuf pointers.
+ */
+static
+bool
+NameList_Find(
+    FlexBuf * list,
+    FixedBuf * name,
+    usize * idx
+) {
+    FixedBuf ** buf_names = (FixedBuf **)FlexBuf_Data(list);
+    usize num_names = FlexBuf_Size(list) / sizeof(FixedBuf *);
+
+    for (usize i = 0; i < num_names; i++) {
+        if (NameEquals(buf_names[i], name)) {
+            *idx = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static
+bool
+NameList_Add(
+    FlexBuf * list,
+    FixedBuf * name
+) {
+    usize idx;
+
+    if (NameList_Find(list, name, &idx)) {
+        return true;
+    }
+
+    return FlexBuf_PushBuf(list, &name, sizeof(FixedBuf *));
+}
+
+/**
+ * @brief Creates an empty program, see `InterpProg_Compile`.
+ *
+ * @return A pointer to the program, or `NULL` if memory allocation fails.
+ */
+InterpProg *
+InterpProg_New(void) {
+    MemTag prev_tag = MeMem_SetTag(MemTag_Runtime);
+    InterpProg * prog = NULL;
+
+    FlexBuf * glob_names = FlexBuf_New();
+    if (glob_names == NULL) {
+        goto Exit;
+    }
+
+    FlexBuf * funcs = FlexBuf_New();
+    if (funcs == NULL) {
+        goto FreeGlobNames;
+    }
+
+    MeMem_SetTag(MemTag_ErrMsg);
+    FlexBuf * err_msg = FlexBuf_New();
+    MeMem_SetTag(MemTag_Runtime);
+
+    if (err_msg == NULL) {
+        goto FreeFuncs;
+    }
+
+    prog = (InterpProg *)MeMem_Malloc(sizeof(InterpProg));
+    if (prog == NULL) {
+        goto FreeErrMsg;
+    }
+
+    prog->tree = NULL;
+    prog->glob_names = glob_names;
+    prog->funcs = funcs;
+    prog->num_chunks = 0;
+
+    prog->err.type = InterpErr_Ok;
+    prog->err.msg = err_msg;
+
+    goto Exit;
+
+FreeErrMsg:
+    FlexBuf_Free(err_msg);
+
+FreeFuncs:
+    FlexBuf_Free(funcs);
+
+FreeGlobNames:
+    FlexBuf_Free(glob_names);
+
+Exit:
+    MeMem_SetTag(prev_tag);
+
+    return prog;
+}
+
+static
+void
+InterpProg_SetError(
+    InterpProg * prog,
+    InterpErr err,
+    FixedBuf * name
+) {
+    prog->err.type = err;
+    InterpErr_PushMsg(prog->err.msg, err, name);
+}
+
+static
+AstNode *
+InterpProg_FindFunc(
+    InterpProg * prog,
+    FixedBuf * name
+) {
+    AstNode ** buf_funcs = (AstNode **)FlexBuf_Data(prog->funcs);
+    usize num_funcs = FlexBuf_Size(prog->funcs) / sizeof(AstNode *);
+
+    for (usize i = 0; i < num_funcs; i++) {
+        if (NameEquals(buf_funcs[i]->ext.func_def.name, name)) {
+            return buf_funcs[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Collects the names assigned by a statement into a name list.
+ */
+static
+bool
+InterpProg_CollectAssigned(
+    InterpProg * prog,
+    AstNode * node,
+    FlexBuf * names
+) {
+    switch (node->tag) {
+    case AstTag_AsgnStmt:
+        if (NameList_Add(names,
+            node->ext.asgn_stmt.lhs->ext.var.str) == false) {
+
+            InterpProg_SetError(prog, InterpErr_NoEnoughMemory, NULL);
+            return false;
+        }
+
+        return true;
+
+    case AstTag_IfStmt:
+        return InterpProg_CollectAssigned(prog,
+            node->ext.if_stmt.then_br, names);
+
+    case AstTag_IfElseStmt:
+        return InterpProg_CollectAssigned(prog,
+                node->ext.if_else_stmt.then_br, names) &&
+            InterpProg_CollectAssigned(prog,
+                node->ext.if_else_stmt.else_br, names);
+
+    case AstTag_MatchStmt: {
+        AstNode ** buf_arms = AstSeq_Data(node->ext.match_stmt.arms);
+        usize num_arms = AstSeq_Count(node->ext.match_stmt.arms);
+        for (usize i = 0; i < num_arms; i++) {
+            if (InterpProg_CollectAssigned(prog,
+                buf_arms[i]->ext.match_arm.body, names) == false) {
+
+                return false;
+            }
+        }
+
+        if (node->ext.match_stmt.else_br != NULL) {
+            return InterpProg_CollectAssigned(prog,
+                node->ext.match_stmt.else_br, names);
+        }
+
+        return true;
+    }
+
+    case AstTag_BlockStmt: {
+        AstNode ** buf_nodes = AstSeq_Data(node->ext.block.seq);
+        usize num_nodes = AstSeq_Count(node->ext.block.seq);
+        for (usize i = 0; i < num_nodes; i++) {
+            if (InterpProg_CollectAssigned(prog,
+                buf_nodes[i], names) == false) {
+
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    default:
+        return true;
+    }
+}
+
+static
+bool
+InterpProg_ResolveSeq(
+    InterpProg * prog,
+    AstSeq * seq,
+    FlexBuf * locals
+);
+
+static
+bool
+InterpProg_ResolveRoot(
+    InterpProg * prog,
+    AstNode * node,
+    FlexBuf * locals
+);
+
+/**
+ * @brief Binds variables to slots and calls to function definitions.
+ *
+ * @param prog A pointer to the program.
+ * @param node A pointer to the node to be resolved.
+ * @param locals A pointer to the frame slot names of the enclosing function,
+ *               or `NULL` at the top level.
+ */
+static
+bool
+InterpProg_ResolveNode(
+    InterpProg * prog,
+    AstNode * node,
+    FlexBuf * locals
+) {
+    switch (node->tag) {
+    case AstTag_StrLit:
+    case AstTag_NumLit:
+    case AstTag_BoolLit:
+        return true;
+
+    case AstTag_Var: {
+        usize slot;
+
+        if (locals != NULL &&
+            NameList_Find(locals, node->ext.var.str, &slot)) {
+
+            node->ext.var.local = true;
+            node->ext.var.slot = slot;
+        } else if (NameList_Find(prog->glob_names,
+            node->ext.var.str, &slot)) {
+
+            node->ext.var.local = false;
+            node->ext.var.slot = slot;
+        } else {
+            InterpProg_SetError(prog,
+                InterpErr_UndefinedVariable, node->ext.var.str);
+            return false;
+        }
+
+        return true;
+    }
+
+    case AstTag_Call: {
+        AstNode * func = InterpProg_FindFunc(prog, node->ext.call.name);
+        if (func == NULL) {
+            InterpProg_SetError(prog,
+                InterpErr_UndefinedFunction, node->ext.call.name);
+            return false;
+        }
+
+        if (AstSeq_Count(node->ext.call.args) !=
+            AstSeq_Count(func->ext.func_def.params)) {
+
+            InterpProg_SetError(prog,
+                InterpErr_ArityMismatch, node->ext.call.name);
+            return false;
+        }
+
+        node->ext.call.func = func;
+
+        AstNode ** buf_args = AstSeq_Data(node->ext.call.args);
+        usize num_args = AstSeq_Count(node->ext.call.args);
+
+        for (usize i = 0; i < num_args; i++) {
+            if (InterpProg_ResolveRoot(prog, buf_args[i], locals) == false) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    case AstTag_LogNotOp:
+
+    case AstTag_UnaPlusOp:
+    case AstTag_UnaMinusOp:
+        return InterpProg_ResolveNode(prog, node->ext.una_op.opd, locals);
+
+    case AstTag_LogOrOp:
+    case AstTag_LogAndOp:
+
+    case AstTag_RelEquOp:
+    case AstTag_RelNeqOp:
+    case AstTag_RelLtOp:
+    case AstTag_RelLteOp:
+    case AstTag_RelGtOp:
+    case AstTag_RelGteOp:
+
+    case AstTag_BinAddOp:
+    case AstTag_BinSubOp:
+    case AstTag_BinMulOp:
+    case AstTag_BinDivOp:
+    case AstTag_BinModOp:
+    case AstTag_BinExpOp:
+        node->ext.bin_op.chunk = NO_CHUNK;
+
+        return InterpProg_ResolveNode(prog, node->ext.bin_op.lhs, locals) &&
+            InterpProg_ResolveNode(prog, node->ext.bin_op.rhs, locals);
+
+    case AstTag_AsgnStmt:
+        return InterpProg_ResolveNode(prog, node->ext.asgn_stmt.lhs, locals) &&
+            InterpProg_ResolveRoot(prog, node->ext.asgn_stmt.rhs, locals);
+
+    case AstTag_IfStmt:
+        return InterpProg_ResolveRoot(prog, node->ext.if_stmt.cond, locals) &&
+            InterpProg_ResolveNode(prog, node->ext.if_stmt.then_br, locals);
+
+    case AstTag_IfElseStmt:
+        return InterpProg_ResolveRoot(prog,
+                node->ext.if_else_stmt.cond, locals) &&
+            InterpProg_ResolveNode(prog,
+                node->ext.if_else_stmt.then_br, locals) &&
+            InterpProg_ResolveNode(prog,
+                node->ext.if_else_stmt.else_br, locals);
+
+    case AstTag_MatchArm:
+        return InterpProg_ResolveNode(prog, node->ext.match_arm.body, locals);
+
+    case AstTag_MatchStmt:
+        if (InterpProg_ResolveRoot(prog,
+                node->ext.match_stmt.subj, locals) == false ||
+            InterpProg_ResolveSeq(prog,
+                node->ext.match_stmt.arms, locals) == false) {
+
+            return false;
+        }
+
+        if (node->ext.match_stmt.else_br != NULL) {
+            return InterpProg_ResolveNode(prog,
+                node->ext.match_stmt.else_br, locals);
+        }
+
+        return true;
+
+    case AstTag_BlockStmt:
+        return InterpProg_ResolveSeq(prog, node->ext.block.seq, locals);
+
+    case AstTag_ExprStmt:
+        return InterpProg_ResolveNode(prog, node->ext.expr_stmt.expr, locals);
+
+    case AstTag_RetStmt: {
+        AstNode * val = node->ext.ret_stmt.val;
+
+        if (locals == NULL) {
+            InterpProg_SetError(prog, InterpErr_ReturnOutsideFunction, NULL);
+            return false;
+        }
+
+        if (val == NULL) {
+            return true;
+        }
+
+        /* The frame of the caller is not needed after a returned call. */
+        if (val->tag == AstTag_Call) {
+            val->ext.call.tail = true;
+        }
+
+        return InterpProg_ResolveRoot(prog, val, locals);
+    }
+
+    case AstTag_FuncDef:
+    case AstTag_Prog:
+        return true;
+    }
+
+    return true;
+}
+
+static
+bool
+InterpProg_ResolveSeq(
+    InterpProg * prog,
+    AstSeq * seq,
+    FlexBuf * locals
+) {
+    AstNode ** buf_nodes = AstSeq_Data(seq);
+    usize num_nodes = AstSeq_Count(seq);
+
+    for (usize i = 0; i < num_nodes; i++) {
+        if (InterpProg_ResolveNode(prog, buf_nodes[i], locals) == false) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Checks whether a node is a binary operator, the only kind of root
+ *        expression worth compiling.
+ */
+static
+inline
+bool
+IsBinOp(
+    AstTag tag
+) {
+    switch (tag) {
+    case AstTag_LogOrOp:
+    case AstTag_LogAndOp:
+
+    case AstTag_RelEquOp:
+    case AstTag_RelNeqOp:
+    case AstTag_RelLtOp:
+    case AstTag_RelLteOp:
+    case AstTag_RelGtOp:
+    case AstTag_RelGteOp:
+
+    case AstTag_BinAddOp:
+    case AstTag_BinSubOp:
+    case AstTag_BinMulOp:
+    case AstTag_BinDivOp:
+    case AstTag_BinModOp:
+    case AstTag_BinExpOp:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Resolves an expression evaluated directly by a statement or a call,
+ *        and numbers it for the JIT if it can be compiled.
+ */
+static
+bool
+InterpProg_ResolveRoot(
+    InterpProg * prog,
+    AstNode * node,
+    FlexBuf * locals
+) {
+    if (InterpProg_ResolveNode(prog, node, locals) == false) {
+        return false;
+    }
+
+    if (IsBinOp(node->tag) &&
+        Jit_Compilable(node)) {
+
+        node->ext.bin_op.chunk = prog->num_chunks;
+        prog->num_chunks += 1;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Lays out the frame of a function, parameters first and then the
+ *        variables assigned in its body.
+ */
+static
+bool
+InterpProg_ResolveFunc(
+    InterpProg * prog,
+    AstNode * func
+) {
+    bool res = false;
+
+    FlexBuf * locals = FlexBuf_New();
+    if (locals == NULL) {
+        InterpProg_SetError(prog, InterpErr_NoEnoughMemory, NULL);
+        goto Exit;
+    }
+
+    AstNode ** buf_params = AstSeq_Data(func->ext.func_def.params);
+    usize num_params = AstSeq_Count(func->ext.func_def.params);
+
+    for (usize i = 0; i < num_params; i++) {
+        FixedBuf * name = buf_params[i]->ext.var.str;
+        usize idx;
+
+        if (NameList_Find(locals, name, &idx)) {
+            InterpProg_SetError(prog, InterpErr_DuplicateParameter, name);
+            goto FreeLocals;
+        }
+
+        if (NameList_Add(locals, name) == false) {
+            InterpProg_SetError(prog, InterpErr_NoEnoughMemory, NULL);
+            goto FreeLocals;
+        }
+    }
+
+    if (InterpProg_CollectAssigned(prog,
+            func->ext.func_def.body, locals) == false ||
+        InterpProg_ResolveSeq(prog,
+            func->ext.func_def.params, locals) == false ||
+        InterpProg_ResolveNode(prog,
+            func->ext.func_def.body, locals) == false) {
+
+        goto FreeLocals;
+    }
+
+    func->ext.func_def.num_slots = FlexBuf_Size(locals) / sizeof(FixedBuf *);
+
+    res = true;
+
+FreeLocals:
+    FlexBuf_Free(locals);
+
+Exit:
+    return res;
+}
+
+/**
+ * @brief Resolves a program so that interpreters can run it.
+ *
+ * Every variable is bound to a global slot or to a slot of the frame of the
+ * enclosing function, and every call is bound to its function definition.
+ * Root expressions that the JIT can compile are numbered.
+ * The tree is annotated in place and must outlive the program. It is only
+ * read afterwards, so interpreters on any thread may run the program at
+ * once, see `Interp_LoadProg`.
+ *
+ * @param prog A pointer to the program, compiled at most once.
+ * @param tree A pointer to the program node.
+ *
+ * @return `true` on success, `false` if the program cannot be resolved.
+ */
+bool
+InterpProg_Compile(
+    InterpProg * prog,
+    AstNode * tree
+) {
+    if (prog->tree != NULL) {
+        return false;
+    }
+
+    MemTag prev_tag = MeMem_SetTag(MemTag_Runtime);
+    bool res = false;
+
+    AstNode ** buf_nodes = AstSeq_Data(tree->ext.block.seq);
+    usize num_nodes = AstSeq_Count(tree->ext.block.seq);
+
+    /* Collect functions and global variables first, so that they can be
+       referred to before their definitions. */
+    for (usize i = 0; i < num_nodes; i++) {
+        AstNode * node = buf_nodes[i];
+
+        if (node->tag != AstTag_FuncDef) {
+            if (InterpProg_CollectAssigned(prog,
+                node, prog->glob_names) == false) {
+
+                goto Exit;
+            }
+
+            continue;
+        }
+
+        if (InterpProg_FindFunc(prog, node->ext.func_def.name) != NULL) {
+            InterpProg_SetError(prog,
+                InterpErr_DuplicateFunction, node->ext.func_def.name);
+            goto Exit;
+        }
+
+        if (FlexBuf_PushBuf(prog->funcs, &node, sizeof(AstNode *)) == false) {
+            InterpProg_SetError(prog, InterpErr_NoEnoughMemory, NULL);
+            goto Exit;
+        }
+    }
+
+    for (usize i = 0; i < num_nodes; i++) {
+        AstNode * node = buf_nodes[i];
+
+        if (node->tag == AstTag_FuncDef) {
+            if (InterpProg_ResolveFunc(prog, node) == false) {
+                goto Exit;
+            }
+        } else {
+            if (InterpProg_ResolveNode(prog, node, NULL) == false) {
+                goto Exit;
+            }
+        }
+    }
+
+    prog->tree = tree;
+    res = true;
+
+Exit:
+    MeMem_SetTag(prev_tag);
+
+    return res;
+}
+
+InterpErr
+InterpProg_ErrorType(
+    InterpProg * prog
+) {
+    return prog->err.type;
+}
+
+FlexBuf *
+InterpProg_ErrorMessage(
+    InterpProg * prog
+) {
+    return prog->err.msg;
+}
+
+void
+InterpProg_Free(
+    InterpProg * prog
+) {
+    FlexBuf_Free(prog->err.msg);
+    FlexBuf_Free(prog->funcs);
+    FlexBuf_Free(prog->glob_names);
+    MeMem_Free(prog);
+}
+
+/**
+ * @brief Sets up the globals and the JIT state of a compiled program, in
+ *        the heap of the interpreter.
+ */
+static
+bool
+Interp_Instantiate(
+    Interp * interp,
+    const InterpProg * prog
+) {
+    usize num_globs = FlexBuf_Size(prog->glob_names) / sizeof(FixedBuf *);
+
+    if (num_globs != 0) {
+
+        /* The table never moves, stores of strings into it go through the
+           write barrier instead. */
+        Value * vals = (Value *)Gc_AllocOld(interp->gc,
+            &value_array_type, sizeof(Value) * num_globs);
+        if (vals == NULL) {
+            Interp_SetError(interp, InterpErr_NoEnoughMemory, NULL);
+            return false;
+        }
+
+        for (usize i = 0; i < num_globs; i++) {
+            Value_InitNil(vals + i);
+        }
+
+        interp->glob.vals = vals;
+        interp->glob.num = num_globs;
+    }
+
+    if (prog->num_chunks != 0) {
+        JitChunk * chunks = (JitChunk *)MeMem_Malloc(
+            sizeof(JitChunk) * prog->num_chunks);
+        if (chunks == NULL) {
+            Interp_SetError(interp, InterpErr_NoEnoughMemory, NULL);
+            return false;
+        }
+
+        for (usize i = 0; i < prog->num_chunks; i++) {
+            chunks[i].stat = ChunkStat_Cold;
+            chunks[i].hits = 0;
+            chunks[i].fn = NULL;
+        }
+
+        interp->jit.chunks = chunks;
+        interp->jit.num_chunks = prog->num_chunks;
+    }
+
+    interp->prog = prog;
+
+    return true;
+}
+
+/**
+ * @brief Loads a compiled program, which is only borrowed.
+ *
+ * The interpreter keeps its globals, heap and compiled code to itself, so
+ * any number of interpreters may load the same program and run it on
+ * their own threads.
+ *
+ * @param interp A pointer to the interpreter.
+ * @param prog A pointer to the program, which must outlive the load.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+Interp_LoadProg(
+    Interp * interp,
+    const InterpProg * prog
+) {
+    if (prog->tree == NULL) {
+        return false;
+    }
+
+    Interp_Reset(interp);
+
+    const MemAllocator * prev = MeMem_Use(interp->alloc);
+    MemTag prev_tag = MeMem_SetTag(MemTag_Runtime);
+    MetricsSpan span;
+
+    bool traced = Trace_Begin("Interp_Load");
+    Metrics_Begin(interp->metrics, &span);
+
+    bool res = Interp_Instantiate(interp, prog);
+
+    Metrics_End(interp->metrics, MetricsPhase_Load, &span);
+    Trace_End("Interp_Load", traced);
+
+    MeMem_SetTag(prev_tag);
+    MeMem_Use(prev);
+
+    return res;
+}
+
+/**
+ * @brief Compiles a program for the interpreter alone and loads it.
+ *
+ * The program is annotated in place and must outlive the interpreter run,
+ * see `InterpProg_Compile`.
+ *
+ * @param interp A pointer to the interpreter.
+ * @param tree A pointer to the program node.
+ *
+ * @return `true` on success, `false` if the program cannot be resolved.
+ */
+bool
+Interp_Load(
+    Interp * interp,
+    AstNode * tree
+) {
+    Interp_Reset(interp);
+
+    const MemAllocator * prev = MeMem_Use(interp->alloc);
+    MemTag prev_tag = MeMem_SetTag(MemTag_Runtime);
+    bool res = false;
+    MetricsSpan span;
+
+    bool traced = Trace_Begin("Interp_Load");
+    Metrics_Begin(interp->metrics, &span);
+
+    InterpProg * prog = InterpProg_New();
+    if (prog == NULL) {
+        Interp_SetError(interp, InterpErr_NoEnoughMemory, NULL);
+        goto Exit;
+    }
+
+    if (InterpProg_Compile(prog, tree) == false) {
+        interp->err.type = prog->err.type;
+        FlexBuf_PushBuf(interp->err.msg, FlexBuf_Data(prog->err.msg),
+            FlexBuf_Size(prog->err.msg));
+        InterpProg_Free(prog);
+        goto Exit;
+    }
+
+    interp->own_prog = prog;
+    res = Interp_Instantiate(interp, prog);
+
+Exit:
+    Metrics_End(interp->metrics, MetricsPhase_Load, &span);
+    Trace_End("Interp_Load", traced);
+
+    MeMem_SetTag(prev_tag);
+    MeMem_Use(prev);
+
+    return res;
+}
+
+static
+ExecRes
+Interp_Exec(
+    Interp * interp,
+    AstNode * node
+);
+
+static
+bool
+Interp_Eval(
+    Interp * interp,
+    AstNode * node,
+    Value * out
+);
+
+static
+bool
+Interp_EvalRoot(
+    Interp * interp,
+    AstNode * node,
+    Value * out
+);
+
+static
+inline
+Value *
+Interp_VarSlot(
+    Interp * interp,
+    AstNode * var
+) {
+    if (var->ext.var.local) {
+        return interp->frame->slots + var->ext.var.slot;
+    }
+
+    return interp->glob.vals + var->ext.var.slot;
+}
+
+/**
+ * @brief Runs the function of the top frame until it returns.
+ *
+ * Tail calls replace the function of the top frame in place, so they are
+ * looped over here instead of recursing.
+ */
+static
+bool
+Interp_RunFrame(
+    Interp * interp
+) {
+    while (true) {
+        AstNode * func = interp->frame->func;
+
+        switch (Interp_Exec(interp, func->ext.func_def.body)) {
+        case ExecRes_Normal:
+            Value_InitNil(&interp->ret);
+            return true;
+
+        case ExecRes_Return:
+            return true;
+
+        case ExecRes_TailCall:
+            break;
+
+        case ExecRes_Error:
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief Evaluates the arguments of a call into newly reserved slots.
+ *
+ * The slots are sized for the whole callee frame, and the arguments are
+ * evaluated in the context of the current frame.
+ */
+static
+bool
+Interp_EvalArgs(
+    Interp * interp,
+    AstNode * call,
+    Value ** slots
+) {
+    AstNode * func = call->ext.call.func;
+    AstNode ** buf_args = AstSeq_Data(call->ext.call.args);
+    usize num_args = AstSeq_Count(call->ext.call.args);
+    Value * buf;
+
+    if (CallStack_Reserve(interp->stack,
+        func->ext.func_def.num_slots, &buf) == false) {
+
+        Interp_SetError(interp, InterpErr_StackOverflow, NULL);
+        return false;
+    }
+
+    for (usize i = 0; i < num_args; i++) {
+        if (Interp_EvalRoot(interp, buf_args[i], buf + i) == false) {
+            CallStack_Release(interp->stack, buf);
+            return false;
+        }
+    }
+
+    *slots = buf;
+
+    return true;
+}
+
+static
+bool
+Interp_EvalCall(
+    Interp * interp,
+    AstNode * call,
+    Value * out
+) {
+    Frame * caller = interp->frame;
+    Value * slots;
+
+    if (Interp_EvalArgs(interp, call, &slots) == false) {
+        return false;
+    }
+
+    Frame * frame = CallStack_Push(interp->stack, call->ext.call.func, slots);
+    if (frame == NULL) {
+        CallStack_Release(interp->stack, slots);
+        Interp_SetError(interp, InterpErr_StackOverflow, NULL);
+        return false;
+    }
+
+    interp->frame = frame;
+
+    bool res = Interp_RunFrame(interp);
+
+    CallStack_Pop(interp->stack);
+    interp->frame = caller;
+
+    if (res == false) {
+        return false;
+    }
+
+    *out = interp->ret;
+    Value_InitNil(&interp->ret);
+
+    return true;
+}
+
+static
+bool
+Interp_ApplyBinOp(
+    Interp * interp,
+    AstTag tag,
+    Value * lhs,
+    Value * rhs,
+    Value * out
+) {
+    InterpErr err = Ops_Binary(interp->gc, tag, lhs, rhs, out);
+    if (err != InterpErr_Ok) {
+        Interp_SetError(interp, err, NULL);
+        return false;
+    }
+
+    return true;
+}
+
+static
+bool
+Interp_CheckBool(
+    Interp * interp,
+    Value * val,
+    bool * b
+) {
+    if (val->tag != ValTag_Bool) {
+        Value_Release(val);
+        Interp_SetError(interp, InterpErr_TypeMismatch, NULL);
+        return false;
+    }
+
+    *b = val->ext.val;
+
+    return true;
+}
+
+static
+bool
+Interp_EvalBool(
+    Interp * interp,
+    AstNode * node,
+    bool * b
+) {
+    Value val;
+
+    return Interp_Eval(interp, node, &val) &&
+        Interp_CheckBool(interp, &val, b);
+}
+
+static
+bool
+Interp_Eval(
+    Interp * interp,
+    AstNode * node,
+    Value * out
+) {
+    switch (node->tag) {
+    case AstTag_StrLit: {
+        FixedBuf * lit = node->ext.str_lit.str;
+
+        StrObj * str = StrObj_New(interp->gc,
+            FixedBuf_Data(lit), FixedBuf_Size(lit));
+        if (str == NULL) {
+            Interp_SetError(interp, InterpErr_NoEnoughMemory, NULL);
+            return false;
+        }
+
+        Value_InitStr(out, str);
+
+        return true;
+    }
+
+    case AstTag_NumLit: {
+        if (node->ext.num_lit.big == NULL) {
+            Value_InitNum(out, node->ext.num_lit.num);
+            return true;
+        }
+
+        BigInt * big = BigInt_Clone(node->ext.num_lit.big);
+        if (big == NULL) {
+            Interp_SetError(interp, InterpErr_NoEnoughMemory, NULL);
+            return false;
+        }
+
+        Value_InitBig(out, big);
+
+        return true;
+    }
+
+    case AstTag_BoolLit:
+        Value_InitBool(out, node->ext.bool_lit.val);
+        return true;
+
+    case AstTag_Var:
+        if (Value_Copy(out, Interp_VarSlot(interp, node)) == false) {
+            Interp_SetError(interp, InterpErr_NoEnoughMemory, NULL);
+            return false;
+        }
+
+        return true;
+
+    case AstTag_Call:
+        return Interp_EvalCall(interp, node, out);
+
+    case AstTag_LogNotOp:
+
+    case AstTag_UnaPlusOp:
+    case AstTag_UnaMinusOp: {
+        if (Interp_Eval(interp, node->ext.una_op.opd, out) == false) {
+            return false;
+        }
+
+        InterpErr err = Ops_Unary(node->tag, out);
+        if (err != InterpErr_Ok) {
+            Value_Release(out);
+            Interp_SetError(interp, err, NULL);
+            return false;
+        }
+
+        return true;
+    }
+
+    case AstTag_LogOrOp:
+    case AstTag_LogAndOp: {
+        bool b;
+
+        if (Interp_EvalBool(interp, node->ext.bin_op.lhs, &b) == false) {
+            return false;
+        }
+
+        /* Short-circuit evaluation. */
+        if (b == (node->tag == AstTag_LogOrOp)) {
+            Value_InitBool(out, b);
+            return true;
+        }
+
+        if (Interp_EvalBool(interp, node->ext.bin_op.rhs, &b) == false) {
+            return false;
+        }
+
+        Value_InitBool(out, b);
+
+        return true;
+    }
+
+    case AstTag_RelEquOp:
+    case AstTag_RelNeqOp:
+    case AstTag_RelLtOp:
+    case AstTag_RelLteOp:
+    case AstTag_RelGtOp:
+    case AstTag_RelGteOp:
+
+    case AstTag_BinAddOp:
+    case AstTag_BinSubOp:
+    case AstTag_BinMulOp:
+    case AstTag_BinDivOp:
+    case AstTag_BinModOp:
+    case AstTag_BinExpOp: {
+        Value lhs;
+        Value rhs;
+        Value * tmp = NULL;
+
+        if (Interp_Eval(interp, node->ext.bin_op.lhs, &lhs) == false) {
+            return false;
+        }
+
+        /* A string must stay visible to the collector while the right
+           operand is evaluated, since calls reach safepoints. */
+        if (lhs.tag == ValTag_Str) {
+            if (CallStack_Reserve(interp->stack, 1, &tmp) == false) {
+                Interp_SetError(interp, InterpErr_StackOverflow, NULL);
+                return false;
+            }
+
+            *tmp = lhs;
+        }
+
+        bool ok = Interp_Eval(interp, node->ext.bin_op.rhs, &rhs);
+
+        if (tmp != NULL) {
+            lhs = *tmp;
+            Value_InitNil(tmp);
+            CallStack_Release(interp->stack, tmp);
+        }
+
+        if (ok == false) {
+            Value_Release(&lhs);
+            return false;
+        }
+
+        bool res = Interp_ApplyBinOp(interp, node->tag, &lhs, &rhs, out);
+
+        Value_Release(&lhs);
+        Value_Release(&rhs);
+
+        return res;
+    }
+
+    default:
+        Interp_SetError(interp, InterpErr_TypeMismatch, NULL);
+        return false;
+    }
+}
+
+/**
+ * @brief Evaluates a root expression, through its compiled code once it is
+ *        hot.
+ *
+ * A root expression is compiled after `ME_JIT_HOT_THRESHOLD` evaluations.
+ * When the compiled code bails out the expression is evaluated again by the
+ * interpreter, which is sound because compiled expressions have no side
+ * effects, and after `ME_JIT_MAX_BAILOUTS` bailouts it stays interpreted.
+ */
+static
+bool
+Interp_EvalRoot(
+    Interp * interp,
+    AstNode * node,
+    Value * out
+) {
+    if (interp->jit.enabled == false ||
+        IsBinOp(node->tag) == false ||
+        node->ext.bin_op.chunk == NO_CHUNK) {
+
+        return Interp_Eval(interp, node, out);
+    }
+
+    JitChunk * chunk = interp->jit.chunks + node->ext.bin_op.chunk;
+
+    if (chunk->stat == ChunkStat_Cold) {
+        chunk->hits += 1;
+        if (chunk->hits >= ME_JIT_HOT_THRESHOLD) {
+            chunk->fn = Jit_Compile(interp->jit.jit, node);
+            chunk->hits = 0;
+
+            if (chunk->fn == NULL) {
+                chunk->stat = ChunkStat_Rejected;
+            } else {
+                chunk->stat = ChunkStat_Compiled;
+                interp->jit.num_compiled += 1;
+            }
+        }
+    }
+
+    if (chunk->stat == ChunkStat_Compiled) {
+        Value * locals = interp->frame == NULL ? NULL : interp->frame->slots;
+
+        if (chunk->fn(locals, interp->glob.vals, out)) {
+            return true;
+        }
+
+        chunk->hits += 1;
+        if (chunk->hits >= ME_JIT_MAX_BAILOUTS) {
+            chunk->stat = ChunkStat_Rejected;
+        }
+    }
+
+    return Interp_Eval(interp, node, out);
+}
+
+static
+bool
+Interp_EvalCond(
+    Interp * interp,
+    AstNode * node,
+    bool * b
+) {
+    Value val;
+
+    return Interp_EvalRoot(interp, node, &val) &&
+        Interp_CheckBool(interp, &val, b);
+}
+
+static
+ExecRes
+Interp_ExecSeq(
+    Interp * interp,
+    AstSeq * seq
+) {
+    AstNode ** buf_nodes = AstSeq_Data(seq);
+    usize num_nodes = AstSeq_Count(seq);
+
+    /* Where the statement being executed is published to the profiler. */
+    AstNode ** stmt = interp->frame != NULL ?
+        &interp->frame->stmt : &interp->stmt;
+
+    for (usize i = 0; i < num_nodes; i++) {
+
+        /* Safepoint, every live value is reachable from the roots. */
+        if (Gc_Poll(interp->gc) == false) {
+            Interp_SetError(interp, InterpErr_NoEnoughMemory, NULL);
+            return ExecRes_Error;
+        }
+
+        *stmt = buf_nodes[i];
+
+        ExecRes res = Interp_Exec(interp, buf_nodes[i]);
+        if (res != ExecRes_Normal) {
+            return res;
+        }
+    }
+
+    return ExecRes_Normal;
+}
+
+static
+ExecRes
+Interp_ExecMatch(
+    Interp * interp,
+    AstNode * node
+) {
+    MatchTab * tab = node->ext.match_stmt.tab;
+    Value subj;
+    bool found;
+    usize idx;
+
+    if (Interp_EvalRoot(interp, node->ext.match_stmt.subj, &subj) == false) {
+        return ExecRes_Error;
+    }
+
+    switch (subj.tag) {
+    case ValTag_Num:
+        found = MatchTab_FindNum(tab, subj.ext.num, &idx);
+        break;
+
+    case ValTag_Big:
+        found = MatchTab_FindBig(tab, subj.ext.big, &idx);
+        break;
+
+    case ValTag_Bool:
+        found = MatchTab_FindBool(tab, subj.ext.val, &idx);
+        break;
+
+    case ValTag_Str: {
+        u8 tmp[STR_INLINE_MAX];
+
+        const u8 * buf = StrObj_Flatten(interp->gc, subj.ext.str, tmp);
+        if (buf == NULL) {
+            Interp_SetError(interp, InterpErr_NoEnoughMemory, NULL);
+            return ExecRes_Error;
+        }
+
+        found = MatchTab_FindStr(tab, buf, StrObj_Size(subj.ext.str), &idx);
+        break;
+    }
+
+    default:
+        found = false;
+        break;
+    }
+
+    Value_Release(&subj);
+
+    if (found) {
+        AstNode * arm = AstSeq_At(node->ext.match_stmt.arms, idx);
+        return Interp_Exec(interp, arm->ext.match_arm.body);
+    }
+
+    if (node->ext.match_stmt.else_br != NULL) {
+        return Interp_Exec(interp, node->ext.match_stmt.else_br);
+    }
+
+    return ExecRes_Normal;
+}
+
+static
+ExecRes
+Interp_ExecRet(
+    Interp * interp,
+    AstNode * node
+) {
+    AstNode * val = node->ext.ret_stmt.val;
+
+    if (val == NULL) {
+        Value_InitNil(&interp->ret);
+        return ExecRes_Return;
+    }
+
+    if (val->tag == AstTag_Call &&
+        val->ext.call.tail) {
+
+        Value * args;
+
+        if (Interp_EvalArgs(interp, val, &args) == false) {
+            return ExecRes_Error;
+        }
+
+        CallStack_TailCall(interp->stack, val->ext.call.func, args);
+
+        return ExecRes_TailCall;
+    }
+
+    if (Interp_EvalRoot(interp, val, &interp->ret) == false) {
+        return ExecRes_Error;
+    }
+
+    return ExecRes_Return;
+}
+
+static
+ExecRes
+Interp_Exec(
+    Interp * interp,
+    AstNode * node
+) {
+    switch (node->tag) {
+    case AstTag_AsgnStmt: {
+        Value val;
+
+        if (Interp_EvalRoot(interp, node->ext.asgn_stmt.rhs, &val) == false) {
+            return ExecRes_Error;
+        }
+
+        AstNode * var = node->ext.asgn_stmt.lhs;
+        Value * slot = Interp_VarSlot(interp, var);
+        Value_Release(slot);
+        *slot = val;
+
+        if (var->ext.var.local == false &&
+            val.tag == ValTag_Str &&
+            StrObj_IsInline(val.ext.str) == false) {
+
+            Gc_WriteBarrier(interp->gc, interp->glob.vals, val.ext.str);
+        }
+
+        return ExecRes_Normal;
+    }
+
+    case AstTag_IfStmt: {
+        bool b;
+
+        if (Interp_EvalCond(interp, node->ext.if_stmt.cond, &b) == false) {
+            return ExecRes_Error;
+        }
+
+        if (b) {
+            return Interp_Exec(interp, node->ext.if_stmt.then_br);
+        }
+
+        return ExecRes_Normal;
+    }
+
+    case AstTag_IfElseStmt: {
+        bool b;
+
+        if (Interp_EvalCond(interp,
+            node->ext.if_else_stmt.cond, &b) == false) {
+
+            return ExecRes_Error;
+        }
+
+        return Interp_Exec(interp, b ?
+            node->ext.if_else_stmt.then_br : node->ext.if_else_stmt.else_br);
+    }
+
+    case AstTag_MatchStmt:
+        return Interp_ExecMatch(interp, node);
+
+    case AstTag_BlockStmt:
+        return Interp_ExecSeq(interp, node->ext.block.seq);
+
+    case AstTag_ExprStmt: {
+        Value val;
+
+        if (Interp_Eval(interp, node->ext.expr_stmt.expr, &val) == false) {
+            return ExecRes_Error;
+        }
+
+        Value_Release(&val);
+
+        return ExecRes_Normal;
+    }
+
+    case AstTag_RetStmt:
+        return Interp_ExecRet(interp, node);
+
+    case AstTag_FuncDef:
+        return ExecRes_Normal;
+
+    default:
+        Interp_SetError(interp, InterpErr_TypeMismatch, NULL);
+        return ExecRes_Error;
+    }
+}
+
+bool
+Interp_Run(
+    Interp * interp
+) {
+    if (interp->prog == NULL) {
+        return false;
+    }
+
+    interp->err.type = InterpErr_Ok;
+    FlexBuf_Clear(interp->err.msg);
+
+    const MemAllocator * prev = MeMem_Use(interp->alloc);
+    MemTag prev_tag = MeMem_SetTag(MemTag_Runtime);
+    bool res = true;
+    MetricsSpan span;
+
+    bool traced = Trace_Begin("Interp_Run");
+    Metrics_Begin(interp->metrics, &span);
+
+    if (Interp_ExecSeq(interp, interp->prog->tree->ext.block.seq) !=
+        ExecRes_Normal) {
+
+        CallStack_Clear(interp->stack);
+        interp->frame = NULL;
+        res = false;
+    }
+
+    interp->stmt = NULL;
+
+    Metrics_End(interp->metrics, MetricsPhase_Run, &span);
+    Trace_End("Interp_Run", traced);
+
+    MeMem_SetTag(prev_tag);
+    MeMem_Use(prev);
+
+    return res;
+}
+
+/**
+ * @brief Fills in where the interpreter is, innermost frame first, for the
+ *        profiler.
+ *
+ * It only reads the call stack, so it may be called from a signal handler
+ * interrupting the thread running the interpreter.
+ *
+ * @param interp A pointer to the interpreter.
+ * @param locs A pointer to receive the locations.
+ * @param max The maximum number of locations, outer ones are left out.
+ *
+ * @return The number of locations, `0` outside of `Interp_Run`.
+ */
+usize
+Interp_Backtrace(
+    Interp * interp,
+    InterpLoc * locs,
+    usize max
+) {
+    if (interp->stmt == NULL) {
+        return 0;
+    }
+
+    usize depth = CallStack_Depth(interp->stack);
+    usize num = 0;
+
+    while (depth > 0 && num < max) {
+        Frame * frame = CallStack_At(interp->stack, --depth);
+
+        locs[num].func = frame->func;
+        locs[num].stmt = frame->stmt;
+        num++;
+    }
+
+    if (num < max) {
+        locs[num].func = NULL;
+        locs[num].stmt = interp->stmt;
+        num++;
+    }
+
+    return num;
+}
+
+/**
+ * @brief Sets the allocator of the memory the interpreter takes while
+ *        loading and running, which defaults to the allocator in scope when
+ *        it was created.
+ */
+void
+Interp_SetAllocator(
+    Interp * interp,
+    const MemAllocator * alloc
+) {
+    interp->alloc = alloc;
+}
+
+/**
+ * @brief Installs metrics the interpreter adds its load and run times to,
+ *        or `NULL` to stop collecting them.
+ */
+void
+Interp_SetMetrics(
+    Interp * interp,
+    Metrics * metrics
+) {
+    interp->metrics = metrics;
+}
+
+/**
+ * @brief Looks up a global variable by name.
+ *
+ * @return A pointer to the value, owned by the interpreter, or `NULL` if the
+ *         loaded program has no such global. Strings may move when the
+ *         program runs again.
+ */
+Value *
+Interp_Global(
+    Interp * interp,
+    const char * name
+) {
+    usize len = strlen(name);
+
+    for (usize i = 0; i < interp->glob.num; i++) {
+        FixedBuf * glob_name = Interp_GlobalName(interp, i);
+
+        if (FixedBuf_Size(glob_name) == len &&
+            memcmp(FixedBuf_Data(glob_name), name, len) == 0) {
+
+            return interp->glob.vals + i;
+        }
+    }
+
+    return NULL;
+}
+
+AstNode *
+Interp_Program(
+    Interp * interp
+) {
+    return interp->prog != NULL ? interp->prog->tree : NULL;
+}
+
+usize
+Interp_GlobalCount(
+    Interp * interp
+) {
+    return interp->glob.num;
+}
+
+/**
+ * @brief Returns the name of a global variable by slot, borrowed from the
+ *        loaded program.
+ */
+FixedBuf *
+Interp_GlobalName(
+    Interp * interp,
+    usize slot
+) {
+    return ((FixedBuf **)FlexBuf_Data(interp->prog->glob_names))[slot];
+}
+
+/**
+ * @brief Appends the values of the global variables to a FlexBuf.
+ *
+ * Values are written by content, so they can be loaded into the heap of
+ * another interpreter running the same program, see `Interp_LoadGlobals`.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+Interp_PushGlobals(
+    Interp * interp,
+    FlexBuf * buf
+) {
+    u64 num = interp->glob.num;
+    bool res = false;
+
+    FlexBuf * dec = FlexBuf_New();
+    if (dec == NULL) {
+        goto Exit;
+    }
+
+    if (FlexBuf_PushBuf(buf, &num, sizeof(u64)) == false) {
+        goto FreeDec;
+    }
+
+    for (usize i = 0; i < interp->glob.num; i++) {
+        Value * val = interp->glob.vals + i;
+        u8 tag = (u8)val->tag;
+        u64 word;
+
+        if (FlexBuf_PushByte(buf, tag) == false) {
+            goto FreeDec;
+        }
+
+        switch (val->tag) {
+        case ValTag_Nil:
+            break;
+
+        case ValTag_Num:
+            word = (u64)val->ext.num;
+            if (FlexBuf_PushBuf(buf, &word, sizeof(u64)) == false) {
+                goto FreeDec;
+            }
+            break;
+
+        case ValTag_Bool:
+            if (FlexBuf_PushByte(buf, val->ext.val ? 1 : 0) == false) {
+                goto FreeDec;
+            }
+            break;
+
+        case ValTag_Str:
+            word = StrObj_Size(val->ext.str);
+
+            if (FlexBuf_PushBuf(buf, &word, sizeof(u64)) == false) {
+                goto FreeDec;
+            }
+
+            u8 * dst = FlexBuf_ReserveTail(buf, (usize)word);
+            if (dst == NULL) {
+                goto FreeDec;
+            }
+
+            StrObj_Write(val->ext.str, dst);
+            FlexBuf_Commit(buf, (usize)word);
+            break;
+
+        case ValTag_Big:
+            FlexBuf_Clear(dec);
+
+            if (BigInt_PushAsStr(val->ext.big, dec) == false) {
+                goto FreeDec;
+            }
+
+            word = FlexBuf_Size(dec);
+
+            if (FlexBuf_PushBuf(buf, &word, sizeof(u64)) == false ||
+                FlexBuf_PushBuf(buf, FlexBuf_Data(dec),
+                    FlexBuf_Size(dec)) == false) {
+
+                goto FreeDec;
+            }
+            break;
+        }
+    }
+
+    res = true;
+
+FreeDec:
+    FlexBuf_Free(dec);
+
+Exit:
+    return res;
+}
+
+/**
+ * @brief Reads the length of a string or big integer from the values
+ *        written by `Interp_PushGlobals`.
+ */
+static
+const u8 *
+Interp_GlobalBytes(
+    const u8 * buf,
+    usize len,
+    usize * off,
+    usize * size
+) {
+    u64 size_64;
+
+    if (len - *off < sizeof(u64)) {
+        return NULL;
+    }
+
+    memcpy(&size_64, buf + *off, sizeof(u64));
+    *off += sizeof(u64);
+
+    if (size_64 > len - *off) {
+        return NULL;
+    }
+
+    const u8 * data = buf + *off;
+
+    *size = (usize)size_64;
+    *off += *size;
+
+    return data;
+}
+
+/**
+ * @brief Sets the global variables to values written by
+ *        `Interp_PushGlobals`, for the same program.
+ *
+ * @param interp A pointer to the interpreter, with the program loaded.
+ * @param buf A pointer to the values.
+ * @param len The size of the values in bytes.
+ *
+ * @return `true` on success, `false` if the values do not match the globals
+ *         of the program or memory allocation fails.
+ */
+bool
+Interp_LoadGlobals(
+    Interp * interp,
+    const u8 * buf,
+    usize len
+) {
+    const MemAllocator * prev = MeMem_Use(interp->alloc);
+    MemTag prev_tag = MeMem_SetTag(MemTag_Runtime);
+    bool res = false;
+    usize off = sizeof(u64);
+    u64 num;
+
+    if (len < sizeof(u64)) {
+        goto Exit;
+    }
+
+    memcpy(&num, buf, sizeof(u64));
+
+    if (num != interp->glob.num) {
+        goto Exit;
+    }
+
+    for (usize i = 0; i < interp->glob.num; i++) {
+        Value * slot = interp->glob.vals + i;
+        const u8 * data;
+        usize size;
+        u64 num_64;
+        Value val;
+
+        if (off == len) {
+            goto Exit;
+        }
+
+        switch (buf[off++]) {
+        case ValTag_Nil:
+            Value_InitNil(&val);
+            break;
+
+        case ValTag_Num:
+            if (len - off < sizeof(u64)) {
+                goto Exit;
+            }
+
+            memcpy(&num_64, buf + off, sizeof(u64));
+            off += sizeof(u64);
+
+            Value_InitNum(&val, (ssize)num_64);
+            break;
+
+        case ValTag_Bool:
+            if (off == len ||
+                buf[off] > 1) {
+
+                goto Exit;
+            }
+
+            Value_InitBool(&val, buf[off++] == 1);
+            break;
+
+        case ValTag_Str:
+            data = Interp_GlobalBytes(buf, len, &off, &size);
+            if (data == NULL) {
+                goto Exit;
+            }
+
+            StrObj * str = StrObj_New(interp->gc, data, size);
+            if (str == NULL) {
+                goto Exit;
+            }
+
+            Value_InitStr(&val, str);
+            break;
+
+        case ValTag_Big:
+            data = Interp_GlobalBytes(buf, len, &off, &size);
+            if (data == NULL ||
+                size == 0) {
+
+                goto Exit;
+            }
+
+            for (usize j = 0; j < size; j++) {
+                if ((data[j] < '0' || data[j] > '9') &&
+                    (j != 0 || data[j] != '-' || size == 1)) {
+
+                    goto Exit;
+                }
+            }
+
+            BigInt * big = BigInt_NewFromDec(data, size);
+            if (big == NULL) {
+                goto Exit;
+            }
+
+            Value_InitBig(&val, big);
+            break;
+
+        default:
+            goto Exit;
+        }
+
+        Value_Release(slot);
+        *slot = val;
+
+        if (val.tag == ValTag_Str &&
+            StrObj_IsInline(val.ext.str) == false) {
+
+            Gc_WriteBarrier(interp->gc, interp->glob.vals, val.ext.str);
+        }
+    }
+
+    res = off == len;
+
+Exit:
+    MeMem_SetTag(prev_tag);
+    MeMem_Use(prev);
+
+    return res;
+}
+
+/**
+ * @brief Enables or disables the template JIT, code compiled so far is kept
+ *        but no longer run while disabled.
+ *
+ * The JIT is enabled by default on builds where `ME_JIT_ENABLED` is set, and
+ * cannot be enabled on the others.
+ */
+void
+Interp_SetJit(
+    Interp * interp,
+    bool enabled
+) {
+    interp->jit.enabled = enabled && ME_JIT_ENABLED;
+}
+
+/**
+ * @brief Returns the number of root expressions compiled since the program
+ *        was loaded.
+ */
+usize
+Interp_JitCount(
+    Interp * interp
+) {
+    return interp->jit.num_compiled;
+}
+
+/**
+ * @brief Makes major collections of the heap incremental, see
+ *        `Gc_SetStepBudget`.
+ */
+void
+Interp_SetGcStepBudget(
+    Interp * interp,
+    usize budget
+) {
+    Gc_SetStepBudget(interp->gc, budget);
+}
+
+/**
+ * @brief Reads the statistics of the heap, which accumulate over the life of
+ *        the interpreter.
+ */
+void
+Interp_GcStats(
+    Interp * interp,
+    GcStats * stats
+) {
+    Gc_Stats(interp->gc, stats);
+}
+
+InterpErr
+Interp_ErrorType(
+    Interp * interp
+) {
+    return interp->err.type;
+}
+
+FlexBuf *
+Interp_ErrorMessage(
+    Interp * interp
+) {
+    return interp->err.msg;
+}
+
+void
+Interp_Reset(
+    Interp * interp
+) {
+    CallStack_Clear(interp->stack);
+    interp->frame = NULL;
+    interp->stmt = NULL;
+    Value_Release(&interp->ret);
+
+    for (usize i = 0; i < interp->glob.num; i++) {
+        Value_Release(interp->glob.vals + i);
+    }
+
+    interp->glob.num = 0;
+    interp->glob.vals = NULL;
+
+    if (interp->own_prog != NULL) {
+        InterpProg_Free(interp->own_prog);
+        interp->own_prog = NULL;
+    }
+
+    interp->prog = NULL;
+
+    if (interp->jit.chunks != NULL) {
+        MeMem_Free(interp->jit.chunks);
+    }
+
+    Jit_Reset(interp->jit.jit);
+    interp->jit.chunks = NULL;
+    interp->jit.num_chunks = 0;
+    interp->jit.num_compiled = 0;
+
+    interp->err.type = InterpErr_Ok;
+    FlexBuf_Clear(interp->err.msg);
+
+    /* Nothing references the heap anymore. */
+    Gc_Clear(interp->gc);
+}
+
+void
+Interp_Free(
+    Interp * interp
+) {
+    Interp_Reset(interp);
+    FlexBuf_Free(interp->err.msg);
+    Jit_Free(interp->jit.jit);
+    Gc_Free(interp->gc);
+    CallStack_Free(interp->stack);
+    MeMem_Free(interp);
+}
\ No newline at end of file
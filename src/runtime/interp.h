@@ -0,0 +1,185 @@
+#ifndef __ME_RUNTIME_INTERP_H__
+#define __ME_RUNTIME_INTERP_H__
+
+#include "menos.h"
+#include "parser/ast.h"
+#include "memory/allocate.h"
+#include "memory/gc.h"
+#include "value.h"
+
+typedef enum _InterpErr {
+    InterpErr_Ok,
+    InterpErr_NoEnoughMemory,
+    InterpErr_UndefinedVariable,
+    InterpErr_UndefinedFunction,
+    InterpErr_DuplicateFunction,
+    InterpErr_DuplicateParameter,
+    InterpErr_ArityMismatch,
+    InterpErr_ReturnOutsideFunction,
+    InterpErr_TypeMismatch,
+    InterpErr_DivisionByZero,
+    InterpErr_StackOverflow,
+} InterpErr;
+
+const char *
+InterpErr_ToStr(
+    InterpErr err
+);
+
+/* Program resolved for the interpreter, read-only once compiled. */
+typedef struct _InterpProg InterpProg;
+
+typedef struct _Interp Interp;
+
+typedef struct _Metrics Metrics;
+
+/* Where a frame is, at the top level if `func` is `NULL`. */
+typedef struct _InterpLoc {
+    AstNode * func;
+
+    /* Statement being executed, `NULL` if none has started yet. */
+    AstNode * stmt;
+} InterpLoc;
+
+InterpProg *
+InterpProg_New(void);
+
+bool
+InterpProg_Compile(
+    InterpProg * prog,
+    AstNode * tree
+);
+
+InterpErr
+InterpProg_ErrorType(
+    InterpProg * prog
+);
+
+FlexBuf *
+InterpProg_ErrorMessage(
+    InterpProg * prog
+);
+
+void
+InterpProg_Free(
+    InterpProg * prog
+);
+
+Interp *
+Interp_New(void);
+
+bool
+Interp_Load(
+    Interp * interp,
+    AstNode * tree
+);
+
+bool
+Interp_LoadProg(
+    Interp * interp,
+    const InterpProg * prog
+);
+
+bool
+Interp_Run(
+    Interp * interp
+);
+
+usize
+Interp_Backtrace(
+    Interp * interp,
+    InterpLoc * locs,
+    usize max
+);
+
+void
+Interp_SetAllocator(
+    Interp * interp,
+    const MemAllocator * alloc
+);
+
+void
+Interp_SetMetrics(
+    Interp * interp,
+    Metrics * metrics
+);
+
+Value *
+Interp_Global(
+    Interp * interp,
+    const char * name
+);
+
+AstNode *
+Interp_Program(
+    Interp * interp
+);
+
+usize
+Interp_GlobalCount(
+    Interp * interp
+);
+
+FixedBuf *
+Interp_GlobalName(
+    Interp * interp,
+    usize slot
+);
+
+bool
+Interp_PushGlobals(
+    Interp * interp,
+    FlexBuf * buf
+);
+
+bool
+Interp_LoadGlobals(
+    Interp * interp,
+    const u8 * buf,
+    usize len
+);
+
+void
+Interp_SetJit(
+    Interp * interp,
+    bool enabled
+);
+
+usize
+Interp_JitCount(
+    Interp * interp
+);
+
+void
+Interp_SetGcStepBudget(
+    Interp * interp,
+    usize budget
+);
+
+void
+Interp_GcStats(
+    Interp * interp,
+    GcStats * stats
+);
+
+InterpErr
+Interp_ErrorType(
+    Interp * interp
+);
+
+FlexBuf *
+Interp_ErrorMessage(
+    Interp * interp
+);
+
+void
+Interp_Reset(
+    Interp * interp
+);
+
+void
+Interp_Free(
+    Interp * interp
+);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,681 @@
+#include <string.h>
+
+#include "jit.h"
+#include "config.h"
+#include "memory/allocate.h"
+#include "util/flex_buf.h"
+
+#if ME_JIT_ENABLED
+#include <sys/mman.h>
+#endif
+
+/* The size of a code page, larger expressions get a mapping of their own. */
+#define JIT_PAGE_SIZE (64 * 1024)
+
+/* Executable mapping, filled from the front. */
+typedef struct _JitPage {
+    u8 * base;
+    usize cap;
+    usize used;
+} JitPage;
+
+typedef struct _Jit {
+
+    /* Code pages, an array of `JitPage`. */
+    FlexBuf * pages;
+} Jit;
+
+/* Static type of an expression, as far as it can be told without running. */
+typedef enum _JitType {
+    JitType_Unknown,
+    JitType_Num,
+    JitType_Bool,
+} JitType;
+
+Jit *
+Jit_New(void) {
+    FlexBuf * pages = FlexBuf_New();
+    if (pages == NULL) {
+        goto Exit;
+    }
+
+    Jit * jit = (Jit *)MeMem_Malloc(sizeof(Jit));
+    if (jit == NULL) {
+        goto FreePages;
+    }
+
+    jit->pages = pages;
+
+    return jit;
+
+FreePages:
+    FlexBuf_Free(pages);
+
+Exit:
+    return NULL;
+}
+
+static
+JitType
+Jit_StaticType(
+    AstNode * expr
+) {
+    switch (expr->tag) {
+    case AstTag_NumLit:
+    case AstTag_UnaPlusOp:
+    case AstTag_UnaMinusOp:
+    case AstTag_BinAddOp:
+    case AstTag_BinSubOp:
+    case AstTag_BinMulOp:
+    case AstTag_BinDivOp:
+    case AstTag_BinModOp:
+    case AstTag_BinExpOp:
+        return JitType_Num;
+
+    case AstTag_BoolLit:
+    case AstTag_LogNotOp:
+    case AstTag_LogOrOp:
+    case AstTag_LogAndOp:
+    case AstTag_RelEquOp:
+    case AstTag_RelNeqOp:
+    case AstTag_RelLtOp:
+    case AstTag_RelLteOp:
+    case AstTag_RelGtOp:
+    case AstTag_RelGteOp:
+        return JitType_Bool;
+
+    default:
+        return JitType_Unknown;
+    }
+}
+
+/**
+ * @brief Picks the operand type of an equality test, numbers unless one of
+ *        the operands is known to be a boolean.
+ */
+static
+JitType
+Jit_EqualityType(
+    AstNode * expr
+) {
+    JitType type = Jit_StaticType(expr->ext.bin_op.lhs);
+
+    if (type == JitType_Unknown) {
+        type = Jit_StaticType(expr->ext.bin_op.rhs);
+    }
+
+    return type == JitType_Unknown ? JitType_Num : type;
+}
+
+static
+bool
+Jit_CompilableAs(
+    AstNode * expr,
+    JitType type
+) {
+    JitType static_type = Jit_StaticType(expr);
+
+    /* Such an expression always fails its guards, leave it to the
+       interpreter to report the error. */
+    if (static_type != JitType_Unknown &&
+        static_type != type) {
+
+        return false;
+    }
+
+    switch (expr->tag) {
+    case AstTag_NumLit:
+        return expr->ext.num_lit.big == NULL;
+
+    case AstTag_BoolLit:
+    case AstTag_Var:
+        return true;
+
+    case AstTag_UnaPlusOp:
+    case AstTag_UnaMinusOp:
+        return Jit_CompilableAs(expr->ext.una_op.opd, JitType_Num);
+
+    case AstTag_LogNotOp:
+        return Jit_CompilableAs(expr->ext.una_op.opd, JitType_Bool);
+
+    case AstTag_LogOrOp:
+    case AstTag_LogAndOp:
+        return Jit_CompilableAs(expr->ext.bin_op.lhs, JitType_Bool) &&
+            Jit_CompilableAs(expr->ext.bin_op.rhs, JitType_Bool);
+
+    case AstTag_RelEquOp:
+    case AstTag_RelNeqOp: {
+        JitType opd_type = Jit_EqualityType(expr);
+
+        return Jit_CompilableAs(expr->ext.bin_op.lhs, opd_type) &&
+            Jit_CompilableAs(expr->ext.bin_op.rhs, opd_type);
+    }
+
+    case AstTag_RelLtOp:
+    case AstTag_RelLteOp:
+    case AstTag_RelGtOp:
+    case AstTag_RelGteOp:
+
+    case AstTag_BinAddOp:
+    case AstTag_BinSubOp:
+    case AstTag_BinMulOp:
+    case AstTag_BinDivOp:
+    case AstTag_BinModOp:
+        return Jit_CompilableAs(expr->ext.bin_op.lhs, JitType_Num) &&
+            Jit_CompilableAs(expr->ext.bin_op.rhs, JitType_Num);
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Checks whether an expression is in the subset handled by the JIT.
+ *
+ * The subset is integer arithmetic except exponentiation, relational
+ * operators and logical operators over literals and variables. Calls and
+ * strings are left to the interpreter.
+ *
+ * @param expr A pointer to the resolved expression.
+ *
+ * @return `true` if `Jit_Compile` can compile the expression on this build,
+ *         `false` otherwise.
+ */
+bool
+Jit_Compilable(
+    AstNode * expr
+) {
+#if ME_JIT_ENABLED
+    JitType type = Jit_StaticType(expr);
+
+    return type != JitType_Unknown &&
+        Jit_CompilableAs(expr, type);
+#else
+    (void)expr;
+    (void)Jit_CompilableAs;
+
+    return false;
+#endif
+}
+
+#if ME_JIT_ENABLED
+
+/* Appends instruction bytes to the code buffer. */
+#define EMIT(code, ...) \
+    FlexBuf_PushBuf((code), (const u8 []){ __VA_ARGS__ }, \
+        sizeof((const u8 []){ __VA_ARGS__ }))
+
+/* x86-64 condition codes, as in the second opcode byte of `jcc rel32`. */
+#define CC_O    0x80
+#define CC_E    0x84
+#define CC_NE   0x85
+#define CC_L    0x8C
+#define CC_GE   0x8D
+#define CC_LE   0x8E
+#define CC_G    0x8F
+
+/* Code offset of the bailout stub, which comes before the entry. */
+#define BAILOUT_OFF 0
+
+static
+bool
+Jit_Emit32(
+    FlexBuf * code,
+    u32 imm
+) {
+    return FlexBuf_PushBuf(code, &imm, sizeof(imm));
+}
+
+static
+bool
+Jit_Emit64(
+    FlexBuf * code,
+    u64 imm
+) {
+    return FlexBuf_PushBuf(code, &imm, sizeof(imm));
+}
+
+/**
+ * @brief Emits `jcc rel32` to a known offset before the current one.
+ */
+static
+bool
+Jit_EmitJccBack(
+    FlexBuf * code,
+    u8 cc,
+    usize target
+) {
+    s32 rel = (s32)((ssize)target - (ssize)(FlexBuf_Size(code) + 6));
+
+    return EMIT(code, 0x0F, cc) &&
+        Jit_Emit32(code, (u32)rel);
+}
+
+/**
+ * @brief Emits `jcc rel32` with a zero displacement to be patched later.
+ *
+ * @param patch Receives the offset of the displacement.
+ */
+static
+bool
+Jit_EmitJccFwd(
+    FlexBuf * code,
+    u8 cc,
+    usize * patch
+) {
+    if (EMIT(code, 0x0F, cc) == false) {
+        return false;
+    }
+
+    *patch = FlexBuf_Size(code);
+
+    return Jit_Emit32(code, 0);
+}
+
+static
+void
+Jit_PatchHere(
+    FlexBuf * code,
+    usize patch
+) {
+    s32 rel = (s32)(FlexBuf_Size(code) - (patch + 4));
+
+    memcpy(FlexBuf_Data(code) + patch, &rel, sizeof(rel));
+}
+
+/**
+ * @brief Emits a guarded load of a variable slot into `rax`.
+ */
+static
+bool
+Jit_EmitVar(
+    FlexBuf * code,
+    AstNode * var,
+    JitType type
+) {
+    usize base = var->ext.var.slot * sizeof(Value);
+    if (base > INT32_MAX - sizeof(Value)) {
+        return false;
+    }
+
+    u32 tag_disp = (u32)(base + offsetof(Value, tag));
+    u32 val_disp = (u32)(base + offsetof(Value, ext));
+    bool res;
+
+    /* mov rcx, rbx | mov rcx, r12 */
+    if (var->ext.var.local) {
+        res = EMIT(code, 0x48, 0x89, 0xD9);
+    } else {
+        res = EMIT(code, 0x4C, 0x89, 0xE1);
+    }
+
+    /* cmp dword [rcx + tag_disp], tag; jne bailout */
+    res = res &&
+        EMIT(code, 0x81, 0xB9) &&
+        Jit_Emit32(code, tag_disp) &&
+        Jit_Emit32(code, type == JitType_Bool ? ValTag_Bool : ValTag_Num) &&
+        Jit_EmitJccBack(code, CC_NE, BAILOUT_OFF);
+
+    if (type == JitType_Bool) {
+        /* movzx eax, byte [rcx + val_disp] */
+        res = res && EMIT(code, 0x0F, 0xB6, 0x81);
+    } else {
+        /* mov rax, [rcx + val_disp] */
+        res = res && EMIT(code, 0x48, 0x8B, 0x81);
+    }
+
+    return res && Jit_Emit32(code, val_disp);
+}
+
+static
+bool
+Jit_EmitExpr(
+    FlexBuf * code,
+    AstNode * expr,
+    JitType type
+);
+
+/**
+ * @brief Evaluates the operands of a binary operator, `lhs` into `rax` and
+ *        `rhs` into `rcx`.
+ */
+static
+bool
+Jit_EmitOperands(
+    FlexBuf * code,
+    AstNode * expr,
+    JitType type
+) {
+    /* push rax; ...; mov rcx, rax; pop rax */
+    return Jit_EmitExpr(code, expr->ext.bin_op.lhs, type) &&
+        EMIT(code, 0x50) &&
+        Jit_EmitExpr(code, expr->ext.bin_op.rhs, type) &&
+        EMIT(code, 0x48, 0x89, 0xC1, 0x58);
+}
+
+/**
+ * @brief Emits the template of an expression, leaving its value in `rax`.
+ */
+static
+bool
+Jit_EmitExpr(
+    FlexBuf * code,
+    AstNode * expr,
+    JitType type
+) {
+    switch (expr->tag) {
+    case AstTag_NumLit:
+        /* mov rax, imm64 */
+        return EMIT(code, 0x48, 0xB8) &&
+            Jit_Emit64(code, (u64)expr->ext.num_lit.num);
+
+    case AstTag_BoolLit:
+        /* mov eax, imm32 */
+        return EMIT(code, 0xB8) &&
+            Jit_Emit32(code, expr->ext.bool_lit.val ? 1 : 0);
+
+    case AstTag_Var:
+        return Jit_EmitVar(code, expr, type);
+
+    case AstTag_UnaPlusOp:
+        return Jit_EmitExpr(code, expr->ext.una_op.opd, JitType_Num);
+
+    case AstTag_UnaMinusOp:
+        /* neg rax; jo bailout */
+        return Jit_EmitExpr(code, expr->ext.una_op.opd, JitType_Num) &&
+            EMIT(code, 0x48, 0xF7, 0xD8) &&
+            Jit_EmitJccBack(code, CC_O, BAILOUT_OFF);
+
+    case AstTag_LogNotOp:
+        /* xor eax, 1 */
+        return Jit_EmitExpr(code, expr->ext.una_op.opd, JitType_Bool) &&
+            EMIT(code, 0x83, 0xF0, 0x01);
+
+    case AstTag_LogOrOp:
+    case AstTag_LogAndOp: {
+        usize patch;
+
+        /* test eax, eax; jnz end | jz end; ...; end: */
+        if (Jit_EmitExpr(code, expr->ext.bin_op.lhs, JitType_Bool) == false ||
+            EMIT(code, 0x85, 0xC0) == false ||
+            Jit_EmitJccFwd(code, expr->tag == AstTag_LogOrOp ?
+                CC_NE : CC_E, &patch) == false ||
+            Jit_EmitExpr(code, expr->ext.bin_op.rhs, JitType_Bool) == false) {
+
+            return false;
+        }
+
+        Jit_PatchHere(code, patch);
+
+        return true;
+    }
+
+    case AstTag_RelEquOp:
+    case AstTag_RelNeqOp:
+    case AstTag_RelLtOp:
+    case AstTag_RelLteOp:
+    case AstTag_RelGtOp:
+    case AstTag_RelGteOp: {
+        JitType opd_type = JitType_Num;
+        u8 cc;
+
+        switch (expr->tag) {
+        case AstTag_RelEquOp:
+            opd_type = Jit_EqualityType(expr);
+            cc = CC_E;
+            break;
+
+        case AstTag_RelNeqOp:
+            opd_type = Jit_EqualityType(expr);
+            cc = CC_NE;
+            break;
+
+        case AstTag_RelLtOp: cc = CC_L; break;
+        case AstTag_RelLteOp: cc = CC_LE; break;
+        case AstTag_RelGtOp: cc = CC_G; break;
+        default: cc = CC_GE; break;
+        }
+
+        /* cmp rax, rcx; setcc al; movzx eax, al */
+        return Jit_EmitOperands(code, expr, opd_type) &&
+            EMIT(code, 0x48, 0x39, 0xC8) &&
+            EMIT(code, 0x0F, (u8)(cc + 0x10), 0xC0) &&
+            EMIT(code, 0x0F, 0xB6, 0xC0);
+    }
+
+    case AstTag_BinAddOp:
+        /* add rax, rcx; jo bailout */
+        return Jit_EmitOperands(code, expr, JitType_Num) &&
+            EMIT(code, 0x48, 0x01, 0xC8) &&
+            Jit_EmitJccBack(code, CC_O, BAILOUT_OFF);
+
+    case AstTag_BinSubOp:
+        /* sub rax, rcx; jo bailout */
+        return Jit_EmitOperands(code, expr, JitType_Num) &&
+            EMIT(code, 0x48, 0x29, 0xC8) &&
+            Jit_EmitJccBack(code, CC_O, BAILOUT_OFF);
+
+    case AstTag_BinMulOp:
+        /* imul rax, rcx; jo bailout */
+        return Jit_EmitOperands(code, expr, JitType_Num) &&
+            EMIT(code, 0x48, 0x0F, 0xAF, 0xC1) &&
+            Jit_EmitJccBack(code, CC_O, BAILOUT_OFF);
+
+    case AstTag_BinDivOp:
+    case AstTag_BinModOp:
+        /* test rcx, rcx; je bailout; cmp rcx, -1; je bailout; cqo;
+           idiv rcx */
+        if (Jit_EmitOperands(code, expr, JitType_Num) == false ||
+            EMIT(code, 0x48, 0x85, 0xC9) == false ||
+            Jit_EmitJccBack(code, CC_E, BAILOUT_OFF) == false ||
+            EMIT(code, 0x48, 0x83, 0xF9, 0xFF) == false ||
+            Jit_EmitJccBack(code, CC_E, BAILOUT_OFF) == false ||
+            EMIT(code, 0x48, 0x99, 0x48, 0xF7, 0xF9) == false) {
+
+            return false;
+        }
+
+        /* mov rax, rdx */
+        return expr->tag == AstTag_BinDivOp ||
+            EMIT(code, 0x48, 0x89, 0xD0);
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Emits the whole function: the bailout stub, the prologue, the
+ *        expression and the store of its value.
+ *
+ * @param entry Receives the offset of the entry point.
+ */
+static
+bool
+Jit_EmitFunc(
+    FlexBuf * code,
+    AstNode * expr,
+    usize * entry
+) {
+    JitType type = Jit_StaticType(expr);
+
+    /* Bailout: lea rsp, [rbp - 24]; pop r13; pop r12; pop rbx; pop rbp;
+       xor eax, eax; ret */
+    if (EMIT(code, 0x48, 0x8D, 0x65, 0xE8,
+            0x41, 0x5D, 0x41, 0x5C, 0x5B, 0x5D,
+            0x31, 0xC0, 0xC3) == false) {
+
+        return false;
+    }
+
+    *entry = FlexBuf_Size(code);
+
+    /* push rbp; mov rbp, rsp; push rbx; push r12; push r13;
+       mov rbx, rdi; mov r12, rsi; mov r13, rdx */
+    if (EMIT(code, 0x55, 0x48, 0x89, 0xE5,
+            0x53, 0x41, 0x54, 0x41, 0x55,
+            0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4, 0x49, 0x89, 0xD5) == false ||
+        Jit_EmitExpr(code, expr, type) == false) {
+
+        return false;
+    }
+
+    /* mov dword [r13 + tag], tag; mov [r13 + ext], rax; mov eax, 1;
+       lea rsp, [rbp - 24]; pop r13; pop r12; pop rbx; pop rbp; ret */
+    return EMIT(code, 0x41, 0xC7, 0x45, (u8)offsetof(Value, tag)) &&
+        Jit_Emit32(code, type == JitType_Bool ? ValTag_Bool : ValTag_Num) &&
+        EMIT(code, 0x49, 0x89, 0x45, (u8)offsetof(Value, ext)) &&
+        EMIT(code, 0xB8, 0x01, 0x00, 0x00, 0x00) &&
+        EMIT(code, 0x48, 0x8D, 0x65, 0xE8,
+            0x41, 0x5D, 0x41, 0x5C, 0x5B, 0x5D, 0xC3);
+}
+
+/**
+ * @brief Copies code into executable memory, keeping the pages either
+ *        writable or executable but never both.
+ */
+static
+u8 *
+Jit_Install(
+    Jit * jit,
+    FlexBuf * code
+) {
+    JitPage * buf_pages = (JitPage *)FlexBuf_Data(jit->pages);
+    usize num_pages = FlexBuf_Size(jit->pages) / sizeof(JitPage);
+    usize len = FlexBuf_Size(code);
+    JitPage * page = NULL;
+
+    if (num_pages != 0 &&
+        buf_pages[num_pages - 1].cap - buf_pages[num_pages - 1].used >= len) {
+
+        page = buf_pages + num_pages - 1;
+    }
+
+    if (page == NULL) {
+        JitPage new_page;
+
+        new_page.cap = len > JIT_PAGE_SIZE ? len : JIT_PAGE_SIZE;
+        new_page.used = 0;
+        new_page.base = (u8 *)mmap(NULL, new_page.cap,
+            PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (new_page.base == MAP_FAILED) {
+            return NULL;
+        }
+
+        if (FlexBuf_PushBuf(jit->pages, &new_page, sizeof(JitPage)) == false) {
+            munmap(new_page.base, new_page.cap);
+            return NULL;
+        }
+
+        page = (JitPage *)FlexBuf_Data(jit->pages) + num_pages;
+    } else if (mprotect(page->base, page->cap,
+        PROT_READ | PROT_WRITE) != 0) {
+
+        return NULL;
+    }
+
+    u8 * dst = page->base + page->used;
+
+    memcpy(dst, FlexBuf_Data(code), len);
+
+    /* Keep the next function 16 bytes aligned. */
+    page->used += (len + 15) & ~(usize)15;
+    if (page->used > page->cap) {
+        page->used = page->cap;
+    }
+
+    if (mprotect(page->base, page->cap, PROT_READ | PROT_EXEC) != 0) {
+        return NULL;
+    }
+
+    return dst;
+}
+
+#endif
+
+/**
+ * @brief Compiles a root expression by stitching together the machine code
+ *        templates of its nodes.
+ *
+ * Operands are evaluated into `rax` with intermediate values on the native
+ * stack. Variables are loaded behind a type guard, and overflow, division by
+ * zero and the `INT_MIN / -1` quotient jump to a bailout stub, so that the
+ * interpreter produces the exact result or error instead.
+ *
+ * @param jit A pointer to the JIT.
+ * @param expr A pointer to the resolved expression, which must satisfy
+ *             `Jit_Compilable`.
+ *
+ * @return The compiled function, or `NULL` if the expression cannot be
+ *         compiled or memory allocation fails.
+ */
+JitFn
+Jit_Compile(
+    Jit * jit,
+    AstNode * expr
+) {
+#if ME_JIT_ENABLED
+    JitFn fn = NULL;
+
+    if (Jit_Compilable(expr) == false) {
+        goto Exit;
+    }
+
+    FlexBuf * code = FlexBuf_New();
+    if (code == NULL) {
+        goto Exit;
+    }
+
+    usize entry;
+
+    if (Jit_EmitFunc(code, expr, &entry) == false) {
+        goto FreeCode;
+    }
+
+    u8 * base = Jit_Install(jit, code);
+    if (base == NULL) {
+        goto FreeCode;
+    }
+
+    fn = (JitFn)(void *)(base + entry);
+
+FreeCode:
+    FlexBuf_Free(code);
+
+Exit:
+    return fn;
+#else
+    (void)jit;
+    (void)expr;
+
+    return NULL;
+#endif
+}
+
+/**
+ * @brief Unmaps all compiled code, invalidating every `JitFn` returned so far.
+ */
+void
+Jit_Reset(
+    Jit * jit
+) {
+#if ME_JIT_ENABLED
+    JitPage * buf_pages = (JitPage *)FlexBuf_Data(jit->pages);
+    usize num_pages = FlexBuf_Size(jit->pages) / sizeof(JitPage);
+
+    for (usize i = 0; i < num_pages; i++) {
+        munmap(buf_pages[i].base, buf_pages[i].cap);
+    }
+#endif
+
+    FlexBuf_Clear(jit->pages);
+}
+
+void
+Jit_Free(
+    Jit * jit
+) {
+    Jit_Reset(jit);
+    FlexBuf_Free(jit->pages);
+    MeMem_Free(jit);
+}
\ No newline at end of file
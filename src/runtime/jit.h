@@ -0,0 +1,48 @@
+#ifndef __ME_RUNTIME_JIT_H__
+#define __ME_RUNTIME_JIT_H__
+
+#include "menos.h"
+#include "parser/ast.h"
+#include "value.h"
+
+/**
+ * Compiled root expression.
+ *
+ * Returns `true` with the result stored in `out`, or `false` if a guard fails
+ * and the expression has to be evaluated by the interpreter instead. The
+ * compiled expressions have no side effects, so bailing out is always safe.
+ */
+typedef bool (* JitFn)(
+    Value * locals,
+    Value * globals,
+    Value * out
+);
+
+/* Executable memory holding the compiled expressions of a program. */
+typedef struct _Jit Jit;
+
+Jit *
+Jit_New(void);
+
+bool
+Jit_Compilable(
+    AstNode * expr
+);
+
+JitFn
+Jit_Compile(
+    Jit * jit,
+    AstNode * expr
+);
+
+void
+Jit_Reset(
+    Jit * jit
+);
+
+void
+Jit_Free(
+    Jit * jit
+);
+
+#endif
\ No newline at end of file
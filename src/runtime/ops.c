@@ -0,0 +1,462 @@
+#include "ops.h"
+
+/**
+ * @brief Raises an integer to a power by repeated squaring.
+ *
+ * @return `true` on success, `false` if the result does not fit in `ssize`.
+ */
+static
+bool
+PowNum(
+    ssize base,
+    ssize exp,
+    ssize * res
+) {
+    if (exp < 0) {
+        if (base == 1) {
+            *res = 1;
+        } else if (base == -1) {
+            *res = (exp & 1) ? -1 : 1;
+        } else {
+            *res = 0;
+        }
+
+        return true;
+    }
+
+    ssize acc = 1;
+    ssize cur = base;
+    ssize rem = exp;
+
+    while (true) {
+        if ((rem & 1) &&
+            __builtin_mul_overflow(acc, cur, &acc)) {
+
+            return false;
+        }
+
+        rem >>= 1;
+        if (rem == 0) {
+            break;
+        }
+
+        if (__builtin_mul_overflow(cur, cur, &cur)) {
+            return false;
+        }
+    }
+
+    *res = acc;
+
+    return true;
+}
+
+static
+InterpErr
+Ops_BigPow(
+    BigInt * base,
+    BigInt * exp,
+    Value * out
+) {
+    ssize small_base = 0;
+    ssize small_exp;
+    bool is_small = BigInt_ToSsize(base, &small_base);
+
+    if (is_small &&
+        (small_base == 1 || small_base == -1)) {
+
+        Value_InitNum(out, small_base == -1 && BigInt_IsOdd(exp) ? -1 : 1);
+        return InterpErr_Ok;
+    }
+
+    if (BigInt_IsNeg(exp)) {
+        Value_InitNum(out, 0);
+        return InterpErr_Ok;
+    }
+
+    if (BigInt_ToSsize(exp, &small_exp) == false) {
+        if (is_small && small_base == 0) {
+            Value_InitNum(out, 0);
+            return InterpErr_Ok;
+        }
+
+        /* The result could not be held in memory anyway. */
+        return InterpErr_NoEnoughMemory;
+    }
+
+    BigInt * res = BigInt_Pow(base, (usize)small_exp);
+    if (res == NULL) {
+        return InterpErr_NoEnoughMemory;
+    }
+
+    Value_InitBig(out, res);
+
+    return InterpErr_Ok;
+}
+
+/**
+ * @brief Applies a binary operator to integers that do not both fit in
+ *        `ssize`, or whose result does not.
+ */
+static
+InterpErr
+Ops_Big(
+    AstTag tag,
+    BigInt * lhs,
+    BigInt * rhs,
+    Value * out
+) {
+    BigInt * res = NULL;
+    ssize num;
+
+    switch (tag) {
+    case AstTag_RelLtOp:
+        Value_InitBool(out, BigInt_Compare(lhs, rhs) < 0);
+        return InterpErr_Ok;
+
+    case AstTag_RelLteOp:
+        Value_InitBool(out, BigInt_Compare(lhs, rhs) <= 0);
+        return InterpErr_Ok;
+
+    case AstTag_RelGtOp:
+        Value_InitBool(out, BigInt_Compare(lhs, rhs) > 0);
+        return InterpErr_Ok;
+
+    case AstTag_RelGteOp:
+        Value_InitBool(out, BigInt_Compare(lhs, rhs) >= 0);
+        return InterpErr_Ok;
+
+    case AstTag_BinAddOp:
+        res = BigInt_Add(lhs, rhs);
+        break;
+
+    case AstTag_BinSubOp:
+        res = BigInt_Sub(lhs, rhs);
+        break;
+
+    case AstTag_BinMulOp:
+        res = BigInt_Mul(lhs, rhs);
+        break;
+
+    case AstTag_BinDivOp:
+    case AstTag_BinModOp:
+        if (BigInt_ToSsize(rhs, &num) &&
+            num == 0) {
+
+            return InterpErr_DivisionByZero;
+        }
+
+        if (BigInt_DivMod(lhs, rhs,
+            tag == AstTag_BinDivOp ? &res : NULL,
+            tag == AstTag_BinModOp ? &res : NULL) == false) {
+
+            return InterpErr_NoEnoughMemory;
+        }
+
+        break;
+
+    case AstTag_BinExpOp:
+        return Ops_BigPow(lhs, rhs, out);
+
+    default:
+        return InterpErr_TypeMismatch;
+    }
+
+    if (res == NULL) {
+        return InterpErr_NoEnoughMemory;
+    }
+
+    Value_InitBig(out, res);
+
+    return InterpErr_Ok;
+}
+
+/**
+ * @brief Redoes an operation on inline integers with big integers, once it
+ *        is known to overflow.
+ */
+static
+InterpErr
+Ops_Promote(
+    AstTag tag,
+    ssize lhs,
+    ssize rhs,
+    Value * out
+) {
+    InterpErr err = InterpErr_NoEnoughMemory;
+
+    BigInt * big_lhs = BigInt_NewFromSsize(lhs);
+    if (big_lhs == NULL) {
+        goto Exit;
+    }
+
+    BigInt * big_rhs = BigInt_NewFromSsize(rhs);
+    if (big_rhs == NULL) {
+        goto FreeLhs;
+    }
+
+    err = Ops_Big(tag, big_lhs, big_rhs, out);
+
+    BigInt_Free(big_rhs);
+
+FreeLhs:
+    BigInt_Free(big_lhs);
+
+Exit:
+    return err;
+}
+
+static
+InterpErr
+Ops_Num(
+    AstTag tag,
+    ssize lhs,
+    ssize rhs,
+    Value * out
+) {
+    ssize res;
+
+    switch (tag) {
+    case AstTag_RelLtOp: Value_InitBool(out, lhs < rhs); return InterpErr_Ok;
+    case AstTag_RelLteOp: Value_InitBool(out, lhs <= rhs); return InterpErr_Ok;
+    case AstTag_RelGtOp: Value_InitBool(out, lhs > rhs); return InterpErr_Ok;
+    case AstTag_RelGteOp: Value_InitBool(out, lhs >= rhs); return InterpErr_Ok;
+
+    case AstTag_BinAddOp:
+        if (__builtin_add_overflow(lhs, rhs, &res)) {
+            return Ops_Promote(tag, lhs, rhs, out);
+        }
+
+        Value_InitNum(out, res);
+        return InterpErr_Ok;
+
+    case AstTag_BinSubOp:
+        if (__builtin_sub_overflow(lhs, rhs, &res)) {
+            return Ops_Promote(tag, lhs, rhs, out);
+        }
+
+        Value_InitNum(out, res);
+        return InterpErr_Ok;
+
+    case AstTag_BinMulOp:
+        if (__builtin_mul_overflow(lhs, rhs, &res)) {
+            return Ops_Promote(tag, lhs, rhs, out);
+        }
+
+        Value_InitNum(out, res);
+        return InterpErr_Ok;
+
+    case AstTag_BinDivOp:
+    case AstTag_BinModOp:
+        if (rhs == 0) {
+            return InterpErr_DivisionByZero;
+        }
+
+        /* The only quotient that does not fit. */
+        if (rhs == -1) {
+            if (tag == AstTag_BinModOp) {
+                Value_InitNum(out, 0);
+                return InterpErr_Ok;
+            }
+
+            if (__builtin_sub_overflow(0, lhs, &res)) {
+                return Ops_Promote(tag, lhs, rhs, out);
+            }
+
+            Value_InitNum(out, res);
+            return InterpErr_Ok;
+        }
+
+        Value_InitNum(out, tag == AstTag_BinDivOp ? lhs / rhs : lhs % rhs);
+        return InterpErr_Ok;
+
+    case AstTag_BinExpOp:
+        if (PowNum(lhs, rhs, &res) == false) {
+            return Ops_Promote(tag, lhs, rhs, out);
+        }
+
+        Value_InitNum(out, res);
+        return InterpErr_Ok;
+
+    default:
+        return InterpErr_TypeMismatch;
+    }
+}
+
+static
+bool
+IsNumeric(
+    Value * val
+) {
+    return val->tag == ValTag_Num || val->tag == ValTag_Big;
+}
+
+/**
+ * @brief Applies a binary operator to integers, at least one of which is big.
+ */
+static
+InterpErr
+Ops_Mixed(
+    AstTag tag,
+    Value * lhs,
+    Value * rhs,
+    Value * out
+) {
+    InterpErr err = InterpErr_NoEnoughMemory;
+    BigInt * tmp_lhs = NULL;
+    BigInt * tmp_rhs = NULL;
+
+    if (lhs->tag == ValTag_Num &&
+        (tmp_lhs = BigInt_NewFromSsize(lhs->ext.num), tmp_lhs == NULL)) {
+
+        goto Exit;
+    }
+
+    if (rhs->tag == ValTag_Num &&
+        (tmp_rhs = BigInt_NewFromSsize(rhs->ext.num), tmp_rhs == NULL)) {
+
+        goto FreeTemps;
+    }
+
+    err = Ops_Big(tag,
+        tmp_lhs != NULL ? tmp_lhs : lhs->ext.big,
+        tmp_rhs != NULL ? tmp_rhs : rhs->ext.big, out);
+
+FreeTemps:
+    if (tmp_lhs != NULL) {
+        BigInt_Free(tmp_lhs);
+    }
+
+    if (tmp_rhs != NULL) {
+        BigInt_Free(tmp_rhs);
+    }
+
+Exit:
+    return err;
+}
+
+/**
+ * @brief Applies a unary operator to a value in place.
+ *
+ * @param tag `AstTag_LogNotOp`, `AstTag_UnaPlusOp` or `AstTag_UnaMinusOp`.
+ * @param val A pointer to the operand, which receives the result. It is left
+ *            untouched on error.
+ *
+ * @return `InterpErr_Ok` on success, or the error to be reported.
+ */
+InterpErr
+Ops_Unary(
+    AstTag tag,
+    Value * val
+) {
+    if (tag == AstTag_LogNotOp) {
+        if (val->tag != ValTag_Bool) {
+            return InterpErr_TypeMismatch;
+        }
+
+        val->ext.val = val->ext.val == false;
+
+        return InterpErr_Ok;
+    }
+
+    if (IsNumeric(val) == false) {
+        return InterpErr_TypeMismatch;
+    }
+
+    if (tag != AstTag_UnaMinusOp) {
+        return InterpErr_Ok;
+    }
+
+    ssize num;
+
+    if (val->tag == ValTag_Num &&
+        __builtin_sub_overflow(0, val->ext.num, &num) == false) {
+
+        val->ext.num = num;
+        return InterpErr_Ok;
+    }
+
+    /* Either a big integer or the negation of the smallest inline one. */
+    BigInt * big = val->tag == ValTag_Big ?
+        val->ext.big : BigInt_NewFromSsize(val->ext.num);
+    if (big == NULL) {
+        return InterpErr_NoEnoughMemory;
+    }
+
+    BigInt * neg = BigInt_Neg(big);
+
+    if (val->tag == ValTag_Num) {
+        BigInt_Free(big);
+    }
+
+    if (neg == NULL) {
+        return InterpErr_NoEnoughMemory;
+    }
+
+    Value_Release(val);
+    Value_InitBig(val, neg);
+
+    return InterpErr_Ok;
+}
+
+/**
+ * @brief Applies a binary operator other than `and` and `or`, which are
+ *        short-circuited by the caller.
+ *
+ * Integers are computed inline with overflow checks and promoted to big
+ * integers when a result does not fit. `+` also concatenates strings, and
+ * `==` and `!=` compare values of any type.
+ *
+ * @param gc A pointer to the heap receiving new strings.
+ * @param tag The tag of the operator node.
+ * @param lhs A pointer to the left operand, borrowed.
+ * @param rhs A pointer to the right operand, borrowed.
+ * @param out A pointer to the value receiving the result.
+ *
+ * @return `InterpErr_Ok` on success, or the error to be reported.
+ */
+InterpErr
+Ops_Binary(
+    Gc * gc,
+    AstTag tag,
+    Value * lhs,
+    Value * rhs,
+    Value * out
+) {
+    if (tag == AstTag_RelEquOp) {
+        Value_InitBool(out, Value_Equals(lhs, rhs));
+        return InterpErr_Ok;
+    }
+
+    if (tag == AstTag_RelNeqOp) {
+        Value_InitBool(out, Value_Equals(lhs, rhs) == false);
+        return InterpErr_Ok;
+    }
+
+    if (lhs->tag == ValTag_Num &&
+        rhs->tag == ValTag_Num) {
+
+        return Ops_Num(tag, lhs->ext.num, rhs->ext.num, out);
+    }
+
+    if (IsNumeric(lhs) &&
+        IsNumeric(rhs)) {
+
+        return Ops_Mixed(tag, lhs, rhs, out);
+    }
+
+    if (tag == AstTag_BinAddOp &&
+        lhs->tag == ValTag_Str &&
+        rhs->tag == ValTag_Str) {
+
+        StrObj * str = StrObj_Join(gc, lhs->ext.str, rhs->ext.str);
+        if (str == NULL) {
+            return InterpErr_NoEnoughMemory;
+        }
+
+        Value_InitStr(out, str);
+
+        return InterpErr_Ok;
+    }
+
+    return InterpErr_TypeMismatch;
+}
\ No newline at end of file
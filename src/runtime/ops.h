@@ -0,0 +1,24 @@
+#ifndef __ME_RUNTIME_OPS_H__
+#define __ME_RUNTIME_OPS_H__
+
+#include "menos.h"
+#include "parser/ast.h"
+#include "interp.h"
+#include "value.h"
+
+InterpErr
+Ops_Unary(
+    AstTag tag,
+    Value * val
+);
+
+InterpErr
+Ops_Binary(
+    Gc * gc,
+    AstTag tag,
+    Value * lhs,
+    Value * rhs,
+    Value * out
+);
+
+#endif
\ No newline at end of file
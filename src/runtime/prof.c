@@ -0,0 +1,390 @@
+#define _GNU_SOURCE
+
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "prof.h"
+#include "config.h"
+#include "memory/allocate.h"
+#include "util/fixed_buf.h"
+
+/* Older C libraries lack the name of the thread a timer signals. */
+#if defined(SIGEV_THREAD_ID) && !defined(sigev_notify_thread_id)
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+/* Locations kept for all samples, enough for an average depth of 4. */
+#define PROF_MAX_LOCS       (ME_PROF_MAX_SAMPLES * 4)
+
+typedef struct _ProfSample {
+    usize first;
+    usize num;
+} ProfSample;
+
+typedef struct _Prof {
+    Interp * interp;
+    timer_t timer;
+    bool running;
+
+    /* Appended to by the signal handler while running, the locations of
+       each sample are innermost first. */
+    ProfSample * samples;
+    usize num_samples;
+    InterpLoc * locs;
+    usize num_locs;
+    u64 dropped;
+} Prof;
+
+/* Folded stack of a sample. */
+typedef struct _ProfLine {
+    const u8 * str;
+    usize off;
+    usize len;
+} ProfLine;
+
+/* Profiler started on the current thread, read by the signal handler. */
+static
+_Thread_local Prof * volatile
+thread_prof = NULL;
+
+/**
+ * @brief Records where the interpreter is, called on the thread running it
+ *        whenever it has spent another period of CPU time.
+ *
+ * It neither allocates nor takes locks, samples past the capacity of the
+ * profiler are only counted.
+ */
+static
+void
+Prof_OnSignal(
+    int sig,
+    siginfo_t * info,
+    void * uctx
+) {
+    (void)sig;
+    (void)info;
+    (void)uctx;
+
+    Prof * prof = thread_prof;
+    if (prof == NULL) {
+        return;
+    }
+
+    if (prof->num_samples == ME_PROF_MAX_SAMPLES ||
+        PROF_MAX_LOCS - prof->num_locs < ME_PROF_MAX_DEPTH) {
+
+        prof->dropped++;
+        return;
+    }
+
+    usize num = Interp_Backtrace(prof->interp, prof->locs + prof->num_locs,
+        ME_PROF_MAX_DEPTH);
+
+    /* The interpreter is not running. */
+    if (num == 0) {
+        return;
+    }
+
+    prof->samples[prof->num_samples].first = prof->num_locs;
+    prof->samples[prof->num_samples].num = num;
+    prof->num_samples++;
+    prof->num_locs += num;
+}
+
+Prof *
+Prof_New(void) {
+    Prof * prof = (Prof *)MeMem_Malloc(sizeof(Prof));
+    if (prof == NULL) {
+        goto Exit;
+    }
+
+    prof->samples = (ProfSample *)MeMem_Malloc(
+        sizeof(ProfSample) * ME_PROF_MAX_SAMPLES);
+    if (prof->samples == NULL) {
+        goto FreeProf;
+    }
+
+    prof->locs = (InterpLoc *)MeMem_Malloc(sizeof(InterpLoc) * PROF_MAX_LOCS);
+    if (prof->locs == NULL) {
+        goto FreeSamples;
+    }
+
+    prof->interp = NULL;
+    prof->running = false;
+    prof->num_samples = 0;
+    prof->num_locs = 0;
+    prof->dropped = 0;
+
+    return prof;
+
+FreeSamples:
+    MeMem_Free(prof->samples);
+
+FreeProf:
+    MeMem_Free(prof);
+
+Exit:
+    return NULL;
+}
+
+/**
+ * @brief Starts sampling an interpreter run by the current thread.
+ *
+ * A timer on the CPU time of the thread raises `SIGPROF` `hz` times per
+ * second, so time the thread spends blocked is not sampled. Samples are
+ * added to those of earlier runs of the profiler. One profiler at a time
+ * may run on each thread.
+ *
+ * @param prof A pointer to the profiler.
+ * @param interp A pointer to the interpreter.
+ * @param hz The samples per second, `0` for `ME_PROF_HZ`.
+ *
+ * @return `true` on success, `false` if the profiler or another one is
+ *         already running on the thread, or the timer cannot be created.
+ */
+bool
+Prof_Start(
+    Prof * prof,
+    Interp * interp,
+    u32 hz
+) {
+#if defined(SIGEV_THREAD_ID)
+    if (prof->running || thread_prof != NULL) {
+        return false;
+    }
+
+    if (hz == 0) {
+        hz = ME_PROF_HZ;
+    }
+
+    struct sigaction act;
+
+    memset(&act, 0, sizeof(act));
+    act.sa_sigaction = Prof_OnSignal;
+    act.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&act.sa_mask);
+
+    if (sigaction(SIGPROF, &act, NULL) != 0) {
+        return false;
+    }
+
+    struct sigevent sev;
+
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = SIGPROF;
+    sev.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &prof->timer) != 0) {
+        return false;
+    }
+
+    prof->interp = interp;
+    thread_prof = prof;
+
+    u64 period_ns = 1000000000UL / hz;
+    struct itimerspec its;
+
+    its.it_interval.tv_sec = (time_t)(period_ns / 1000000000UL);
+    its.it_interval.tv_nsec = (long)(period_ns % 1000000000UL);
+    its.it_value = its.it_interval;
+
+    if (timer_settime(prof->timer, 0, &its, NULL) != 0) {
+        thread_prof = NULL;
+        timer_delete(prof->timer);
+        return false;
+    }
+
+    prof->running = true;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Stops sampling, it must be called on the thread that started the
+ *        profiler.
+ */
+void
+Prof_Stop(
+    Prof * prof
+) {
+    if (prof->running == false) {
+        return;
+    }
+
+    /* A signal still pending once the timer is gone finds no profiler. */
+    thread_prof = NULL;
+    atomic_signal_fence(memory_order_seq_cst);
+
+    timer_delete(prof->timer);
+    prof->running = false;
+}
+
+usize
+Prof_NumSamples(
+    Prof * prof
+) {
+    return prof->num_samples;
+}
+
+/**
+ * @brief Returns the number of samples lost because the profiler was full.
+ */
+u64
+Prof_NumDropped(
+    Prof * prof
+) {
+    return prof->dropped;
+}
+
+static
+bool
+Prof_PushLoc(
+    FlexBuf * buf,
+    const InterpLoc * loc
+) {
+    AstNode * node = loc->stmt != NULL ? loc->stmt : loc->func;
+
+    if (loc->func != NULL) {
+        FixedBuf * name = loc->func->ext.func_def.name;
+
+        if (FlexBuf_PushBuf(buf, FixedBuf_Data(name),
+            FixedBuf_Size(name)) == false) {
+
+            return false;
+        }
+    } else if (FlexBuf_PushStr(buf, "(top)") == false) {
+        return false;
+    }
+
+    return FlexBuf_PushByte(buf, ':') &&
+        FlexBuf_PushUInt(buf, (u64)node->row + 1) &&
+        FlexBuf_PushByte(buf, ':') &&
+        FlexBuf_PushUInt(buf, (u64)node->col + 1);
+}
+
+static
+int
+ProfLine_Compare(
+    const void * lhs,
+    const void * rhs
+) {
+    const ProfLine * a = (const ProfLine *)lhs;
+    const ProfLine * b = (const ProfLine *)rhs;
+    int res = memcmp(a->str, b->str, a->len < b->len ? a->len : b->len);
+
+    if (res != 0) {
+        return res;
+    }
+
+    return (a->len > b->len) - (a->len < b->len);
+}
+
+/**
+ * @brief Appends the samples to a FlexBuf in the folded stack format of
+ *        flame graph tools, one line per distinct stack with its count.
+ *
+ * Frames run from the top level to the innermost call, separated by `;`.
+ * Each one is named after its function, or `(top)`, followed by the row
+ * and column of the statement it was executing.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+Prof_PushFolded(
+    Prof * prof,
+    FlexBuf * buf
+) {
+    bool res = false;
+
+    if (prof->num_samples == 0) {
+        return true;
+    }
+
+    FlexBuf * stacks = FlexBuf_New();
+    if (stacks == NULL) {
+        goto Exit;
+    }
+
+    ProfLine * lines = (ProfLine *)MeMem_Malloc(
+        sizeof(ProfLine) * prof->num_samples);
+    if (lines == NULL) {
+        goto FreeStacks;
+    }
+
+    for (usize i = 0; i < prof->num_samples; i++) {
+        const ProfSample * sample = prof->samples + i;
+        const InterpLoc * locs = prof->locs + sample->first;
+
+        lines[i].off = FlexBuf_Size(stacks);
+
+        for (usize j = sample->num; j > 0; j--) {
+            if (j != sample->num && FlexBuf_PushByte(stacks, ';') == false) {
+                goto FreeLines;
+            }
+
+            if (Prof_PushLoc(stacks, locs + j - 1) == false) {
+                goto FreeLines;
+            }
+        }
+
+        lines[i].len = FlexBuf_Size(stacks) - lines[i].off;
+    }
+
+    /* The stacks no longer move once all are written. */
+    for (usize i = 0; i < prof->num_samples; i++) {
+        lines[i].str = FlexBuf_Data(stacks) + lines[i].off;
+    }
+
+    qsort(lines, prof->num_samples, sizeof(ProfLine), ProfLine_Compare);
+
+    for (usize i = 0; i < prof->num_samples;) {
+        usize end = i + 1;
+
+        while (end < prof->num_samples &&
+            ProfLine_Compare(lines + i, lines + end) == 0) {
+
+            end++;
+        }
+
+        if (FlexBuf_PushBuf(buf, lines[i].str, lines[i].len) == false ||
+            FlexBuf_PushByte(buf, ' ') == false ||
+            FlexBuf_PushUInt(buf, (u64)(end - i)) == false ||
+            FlexBuf_PushByte(buf, '\n') == false) {
+
+            goto FreeLines;
+        }
+
+        i = end;
+    }
+
+    res = true;
+
+FreeLines:
+    MeMem_Free(lines);
+
+FreeStacks:
+    FlexBuf_Free(stacks);
+
+Exit:
+    return res;
+}
+
+void
+Prof_Free(
+    Prof * prof
+) {
+    Prof_Stop(prof);
+
+    MeMem_Free(prof->locs);
+    MeMem_Free(prof->samples);
+    MeMem_Free(prof);
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef __ME_RUNTIME_PROF_H__
+#define __ME_RUNTIME_PROF_H__
+
+#include "menos.h"
+#include "interp.h"
+#include "util/flex_buf.h"
+
+/* Sampling profiler of the statements an interpreter executes. */
+typedef struct _Prof Prof;
+
+Prof *
+Prof_New(void);
+
+bool
+Prof_Start(
+    Prof * prof,
+    Interp * interp,
+    u32 hz
+);
+
+void
+Prof_Stop(
+    Prof * prof
+);
+
+usize
+Prof_NumSamples(
+    Prof * prof
+);
+
+u64
+Prof_NumDropped(
+    Prof * prof
+);
+
+bool
+Prof_PushFolded(
+    Prof * prof,
+    FlexBuf * buf
+);
+
+void
+Prof_Free(
+    Prof * prof
+);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include <string.h>
+
+#include "snapshot.h"
+#include "memory/allocate.h"
+#include "parser/ast_img.h"
+#include "util/flex_buf.h"
+#include "util/hash.h"
+#include "util/map_file.h"
+
+/* Layout: `SnapHdr`, the image of the program, then the globals. */
+typedef struct _SnapHdr {
+    u8 magic[8];
+
+    /* Fingerprint of the image layout, see `AstImg_Fingerprint`. */
+    u64 fingerprint;
+
+    u64 img_size;
+    u64 globs_size;
+
+    /* Hash of everything after the header. */
+    u64 hash;
+} SnapHdr;
+
+static const u8 SNAP_MAGIC[8] = { 'M', 'E', 'S', 'N', 'A', 'P', '0', '1' };
+
+typedef struct _Snapshot {
+
+    /* Mapping of the file, holding the globals. */
+    MapFile * map;
+
+    AstNode * tree;
+    InterpProg * prog;
+
+    const u8 * globs;
+    usize globs_size;
+} Snapshot;
+
+/**
+ * @brief Saves the program and the global variables of an interpreter.
+ *
+ * The file is replaced atomically, so interpreters may restore from it
+ * while it is saved again.
+ *
+ * @param interp A pointer to the interpreter, with a program loaded and
+ *               typically run to initialize the globals.
+ * @param path The path of the file.
+ *
+ * @return `true` on success, `false` if no program is loaded, memory
+ *         allocation fails or the file cannot be written.
+ */
+bool
+Snapshot_Save(
+    Interp * interp,
+    const char * path
+) {
+    AstNode * tree = Interp_Program(interp);
+    bool res = false;
+    SnapHdr hdr;
+
+    if (tree == NULL) {
+        goto Exit;
+    }
+
+    FlexBuf * buf = FlexBuf_New();
+    if (buf == NULL) {
+        goto Exit;
+    }
+
+    memset(&hdr, 0, sizeof(SnapHdr));
+
+    if (FlexBuf_PushBuf(buf, &hdr, sizeof(SnapHdr)) == false ||
+        AstImg_Push(tree, buf) == false) {
+
+        goto FreeBuf;
+    }
+
+    usize img_end = FlexBuf_Size(buf);
+
+    if (Interp_PushGlobals(interp, buf) == false) {
+        goto FreeBuf;
+    }
+
+    u8 * data = FlexBuf_Data(buf);
+    usize size = FlexBuf_Size(buf);
+
+    memcpy(hdr.magic, SNAP_MAGIC, sizeof(SNAP_MAGIC));
+    hdr.fingerprint = AstImg_Fingerprint();
+    hdr.img_size = img_end - sizeof(SnapHdr);
+    hdr.globs_size = size - img_end;
+    hdr.hash = Hash_Fnv1aWords(data + sizeof(SnapHdr),
+        size - sizeof(SnapHdr));
+
+    memcpy(data, &hdr, sizeof(SnapHdr));
+
+    res = MapFile_WriteAtomic(path, data, size);
+
+FreeBuf:
+    FlexBuf_Free(buf);
+
+Exit:
+    return res;
+}
+
+/**
+ * @brief Loads a snapshot and compiles its program, once for any number of
+ *        interpreters to restore from.
+ *
+ * The file is mapped rather than read, the program is built from its image
+ * in a single pass and the globals are only read when restored.
+ *
+ * @return A pointer to the snapshot, or `NULL` if the file cannot be read,
+ *         was saved by an incompatible build, is damaged, or memory
+ *         allocation fails.
+ */
+Snapshot *
+Snapshot_Load(
+    const char * path
+) {
+    SnapHdr hdr;
+
+    Snapshot * snap = (Snapshot *)MeMem_Malloc(sizeof(Snapshot));
+    if (snap == NULL) {
+        goto Exit;
+    }
+
+    snap->tree = NULL;
+
+    snap->map = MapFile_Open(path);
+    if (snap->map == NULL) {
+        goto FreeSnap;
+    }
+
+    const u8 * data = MapFile_Data(snap->map);
+    usize size = MapFile_Size(snap->map);
+
+    if (size < sizeof(SnapHdr)) {
+        goto CloseMap;
+    }
+
+    memcpy(&hdr, data, sizeof(SnapHdr));
+
+    usize rest = size - sizeof(SnapHdr);
+
+    if (memcmp(hdr.magic, SNAP_MAGIC, sizeof(SNAP_MAGIC)) != 0 ||
+        hdr.fingerprint != AstImg_Fingerprint() ||
+        hdr.img_size > rest ||
+        hdr.globs_size != rest - hdr.img_size ||
+        hdr.hash != Hash_Fnv1aWords(data + sizeof(SnapHdr), rest)) {
+
+        goto CloseMap;
+    }
+
+    if (AstImg_Load(data + sizeof(SnapHdr), (usize)hdr.img_size,
+            &snap->tree) == false) {
+
+        goto CloseMap;
+    }
+
+    snap->prog = InterpProg_New();
+    if (snap->prog == NULL) {
+        goto FreeTree;
+    }
+
+    if (InterpProg_Compile(snap->prog, snap->tree) == false) {
+        goto FreeProg;
+    }
+
+    snap->globs = data + sizeof(SnapHdr) + hdr.img_size;
+    snap->globs_size = (usize)hdr.globs_size;
+
+    return snap;
+
+FreeProg:
+    InterpProg_Free(snap->prog);
+
+FreeTree:
+    AstNode_FreeTree(snap->tree);
+
+CloseMap:
+    MapFile_Close(snap->map);
+
+FreeSnap:
+    MeMem_Free(snap);
+
+Exit:
+    return NULL;
+}
+
+/**
+ * @brief Returns the compiled program of a snapshot, for interpreters that
+ *        start without the saved globals.
+ */
+const InterpProg *
+Snapshot_Prog(
+    Snapshot * snap
+) {
+    return snap->prog;
+}
+
+/**
+ * @brief Loads the program of a snapshot into an interpreter and sets its
+ *        globals to the saved values.
+ *
+ * Interpreters restored from the same snapshot share the program, as with
+ * `Interp_LoadProg`, and may run on their own threads.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+Snapshot_Restore(
+    Snapshot * snap,
+    Interp * interp
+) {
+    return Interp_LoadProg(interp, snap->prog) &&
+        Interp_LoadGlobals(interp, snap->globs, snap->globs_size);
+}
+
+/**
+ * @brief Frees a snapshot, after every interpreter restored from it has been
+ *        reset or freed.
+ */
+void
+Snapshot_Free(
+    Snapshot * snap
+) {
+    InterpProg_Free(snap->prog);
+    AstNode_FreeTree(snap->tree);
+    MapFile_Close(snap->map);
+    MeMem_Free(snap);
+}
\ No newline at end of file
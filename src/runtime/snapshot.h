@@ -0,0 +1,38 @@
+#ifndef __ME_RUNTIME_SNAPSHOT_H__
+#define __ME_RUNTIME_SNAPSHOT_H__
+
+#include "menos.h"
+#include "interp.h"
+
+/* Initialized program and globals saved to a file, restored into new
+   interpreters without parsing or running the initialization again. */
+typedef struct _Snapshot Snapshot;
+
+bool
+Snapshot_Save(
+    Interp * interp,
+    const char * path
+);
+
+Snapshot *
+Snapshot_Load(
+    const char * path
+);
+
+const InterpProg *
+Snapshot_Prog(
+    Snapshot * snap
+);
+
+bool
+Snapshot_Restore(
+    Snapshot * snap,
+    Interp * interp
+);
+
+void
+Snapshot_Free(
+    Snapshot * snap
+);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,510 @@
+#include <string.h>
+
+#include "str_obj.h"
+#include "config.h"
+
+typedef enum _StrKind {
+    StrKind_Flat,
+    StrKind_Rope,
+
+    /* Rope whose bytes were copied to a flat string, its left side. */
+    StrKind_Flattened,
+} StrKind;
+
+typedef struct _StrObj {
+    usize len;
+    StrKind kind;
+} StrObj;
+
+typedef struct _StrFlat {
+    StrObj base;
+    u8 data[];
+} StrFlat;
+
+/* Concatenation of two strings, both longer than `ME_STR_LEAF_MAX` bytes
+   together. */
+typedef struct _StrRope {
+    StrObj base;
+    StrObj * left;
+    StrObj * right;
+} StrRope;
+
+/* Inline strings are tagged references, with the lowest bit set, the length
+   in the rest of the lowest byte and the bytes in the higher ones. Heap
+   strings are aligned, so their lowest bit is clear. */
+#define STR_INLINE_TAG ((uintptr_t)1)
+
+static
+void
+StrRope_Trace(
+    Gc * gc,
+    void * obj,
+    usize size,
+    GcVisitFn visit
+) {
+    StrRope * rope = (StrRope *)obj;
+
+    (void)size;
+
+    if (StrObj_IsInline(rope->left) == false) {
+        visit(gc, (void **)&rope->left);
+    }
+
+    if (StrObj_IsInline(rope->right) == false) {
+        visit(gc, (void **)&rope->right);
+    }
+}
+
+/* Flat strings hold no references. */
+static
+const GcType
+str_flat_type = {
+    "string",
+    NULL,
+};
+
+static
+const GcType
+str_rope_type = {
+    "rope",
+    StrRope_Trace,
+};
+
+bool
+StrObj_IsInline(
+    StrObj * str
+) {
+    return ((uintptr_t)str & STR_INLINE_TAG) != 0;
+}
+
+static
+StrObj *
+StrObj_NewInline(
+    const u8 * buf,
+    usize len
+) {
+    uintptr_t bits = STR_INLINE_TAG | (uintptr_t)len << 1;
+
+    for (usize i = 0; i < len; i++) {
+        bits |= (uintptr_t)buf[i] << (8 * (i + 1));
+    }
+
+    return (StrObj *)bits;
+}
+
+static
+void
+StrObj_ReadInline(
+    StrObj * str,
+    u8 * dst
+) {
+    uintptr_t bits = (uintptr_t)str;
+    usize len = (bits & 0xff) >> 1;
+
+    for (usize i = 0; i < len; i++) {
+        dst[i] = (u8)(bits >> (8 * (i + 1)));
+    }
+}
+
+usize
+StrObj_Size(
+    StrObj * str
+) {
+    if (StrObj_IsInline(str)) {
+        return ((uintptr_t)str & 0xff) >> 1;
+    }
+
+    return str->len;
+}
+
+/**
+ * @brief Returns the flat string holding the bytes of a flattened rope, or
+ *        the string itself.
+ */
+static
+StrObj *
+StrObj_Resolve(
+    StrObj * str
+) {
+    if (StrObj_IsInline(str) == false &&
+        str->kind == StrKind_Flattened) {
+
+        return ((StrRope *)str)->left;
+    }
+
+    return str;
+}
+
+static
+bool
+StrObj_IsRope(
+    StrObj * str
+) {
+    return StrObj_IsInline(str) == false && str->kind == StrKind_Rope;
+}
+
+/**
+ * @brief Returns the bytes of a string that is not a rope, inline strings
+ *        are copied to `tmp`, which holds `STR_INLINE_MAX` bytes.
+ */
+static
+const u8 *
+StrObj_Bytes(
+    StrObj * str,
+    u8 * tmp
+) {
+    if (StrObj_IsInline(str)) {
+        StrObj_ReadInline(str, tmp);
+        return tmp;
+    }
+
+    return ((StrFlat *)StrObj_Resolve(str))->data;
+}
+
+static
+StrFlat *
+StrObj_NewFlat(
+    Gc * gc,
+    usize len
+) {
+    StrFlat * flat = (StrFlat *)Gc_Alloc(gc, &str_flat_type,
+        sizeof(StrFlat) + len);
+    if (flat == NULL) {
+        return NULL;
+    }
+
+    flat->base.len = len;
+    flat->base.kind = StrKind_Flat;
+
+    return flat;
+}
+
+static
+StrObj *
+StrObj_NewRope(
+    Gc * gc,
+    StrObj * left,
+    StrObj * right
+) {
+    StrRope * rope = (StrRope *)Gc_Alloc(gc, &str_rope_type,
+        sizeof(StrRope));
+    if (rope == NULL) {
+        return NULL;
+    }
+
+    rope->base.len = StrObj_Size(left) + StrObj_Size(right);
+    rope->base.kind = StrKind_Rope;
+    rope->left = left;
+    rope->right = right;
+
+    /* The nursery may be full, leaving the rope in the old generation. */
+    if (StrObj_IsInline(left) == false) {
+        Gc_WriteBarrier(gc, rope, left);
+    }
+
+    if (StrObj_IsInline(right) == false) {
+        Gc_WriteBarrier(gc, rope, right);
+    }
+
+    return &rope->base;
+}
+
+/**
+ * @brief Creates a string from a copy of a buffer.
+ *
+ * Strings of up to `STR_INLINE_MAX` bytes are stored in the reference
+ * itself.
+ *
+ * @return A pointer to the new string, or `NULL` if memory allocation fails.
+ */
+StrObj *
+StrObj_New(
+    Gc * gc,
+    const u8 * buf,
+    usize len
+) {
+    if (len <= STR_INLINE_MAX) {
+        return StrObj_NewInline(buf, len);
+    }
+
+    StrFlat * flat = StrObj_NewFlat(gc, len);
+    if (flat == NULL) {
+        return NULL;
+    }
+
+    memcpy(flat->data, buf, len);
+
+    return &flat->base;
+}
+
+/**
+ * @brief Copies the bytes of a string.
+ *
+ * Ropes are walked by recursing into their shorter side only, so that the
+ * recursion depth stays logarithmic in the length whatever their shape.
+ *
+ * @param dst A pointer to a buffer of `StrObj_Size(str)` bytes.
+ */
+void
+StrObj_Write(
+    StrObj * str,
+    u8 * dst
+) {
+    while (StrObj_IsRope(str)) {
+        StrRope * rope = (StrRope *)str;
+        usize left_len = StrObj_Size(rope->left);
+
+        if (left_len <= StrObj_Size(rope->right)) {
+            StrObj_Write(rope->left, dst);
+            str = rope->right;
+            dst += left_len;
+        } else {
+            StrObj_Write(rope->right, dst + left_len);
+            str = rope->left;
+        }
+    }
+
+    u8 tmp[STR_INLINE_MAX];
+
+    memcpy(dst, StrObj_Bytes(str, tmp), StrObj_Size(str));
+}
+
+/**
+ * @brief Creates the concatenation of two strings.
+ *
+ * Short results are copied, longer ones are ropes sharing both operands.
+ * Appending a short string to a rope, or prepending one, copies the leaf at
+ * that end only, so repeated concatenation takes amortized constant time.
+ *
+ * @return A pointer to the new string, or `NULL` if memory allocation fails.
+ */
+StrObj *
+StrObj_Join(
+    Gc * gc,
+    StrObj * str_1,
+    StrObj * str_2
+) {
+    str_1 = StrObj_Resolve(str_1);
+    str_2 = StrObj_Resolve(str_2);
+
+    usize len_1 = StrObj_Size(str_1);
+    usize len_2 = StrObj_Size(str_2);
+    usize len = len_1 + len_2;
+
+    if (len_1 == 0) {
+        return str_2;
+    }
+
+    if (len_2 == 0) {
+        return str_1;
+    }
+
+    if (len <= STR_INLINE_MAX) {
+        u8 buf[STR_INLINE_MAX];
+
+        StrObj_Write(str_1, buf);
+        StrObj_Write(str_2, buf + len_1);
+
+        return StrObj_NewInline(buf, len);
+    }
+
+    if (len <= ME_STR_LEAF_MAX) {
+        StrFlat * flat = StrObj_NewFlat(gc, len);
+        if (flat == NULL) {
+            return NULL;
+        }
+
+        StrObj_Write(str_1, flat->data);
+        StrObj_Write(str_2, flat->data + len_1);
+
+        return &flat->base;
+    }
+
+    if (StrObj_IsRope(str_1)) {
+        StrRope * rope = (StrRope *)str_1;
+
+        if (StrObj_Size(rope->right) + len_2 <= ME_STR_LEAF_MAX) {
+            StrObj * leaf = StrObj_Join(gc, rope->right, str_2);
+            if (leaf == NULL) {
+                return NULL;
+            }
+
+            return StrObj_NewRope(gc, rope->left, leaf);
+        }
+    }
+
+    if (StrObj_IsRope(str_2)) {
+        StrRope * rope = (StrRope *)str_2;
+
+        if (len_1 + StrObj_Size(rope->left) <= ME_STR_LEAF_MAX) {
+            StrObj * leaf = StrObj_Join(gc, str_1, rope->left);
+            if (leaf == NULL) {
+                return NULL;
+            }
+
+            return StrObj_NewRope(gc, leaf, rope->right);
+        }
+    }
+
+    return StrObj_NewRope(gc, str_1, str_2);
+}
+
+/**
+ * @brief Returns the bytes of a string, copying those of a rope into a flat
+ *        string that replaces its sides.
+ *
+ * @param tmp A pointer to a buffer of `STR_INLINE_MAX` bytes, receiving the
+ *            bytes of inline strings.
+ *
+ * @return A pointer to the bytes, or `NULL` if memory allocation fails.
+ */
+const u8 *
+StrObj_Flatten(
+    Gc * gc,
+    StrObj * str,
+    u8 * tmp
+) {
+    if (StrObj_IsRope(str) == false) {
+        return StrObj_Bytes(str, tmp);
+    }
+
+    StrRope * rope = (StrRope *)str;
+
+    StrFlat * flat = StrObj_NewFlat(gc, str->len);
+    if (flat == NULL) {
+        return NULL;
+    }
+
+    StrObj_Write(str, flat->data);
+
+    rope->base.kind = StrKind_Flattened;
+    rope->left = &flat->base;
+    rope->right = NULL;
+
+    Gc_WriteBarrier(gc, rope, flat);
+
+    return flat->data;
+}
+
+/**
+ * @brief Compares the bytes of a string from `off` with a buffer.
+ */
+static
+bool
+StrObj_MatchAt(
+    StrObj * str,
+    usize off,
+    const u8 * buf,
+    usize len
+) {
+    while (StrObj_IsRope(str)) {
+        StrRope * rope = (StrRope *)str;
+        usize left_len = StrObj_Size(rope->left);
+
+        if (off + len <= left_len) {
+            str = rope->left;
+            continue;
+        }
+
+        if (off >= left_len) {
+            str = rope->right;
+            off -= left_len;
+            continue;
+        }
+
+        /* The range spans both sides, recurse into the shorter part. */
+        usize num = left_len - off;
+
+        if (num <= len - num) {
+            if (StrObj_MatchAt(rope->left, off, buf, num) == false) {
+                return false;
+            }
+
+            str = rope->right;
+            off = 0;
+            buf += num;
+            len -= num;
+        } else {
+            if (StrObj_MatchAt(rope->right, 0, buf + num,
+                len - num) == false) {
+
+                return false;
+            }
+
+            str = rope->left;
+            len = num;
+        }
+    }
+
+    u8 tmp[STR_INLINE_MAX];
+
+    return len == 0 || memcmp(StrObj_Bytes(str, tmp) + off, buf, len) == 0;
+}
+
+/**
+ * @brief Compares each leaf of a string with the bytes of another one at
+ *        the same offset.
+ */
+static
+bool
+StrObj_MatchLeaves(
+    StrObj * str,
+    usize off,
+    StrObj * other
+) {
+    while (StrObj_IsRope(str)) {
+        StrRope * rope = (StrRope *)str;
+        usize left_len = StrObj_Size(rope->left);
+
+        if (left_len <= StrObj_Size(rope->right)) {
+            if (StrObj_MatchLeaves(rope->left, off, other) == false) {
+                return false;
+            }
+
+            str = rope->right;
+            off += left_len;
+        } else {
+            if (StrObj_MatchLeaves(rope->right, off + left_len,
+                other) == false) {
+
+                return false;
+            }
+
+            str = rope->left;
+        }
+    }
+
+    u8 tmp[STR_INLINE_MAX];
+
+    return StrObj_MatchAt(other, off, StrObj_Bytes(str, tmp),
+        StrObj_Size(str));
+}
+
+bool
+StrObj_Equals(
+    StrObj * str,
+    const u8 * buf,
+    usize len
+) {
+    return StrObj_Size(str) == len && StrObj_MatchAt(str, 0, buf, len);
+}
+
+/**
+ * @brief Compares two strings without flattening them.
+ */
+bool
+StrObj_EqualsStr(
+    StrObj * str_1,
+    StrObj * str_2
+) {
+    if (StrObj_Size(str_1) != StrObj_Size(str_2)) {
+        return false;
+    }
+
+    /* A string that is not a rope is a single leaf, compared in one go. */
+    if (StrObj_IsRope(str_2) == false) {
+        return StrObj_MatchLeaves(str_2, 0, str_1);
+    }
+
+    return StrObj_MatchLeaves(str_1, 0, str_2);
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef __ME_RUNTIME_STR_OBJ_H__
+#define __ME_RUNTIME_STR_OBJ_H__
+
+#include <stdint.h>
+
+#include "menos.h"
+#include "memory/gc.h"
+
+/* Immutable string, either stored inline in the reference itself, a flat
+   string on the collected heap, or a rope of two strings. */
+typedef struct _StrObj StrObj;
+
+/* The longest string stored inline, with no heap allocation. */
+#define STR_INLINE_MAX (sizeof(uintptr_t) - 1)
+
+StrObj *
+StrObj_New(
+    Gc * gc,
+    const u8 * buf,
+    usize len
+);
+
+StrObj *
+StrObj_Join(
+    Gc * gc,
+    StrObj * str_1,
+    StrObj * str_2
+);
+
+const u8 *
+StrObj_Flatten(
+    Gc * gc,
+    StrObj * str,
+    u8 * tmp
+);
+
+bool
+StrObj_IsInline(
+    StrObj * str
+);
+
+usize
+StrObj_Size(
+    StrObj * str
+);
+
+void
+StrObj_Write(
+    StrObj * str,
+    u8 * dst
+);
+
+bool
+StrObj_Equals(
+    StrObj * str,
+    const u8 * buf,
+    usize len
+);
+
+bool
+StrObj_EqualsStr(
+    StrObj * str_1,
+    StrObj * str_2
+);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "value.h"
+
+const char *
+ValTag_ToStr(
+    ValTag tag
+) {
+    switch (tag) {
+    case ValTag_Nil: return "nil";
+    case ValTag_Num: return "number";
+    case ValTag_Bool: return "boolean";
+    case ValTag_Str: return "string";
+    case ValTag_Big: return "number";
+    }
+}
+
+void
+Value_InitNil(
+    Value * val
+) {
+    val->tag = ValTag_Nil;
+}
+
+void
+Value_InitNum(
+    Value * val,
+    ssize num
+) {
+    val->tag = ValTag_Num;
+    val->ext.num = num;
+}
+
+void
+Value_InitBool(
+    Value * val,
+    bool b
+) {
+    val->tag = ValTag_Bool;
+    val->ext.val = b;
+}
+
+/**
+ * @brief Initializes an integer value from a big integer.
+ *
+ * Integers within the range of `ssize` are stored inline, so that every
+ * number has a single representation and the fast paths see plain values.
+ *
+ * @param val A pointer to the value to be initialized.
+ * @param big A pointer to the integer, whose ownership is taken.
+ */
+void
+Value_InitBig(
+    Value * val,
+    BigInt * big
+) {
+    ssize num;
+
+    if (BigInt_ToSsize(big, &num)) {
+        BigInt_Free(big);
+
+        val->tag = ValTag_Num;
+        val->ext.num = num;
+
+        return;
+    }
+
+    val->tag = ValTag_Big;
+    val->ext.big = big;
+}
+
+void
+Value_InitStr(
+    Value * val,
+    StrObj * str
+) {
+    val->tag = ValTag_Str;
+    val->ext.str = str;
+}
+
+bool
+Value_Copy(
+    Value * dst,
+    Value * src
+) {
+    if (src->tag == ValTag_Big) {
+        BigInt * big = BigInt_Clone(src->ext.big);
+        if (big == NULL) {
+            dst->tag = ValTag_Nil;
+            return false;
+        }
+
+        dst->tag = ValTag_Big;
+        dst->ext.big = big;
+
+        return true;
+    }
+
+    *dst = *src;
+
+    return true;
+}
+
+bool
+Value_Equals(
+    Value * val_1,
+    Value * val_2
+) {
+    if (val_1->tag != val_2->tag) {
+        return false;
+    }
+
+    switch (val_1->tag) {
+    case ValTag_Nil:
+        return true;
+
+    case ValTag_Num:
+        return val_1->ext.num == val_2->ext.num;
+
+    case ValTag_Bool:
+        return val_1->ext.val == val_2->ext.val;
+
+    case ValTag_Str:
+        return StrObj_EqualsStr(val_1->ext.str, val_2->ext.str);
+
+    case ValTag_Big:
+        return BigInt_Compare(val_1->ext.big, val_2->ext.big) == 0;
+    }
+
+    return false;
+}
+
+bool
+Value_PushAsStr(
+    Value * val,
+    FlexBuf * buf
+) {
+    switch (val->tag) {
+    case ValTag_Nil:
+        return FlexBuf_PushStr(buf, "nil");
+
+    case ValTag_Num:
+        return FlexBuf_PushInt(buf, val->ext.num);
+
+    case ValTag_Bool:
+        return FlexBuf_PushStr(buf, val->ext.val ? "true" : "false");
+
+    case ValTag_Str: {
+        usize size = FlexBuf_Size(buf);
+
+        if (FlexBuf_PushDupByte(buf, 0, StrObj_Size(val->ext.str)) == false) {
+            return false;
+        }
+
+        StrObj_Write(val->ext.str, FlexBuf_Data(buf) + size);
+
+        return true;
+    }
+
+    case ValTag_Big:
+        return BigInt_PushAsStr(val->ext.big, buf);
+    }
+
+    return false;
+}
+
+/**
+ * @brief Visits the heap reference of a value, if it has one.
+ */
+void
+Value_Visit(
+    Gc * gc,
+    Value * val,
+    GcVisitFn visit
+) {
+    if (val->tag == ValTag_Str &&
+        StrObj_IsInline(val->ext.str) == false) {
+
+        visit(gc, (void **)&val->ext.str);
+    }
+}
+
+static
+void
+ValueArray_Trace(
+    Gc * gc,
+    void * obj,
+    usize size,
+    GcVisitFn visit
+) {
+    Value * vals = (Value *)obj;
+
+    for (usize i = 0; i < size / sizeof(Value); i++) {
+        Value_Visit(gc, vals + i, visit);
+    }
+}
+
+const GcType
+value_array_type = {
+    "values",
+    ValueArray_Trace,
+};
+
+/**
+ * @brief Releases what a value owns and sets it to nil.
+ *
+ * Strings are left to the collector.
+ */
+void
+Value_Release(
+    Value * val
+) {
+    if (val->tag == ValTag_Big) {
+        BigInt_Free(val->ext.big);
+    }
+
+    val->tag = ValTag_Nil;
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#ifndef __ME_RUNTIME_VALUE_H__
+#define __ME_RUNTIME_VALUE_H__
+
+#include "menos.h"
+#include "util/fixed_buf.h"
+#include "util/flex_buf.h"
+#include "util/big_int.h"
+#include "memory/gc.h"
+#include "str_obj.h"
+
+/* Value tag, the type of a runtime value. */
+typedef enum _ValTag {
+    ValTag_Nil,     /* Unassigned variable or missing return value. */
+    ValTag_Num,     /* Integer. */
+    ValTag_Bool,    /* Boolean. */
+    ValTag_Str,     /* String. */
+    ValTag_Big,     /* Integer that does not fit in `ssize`. */
+} ValTag;
+
+const char *
+ValTag_ToStr(
+    ValTag tag
+);
+
+/* Runtime value. */
+typedef struct _Value {
+
+    /* Value tag. */
+    ValTag tag;
+
+    union {
+        ssize num;
+
+        bool val;
+
+        /* String on the collected heap. */
+        StrObj * str;
+
+        /* Owned integer, never within the range of `ssize`. */
+        BigInt * big;
+    } ext;
+} Value;
+
+void
+Value_InitNil(
+    Value * val
+);
+
+void
+Value_InitNum(
+    Value * val,
+    ssize num
+);
+
+void
+Value_InitBool(
+    Value * val,
+    bool b
+);
+
+void
+Value_InitBig(
+    Value * val,
+    BigInt * big
+);
+
+void
+Value_InitStr(
+    Value * val,
+    StrObj * str
+);
+
+bool
+Value_Copy(
+    Value * dst,
+    Value * src
+);
+
+bool
+Value_Equals(
+    Value * val_1,
+    Value * val_2
+);
+
+bool
+Value_PushAsStr(
+    Value * val,
+    FlexBuf * buf
+);
+
+void
+Value_Visit(
+    Gc * gc,
+    Value * val,
+    GcVisitFn visit
+);
+
+/* Heap type of value arrays, which are traced through. */
+extern const GcType value_array_type;
+
+void
+Value_Release(
+    Value * val
+);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,890 @@
+#include <string.h>
+
+#include "big_int.h"
+#include "config.h"
+#include "memory/allocate.h"
+
+/* Operands with at least this many limbs are multiplied with Karatsuba. */
+#define KARATSUBA_THRESHOLD 32
+
+/* The largest power of ten that fits in a limb, and its exponent. */
+#define DEC_CHUNK_BASE 1000000000U
+#define DEC_CHUNK_DIGITS 9
+
+/* Sign-magnitude integer, the limbs are stored least significant first. */
+typedef struct _BigInt {
+    bool neg;
+
+    /* The number of limbs in use, without leading zero limbs. Zero has no
+       limbs and is never negative. */
+    usize len;
+
+    u32 limbs[];
+} BigInt;
+
+static
+BigInt *
+BigInt_Alloc(
+    usize len
+) {
+    BigInt * big = (BigInt *)MeMem_Malloc(sizeof(BigInt) + sizeof(u32) * len);
+    if (big == NULL) {
+        return NULL;
+    }
+
+    big->neg = false;
+    big->len = len;
+
+    return big;
+}
+
+static
+BigInt *
+BigInt_Trim(
+    BigInt * big
+) {
+    while (big->len != 0 &&
+           big->limbs[big->len - 1] == 0) {
+
+        big->len -= 1;
+    }
+
+    if (big->len == 0) {
+        big->neg = false;
+    }
+
+    return big;
+}
+
+static
+int
+MagCompare(
+    const u32 * a,
+    usize len_a,
+    const u32 * b,
+    usize len_b
+) {
+    if (len_a != len_b) {
+        return len_a < len_b ? -1 : 1;
+    }
+
+    for (usize i = len_a; i-- > 0;) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Adds a magnitude into another in place, the sum must fit in `dst`.
+ */
+static
+void
+MagAddInto(
+    u32 * dst,
+    usize len_dst,
+    const u32 * src,
+    usize len_src
+) {
+    u64 carry = 0;
+    usize i = 0;
+
+    while (len_src != 0 &&
+           src[len_src - 1] == 0) {
+
+        len_src -= 1;
+    }
+
+    for (; i < len_src; i++) {
+        u64 sum = (u64)dst[i] + src[i] + carry;
+        dst[i] = (u32)sum;
+        carry = sum >> 32;
+    }
+
+    for (; carry != 0 && i < len_dst; i++) {
+        u64 sum = (u64)dst[i] + carry;
+        dst[i] = (u32)sum;
+        carry = sum >> 32;
+    }
+}
+
+/**
+ * @brief Subtracts a magnitude from another in place, `dst` must not be the
+ *        smaller one.
+ */
+static
+void
+MagSubInto(
+    u32 * dst,
+    usize len_dst,
+    const u32 * src,
+    usize len_src
+) {
+    u64 borrow = 0;
+    usize i = 0;
+
+    while (len_src != 0 &&
+           src[len_src - 1] == 0) {
+
+        len_src -= 1;
+    }
+
+    for (; i < len_src; i++) {
+        u64 diff = (u64)dst[i] - src[i] - borrow;
+        dst[i] = (u32)diff;
+        borrow = (diff >> 32) & 1;
+    }
+
+    for (; borrow != 0 && i < len_dst; i++) {
+        u64 diff = (u64)dst[i] - borrow;
+        dst[i] = (u32)diff;
+        borrow = (diff >> 32) & 1;
+    }
+}
+
+static
+void
+MagMulSchool(
+    const u32 * a,
+    usize len_a,
+    const u32 * b,
+    usize len_b,
+    u32 * out
+) {
+    memset(out, 0, sizeof(u32) * (len_a + len_b));
+
+    for (usize i = 0; i < len_a; i++) {
+        u64 carry = 0;
+
+        for (usize j = 0; j < len_b; j++) {
+            u64 cur = (u64)a[i] * b[j] + out[i + j] + carry;
+            out[i + j] = (u32)cur;
+            carry = cur >> 32;
+        }
+
+        out[i + len_b] = (u32)carry;
+    }
+}
+
+/**
+ * @brief Multiplies two magnitudes into `len_a + len_b` limbs of `out`.
+ *
+ * Operands below `KARATSUBA_THRESHOLD` limbs use the schoolbook method.
+ * Larger ones are split in halves, `a = a1 * B^m + a0`, and the product is
+ * assembled from three half-size products, `a0 * b0`, `a1 * b1` and
+ * `(a0 + a1) * (b0 + b1)`. An operand shorter than the split point is
+ * multiplied against both halves of the other one instead.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+static
+bool
+MagMul(
+    const u32 * a,
+    usize len_a,
+    const u32 * b,
+    usize len_b,
+    u32 * out
+) {
+    if (len_a < len_b) {
+        const u32 * tmp = a;
+        a = b;
+        b = tmp;
+
+        usize tmp_len = len_a;
+        len_a = len_b;
+        len_b = tmp_len;
+    }
+
+    if (len_b < KARATSUBA_THRESHOLD) {
+        MagMulSchool(a, len_a, b, len_b, out);
+        return true;
+    }
+
+    usize len_out = len_a + len_b;
+    usize m = (len_a + 1) / 2;
+
+    if (len_b <= m) {
+        /* Large enough for either product, since `m >= len_a - m`. */
+        u32 * prod = (u32 *)MeMem_Malloc(sizeof(u32) * (m + len_b));
+        if (prod == NULL) {
+            return false;
+        }
+
+        memset(out, 0, sizeof(u32) * len_out);
+
+        bool res = MagMul(a, m, b, len_b, prod);
+        if (res) {
+            MagAddInto(out, len_out, prod, m + len_b);
+            res = MagMul(a + m, len_a - m, b, len_b, prod);
+        }
+
+        if (res) {
+            MagAddInto(out + m, len_out - m, prod, len_a - m + len_b);
+        }
+
+        MeMem_Free(prod);
+
+        return res;
+    }
+
+    /* Sums of the halves, then their product, in one scratch buffer. */
+    u32 * scratch = (u32 *)MeMem_Malloc(sizeof(u32) * (4 * m + 4));
+    if (scratch == NULL) {
+        return false;
+    }
+
+    u32 * sum_a = scratch;
+    u32 * sum_b = scratch + m + 1;
+    u32 * mid = scratch + 2 * m + 2;
+    bool res = false;
+
+    if (MagMul(a, m, b, m, out) == false ||
+        MagMul(a + m, len_a - m, b + m, len_b - m, out + 2 * m) == false) {
+
+        goto FreeScratch;
+    }
+
+    memset(sum_a, 0, sizeof(u32) * (m + 1));
+    memcpy(sum_a, a, sizeof(u32) * m);
+    MagAddInto(sum_a, m + 1, a + m, len_a - m);
+
+    memset(sum_b, 0, sizeof(u32) * (m + 1));
+    memcpy(sum_b, b, sizeof(u32) * m);
+    MagAddInto(sum_b, m + 1, b + m, len_b - m);
+
+    if (MagMul(sum_a, m + 1, sum_b, m + 1, mid) == false) {
+        goto FreeScratch;
+    }
+
+    /* a0 * b1 + a1 * b0 */
+    MagSubInto(mid, 2 * m + 2, out, 2 * m);
+    MagSubInto(mid, 2 * m + 2, out + 2 * m, len_out - 2 * m);
+    MagAddInto(out + m, len_out - m, mid, 2 * m + 2);
+
+    res = true;
+
+FreeScratch:
+    MeMem_Free(scratch);
+
+    return res;
+}
+
+/**
+ * @brief Divides a magnitude by a single limb in place.
+ *
+ * @return The remainder.
+ */
+static
+u32
+MagDivSmall(
+    u32 * a,
+    usize len_a,
+    u32 div
+) {
+    u64 rem = 0;
+
+    for (usize i = len_a; i-- > 0;) {
+        u64 cur = (rem << 32) | a[i];
+        a[i] = (u32)(cur / div);
+        rem = cur % div;
+    }
+
+    return (u32)rem;
+}
+
+/**
+ * @brief Long division of magnitudes, Knuth's algorithm D.
+ *
+ * @param u The dividend, `len_u >= len_v`.
+ * @param v The divisor, whose most significant limb is not zero.
+ * @param quo Receives `len_u - len_v + 1` limbs of quotient.
+ * @param rem Receives `len_v` limbs of remainder.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+static
+bool
+MagDivMod(
+    const u32 * u,
+    usize len_u,
+    const u32 * v,
+    usize len_v,
+    u32 * quo,
+    u32 * rem
+) {
+    if (len_v == 1) {
+        memcpy(quo, u, sizeof(u32) * len_u);
+        rem[0] = MagDivSmall(quo, len_u, v[0]);
+        return true;
+    }
+
+    u32 * un = (u32 *)MeMem_Malloc(sizeof(u32) * (len_u + 1 + len_v));
+    if (un == NULL) {
+        return false;
+    }
+
+    u32 * vn = un + len_u + 1;
+    int shift = __builtin_clz(v[len_v - 1]);
+
+    /* Normalize so that the top limb of the divisor has its high bit set. */
+    for (usize i = len_v - 1; i > 0; i--) {
+        vn[i] = shift == 0 ? v[i] :
+            (v[i] << shift) | (v[i - 1] >> (32 - shift));
+    }
+
+    vn[0] = v[0] << shift;
+
+    un[len_u] = shift == 0 ? 0 : u[len_u - 1] >> (32 - shift);
+    for (usize i = len_u - 1; i > 0; i--) {
+        un[i] = shift == 0 ? u[i] :
+            (u[i] << shift) | (u[i - 1] >> (32 - shift));
+    }
+
+    un[0] = u[0] << shift;
+
+    for (usize j = len_u - len_v + 1; j-- > 0;) {
+        u64 num = ((u64)un[j + len_v] << 32) | un[j + len_v - 1];
+        u64 qhat = num / vn[len_v - 1];
+        u64 rhat = num % vn[len_v - 1];
+
+        while (qhat > 0xFFFFFFFFUL ||
+               qhat * vn[len_v - 2] > ((rhat << 32) | un[j + len_v - 2])) {
+
+            qhat -= 1;
+            rhat += vn[len_v - 1];
+            if (rhat > 0xFFFFFFFFUL) {
+                break;
+            }
+        }
+
+        /* Multiply and subtract. */
+        s64 borrow = 0;
+        s64 diff;
+
+        for (usize i = 0; i < len_v; i++) {
+            u64 prod = qhat * vn[i];
+            diff = (s64)un[i + j] - borrow - (s64)(prod & 0xFFFFFFFFUL);
+            un[i + j] = (u32)diff;
+            borrow = (s64)(prod >> 32) - (diff >> 32);
+        }
+
+        diff = (s64)un[j + len_v] - borrow;
+        un[j + len_v] = (u32)diff;
+
+        quo[j] = (u32)qhat;
+
+        /* The estimate was one too large, add the divisor back. */
+        if (diff < 0) {
+            u64 carry = 0;
+
+            quo[j] -= 1;
+
+            for (usize i = 0; i < len_v; i++) {
+                u64 sum = (u64)un[i + j] + vn[i] + carry;
+                un[i + j] = (u32)sum;
+                carry = sum >> 32;
+            }
+
+            un[j + len_v] += (u32)carry;
+        }
+    }
+
+    for (usize i = 0; i < len_v; i++) {
+        rem[i] = shift == 0 ? un[i] :
+            (un[i] >> shift) | (un[i + 1] << (32 - shift));
+    }
+
+    MeMem_Free(un);
+
+    return true;
+}
+
+BigInt *
+BigInt_NewFromSsize(
+    ssize num
+) {
+    BigInt * big = BigInt_Alloc(2);
+    if (big == NULL) {
+        return NULL;
+    }
+
+    u64 mag = num < 0 ? 0 - (u64)num : (u64)num;
+
+    big->neg = num < 0;
+    big->limbs[0] = (u32)mag;
+    big->limbs[1] = (u32)(mag >> 32);
+
+    return BigInt_Trim(big);
+}
+
+/**
+ * @brief Parses a decimal integer with an optional leading minus sign.
+ *
+ * @param buf A pointer to the digits, which are not validated.
+ * @param len The number of bytes.
+ *
+ * @return A pointer to the new integer, or `NULL` if memory allocation
+ *         fails.
+ */
+BigInt *
+BigInt_NewFromDec(
+    const u8 * buf,
+    usize len
+) {
+    bool neg = false;
+
+    if (len != 0 && buf[0] == '-') {
+        neg = true;
+        buf += 1;
+        len -= 1;
+    }
+
+    /* A chunk of nine digits takes less than a limb. */
+    BigInt * big = BigInt_Alloc(len / DEC_CHUNK_DIGITS + 1);
+    if (big == NULL) {
+        return NULL;
+    }
+
+    big->len = 0;
+
+    for (usize off = 0; off < len;) {
+        usize num_digits = len - off;
+        if (num_digits > DEC_CHUNK_DIGITS) {
+            num_digits = DEC_CHUNK_DIGITS;
+        }
+
+        u64 mul = 1;
+        u64 carry = 0;
+
+        for (usize i = 0; i < num_digits; i++) {
+            mul *= 10;
+            carry = carry * 10 + (buf[off + i] - '0');
+        }
+
+        for (usize i = 0; i < big->len; i++) {
+            u64 cur = big->limbs[i] * mul + carry;
+            big->limbs[i] = (u32)cur;
+            carry = cur >> 32;
+        }
+
+        if (carry != 0) {
+            big->limbs[big->len] = (u32)carry;
+            big->len += 1;
+        }
+
+        off += num_digits;
+    }
+
+    big->neg = neg;
+
+    return BigInt_Trim(big);
+}
+
+BigInt *
+BigInt_Clone(
+    BigInt * big
+) {
+    BigInt * clone = BigInt_Alloc(big->len);
+    if (clone == NULL) {
+        return NULL;
+    }
+
+    clone->neg = big->neg;
+    memcpy(clone->limbs, big->limbs, sizeof(u32) * big->len);
+
+    return clone;
+}
+
+bool
+BigInt_IsNeg(
+    BigInt * big
+) {
+    return big->neg;
+}
+
+bool
+BigInt_IsOdd(
+    BigInt * big
+) {
+    return big->len != 0 && (big->limbs[0] & 1) != 0;
+}
+
+/**
+ * @brief Converts an integer to `ssize` if it fits.
+ *
+ * @return `true` on success, `false` if the integer is out of range, in
+ *         which case `num` is left untouched.
+ */
+bool
+BigInt_ToSsize(
+    BigInt * big,
+    ssize * num
+) {
+    if (big->len > 2) {
+        return false;
+    }
+
+    u64 mag = 0;
+
+    if (big->len > 0) {
+        mag = big->limbs[0];
+    }
+
+    if (big->len > 1) {
+        mag |= (u64)big->limbs[1] << 32;
+    }
+
+    if (mag > (u64)INT64_MAX + (big->neg ? 1 : 0)) {
+        return false;
+    }
+
+    *num = big->neg ? (ssize)(0 - mag) : (ssize)mag;
+
+    return true;
+}
+
+int
+BigInt_Compare(
+    BigInt * big_1,
+    BigInt * big_2
+) {
+    if (big_1->neg != big_2->neg) {
+        return big_1->neg ? -1 : 1;
+    }
+
+    int res = MagCompare(big_1->limbs, big_1->len, big_2->limbs, big_2->len);
+
+    return big_1->neg ? -res : res;
+}
+
+BigInt *
+BigInt_Neg(
+    BigInt * big
+) {
+    BigInt * res = BigInt_Clone(big);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    res->neg = res->len != 0 && big->neg == false;
+
+    return res;
+}
+
+/**
+ * @brief Adds `rhs`, with its sign flipped if `rhs_neg` differs from it.
+ */
+static
+BigInt *
+BigInt_AddSigned(
+    BigInt * lhs,
+    BigInt * rhs,
+    bool rhs_neg
+) {
+    BigInt * big_1 = lhs;
+    BigInt * big_2 = rhs;
+    bool neg_1 = lhs->neg;
+
+    if (lhs->neg == rhs_neg) {
+        if (big_1->len < big_2->len) {
+            big_1 = rhs;
+            big_2 = lhs;
+        }
+
+        BigInt * res = BigInt_Alloc(big_1->len + 1);
+        if (res == NULL) {
+            return NULL;
+        }
+
+        memcpy(res->limbs, big_1->limbs, sizeof(u32) * big_1->len);
+        res->limbs[big_1->len] = 0;
+        MagAddInto(res->limbs, res->len, big_2->limbs, big_2->len);
+        res->neg = neg_1;
+
+        return BigInt_Trim(res);
+    }
+
+    /* Subtract the smaller magnitude from the larger one. */
+    if (MagCompare(lhs->limbs, lhs->len, rhs->limbs, rhs->len) < 0) {
+        big_1 = rhs;
+        big_2 = lhs;
+        neg_1 = rhs_neg;
+    }
+
+    BigInt * res = BigInt_Alloc(big_1->len);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    memcpy(res->limbs, big_1->limbs, sizeof(u32) * big_1->len);
+    MagSubInto(res->limbs, res->len, big_2->limbs, big_2->len);
+    res->neg = neg_1;
+
+    return BigInt_Trim(res);
+}
+
+BigInt *
+BigInt_Add(
+    BigInt * lhs,
+    BigInt * rhs
+) {
+    return BigInt_AddSigned(lhs, rhs, rhs->neg);
+}
+
+BigInt *
+BigInt_Sub(
+    BigInt * lhs,
+    BigInt * rhs
+) {
+    return BigInt_AddSigned(lhs, rhs, rhs->len != 0 && rhs->neg == false);
+}
+
+BigInt *
+BigInt_Mul(
+    BigInt * lhs,
+    BigInt * rhs
+) {
+    BigInt * res = BigInt_Alloc(lhs->len + rhs->len);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    if (lhs->len == 0 || rhs->len == 0) {
+        res->len = 0;
+        return res;
+    }
+
+    if (MagMul(lhs->limbs, lhs->len, rhs->limbs, rhs->len,
+        res->limbs) == false) {
+
+        BigInt_Free(res);
+        return NULL;
+    }
+
+    res->neg = lhs->neg != rhs->neg;
+
+    return BigInt_Trim(res);
+}
+
+/**
+ * @brief Divides two integers, truncating toward zero as C does.
+ *
+ * The remainder has the sign of the dividend.
+ *
+ * @param rhs A pointer to the divisor, which must not be zero.
+ * @param quo Receives the quotient, can be `NULL`.
+ * @param rem Receives the remainder, can be `NULL`.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+BigInt_DivMod(
+    BigInt * lhs,
+    BigInt * rhs,
+    BigInt ** quo,
+    BigInt ** rem
+) {
+    usize len_quo = lhs->len >= rhs->len ? lhs->len - rhs->len + 1 : 0;
+
+    BigInt * _quo = BigInt_Alloc(len_quo);
+    if (_quo == NULL) {
+        goto Exit;
+    }
+
+    BigInt * _rem = BigInt_Alloc(lhs->len < rhs->len ? lhs->len : rhs->len);
+    if (_rem == NULL) {
+        goto FreeQuo;
+    }
+
+    if (len_quo == 0) {
+        memcpy(_rem->limbs, lhs->limbs, sizeof(u32) * lhs->len);
+    } else if (MagDivMod(lhs->limbs, lhs->len, rhs->limbs, rhs->len,
+        _quo->limbs, _rem->limbs) == false) {
+
+        goto FreeRem;
+    }
+
+    _quo->neg = lhs->neg != rhs->neg;
+    _rem->neg = lhs->neg;
+
+    if (quo != NULL) {
+        *quo = BigInt_Trim(_quo);
+    } else {
+        BigInt_Free(_quo);
+    }
+
+    if (rem != NULL) {
+        *rem = BigInt_Trim(_rem);
+    } else {
+        BigInt_Free(_rem);
+    }
+
+    return true;
+
+FreeRem:
+    BigInt_Free(_rem);
+
+FreeQuo:
+    BigInt_Free(_quo);
+
+Exit:
+    return false;
+}
+
+/* The number of bits of the magnitude, 0 for zero. */
+static
+usize
+BigInt_BitLen(
+    BigInt * big
+) {
+    if (big->len == 0) {
+        return 0;
+    }
+
+    return big->len * 32 - (usize)__builtin_clz(big->limbs[big->len - 1]);
+}
+
+/**
+ * @brief Raises an integer to a power by repeated squaring.
+ *
+ * @return The power, or `NULL` if memory allocation fails or the power
+ *         would take more than `ME_BIGINT_MAX_BITS` bits.
+ */
+BigInt *
+BigInt_Pow(
+    BigInt * base,
+    usize exp
+) {
+    usize bits = BigInt_BitLen(base);
+
+    /* The power takes at least `(bits - 1) * exp + 1` bits, so those over
+       the limit are refused before squaring towards them. */
+    if (bits > 1 &&
+        exp > (ME_BIGINT_MAX_BITS - 1) / (bits - 1)) {
+
+        goto Exit;
+    }
+
+    BigInt * res = BigInt_NewFromSsize(1);
+    if (res == NULL) {
+        goto Exit;
+    }
+
+    BigInt * cur = BigInt_Clone(base);
+    if (cur == NULL) {
+        goto FreeRes;
+    }
+
+    while (exp != 0) {
+        if (exp & 1) {
+            BigInt * prod = BigInt_Mul(res, cur);
+            if (prod == NULL) {
+                goto FreeCur;
+            }
+
+            BigInt_Free(res);
+            res = prod;
+        }
+
+        exp >>= 1;
+        if (exp == 0) {
+            break;
+        }
+
+        BigInt * sqr = BigInt_Mul(cur, cur);
+        if (sqr == NULL) {
+            goto FreeCur;
+        }
+
+        BigInt_Free(cur);
+        cur = sqr;
+    }
+
+    BigInt_Free(cur);
+
+    return res;
+
+FreeCur:
+    BigInt_Free(cur);
+
+FreeRes:
+    BigInt_Free(res);
+
+Exit:
+    return NULL;
+}
+
+/**
+ * @brief Appends the decimal representation of an integer.
+ */
+bool
+BigInt_PushAsStr(
+    BigInt * big,
+    FlexBuf * buf
+) {
+    if (big->len == 0) {
+        return FlexBuf_PushByte(buf, '0');
+    }
+
+    /* The magnitude, then its base 10^9 digits, least significant first. */
+    u32 * mag = (u32 *)MeMem_Malloc(sizeof(u32) * big->len * 3);
+    if (mag == NULL) {
+        return false;
+    }
+
+    u32 * chunks = mag + big->len;
+    usize len_mag = big->len;
+    usize num_chunks = 0;
+    bool res = true;
+
+    memcpy(mag, big->limbs, sizeof(u32) * big->len);
+
+    while (len_mag != 0) {
+        chunks[num_chunks] = MagDivSmall(mag, len_mag, DEC_CHUNK_BASE);
+        num_chunks += 1;
+
+        while (len_mag != 0 &&
+               mag[len_mag - 1] == 0) {
+
+            len_mag -= 1;
+        }
+    }
+
+    if (big->neg) {
+        res = FlexBuf_PushByte(buf, '-');
+    }
+
+    res = res && FlexBuf_PushUInt(buf, chunks[num_chunks - 1]);
+
+    /* The lower chunks are written in place as 9 zero-padded digits. */
+    for (usize i = num_chunks - 1; res && i-- > 0;) {
+        u8 * tail = FlexBuf_ReserveTail(buf, 9);
+        if (tail == NULL) {
+            res = false;
+            break;
+        }
+
+        u32 chunk = chunks[i];
+
+        for (usize j = 9; j-- > 0;) {
+            tail[j] = (u8)('0' + chunk % 10);
+            chunk /= 10;
+        }
+
+        FlexBuf_Commit(buf, 9);
+    }
+
+    MeMem_Free(mag);
+
+    return res;
+}
+
+void
+BigInt_Free(
+    BigInt * big
+) {
+    MeMem_Free(big);
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#ifndef __ME_UTIL_BIG_INT_H__
+#define __ME_UTIL_BIG_INT_H__
+
+#include "menos.h"
+#include "flex_buf.h"
+
+typedef struct _BigInt BigInt;
+
+BigInt *
+BigInt_NewFromSsize(
+    ssize num
+);
+
+BigInt *
+BigInt_NewFromDec(
+    const u8 * buf,
+    usize len
+);
+
+BigInt *
+BigInt_Clone(
+    BigInt * big
+);
+
+bool
+BigInt_IsNeg(
+    BigInt * big
+);
+
+bool
+BigInt_IsOdd(
+    BigInt * big
+);
+
+bool
+BigInt_ToSsize(
+    BigInt * big,
+    ssize * num
+);
+
+int
+BigInt_Compare(
+    BigInt * big_1,
+    BigInt * big_2
+);
+
+BigInt *
+BigInt_Neg(
+    BigInt * big
+);
+
+BigInt *
+BigInt_Add(
+    BigInt * lhs,
+    BigInt * rhs
+);
+
+BigInt *
+BigInt_Sub(
+    BigInt * lhs,
+    BigInt * rhs
+);
+
+BigInt *
+BigInt_Mul(
+    BigInt * lhs,
+    BigInt * rhs
+);
+
+bool
+BigInt_DivMod(
+    BigInt * lhs,
+    BigInt * rhs,
+    BigInt ** quo,
+    BigInt ** rem
+);
+
+BigInt *
+BigInt_Pow(
+    BigInt * base,
+    usize exp
+);
+
+bool
+BigInt_PushAsStr(
+    BigInt * big,
+    FlexBuf * buf
+);
+
+void
+BigInt_Free(
+    BigInt * big
+);
+
+#endif
\ No newline at end of file
@@ -10,43 +10,49 @@
 #include "flex_buf.h"
 #include "menos.h"
 
+/* The data follows the header in the same allocation. */
 typedef struct _FixedBuf {
+    /* Points to `data`, or `NULL` if the buffer is empty. */
     u8 * buf;
     usize len;
+    u8 data[];
 } FixedBuf;
 
+/* Buffers up to this length, as most names and literals, share a single
+   allocation size and are recycled by the thread freeing them. */
+#define FIXED_BUF_SMALL_LEN 32
+
+static
+_Thread_local MemCache
+small_cache = MEM_CACHE_INIT(sizeof(FixedBuf) + FIXED_BUF_SMALL_LEN);
+
 FixedBuf *
 FixedBuf_NewWithLen(
     usize len
 ) {
-    u8 * buf;
+    if (len > SIZE_MAX - sizeof(FixedBuf)) {
+        return NULL;
+    }
+
+    MemTag prev_tag = MeMem_SetTagIfOther(MemTag_Buffer);
+    FixedBuf * obj;
 
-    if (len == 0) {
-        buf = NULL;
+    if (len <= FIXED_BUF_SMALL_LEN) {
+        obj = (FixedBuf *)MeMem_CacheAlloc(&small_cache);
     } else {
-        buf = (u8 *)MeMem_Malloc(len);
-        if (buf == NULL) {
-            return NULL;
-        }
+        obj = (FixedBuf *)MeMem_Malloc(sizeof(FixedBuf) + len);
     }
 
-    FixedBuf * obj = (FixedBuf *)MeMem_Malloc(sizeof(FixedBuf));
+    MeMem_SetTag(prev_tag);
+
     if (obj == NULL) {
-        goto FreeBuf;
+        return NULL;
     }
 
+    obj->buf = len == 0 ? NULL : obj->data;
     obj->len = len;
-    obj->buf = buf;
 
     return obj;
-
-FreeBuf:
-    if (buf != NULL) {
-        MeMem_Free(buf);
-    }
-
-Exit:
-    return NULL;
 }
 
 FixedBuf *
@@ -95,11 +101,16 @@ FixedBuf_NewFromFmt(
 
     len = vsnprintf(NULL, 0, fmt, args);
 
-    if (len > sizeof(mini_buf)) {
-        buf = (char *)MeMem_Malloc(len + 1);
+    if (len < 0) {
+        va_end(args);
+        return NULL;
+    }
+
+    if ((usize)len >= sizeof(mini_buf)) {
+        buf = (char *)MeMem_Malloc((usize)len + 1);
         if (buf == NULL) {
             va_end(args);
-            return false;
+            return NULL;
         }
     }
 
@@ -184,42 +195,8 @@ FixedBuf_ToEscapedFlexBuf(
         goto Exit;
     }
 
-    bool res;
-
-    for (usize i = 0; i < obj->len; i++) {
-        u8 byte = obj->buf[i];
-
-        if (byte >= 0x20 &&
-            byte <= 0x7E) {
-
-            if (byte == '\\') {
-                res = FlexBuf_PushBuf(dst_obj, "\\\\", 2);
-            } else if (byte == '"') {
-                res = FlexBuf_PushBuf(dst_obj, "\\\"", 2);
-            } else {
-                res = FlexBuf_PushByte(dst_obj, byte);
-            }
-        } else {
-            if (byte == '\t') {
-                res = FlexBuf_PushBuf(dst_obj, "\\t", 2);
-            } else if (byte == '\n') {
-                res = FlexBuf_PushBuf(dst_obj, "\\n", 2);
-            } else if (byte == '\r') {
-                res = FlexBuf_PushBuf(dst_obj, "\\r", 2);
-            } else {
-                const char * CHAR_MAP = "0123456789ABCDEF";
-                u8 buf[4] = { '\\', 'x', '0', '0' };
-
-                buf[2] = CHAR_MAP[byte >> 4];
-                buf[3] = CHAR_MAP[byte & 0x0F];
-
-                res = FlexBuf_PushBuf(dst_obj, buf, sizeof(buf));
-            }
-        }
-
-        if (res == false) {
-            goto FreeDst;
-        }
+    if (FlexBuf_PushEscaped(dst_obj, obj->buf, obj->len) == false) {
+        goto FreeDst;
     }
 
     return dst_obj;
@@ -237,7 +214,7 @@ FixedBuf_Escape(
 ) {
     FlexBuf * tmp_obj = FixedBuf_ToEscapedFlexBuf(obj);
     if (tmp_obj == NULL) {
-        goto Exit;
+        return NULL;
     }
 
     FixedBuf * new_obj = FixedBuf_NewFromBuf(
@@ -245,7 +222,6 @@ FixedBuf_Escape(
 
     FlexBuf_Free(tmp_obj);
 
-Exit:
     return new_obj;
 }
 
@@ -274,9 +250,7 @@ FixedBuf_Strip(
     }
 
     if (left_idx == obj->len) {
-        MeMem_Free(obj->buf);
-        obj->buf = NULL;
-        obj->len = 0;
+        FixedBuf_Clear(obj);
         return;
     }
 
@@ -297,9 +271,7 @@ FixedBuf_Strip(
     }
 
     if (right_idx == left_idx) {
-        MeMem_Free(obj->buf);
-        obj->buf = NULL;
-        obj->len = 0;
+        FixedBuf_Clear(obj);
         return;
     }
 
@@ -313,39 +285,7 @@ FixedBuf *
 FixedBuf_Clone(
     FixedBuf * obj
 ) {
-    u8 * buf;
-    usize len;
-
-    if (obj->buf != NULL) {
-        buf = (u8 *)MeMem_Malloc(obj->len);
-        if (buf == NULL) {
-            goto Exit;
-        }
-
-        memcpy(buf, obj->buf, obj->len);
-        len = obj->len;
-    } else {
-        buf = NULL;
-        len = 0;
-    }
-
-    FixedBuf * new_obj = (FixedBuf *)MeMem_Malloc(sizeof(FixedBuf));
-    if (new_obj == NULL) {
-        goto FreeBuffer;
-    }
-
-    new_obj->buf = buf;
-    new_obj->len = len;
-
-    return new_obj;
-
-FreeBuffer:
-    if (buf != NULL) {
-        MeMem_Free(buf);
-    }
-
-Exit:
-    return NULL;
+    return FixedBuf_NewFromBuf(obj->buf, obj->len);
 }
 
 FixedBuf *
@@ -365,15 +305,13 @@ FixedBuf_Join(
     return buf;
 }
 
+/**
+ * @brief Empties the buffer, its storage is released with the buffer.
+ */
 void
 FixedBuf_Clear(
     FixedBuf * obj
 ) {
-    if (obj->buf == NULL) {
-        return;
-    }
-
-    MeMem_Free(obj->buf);
     obj->buf = NULL;
     obj->len = 0;
 }
@@ -382,9 +320,5 @@ void
 FixedBuf_Free(
     FixedBuf * obj
 ) {
-    if (obj->buf != NULL) {
-        MeMem_Free(obj->buf);
-    }
-
-    MeMem_Free(obj);
+    MeMem_CacheFree(&small_cache, obj);
 }
\ No newline at end of file
@@ -1,23 +1,80 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdint.h>
 
 #include "flex_buf.h"
 #include "memory/allocate.h"
 #include "menos.h"
+#include "config.h"
 #include "util/fixed_buf.h"
 
-typedef struct _FlexBuf {
-    u8 * buf;
-    usize cap;
-    usize len;
-} FlexBuf;
-
 static const usize INIT_CAP = 16;
 
+/* The free room a formatted string is first tried in. */
+static const usize FMT_MIN_ROOM = 64;
+
+/**
+ * @brief Resizes the buffer of a FlexBuf to hold at least `min_cap` bytes.
+ *
+ * When `geo` is set the capacity grows by `ME_FLEX_BUF_GROWTH_PERCENT` of
+ * itself, so that a run of appends reallocates a logarithmic number of
+ * times, otherwise it becomes exactly `min_cap`.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+static
+bool
+FlexBuf_Grow(
+    FlexBuf * obj,
+    usize min_cap,
+    bool geo
+) {
+    usize new_cap = min_cap;
+    u8 * new_buf;
+
+    if (geo) {
+        if (obj->cap <= SIZE_MAX / ME_FLEX_BUF_GROWTH_PERCENT) {
+            usize geo_cap = obj->cap * ME_FLEX_BUF_GROWTH_PERCENT / 100;
+
+            if (geo_cap > new_cap) {
+                new_cap = geo_cap;
+            }
+        }
+
+        if (new_cap < INIT_CAP) {
+            new_cap = INIT_CAP;
+        }
+    }
+
+    if (obj->buf == NULL) {
+        new_buf = MeMem_MallocTagged(new_cap, MeMem_TagOf(obj));
+    } else {
+        new_buf = MeMem_Realloc(obj->buf, new_cap);
+    }
+
+    if (new_buf == NULL) {
+        return false;
+    }
+
+    obj->buf = new_buf;
+    obj->cap = new_cap;
+
+    return true;
+}
+
+/* Headers are recycled by the thread freeing them. */
+static
+_Thread_local MemCache
+flex_buf_cache = MEM_CACHE_INIT(sizeof(FlexBuf));
+
 FlexBuf *
 FlexBuf_New(void) {
-    FlexBuf * obj = (FlexBuf *)MeMem_Malloc(sizeof(FlexBuf));
+    /* The data is accounted with the header. */
+    MemTag prev_tag = MeMem_SetTagIfOther(MemTag_Buffer);
+    FlexBuf * obj = (FlexBuf *)MeMem_CacheAlloc(&flex_buf_cache);
+    MeMem_SetTag(prev_tag);
+
     if (obj == NULL) {
         return NULL;
     }
@@ -39,53 +96,57 @@ FlexBuf_Clear(
 }
 
 /**
- * @brief Appends a byte to the end of a FlexBuf.
+ * @brief Reserves room for at least `num` more bytes in a FlexBuf.
  *
- * This function adds a single byte (`byte`) to the end of the FlexBuf (`obj`).
- * If there is insufficient space in the buffer, it reallocates memory to
- * accommodate the new byte. The buffer's length is updated accordingly.
+ * Appends of up to `num` bytes that follow do not reallocate. Callers that
+ * can estimate the final size use it to skip the intermediate copies of
+ * geometric growth.
  *
- * @param obj A pointer to the FlexBuf to which the byte will be appended.
- * @param byte The byte to be added to the FlexBuf.
+ * @param obj A pointer to the FlexBuf.
+ * @param num The number of bytes to be appended.
  *
- * @return `true` if the byte is successfully appended, `false` if memory
- *         allocation fails.
+ * @return `true` on success, `false` if memory allocation fails.
  */
 bool
-FlexBuf_PushByte(
+FlexBuf_Reserve(
     FlexBuf * obj,
-    u8 byte
+    usize num
 ) {
-    usize new_len = obj->len + 1;
+    usize new_len = obj->len + num;
 
-    if (new_len > obj->cap) {
-        usize new_cap = new_len;
-        u8 * new_buf;
+    if (new_len < obj->len) {
+        return false;
+    }
 
-        if (new_cap < INIT_CAP) {
-            new_cap = INIT_CAP;
-        } else {
-            new_cap = (new_cap & (~0x7UL)) << 1;
-        }
+    if (new_len <= obj->cap) {
+        return true;
+    }
 
-        if (obj->buf == NULL) {
-            new_buf = MeMem_Malloc(new_cap);
-        } else {
-            new_buf = MeMem_Realloc(obj->buf, new_cap);
-        }
+    return FlexBuf_Grow(obj, new_len, false);
+}
 
-        if (new_buf == NULL) {
-            return false;
-        }
+/**
+ * @brief Grows a FlexBuf geometrically to take `num` more bytes, the slow
+ *        path of the inline appends.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+FlexBuf_Expand(
+    FlexBuf * obj,
+    usize num
+) {
+    usize new_len = obj->len + num;
 
-        obj->buf = new_buf;
-        obj->cap = new_cap;
+    if (new_len < obj->len) {
+        return false;
     }
 
-    obj->buf[obj->len] = byte;
-    obj->len += 1;
+    if (new_len <= obj->cap) {
+        return true;
+    }
 
-    return true;
+    return FlexBuf_Grow(obj, new_len, true);
 }
 
 /**
@@ -109,30 +170,13 @@ FlexBuf_PushDupByte(
     u8 byte,
     usize cnt
 ) {
-    usize new_len = obj->len + cnt;
-
-    if (new_len > obj->cap) {
-        usize new_cap = new_len;
-        u8 * new_buf;
-
-        if (new_cap < INIT_CAP) {
-            new_cap = INIT_CAP;
-        } else {
-            new_cap = (new_cap & (~0x7UL)) << 1;
-        }
-
-        if (obj->buf == NULL) {
-            new_buf = MeMem_Malloc(new_cap);
-        } else {
-            new_buf = MeMem_Realloc(obj->buf, new_cap);
-        }
-
-        if (new_buf == NULL) {
-            return false;
-        }
+    /* An empty FlexBuf has no buffer to pass to memset. */
+    if (cnt == 0) {
+        return true;
+    }
 
-        obj->buf = new_buf;
-        obj->cap = new_cap;
+    if (FlexBuf_Expand(obj, cnt) == false) {
+        return false;
     }
 
     memset(obj->buf + obj->len, byte, cnt);
@@ -142,60 +186,29 @@ FlexBuf_PushDupByte(
 }
 
 /**
- * @brief Appends a block of data to the end of a FlexBuf.
+ * @brief Reserves room for `num` bytes at the end of a FlexBuf to be
+ *        written in place.
  *
- * This function adds a specified block of data (`buf` with length `len`) to
- * the end of the FlexBuf (`obj`). If there is insufficient space in the buffer,
- * it reallocates memory to accommodate the new data. The buffer's length is
- * updated accordingly.
+ * The bytes count once passed to `FlexBuf_Commit`, which lets a loop fill
+ * the buffer without an append call per byte. The pointer is valid until
+ * the next change to the FlexBuf.
  *
- * @param obj A pointer to the FlexBuf to which the data will be appended.
- * @param buf A pointer to the block of data to be added to the FlexBuf.
- * @param len The length of the data block to be added.
+ * @param obj A pointer to the FlexBuf.
+ * @param num The number of bytes to be written.
  *
- * @return `true` if the data is successfully appended, `false` if memory
- *         allocation fails.
+ * @return A pointer to the reserved bytes, or `NULL` if memory allocation
+ *         fails.
  */
-bool
-FlexBuf_PushBuf(
+u8 *
+FlexBuf_ReserveTail(
     FlexBuf * obj,
-    const void * buf,
-    usize len
+    usize num
 ) {
-    if (len == 0) {
-        return true;
-    }
-
-    usize new_len = obj->len + len;
-
-    if (new_len > obj->cap) {
-        usize new_cap = new_len;
-        u8 * new_buf;
-
-        if (new_cap < INIT_CAP) {
-            new_cap = INIT_CAP;
-        } else {
-            new_cap = (new_cap & (~0x7UL)) << 1;
-        }
-
-        if (obj->buf == NULL) {
-            new_buf = MeMem_Malloc(new_cap);
-        } else {
-            new_buf = MeMem_Realloc(obj->buf, new_cap);
-        }
-
-        if (new_buf == NULL) {
-            return false;
-        }
-
-        obj->buf = new_buf;
-        obj->cap = new_cap;
+    if (FlexBuf_Expand(obj, num) == false) {
+        return NULL;
     }
 
-    memcpy(obj->buf + obj->len, buf, len);
-    obj->len += len;
-
-    return true;
+    return obj->buf + obj->len;
 }
 
 /**
@@ -247,9 +260,9 @@ FlexBuf_PushStrWithNull(
  * @brief Appends a formatted string to the end of a FlexBuf.
  *
  * This function formats the given string (`fmt`) with the provided arguments
- * and appends it to the end of the FlexBuf (`obj`). The formatted string is
- * first stored in a temporary buffer (or dynamically allocated if too large)
- * before being added to the FlexBuf.
+ * straight into the free room at the end of the FlexBuf (`obj`). Only when
+ * the room is too small is the buffer grown to the reported length and the
+ * string formatted a second time.
  *
  * @param obj A pointer to the FlexBuf to which the formatted string will be
  *            appended.
@@ -258,7 +271,7 @@ FlexBuf_PushStrWithNull(
  * @param ... Additional arguments to be formatted according to `fmt`.
  *
  * @return `true` if the formatted string is successfully appended, `false`
- *         if memory allocation or appending fails.
+ *         if memory allocation or formatting fails.
  */
 bool
 FlexBuf_PushFmt(
@@ -266,39 +279,154 @@ FlexBuf_PushFmt(
     const char * fmt,
     ...
 ) {
-    char mini_buf[256];
-    char * buf = mini_buf;
     va_list args;
-    bool res;
+    va_list retry_args;
+    bool res = false;
     int len;
 
     va_start(args, fmt);
+    va_copy(retry_args, args);
 
-    len = vsnprintf(NULL, 0, fmt, args);
+    if (obj->cap - obj->len < FMT_MIN_ROOM &&
+        FlexBuf_Expand(obj, FMT_MIN_ROOM) == false) {
 
-    if (len > sizeof(mini_buf)) {
-        buf = (char *)MeMem_Malloc(len + 1);
-        if (buf == NULL) {
-            va_end(args);
-            return false;
+        goto End;
+    }
+
+    /* The terminating null byte lands past the length. */
+    usize room = obj->cap - obj->len;
+
+    len = vsnprintf((char *)obj->buf + obj->len, room, fmt, args);
+    if (len < 0) {
+        goto End;
+    }
+
+    if ((usize)len >= room) {
+        if (FlexBuf_Expand(obj, (usize)len + 1) == false) {
+            goto End;
         }
+
+        vsnprintf((char *)obj->buf + obj->len, (usize)len + 1, fmt,
+            retry_args);
     }
 
+    obj->len += (usize)len;
+    res = true;
+
+End:
+    va_end(retry_args);
     va_end(args);
 
-    va_start(args, fmt);
+    return res;
+}
+
+/**
+ * @brief Appends the decimal representation of an unsigned integer to the
+ *        end of a FlexBuf, without parsing a format.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+FlexBuf_PushUInt(
+    FlexBuf * obj,
+    u64 val
+) {
+    u8 digits[20];
+    usize idx = sizeof(digits);
 
-    vsnprintf(buf, len + 1, fmt, args);
+    do {
+        digits[--idx] = (u8)('0' + val % 10);
+        val /= 10;
+    } while (val != 0);
 
-    va_end(args);
+    return FlexBuf_PushBuf(obj, digits + idx, sizeof(digits) - idx);
+}
+
+/**
+ * @brief Appends the decimal representation of a signed integer to the end
+ *        of a FlexBuf, without parsing a format.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+FlexBuf_PushInt(
+    FlexBuf * obj,
+    s64 val
+) {
+    if (val >= 0) {
+        return FlexBuf_PushUInt(obj, (u64)val);
+    }
 
-    res = FlexBuf_PushBuf(obj, buf, len);
+    /* Negated in unsigned arithmetic, which also holds the minimum. */
+    return FlexBuf_PushByte(obj, '-') &&
+        FlexBuf_PushUInt(obj, 0 - (u64)val);
+}
 
-    if (buf != mini_buf) {
-        MeMem_Free(buf);
+/**
+ * @brief Appends a block of data to the end of a FlexBuf, escaped as the
+ *        contents of a double-quoted string.
+ *
+ * Backslashes and double quotes are prefixed with a backslash, tabs and
+ * line breaks become `\t`, `\n` and `\r`, and other bytes outside of
+ * printable ASCII become `\xHH`. Runs of bytes needing no escape are
+ * copied at once.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+FlexBuf_PushEscaped(
+    FlexBuf * obj,
+    const void * buf,
+    usize len
+) {
+    const char * CHAR_MAP = "0123456789ABCDEF";
+    const u8 * src = (const u8 *)buf;
+    usize idx = 0;
+
+    while (idx < len) {
+        usize run = idx;
+
+        while (run < len &&
+               src[run] >= 0x20 &&
+               src[run] <= 0x7E &&
+               src[run] != '\\' &&
+               src[run] != '"') {
+            run++;
+        }
+
+        if (FlexBuf_PushBuf(obj, src + idx, run - idx) == false) {
+            return false;
+        }
+
+        if (run == len) {
+            break;
+        }
+
+        u8 byte = src[run];
+        u8 esc[4] = { '\\', byte, 0, 0 };
+        usize esc_len = 2;
+
+        if (byte == '\t') {
+            esc[1] = 't';
+        } else if (byte == '\n') {
+            esc[1] = 'n';
+        } else if (byte == '\r') {
+            esc[1] = 'r';
+        } else if (byte != '\\' && byte != '"') {
+            esc[1] = 'x';
+            esc[2] = CHAR_MAP[byte >> 4];
+            esc[3] = CHAR_MAP[byte & 0x0F];
+            esc_len = 4;
+        }
+
+        if (FlexBuf_PushBuf(obj, esc, esc_len) == false) {
+            return false;
+        }
+
+        idx = run + 1;
     }
 
-    return res;
+    return true;
 }
 
 /**
@@ -478,5 +606,5 @@ FlexBuf_Free(
         MeMem_Free(obj->buf);
     }
 
-    MeMem_Free(obj);
+    MeMem_CacheFree(&flex_buf_cache, obj);
 }
\ No newline at end of file
@@ -1,10 +1,18 @@
 #ifndef __ME_UTIL_FLEX_BUF_H__
 #define __ME_UTIL_FLEX_BUF_H__
 
+#include <string.h>
+
 #include "menos.h"
 #include "fixed_buf.h"
 
-typedef struct _FlexBuf FlexBuf;
+/* The fields are only exposed for the inline appends below, they must be
+   accessed through the functions. */
+typedef struct _FlexBuf {
+    u8 * buf;
+    usize cap;
+    usize len;
+} FlexBuf;
 
 FlexBuf *
 FlexBuf_New(void);
@@ -14,11 +22,42 @@ FlexBuf_Clear(
     FlexBuf * obj
 );
 
+bool
+FlexBuf_Reserve(
+    FlexBuf * obj,
+    usize num
+);
+
+bool
+FlexBuf_Expand(
+    FlexBuf * obj,
+    usize num
+);
+
+/**
+ * @brief Appends a byte to the end of a FlexBuf.
+ *
+ * @return `true` if the byte is successfully appended, `false` if memory
+ *         allocation fails.
+ */
+static
+inline
 bool
 FlexBuf_PushByte(
     FlexBuf * obj,
     u8 byte
-);
+) {
+    if (ME_UNLIKELY(obj->len == obj->cap) &&
+        FlexBuf_Expand(obj, 1) == false) {
+
+        return false;
+    }
+
+    obj->buf[obj->len] = byte;
+    obj->len += 1;
+
+    return true;
+}
 
 bool
 FlexBuf_PushDupByte(
@@ -27,13 +66,56 @@ FlexBuf_PushDupByte(
     usize cnt
 );
 
+/**
+ * @brief Appends a block of data to the end of a FlexBuf.
+ *
+ * @return `true` if the data is successfully appended, `false` if memory
+ *         allocation fails.
+ */
+static
+inline
 bool
 FlexBuf_PushBuf(
     FlexBuf * obj,
     const void * buf,
     usize len
+) {
+    if (len == 0) {
+        return true;
+    }
+
+    if (ME_UNLIKELY(len > obj->cap - obj->len) &&
+        FlexBuf_Expand(obj, len) == false) {
+
+        return false;
+    }
+
+    memcpy(obj->buf + obj->len, buf, len);
+    obj->len += len;
+
+    return true;
+}
+
+u8 *
+FlexBuf_ReserveTail(
+    FlexBuf * obj,
+    usize num
 );
 
+/**
+ * @brief Counts `num` bytes written after `FlexBuf_ReserveTail` as
+ *        appended.
+ */
+static
+inline
+void
+FlexBuf_Commit(
+    FlexBuf * obj,
+    usize num
+) {
+    obj->len += num;
+}
+
 bool
 FlexBuf_PushStr(
     FlexBuf * obj,
@@ -53,6 +135,25 @@ FlexBuf_PushFmt(
     ...
 );
 
+bool
+FlexBuf_PushUInt(
+    FlexBuf * obj,
+    u64 val
+);
+
+bool
+FlexBuf_PushInt(
+    FlexBuf * obj,
+    s64 val
+);
+
+bool
+FlexBuf_PushEscaped(
+    FlexBuf * obj,
+    const void * buf,
+    usize len
+);
+
 u8 *
 FlexBuf_Data(
     FlexBuf * obj
@@ -0,0 +1,67 @@
+#ifndef __ME_UTIL_HASH_H__
+#define __ME_UTIL_HASH_H__
+
+#include <string.h>
+
+#include "menos.h"
+
+/* Parameters of 64-bit FNV-1a. */
+#define HASH_FNV_OFFSET     0xCBF29CE484222325UL
+#define HASH_FNV_PRIME      0x100000001B3UL
+
+/**
+ * @brief Hashes bytes with 64-bit FNV-1a, the hash of short keys looked up
+ *        in tables.
+ */
+static
+inline
+u64
+Hash_Fnv1a(
+    const u8 * buf,
+    usize len
+) {
+    u64 hash = HASH_FNV_OFFSET;
+
+    for (usize i = 0; i < len; i++) {
+        hash ^= buf[i];
+        hash *= HASH_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Hashes bytes with 64-bit FNV-1a taking a word at a time, the
+ *        checksum of files large enough for hashing them byte by byte to
+ *        take a while.
+ *
+ * It is not the same hash as `Hash_Fnv1a` and depends on the byte order of
+ * the host, as do the files it checks.
+ */
+static
+inline
+u64
+Hash_Fnv1aWords(
+    const u8 * buf,
+    usize len
+) {
+    u64 hash = HASH_FNV_OFFSET;
+    usize i = 0;
+
+    for (; i + sizeof(u64) <= len; i += sizeof(u64)) {
+        u64 word;
+        memcpy(&word, buf + i, sizeof(u64));
+
+        hash ^= word;
+        hash *= HASH_FNV_PRIME;
+    }
+
+    for (; i < len; i++) {
+        hash ^= buf[i];
+        hash *= HASH_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "map_file.h"
+#include "memory/allocate.h"
+
+typedef struct _MapFile {
+
+    /* Mapped contents, `NULL` for an empty file. */
+    u8 * data;
+    usize size;
+} MapFile;
+
+/**
+ * @brief Maps a whole file for reading.
+ *
+ * The mapping is private, so the file may be replaced while it is mapped
+ * without the contents changing under the reader.
+ *
+ * @return A pointer to the mapping, or `NULL` if the file cannot be opened
+ *         or mapped, or memory allocation fails.
+ */
+MapFile *
+MapFile_Open(
+    const char * path
+) {
+    MapFile * map = NULL;
+    struct stat st;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        goto Exit;
+    }
+
+    if (fstat(fd, &st) != 0 ||
+        S_ISREG(st.st_mode) == false) {
+
+        goto CloseFile;
+    }
+
+    map = (MapFile *)MeMem_Malloc(sizeof(MapFile));
+    if (map == NULL) {
+        goto CloseFile;
+    }
+
+    map->data = NULL;
+    map->size = (usize)st.st_size;
+
+    if (map->size != 0) {
+        void * data = mmap(NULL, map->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            goto FreeMap;
+        }
+
+        map->data = (u8 *)data;
+    }
+
+    goto CloseFile;
+
+FreeMap:
+    MeMem_Free(map);
+    map = NULL;
+
+CloseFile:
+    close(fd);
+
+Exit:
+    return map;
+}
+
+const u8 *
+MapFile_Data(
+    MapFile * map
+) {
+    return map->data;
+}
+
+usize
+MapFile_Size(
+    MapFile * map
+) {
+    return map->size;
+}
+
+void
+MapFile_Close(
+    MapFile * map
+) {
+    if (map->data != NULL) {
+        munmap(map->data, map->size);
+    }
+
+    MeMem_Free(map);
+}
+
+static
+bool
+WriteAll(
+    int fd,
+    const u8 * buf,
+    usize len
+) {
+    while (len > 0) {
+        ssize_t num = write(fd, buf, len);
+        if (num < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return false;
+        }
+
+        buf += num;
+        len -= (usize)num;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Replaces a file with new contents, atomically.
+ *
+ * The contents are written to a temporary file next to the target, synced
+ * and renamed over it. Readers, in this process or others, see either the
+ * old file or the whole new one, and of concurrent writers the last rename
+ * wins.
+ *
+ * @return `true` on success, `false` if the file cannot be written.
+ */
+bool
+MapFile_WriteAtomic(
+    const char * path,
+    const void * buf,
+    usize len
+) {
+    const char * SUFFIX = ".tmp.XXXXXX";
+    bool res = false;
+
+    usize tmp_len = strlen(path) + strlen(SUFFIX) + 1;
+    char * tmp_path = (char *)MeMem_Malloc(tmp_len);
+    if (tmp_path == NULL) {
+        goto Exit;
+    }
+
+    snprintf(tmp_path, tmp_len, "%s%s", path, SUFFIX);
+
+    int fd = mkstemp(tmp_path);
+    if (fd < 0) {
+        goto FreePath;
+    }
+
+    if (fchmod(fd, 0644) != 0 ||
+        WriteAll(fd, (const u8 *)buf, len) == false ||
+        fsync(fd) != 0) {
+
+        close(fd);
+        goto Unlink;
+    }
+
+    if (close(fd) != 0 ||
+        rename(tmp_path, path) != 0) {
+
+        goto Unlink;
+    }
+
+    res = true;
+    goto FreePath;
+
+Unlink:
+    unlink(tmp_path);
+
+FreePath:
+    MeMem_Free(tmp_path);
+
+Exit:
+    return res;
+}
\ No newline at end of file
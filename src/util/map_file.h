@@ -0,0 +1,36 @@
+#ifndef __ME_UTIL_MAP_FILE_H__
+#define __ME_UTIL_MAP_FILE_H__
+
+#include "menos.h"
+
+/* Read-only mapping of a whole file. */
+typedef struct _MapFile MapFile;
+
+MapFile *
+MapFile_Open(
+    const char * path
+);
+
+const u8 *
+MapFile_Data(
+    MapFile * map
+);
+
+usize
+MapFile_Size(
+    MapFile * map
+);
+
+void
+MapFile_Close(
+    MapFile * map
+);
+
+bool
+MapFile_WriteAtomic(
+    const char * path,
+    const void * buf,
+    usize len
+);
+
+#endif
\ No newline at end of file
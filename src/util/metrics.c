@@ -0,0 +1,77 @@
+#include <string.h>
+
+#include "metrics.h"
+
+const char *
+MetricsPhase_ToStr(
+    MetricsPhase phase
+) {
+    switch (phase) {
+    case MetricsPhase_Lex: return "lex";
+    case MetricsPhase_Parse: return "parse";
+    case MetricsPhase_Load: return "load";
+    case MetricsPhase_Run: return "run";
+    default: return "unknown";
+    }
+}
+
+void
+Metrics_Clear(
+    Metrics * m
+) {
+    memset(m, 0, sizeof(Metrics));
+}
+
+/**
+ * @brief Appends a report of the metrics to a FlexBuf, one line per phase
+ *        followed by the bytes scanned and the deepest nesting.
+ *
+ * The counts by tag are reported with `Metrics_PushCounts`, by the caller
+ * that knows the names of the tags.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+Metrics_PushAsStr(
+    const Metrics * m,
+    FlexBuf * buf
+) {
+    for (usize i = 0; i < METRICS_NUM_PHASES; i++) {
+        if (FlexBuf_PushFmt(buf, "%s: %llu ns, %llu allocs\n",
+            MetricsPhase_ToStr((MetricsPhase)i),
+            (unsigned long long)m->phase_ns[i],
+            (unsigned long long)m->phase_allocs[i]) == false) {
+
+            return false;
+        }
+    }
+
+    return FlexBuf_PushFmt(buf, "bytes scanned: %llu\nmax depth: %zu\n",
+        (unsigned long long)m->bytes_scanned, m->max_depth);
+}
+
+/**
+ * @brief Appends the nonzero counters of the first `num_tags` tags to a
+ *        FlexBuf, one line each, as the kind and name of the tag.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+Metrics_PushCounts(
+    const u64 * counts,
+    usize num_tags,
+    const char * kind,
+    MetricsTagName name,
+    FlexBuf * buf
+) {
+    for (usize i = 0; i < num_tags; i++) {
+        if (counts[i] != 0 &&
+            FlexBuf_PushFmt(buf, "%s %s: %llu\n", kind, name(i),
+                (unsigned long long)counts[i]) == false) {
+
+            return false;
+        }
+    }
+
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#ifndef __ME_UTIL_METRICS_H__
+#define __ME_UTIL_METRICS_H__
+
+#include <time.h>
+
+#include "menos.h"
+#include "memory/allocate.h"
+#include "util/flex_buf.h"
+
+typedef enum _MetricsPhase {
+    MetricsPhase_Lex,
+    MetricsPhase_Parse,
+    MetricsPhase_Load,
+    MetricsPhase_Run,
+} MetricsPhase;
+
+#define METRICS_NUM_PHASES  4
+
+/* Counters per kind of tag, at least the number of token and node tags,
+   which the lexer and parser check. */
+#define METRICS_MAX_TAGS    64
+
+/* Names the tag of a counter in a report. */
+typedef const char * (* MetricsTagName)(usize tag);
+
+/* Counters of the work done on a script, filled in by the stages it is
+   installed in. The caller owns it and clears it with `Metrics_Clear`. */
+typedef struct _Metrics {
+
+    /* Time spent and blocks allocated by the thread in each phase. */
+    u64 phase_ns[METRICS_NUM_PHASES];
+    u64 phase_allocs[METRICS_NUM_PHASES];
+
+    u64 bytes_scanned;
+
+    /* Tokens emitted and nodes parsed, indexed by `TokTag` and `AstTag`. */
+    u64 toks[METRICS_MAX_TAGS];
+    u64 nodes[METRICS_MAX_TAGS];
+
+    /* Deepest nesting of a parsed tree, the root being at depth 1. */
+    usize max_depth;
+} Metrics;
+
+/* Start of a timed phase. */
+typedef struct _MetricsSpan {
+    u64 start_ns;
+    u64 start_allocs;
+} MetricsSpan;
+
+static
+inline
+u64
+Metrics_Now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (u64)ts.tv_sec * 1000000000UL + (u64)ts.tv_nsec;
+}
+
+static
+inline
+void
+Metrics_Begin(
+    Metrics * m,
+    MetricsSpan * span
+) {
+    if (m == NULL) {
+        return;
+    }
+
+    span->start_ns = Metrics_Now();
+    span->start_allocs = MeMem_ThreadAllocs();
+}
+
+static
+inline
+void
+Metrics_End(
+    Metrics * m,
+    MetricsPhase phase,
+    const MetricsSpan * span
+) {
+    if (m == NULL) {
+        return;
+    }
+
+    m->phase_ns[phase] += Metrics_Now() - span->start_ns;
+    m->phase_allocs[phase] += MeMem_ThreadAllocs() - span->start_allocs;
+}
+
+const char *
+MetricsPhase_ToStr(
+    MetricsPhase phase
+);
+
+void
+Metrics_Clear(
+    Metrics * m
+);
+
+bool
+Metrics_PushAsStr(
+    const Metrics * m,
+    FlexBuf * buf
+);
+
+bool
+Metrics_PushCounts(
+    const u64 * counts,
+    usize num_tags,
+    const char * kind,
+    MetricsTagName name,
+    FlexBuf * buf
+);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,804 @@
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "sched.h"
+#include "config.h"
+#include "memory/allocate.h"
+
+/* The number of tasks a deque starts with room for, a power of two. */
+#define SCHED_DEQUE_MIN_CAP 64
+
+/* The rounds of stealing an idle worker tries before going to sleep. */
+#define SCHED_IDLE_ROUNDS   64
+
+typedef struct _SchedFor SchedFor;
+
+typedef struct _SchedTask {
+    SchedGroup * group;
+
+    /* Either a function of its argument, or a part of a parallel loop. */
+    SchedFn fn;
+    void * arg;
+    SchedFor * loop;
+    usize begin;
+    usize end;
+
+    /* Link in the queue of tasks spawned from outside the workers. */
+    struct _SchedTask * next;
+} SchedTask;
+
+/* Parallel loop, the parts split off are tasks of its group. */
+typedef struct _SchedFor {
+    Sched * sched;
+    SchedGroup group;
+    usize grain;
+    SchedRangeFn fn;
+    void * ctx;
+} SchedFor;
+
+/* Circular array of a deque, replaced by one twice as large when full. */
+typedef struct _SchedArray {
+    usize cap;
+    struct _SchedArray * prev;
+    _Atomic(SchedTask *) buf[];
+} SchedArray;
+
+/* Chase-Lev deque, the owner pushes and pops at the bottom while thieves
+   take from the top. */
+typedef struct _SchedDeque {
+    atomic_size_t top;
+    atomic_size_t bottom;
+    _Atomic(SchedArray *) array;
+} SchedDeque;
+
+typedef struct _SchedWorker {
+    Sched * sched;
+    usize idx;
+    pthread_t thread;
+    SchedDeque deque;
+
+    /* State of the victim picker. */
+    u64 rand;
+} SchedWorker;
+
+typedef struct _Sched {
+    SchedWorker * workers;
+    usize num_workers;
+    bool pin;
+
+    /* Tasks spawned from outside the workers. */
+    pthread_mutex_t lock;
+    SchedTask * head;
+    SchedTask * tail;
+    atomic_size_t num_injected;
+
+    /* Idle workers sleep on `wake`, joiners outside the workers on
+       `joined`, both under `lock`. */
+    pthread_cond_t wake;
+    pthread_cond_t joined;
+    atomic_size_t num_sleeping;
+    atomic_bool stop;
+} Sched;
+
+static
+_Thread_local MemCache
+task_cache = MEM_CACHE_INIT(sizeof(SchedTask));
+
+/* Worker running on the current thread, if any. */
+static
+_Thread_local SchedWorker *
+thread_worker = NULL;
+
+static
+SchedArray *
+SchedArray_New(
+    usize cap
+) {
+    SchedArray * arr = (SchedArray *)MeMem_Malloc(sizeof(SchedArray) +
+        sizeof(_Atomic(SchedTask *)) * cap);
+    if (arr == NULL) {
+        return NULL;
+    }
+
+    arr->cap = cap;
+    arr->prev = NULL;
+
+    return arr;
+}
+
+static
+bool
+SchedDeque_Init(
+    SchedDeque * dq
+) {
+    SchedArray * arr = SchedArray_New(SCHED_DEQUE_MIN_CAP);
+    if (arr == NULL) {
+        return false;
+    }
+
+    atomic_init(&dq->top, 0);
+    atomic_init(&dq->bottom, 0);
+    atomic_init(&dq->array, arr);
+
+    return true;
+}
+
+/**
+ * @brief Releases the deque with every array it outgrew, which thieves may
+ *        have been reading until the workers stopped.
+ */
+static
+void
+SchedDeque_Fini(
+    SchedDeque * dq
+) {
+    SchedArray * arr = atomic_load_explicit(&dq->array, memory_order_relaxed);
+
+    while (arr != NULL) {
+        SchedArray * prev = arr->prev;
+        MeMem_Free(arr);
+        arr = prev;
+    }
+}
+
+/**
+ * @brief Pushes a task at the bottom, only called by the owner.
+ *
+ * @return `true` on success, `false` if the deque is full and memory
+ *         allocation fails.
+ */
+static
+bool
+SchedDeque_Push(
+    SchedDeque * dq,
+    SchedTask * task
+) {
+    usize b = atomic_load_explicit(&dq->bottom, memory_order_relaxed);
+    usize t = atomic_load_explicit(&dq->top, memory_order_acquire);
+    SchedArray * arr = atomic_load_explicit(&dq->array, memory_order_relaxed);
+
+    if (b - t >= arr->cap) {
+        SchedArray * grown = SchedArray_New(arr->cap * 2);
+        if (grown == NULL) {
+            return false;
+        }
+
+        for (usize i = t; i < b; i++) {
+            atomic_store_explicit(grown->buf + (i & (grown->cap - 1)),
+                atomic_load_explicit(arr->buf + (i & (arr->cap - 1)),
+                    memory_order_relaxed),
+                memory_order_relaxed);
+        }
+
+        grown->prev = arr;
+        atomic_store_explicit(&dq->array, grown, memory_order_release);
+        arr = grown;
+    }
+
+    /* Thieves reading the new bottom see the task it covers. */
+    atomic_store_explicit(arr->buf + (b & (arr->cap - 1)), task,
+        memory_order_relaxed);
+    atomic_store_explicit(&dq->bottom, b + 1, memory_order_release);
+
+    return true;
+}
+
+/**
+ * @brief Pops the task pushed last, only called by the owner.
+ */
+static
+SchedTask *
+SchedDeque_Pop(
+    SchedDeque * dq
+) {
+    usize b = atomic_load_explicit(&dq->bottom, memory_order_relaxed);
+    usize t = atomic_load_explicit(&dq->top, memory_order_relaxed);
+
+    /* Empty, and `bottom - 1` would wrap below `top`. */
+    if (b == t) {
+        return NULL;
+    }
+
+    b -= 1;
+
+    SchedArray * arr = atomic_load_explicit(&dq->array, memory_order_relaxed);
+    atomic_store_explicit(&dq->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    t = atomic_load_explicit(&dq->top, memory_order_relaxed);
+
+    if (t > b) {
+        atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    SchedTask * task = atomic_load_explicit(arr->buf + (b & (arr->cap - 1)),
+        memory_order_relaxed);
+
+    /* The last task, raced for with the thieves. */
+    if (t == b) {
+        if (atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1,
+            memory_order_seq_cst, memory_order_relaxed) == false) {
+
+            task = NULL;
+        }
+
+        atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+    }
+
+    return task;
+}
+
+/**
+ * @brief Takes the oldest task, called by any thread.
+ */
+static
+SchedTask *
+SchedDeque_Steal(
+    SchedDeque * dq
+) {
+    usize t = atomic_load_explicit(&dq->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    usize b = atomic_load_explicit(&dq->bottom, memory_order_acquire);
+
+    if (t >= b) {
+        return NULL;
+    }
+
+    SchedArray * arr = atomic_load_explicit(&dq->array, memory_order_acquire);
+    SchedTask * task = atomic_load_explicit(arr->buf + (t & (arr->cap - 1)),
+        memory_order_relaxed);
+
+    if (atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1,
+        memory_order_seq_cst, memory_order_relaxed) == false) {
+
+        return NULL;
+    }
+
+    return task;
+}
+
+static
+bool
+SchedDeque_IsEmpty(
+    SchedDeque * dq
+) {
+    usize t = atomic_load_explicit(&dq->top, memory_order_acquire);
+    usize b = atomic_load_explicit(&dq->bottom, memory_order_acquire);
+
+    return t >= b;
+}
+
+static
+void
+Sched_ForRange(
+    SchedFor * loop,
+    usize begin,
+    usize end
+);
+
+/**
+ * @brief Runs a task and frees it, then marks it done in its group.
+ */
+static
+void
+Sched_RunTask(
+    Sched * sched,
+    SchedTask * task
+) {
+    SchedGroup * group = task->group;
+
+    if (task->loop != NULL) {
+        Sched_ForRange(task->loop, task->begin, task->end);
+    } else {
+        task->fn(task->arg);
+    }
+
+    MeMem_CacheFree(&task_cache, task);
+
+    /* The last task of a group may have a joiner outside the workers
+       waiting for it. */
+    if (atomic_fetch_sub(&group->pending, 1) == 1) {
+        pthread_mutex_lock(&sched->lock);
+        pthread_cond_broadcast(&sched->joined);
+        pthread_mutex_unlock(&sched->lock);
+    }
+}
+
+static
+SchedTask *
+Sched_TakeInjected(
+    Sched * sched
+) {
+    SchedTask * task = NULL;
+
+    if (atomic_load_explicit(&sched->num_injected,
+        memory_order_acquire) == 0) {
+
+        return NULL;
+    }
+
+    pthread_mutex_lock(&sched->lock);
+
+    if (sched->head != NULL) {
+        task = sched->head;
+        sched->head = task->next;
+        if (sched->head == NULL) {
+            sched->tail = NULL;
+        }
+
+        atomic_fetch_sub(&sched->num_injected, 1);
+    }
+
+    pthread_mutex_unlock(&sched->lock);
+
+    return task;
+}
+
+/**
+ * @brief Finds a task for a worker, or for a joiner outside the workers if
+ *        `self` is `NULL`: its own newest task, then one spawned from
+ *        outside, then one stolen from a random victim.
+ */
+static
+SchedTask *
+Sched_FindTask(
+    Sched * sched,
+    SchedWorker * self
+) {
+    SchedTask * task;
+
+    if (self != NULL && (task = SchedDeque_Pop(&self->deque)) != NULL) {
+        return task;
+    }
+
+    if ((task = Sched_TakeInjected(sched)) != NULL) {
+        return task;
+    }
+
+    usize start = 0;
+
+    if (self != NULL) {
+        self->rand ^= self->rand << 13;
+        self->rand ^= self->rand >> 7;
+        self->rand ^= self->rand << 17;
+        start = (usize)(self->rand % sched->num_workers);
+    }
+
+    for (usize i = 0; i < sched->num_workers; i++) {
+        SchedWorker * victim = sched->workers +
+            (start + i) % sched->num_workers;
+
+        if (victim != self &&
+            (task = SchedDeque_Steal(&victim->deque)) != NULL) {
+
+            return task;
+        }
+    }
+
+    return NULL;
+}
+
+static
+bool
+Sched_HasWork(
+    Sched * sched
+) {
+    if (atomic_load(&sched->num_injected) != 0) {
+        return true;
+    }
+
+    for (usize i = 0; i < sched->num_workers; i++) {
+        if (SchedDeque_IsEmpty(&sched->workers[i].deque) == false) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Wakes a sleeping worker, if any, after work was made visible.
+ */
+static
+void
+Sched_Notify(
+    Sched * sched
+) {
+    /* Pairs with the fence of a worker going to sleep, either it sees the
+       new work or this sees it sleeping. */
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (atomic_load_explicit(&sched->num_sleeping,
+        memory_order_relaxed) == 0) {
+
+        return;
+    }
+
+    pthread_mutex_lock(&sched->lock);
+    pthread_cond_signal(&sched->wake);
+    pthread_mutex_unlock(&sched->lock);
+}
+
+static
+void
+Sched_Sleep(
+    Sched * sched
+) {
+    pthread_mutex_lock(&sched->lock);
+
+    atomic_fetch_add(&sched->num_sleeping, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (Sched_HasWork(sched) == false && atomic_load(&sched->stop) == false) {
+        pthread_cond_wait(&sched->wake, &sched->lock);
+    }
+
+    atomic_fetch_sub(&sched->num_sleeping, 1);
+
+    pthread_mutex_unlock(&sched->lock);
+}
+
+static
+void
+SchedWorker_Pin(
+    SchedWorker * worker
+) {
+#if defined(__linux__)
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t set;
+
+    if (num_cpus <= 0) {
+        return;
+    }
+
+    CPU_ZERO(&set);
+    CPU_SET((int)(worker->idx % (usize)num_cpus), &set);
+
+    /* Pinning is only a hint, workers run anywhere if it fails. */
+    pthread_setaffinity_np(worker->thread, sizeof(set), &set);
+#endif
+}
+
+static
+void *
+SchedWorker_Main(
+    void * arg
+) {
+    SchedWorker * worker = (SchedWorker *)arg;
+    Sched * sched = worker->sched;
+    usize idle = 0;
+
+    thread_worker = worker;
+
+    if (sched->pin) {
+        SchedWorker_Pin(worker);
+    }
+
+    while (atomic_load_explicit(&sched->stop, memory_order_acquire) == false) {
+        SchedTask * task = Sched_FindTask(sched, worker);
+
+        if (task != NULL) {
+            Sched_RunTask(sched, task);
+            idle = 0;
+        } else if (++idle < SCHED_IDLE_ROUNDS) {
+            sched_yield();
+        } else {
+            Sched_Sleep(sched);
+            idle = 0;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Creates a scheduler with a work-stealing deque per worker.
+ *
+ * @param num_workers The number of worker threads, `0` for one per online
+ *        processor.
+ * @param pin Whether worker `i` is pinned to processor `i`, modulo the
+ *        number of processors.
+ *
+ * @return A pointer to the scheduler, or `NULL` if memory allocation or
+ *         thread creation fails.
+ */
+Sched *
+Sched_New(
+    usize num_workers,
+    bool pin
+) {
+    usize num_ready = 0;
+    usize num_started = 0;
+
+    if (num_workers == 0) {
+        long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = num_cpus > 0 ? (usize)num_cpus : 1;
+    }
+
+    Sched * sched = (Sched *)MeMem_Malloc(sizeof(Sched));
+    if (sched == NULL) {
+        goto Exit;
+    }
+
+    sched->workers = (SchedWorker *)MeMem_Malloc(
+        sizeof(SchedWorker) * num_workers);
+    if (sched->workers == NULL) {
+        goto FreeSched;
+    }
+
+    sched->num_workers = num_workers;
+    sched->pin = pin;
+
+    pthread_mutex_init(&sched->lock, NULL);
+    sched->head = NULL;
+    sched->tail = NULL;
+    atomic_init(&sched->num_injected, 0);
+
+    pthread_cond_init(&sched->wake, NULL);
+    pthread_cond_init(&sched->joined, NULL);
+    atomic_init(&sched->num_sleeping, 0);
+    atomic_init(&sched->stop, false);
+
+    for (; num_ready < num_workers; num_ready++) {
+        SchedWorker * worker = sched->workers + num_ready;
+
+        worker->sched = sched;
+        worker->idx = num_ready;
+        worker->rand = 0x9E3779B97F4A7C15UL * (num_ready + 1);
+
+        if (SchedDeque_Init(&worker->deque) == false) {
+            goto Shutdown;
+        }
+    }
+
+    for (; num_started < num_workers; num_started++) {
+        SchedWorker * worker = sched->workers + num_started;
+
+        if (pthread_create(&worker->thread, NULL,
+            SchedWorker_Main, worker) != 0) {
+
+            goto Shutdown;
+        }
+    }
+
+    return sched;
+
+Shutdown:
+    pthread_mutex_lock(&sched->lock);
+    atomic_store(&sched->stop, true);
+    pthread_cond_broadcast(&sched->wake);
+    pthread_mutex_unlock(&sched->lock);
+
+    for (usize i = 0; i < num_started; i++) {
+        pthread_join(sched->workers[i].thread, NULL);
+    }
+
+    for (usize i = 0; i < num_ready; i++) {
+        SchedDeque_Fini(&sched->workers[i].deque);
+    }
+
+    pthread_cond_destroy(&sched->joined);
+    pthread_cond_destroy(&sched->wake);
+    pthread_mutex_destroy(&sched->lock);
+    MeMem_Free(sched->workers);
+
+FreeSched:
+    MeMem_Free(sched);
+
+Exit:
+    return NULL;
+}
+
+usize
+Sched_NumWorkers(
+    Sched * sched
+) {
+    return sched->num_workers;
+}
+
+/**
+ * @brief Queues a task, on the deque of the current worker if called from
+ *        a task, so that the worker runs it next unless it is stolen.
+ */
+static
+void
+Sched_Submit(
+    Sched * sched,
+    SchedTask * task
+) {
+    SchedWorker * self = thread_worker;
+
+    if (self != NULL && self->sched == sched &&
+        SchedDeque_Push(&self->deque, task)) {
+
+        Sched_Notify(sched);
+        return;
+    }
+
+    task->next = NULL;
+
+    pthread_mutex_lock(&sched->lock);
+
+    if (sched->tail != NULL) {
+        sched->tail->next = task;
+    } else {
+        sched->head = task;
+    }
+
+    sched->tail = task;
+    atomic_fetch_add(&sched->num_injected, 1);
+
+    pthread_mutex_unlock(&sched->lock);
+
+    Sched_Notify(sched);
+}
+
+/**
+ * @brief Spawns a task into a group, to be run by any worker.
+ *
+ * If memory allocation fails the task is run at once by the caller, so
+ * spawning never fails.
+ */
+void
+Sched_Spawn(
+    Sched * sched,
+    SchedGroup * group,
+    SchedFn fn,
+    void * arg
+) {
+    SchedTask * task = (SchedTask *)MeMem_CacheAlloc(&task_cache);
+    if (task == NULL) {
+        fn(arg);
+        return;
+    }
+
+    task->group = group;
+    task->fn = fn;
+    task->arg = arg;
+    task->loop = NULL;
+
+    atomic_fetch_add(&group->pending, 1);
+    Sched_Submit(sched, task);
+}
+
+/**
+ * @brief Waits until every task spawned into a group is done.
+ *
+ * A worker runs other tasks meanwhile, so tasks may fork and join without
+ * tying up their thread. Other threads help until no task is left to take,
+ * then sleep.
+ */
+void
+Sched_Join(
+    Sched * sched,
+    SchedGroup * group
+) {
+    SchedWorker * self = thread_worker;
+
+    if (self != NULL && self->sched != sched) {
+        self = NULL;
+    }
+
+    while (atomic_load_explicit(&group->pending, memory_order_acquire) != 0) {
+        SchedTask * task = Sched_FindTask(sched, self);
+
+        if (task != NULL) {
+            Sched_RunTask(sched, task);
+        } else if (self != NULL) {
+            sched_yield();
+        } else {
+            pthread_mutex_lock(&sched->lock);
+
+            if (atomic_load(&group->pending) != 0) {
+                pthread_cond_wait(&sched->joined, &sched->lock);
+            }
+
+            pthread_mutex_unlock(&sched->lock);
+        }
+    }
+}
+
+/**
+ * @brief Splits a part of a loop in halves down to the grain, spawning the
+ *        upper halves and running the lowest part itself.
+ */
+static
+void
+Sched_ForRange(
+    SchedFor * loop,
+    usize begin,
+    usize end
+) {
+    while (end - begin > loop->grain) {
+        usize mid = begin + (end - begin) / 2;
+
+        SchedTask * task = (SchedTask *)MeMem_CacheAlloc(&task_cache);
+        if (task == NULL) {
+            break;
+        }
+
+        task->group = &loop->group;
+        task->fn = NULL;
+        task->arg = NULL;
+        task->loop = loop;
+        task->begin = mid;
+        task->end = end;
+
+        atomic_fetch_add(&loop->group.pending, 1);
+        Sched_Submit(loop->sched, task);
+
+        end = mid;
+    }
+
+    loop->fn(loop->ctx, begin, end);
+}
+
+/**
+ * @brief Runs `fn` over the parts of `[begin, end)` in parallel and waits
+ *        for all of them.
+ *
+ * @param grain The largest part run by a single call, `0` to split the
+ *        range in about 8 parts per worker.
+ */
+void
+Sched_ParallelFor(
+    Sched * sched,
+    usize begin,
+    usize end,
+    usize grain,
+    SchedRangeFn fn,
+    void * ctx
+) {
+    if (begin >= end) {
+        return;
+    }
+
+    if (grain == 0) {
+        grain = (end - begin) / (sched->num_workers * 8);
+        if (grain == 0) {
+            grain = 1;
+        }
+    }
+
+    SchedFor loop;
+
+    loop.sched = sched;
+    atomic_init(&loop.group.pending, 0);
+    loop.grain = grain;
+    loop.fn = fn;
+    loop.ctx = ctx;
+
+    Sched_ForRange(&loop, begin, end);
+    Sched_Join(sched, &loop.group);
+}
+
+/**
+ * @brief Stops the workers and releases the scheduler, every group must
+ *        have been joined before.
+ */
+void
+Sched_Free(
+    Sched * sched
+) {
+    pthread_mutex_lock(&sched->lock);
+    atomic_store(&sched->stop, true);
+    pthread_cond_broadcast(&sched->wake);
+    pthread_mutex_unlock(&sched->lock);
+
+    for (usize i = 0; i < sched->num_workers; i++) {
+        pthread_join(sched->workers[i].thread, NULL);
+    }
+
+    for (usize i = 0; i < sched->num_workers; i++) {
+        SchedDeque_Fini(&sched->workers[i].deque);
+    }
+
+    pthread_cond_destroy(&sched->joined);
+    pthread_cond_destroy(&sched->wake);
+    pthread_mutex_destroy(&sched->lock);
+    MeMem_Free(sched->workers);
+    MeMem_Free(sched);
+}
\ No newline at end of file
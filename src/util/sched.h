@@ -0,0 +1,64 @@
+#ifndef __ME_UTIL_SCHED_H__
+#define __ME_UTIL_SCHED_H__
+
+#include <stdatomic.h>
+
+#include "menos.h"
+
+typedef void (* SchedFn)(void * arg);
+
+/* Runs the part `[begin, end)` of a range. */
+typedef void (* SchedRangeFn)(void * ctx, usize begin, usize end);
+
+/* Tasks spawned together and joined together, it may live on the stack of
+   the thread joining it. */
+typedef struct _SchedGroup {
+    atomic_size_t pending;
+} SchedGroup;
+
+#define SCHED_GROUP_INIT    { 0 }
+
+/* Pool of threads running tasks off work-stealing deques. */
+typedef struct _Sched Sched;
+
+Sched *
+Sched_New(
+    usize num_workers,
+    bool pin
+);
+
+usize
+Sched_NumWorkers(
+    Sched * sched
+);
+
+void
+Sched_Spawn(
+    Sched * sched,
+    SchedGroup * group,
+    SchedFn fn,
+    void * arg
+);
+
+void
+Sched_Join(
+    Sched * sched,
+    SchedGroup * group
+);
+
+void
+Sched_ParallelFor(
+    Sched * sched,
+    usize begin,
+    usize end,
+    usize grain,
+    SchedRangeFn fn,
+    void * ctx
+);
+
+void
+Sched_Free(
+    Sched * sched
+);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,305 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include "trace.h"
+
+#define TRACE_RING_MASK     (ME_TRACE_RING_SIZE - 1)
+
+_Static_assert((ME_TRACE_RING_SIZE & TRACE_RING_MASK) == 0,
+    "ME_TRACE_RING_SIZE must be a power of two");
+
+typedef struct _TraceEvent {
+    const char * name;
+    u64 ts_ns;
+
+    /* Rings are reused once their thread exits, so every event keeps the
+       thread that recorded it. */
+    u32 tid;
+    char ph;
+} TraceEvent;
+
+/* Events of one thread, the oldest are overwritten when it is full. */
+typedef struct _TraceRing {
+    TraceEvent events[ME_TRACE_RING_SIZE];
+
+    /* Events ever recorded, only stored by the owning thread. */
+    _Atomic u64 head;
+
+    /* Events already flushed, only touched under `flush_lock`. */
+    u64 tail;
+
+    atomic_bool in_use;
+    struct _TraceRing * next;
+} TraceRing;
+
+atomic_bool
+trace_on = false;
+
+/* Every ring ever created, rings are never unlinked. */
+static
+_Atomic(TraceRing *)
+trace_rings = NULL;
+
+static
+atomic_uint
+trace_next_tid = 1;
+
+static
+pthread_mutex_t
+flush_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static
+_Thread_local TraceRing *
+thread_ring = NULL;
+
+static
+_Thread_local u32
+thread_tid = 0;
+
+static
+pthread_key_t
+ring_key;
+
+static
+pthread_once_t
+ring_key_once = PTHREAD_ONCE_INIT;
+
+static
+void
+TraceRing_OnThreadExit(
+    void * arg
+) {
+    TraceRing * ring = (TraceRing *)arg;
+
+    atomic_store_explicit(&ring->in_use, false, memory_order_release);
+}
+
+static
+void
+TraceRing_CreateKey(void) {
+    pthread_key_create(&ring_key, TraceRing_OnThreadExit);
+}
+
+/**
+ * @brief Takes a ring left by an exited thread, or links a new one.
+ *
+ * Rings are allocated from the C library, tracing neither counts against
+ * the allocator in scope nor shows up in its statistics.
+ */
+static
+TraceRing *
+TraceRing_Acquire(void) {
+    TraceRing * ring;
+
+    pthread_once(&ring_key_once, TraceRing_CreateKey);
+
+    ring = atomic_load_explicit(&trace_rings, memory_order_acquire);
+
+    for (; ring != NULL; ring = ring->next) {
+        bool expected = false;
+
+        if (atomic_compare_exchange_strong(&ring->in_use, &expected, true)) {
+            goto Found;
+        }
+    }
+
+    ring = (TraceRing *)malloc(sizeof(TraceRing));
+    if (ring == NULL) {
+        return NULL;
+    }
+
+    atomic_init(&ring->head, 0);
+    ring->tail = 0;
+    atomic_init(&ring->in_use, true);
+    ring->next = atomic_load_explicit(&trace_rings, memory_order_relaxed);
+
+    while (atomic_compare_exchange_weak_explicit(&trace_rings, &ring->next,
+        ring, memory_order_release, memory_order_relaxed) == false) {}
+
+Found:
+    pthread_setspecific(ring_key, ring);
+
+    return ring;
+}
+
+/**
+ * @brief Appends an event to the ring of the current thread, without taking
+ *        any lock once the ring exists.
+ */
+void
+Trace_Record(
+    const char * name,
+    char ph
+) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    if (ME_UNLIKELY(thread_ring == NULL)) {
+        thread_ring = TraceRing_Acquire();
+        if (thread_ring == NULL) {
+            return;
+        }
+
+        thread_tid = atomic_fetch_add(&trace_next_tid, 1);
+    }
+
+    TraceRing * ring = thread_ring;
+    u64 head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    TraceEvent * ev = ring->events + (head & TRACE_RING_MASK);
+
+    ev->name = name;
+    ev->ts_ns = (u64)ts.tv_sec * 1000000000UL + (u64)ts.tv_nsec;
+    ev->tid = thread_tid;
+    ev->ph = ph;
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void
+Trace_Enable(
+    bool on
+) {
+    atomic_store(&trace_on, on);
+}
+
+static
+bool
+TraceRing_Flush(
+    TraceRing * ring,
+    FlexBuf * buf,
+    pid_t pid,
+    bool * first
+) {
+    u64 head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    u64 idx = ring->tail;
+
+    if (head - idx > ME_TRACE_RING_SIZE) {
+        idx = head - ME_TRACE_RING_SIZE;
+    }
+
+    for (; idx < head; idx++) {
+        TraceEvent ev = ring->events[idx & TRACE_RING_MASK];
+
+        /* The owner may have wrapped around while the event was copied,
+           then the copy can be torn and is dropped. */
+        atomic_thread_fence(memory_order_acquire);
+        u64 now = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        if (now - idx >= ME_TRACE_RING_SIZE) {
+            continue;
+        }
+
+        if (FlexBuf_PushFmt(buf,
+            "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03llu,"
+            "\"pid\":%d,\"tid\":%u}",
+            *first ? "\n" : ",\n", ev.name, ev.ph,
+            (unsigned long long)(ev.ts_ns / 1000),
+            (unsigned long long)(ev.ts_ns % 1000),
+            (int)pid, (unsigned)ev.tid) == false) {
+
+            return false;
+        }
+
+        *first = false;
+    }
+
+    ring->tail = head;
+
+    return true;
+}
+
+/**
+ * @brief Appends the events recorded since the last flush to a FlexBuf, as
+ *        a Chrome trace-event JSON document that Perfetto also loads.
+ *
+ * Threads may keep recording meanwhile. Events overwritten before they
+ * were flushed are lost, so a span may lack its begin or end event.
+ *
+ * @return `true` on success, `false` if memory allocation fails.
+ */
+bool
+Trace_Flush(
+    FlexBuf * buf
+) {
+    bool first = true;
+    bool res = false;
+    pid_t pid = getpid();
+
+    pthread_mutex_lock(&flush_lock);
+
+    if (FlexBuf_PushStr(buf, "{\"traceEvents\":[") == false) {
+        goto Unlock;
+    }
+
+    TraceRing * ring = atomic_load_explicit(&trace_rings,
+        memory_order_acquire);
+
+    for (; ring != NULL; ring = ring->next) {
+        if (TraceRing_Flush(ring, buf, pid, &first) == false) {
+            goto Unlock;
+        }
+    }
+
+    res = FlexBuf_PushStr(buf, "\n]}\n");
+
+Unlock:
+    pthread_mutex_unlock(&flush_lock);
+
+    return res;
+}
+
+/**
+ * @brief Flushes the recorded events to a file, replacing its contents.
+ *
+ * @return `true` on success, `false` if the file cannot be written or
+ *         memory allocation fails.
+ */
+bool
+Trace_WriteFile(
+    const char * path
+) {
+    bool res = false;
+
+    FlexBuf * buf = FlexBuf_New();
+    if (buf == NULL) {
+        goto Exit;
+    }
+
+    if (Trace_Flush(buf) == false) {
+        goto FreeBuf;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        goto FreeBuf;
+    }
+
+    const u8 * data = FlexBuf_Data(buf);
+    usize len = FlexBuf_Size(buf);
+
+    while (len > 0) {
+        ssize_t num = write(fd, data, len);
+        if (num <= 0) {
+            goto CloseFile;
+        }
+
+        data += num;
+        len -= (usize)num;
+    }
+
+    res = true;
+
+CloseFile:
+    if (close(fd) != 0) {
+        res = false;
+    }
+
+FreeBuf:
+    FlexBuf_Free(buf);
+
+Exit:
+    return res;
+}
\ No newline at end of file
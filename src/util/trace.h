@@ -0,0 +1,81 @@
+#ifndef __ME_UTIL_TRACE_H__
+#define __ME_UTIL_TRACE_H__
+
+#include <stdatomic.h>
+
+#include "menos.h"
+#include "config.h"
+#include "util/flex_buf.h"
+
+/* Whether events are being recorded, see `Trace_Enable`. */
+extern atomic_bool trace_on;
+
+void
+Trace_Record(
+    const char * name,
+    char ph
+);
+
+/**
+ * @brief Records the start of a span on the current thread, if tracing is
+ *        enabled. The name must outlive the trace, a string literal.
+ *
+ * @return Whether the span is recorded, to be passed to `Trace_End` so that
+ *         its end is recorded exactly when its start was, even if tracing
+ *         is enabled or disabled in between.
+ */
+static
+inline
+bool
+Trace_Begin(
+    const char * name
+) {
+#if ME_TRACE
+    if (ME_UNLIKELY(atomic_load_explicit(&trace_on, memory_order_relaxed))) {
+        Trace_Record(name, 'B');
+        return true;
+    }
+#else
+    (void)name;
+#endif
+
+    return false;
+}
+
+/**
+ * @brief Records the end of the span last begun on the current thread, if
+ *        its start was recorded.
+ */
+static
+inline
+void
+Trace_End(
+    const char * name,
+    bool began
+) {
+#if ME_TRACE
+    if (ME_UNLIKELY(began)) {
+        Trace_Record(name, 'E');
+    }
+#else
+    (void)name;
+    (void)began;
+#endif
+}
+
+void
+Trace_Enable(
+    bool on
+);
+
+bool
+Trace_Flush(
+    FlexBuf * buf
+);
+
+bool
+Trace_WriteFile(
+    const char * path
+);
+
+#endif
\ No newline at end of file
@@ -1,17 +1,29 @@
 #include "greatest.h"
 
+SUITE(AotSuite);
 SUITE(FixedBufSuite);
 SUITE(FlexBufSuite);
+SUITE(GcSuite);
+SUITE(InterpSuite);
 SUITE(LexerSuite);
+SUITE(ParserSuite);
+SUITE(PoolSuite);
+SUITE(SchedSuite);
 
 GREATEST_MAIN_DEFS();
 
 int main(int argc, char **argv) {
     GREATEST_MAIN_BEGIN();
 
+    RUN_SUITE(AotSuite);
     RUN_SUITE(FixedBufSuite);
     RUN_SUITE(FlexBufSuite);
+    RUN_SUITE(GcSuite);
+    RUN_SUITE(InterpSuite);
     RUN_SUITE(LexerSuite);
+    RUN_SUITE(ParserSuite);
+    RUN_SUITE(PoolSuite);
+    RUN_SUITE(SchedSuite);
 
     GREATEST_MAIN_END();
 }
\ No newline at end of file
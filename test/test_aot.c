@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "greatest.h"
+#include "menos.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "runtime/aot.h"
+#include "runtime/aot_rt.h"
+#include "runtime/interp.h"
+
+/* Programs run by both the interpreter and their translation. */
+static const char * const CORPUS[] = {
+    "a = 2 + 3 * 4;\n"
+    "b = a ^ 2;\n"
+    "c = -a % 5;\n"
+    "if a > 10 and not (b == 0) { d = 1; } else { d = 2; }\n"
+    "e = a / 0 == 1 or true;\n",
+
+    "fn fib(n) {\n"
+    "    if n < 2 { return n; }\n"
+    "    return fib(n - 1) + fib(n - 2);\n"
+    "}\n"
+    "r = fib(20);\n",
+
+    "fn sum(n, acc) {\n"
+    "    if n == 0 { return acc; }\n"
+    "    return sum(n - 1, acc + n);\n"
+    "}\n"
+    "r = sum(100000, 0);\n",
+
+    "fn name(n) {\n"
+    "    match n {\n"
+    "        1 { s = \"one\"; }\n"
+    "        2 { s = \"two\"; }\n"
+    "        -7 { s = \"minus seven\"; }\n"
+    "        \"x\" { s = \"ex\"; }\n"
+    "        true { s = \"yes\"; }\n"
+    "        else { s = \"many\"; }\n"
+    "    }\n"
+    "    return s + \"!\";\n"
+    "}\n"
+    "a = name(1);\n"
+    "b = name(-7);\n"
+    "c = name(\"x\");\n"
+    "d = name(true);\n"
+    "e = name(false);\n"
+    "f = name(99);\n",
+
+    "fn depth(n) { return 1 + depth(n + 1); }\n"
+    "a = 1;\n"
+    "r = depth(0);\n",
+
+    "fn f(a, b) { return a + b; }\n"
+    "x = f(1, 2);\n"
+    "y = f(\"a\", 2);\n",
+
+    "a = 2 ^ 100;\n"
+    "b = 99999999999999999999999 * a - 1;\n"
+    "c = b / 12345678901 % 1000;\n"
+    "match a {\n"
+    "    1267650600228229401496703205376 { d = 1; }\n"
+    "    -1 { d = 2; }\n"
+    "    else { d = 3; }\n"
+    "}\n"
+    "e = -9223372036854775807 - 1 - 1 + 1;\n",
+
+    "keep = \"ke\" + \"ep\";\n"
+    "fn churn(n, s) {\n"
+    "    if n == 0 { return s; }\n"
+    "    t = s + \"abcdefghijklmnopqrstuvwxyz\";\n"
+    "    return churn(n - 1, \"k\" + \"v\");\n"
+    "}\n"
+    "r = keep + churn(50000, \"\");\n",
+};
+
+typedef struct _AotRes {
+    Lexer * lex;
+    LexOut * lo;
+    Parser * par;
+    AstNode * tree;
+    Interp * interp;
+    FlexBuf * src;
+    AotLib * lib;
+    char dir[32];
+    char c_path[64];
+    char so_path[64];
+} AotRes;
+
+static
+void
+AotRes_Free(
+    AotRes * res
+) {
+    if (res->lib != NULL) {
+        AotLib_Close(res->lib);
+    }
+
+    if (res->src != NULL) {
+        FlexBuf_Free(res->src);
+    }
+
+    if (res->interp != NULL) {
+        Interp_Free(res->interp);
+    }
+
+    if (res->tree != NULL) {
+        AstNode_FreeTree(res->tree);
+    }
+
+    if (res->lo != NULL) {
+        LexOut_Free(res->lo);
+    }
+
+    if (res->par != NULL) {
+        Parser_Free(res->par);
+    }
+
+    if (res->lex != NULL) {
+        Lexer_Free(res->lex);
+    }
+
+    if (res->dir[0] != '\0') {
+        unlink(res->c_path);
+        unlink(res->so_path);
+        rmdir(res->dir);
+    }
+}
+
+/* Loads a program, translates it and compiles the translation. */
+static
+bool
+AotStr(
+    const char * str,
+    AotRes * res
+) {
+    char cmd[512];
+
+    memset(res, 0, sizeof(AotRes));
+
+    if (res->lex = Lexer_New(), res->lex == NULL ||
+        Lexer_ScanBuf(res->lex, str, strlen(str), &res->lo) == false ||
+        (res->par = Parser_New(), res->par == NULL)) {
+
+        return false;
+    }
+
+    Parser_Link(res->par, res->lo);
+
+    if (Parser_Parse(res->par, &res->tree) == false ||
+        (res->interp = Interp_New(), res->interp == NULL) ||
+        Interp_Load(res->interp, res->tree) == false ||
+        (res->src = FlexBuf_New(), res->src == NULL) ||
+        Aot_Translate(res->interp, res->src) == false) {
+
+        return false;
+    }
+
+    strcpy(res->dir, "/tmp/menos_aot_XXXXXX");
+    if (mkdtemp(res->dir) == NULL) {
+        res->dir[0] = '\0';
+        return false;
+    }
+
+    snprintf(res->c_path, sizeof(res->c_path), "%s/prog.c", res->dir);
+    snprintf(res->so_path, sizeof(res->so_path), "%s/prog.so", res->dir);
+
+    FILE * file = fopen(res->c_path, "w");
+    if (file == NULL) {
+        return false;
+    }
+
+    fwrite(FlexBuf_Data(res->src), 1, FlexBuf_Size(res->src), file);
+    fclose(file);
+
+    snprintf(cmd, sizeof(cmd),
+        "%s -shared -fPIC -O1 -Wall -Werror -I%s -o %s %s",
+        ME_AOT_CC, ME_SOURCE_DIR, res->so_path, res->c_path);
+
+    if (system(cmd) != 0) {
+        return false;
+    }
+
+    res->lib = AotLib_Open(res->so_path);
+
+    return res->lib != NULL;
+}
+
+/* The translation is compiled with the compiler that built the tests, so
+   a missing or broken compiler fails the test rather than skipping it. */
+TEST TranslationMatchesInterpreter(void) {
+    for (usize i = 0; i < sizeof(CORPUS) / sizeof(CORPUS[0]); i++) {
+        AotRes res;
+        AotCtx ctx;
+
+        ASSERTm("translation failed to compile", AotStr(CORPUS[i], &res));
+
+        const AotProg * prog = AotLib_Prog(res.lib);
+        bool interp_ok = Interp_Run(res.interp);
+        bool aot_ok = AotLib_Run(res.lib, &ctx);
+
+        ASSERT_EQ(interp_ok, aot_ok);
+        ASSERT_EQ(Interp_ErrorType(res.interp), ctx.err);
+        ASSERT_EQ(Interp_GlobalCount(res.interp), prog->num_globals);
+
+        for (usize j = 0; j < prog->num_globals; j++) {
+            Value * val = AotProg_Global(prog, prog->global_names[j]);
+            ASSERT_NEQ(NULL, val);
+            ASSERT(Value_Equals(
+                Interp_Global(res.interp, prog->global_names[j]), val));
+        }
+
+        AotRes_Free(&res);
+    }
+
+    PASS();
+}
+
+SUITE(AotSuite) {
+    RUN_TEST(TranslationMatchesInterpreter);
+}
\ No newline at end of file
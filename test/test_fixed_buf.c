@@ -84,6 +84,23 @@ TEST CreateFromFormat(void) {
     PASS();
 }
 
+TEST CreateFromLongFormat(void) {
+    char str[257];
+
+    memset(str, 'x', sizeof(str) - 1);
+    str[sizeof(str) - 1] = '\0';
+
+    /* One past the size of the stack buffer used for formatting. */
+    FixedBuf * buf = FixedBuf_NewFromFmt("%s", str);
+    ASSERT_NEQ(NULL, buf);
+    ASSERT_EQ_FMT(sizeof(str) - 1, FixedBuf_Size(buf), "%zu");
+    ASSERT_MEM_EQ(str, FixedBuf_Data(buf), sizeof(str) - 1);
+
+    FixedBuf_Free(buf);
+
+    PASS();
+}
+
 TEST EscapeString(void) {
     const char * SRC_STR = "\"Hello\\ \x1B[34\t \r\n\"";
     const usize SRC_LEN = strlen(SRC_STR);
@@ -238,6 +255,7 @@ SUITE(FixedBufSuite) {
     RUN_TEST(CreateFromString);
     RUN_TEST(CreateFromStringWithNull);
     RUN_TEST(CreateFromFormat);
+    RUN_TEST(CreateFromLongFormat);
     RUN_TEST(EscapeString);
     RUN_TEST(StripLeftSide);
     RUN_TEST(StripRightSide);
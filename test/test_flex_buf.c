@@ -71,8 +71,106 @@ TEST PushBuffer(void) {
 }
 
 
+TEST ReserveCapacity(void) {
+    FlexBuf * buf = FlexBuf_New();
+    ASSERT_NEQ(NULL, buf);
+
+    const usize LEN = 1000;
+
+    ASSERT(FlexBuf_Reserve(buf, LEN));
+    ASSERT_EQ_FMT(LEN, FlexBuf_Capacity(buf), "%zu");
+    ASSERT_EQ_FMT(0UL, FlexBuf_Size(buf), "%zu");
+
+    /* Appends within the reserved room keep the buffer in place. */
+    u8 * data = FlexBuf_Data(buf);
+
+    for (usize i = 0; i < LEN; i++) {
+        ASSERT(FlexBuf_PushByte(buf, (u8)i));
+    }
+
+    ASSERT_EQ_FMT(data, FlexBuf_Data(buf), "%p");
+    ASSERT_EQ_FMT(LEN, FlexBuf_Capacity(buf), "%zu");
+
+    /* Past it the capacity grows geometrically. */
+    ASSERT(FlexBuf_PushByte(buf, 0));
+    ASSERT(FlexBuf_Capacity(buf) >= LEN * 3 / 2);
+
+    ASSERT(FlexBuf_Reserve(buf, 0));
+    ASSERT_EQ(false, FlexBuf_Reserve(buf, (usize)-1));
+
+    FlexBuf_Free(buf);
+
+    PASS();
+}
+
+TEST ReserveTailThenCommit(void) {
+    FlexBuf * buf = FlexBuf_New();
+    ASSERT_NEQ(NULL, buf);
+
+    ASSERT(FlexBuf_PushStr(buf, "ab"));
+
+    u8 * tail = FlexBuf_ReserveTail(buf, 3);
+    ASSERT_NEQ(NULL, tail);
+    ASSERT_EQ_FMT(2UL, FlexBuf_Size(buf), "%zu");
+    ASSERT(FlexBuf_Capacity(buf) >= 5);
+
+    memcpy(tail, "cde", 3);
+    FlexBuf_Commit(buf, 3);
+
+    ASSERT_EQ_FMT(5UL, FlexBuf_Size(buf), "%zu");
+    ASSERT_MEM_EQ("abcde", FlexBuf_Data(buf), 5);
+
+    FlexBuf_Free(buf);
+
+    PASS();
+}
+
+TEST PushFormattedAndNumbers(void) {
+    FlexBuf * buf = FlexBuf_New();
+    ASSERT_NEQ(NULL, buf);
+
+    /* Longer than the room first tried, so it is formatted again. */
+    char long_str[300];
+    memset(long_str, 'x', sizeof(long_str) - 1);
+    long_str[sizeof(long_str) - 1] = '\0';
+
+    ASSERT(FlexBuf_PushFmt(buf, "<%s>", long_str));
+    ASSERT_EQ_FMT(sizeof(long_str) + 1, FlexBuf_Size(buf), "%zu");
+    ASSERT_EQ('>', FlexBuf_Data(buf)[FlexBuf_Size(buf) - 1]);
+
+    FlexBuf_Clear(buf);
+
+    ASSERT(FlexBuf_PushUInt(buf, 0));
+    ASSERT(FlexBuf_PushByte(buf, ' '));
+    ASSERT(FlexBuf_PushUInt(buf, UINT64_MAX));
+    ASSERT(FlexBuf_PushByte(buf, ' '));
+    ASSERT(FlexBuf_PushInt(buf, -42));
+    ASSERT(FlexBuf_PushByte(buf, ' '));
+    ASSERT(FlexBuf_PushInt(buf, INT64_MIN));
+
+    const char * EXPECTED =
+        "0 18446744073709551615 -42 -9223372036854775808";
+    ASSERT_EQ_FMT(strlen(EXPECTED), FlexBuf_Size(buf), "%zu");
+    ASSERT_MEM_EQ(EXPECTED, FlexBuf_Data(buf), strlen(EXPECTED));
+
+    FlexBuf_Clear(buf);
+
+    ASSERT(FlexBuf_PushEscaped(buf, "a\"b\\c\td\n\x01", 9));
+
+    EXPECTED = "a\\\"b\\\\c\\td\\n\\x01";
+    ASSERT_EQ_FMT(strlen(EXPECTED), FlexBuf_Size(buf), "%zu");
+    ASSERT_MEM_EQ(EXPECTED, FlexBuf_Data(buf), strlen(EXPECTED));
+
+    FlexBuf_Free(buf);
+
+    PASS();
+}
+
 SUITE(FlexBufSuite) {
     RUN_TEST(CreateEmptyBuffer);
     RUN_TEST(PushByte);
     RUN_TEST(PushBuffer);
+    RUN_TEST(ReserveCapacity);
+    RUN_TEST(ReserveTailThenCommit);
+    RUN_TEST(PushFormattedAndNumbers);
 }
\ No newline at end of file
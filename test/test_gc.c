@@ -0,0 +1,353 @@
+#include <sched.h>
+
+#include "greatest.h"
+#include "menos.h"
+#include "config.h"
+#include "memory/gc.h"
+
+typedef struct _Cell {
+    struct _Cell * next;
+    usize val;
+} Cell;
+
+static
+void
+Cell_Trace(
+    Gc * gc,
+    void * obj,
+    usize size,
+    GcVisitFn visit
+) {
+    (void)size;
+
+    visit(gc, (void **)&((Cell *)obj)->next);
+}
+
+static
+const GcType
+cell_type = {
+    "cell",
+    Cell_Trace,
+};
+
+/* Objects without references, to fill the old generation. */
+static
+const GcType
+blob_type = {
+    "blob",
+    NULL,
+};
+
+#define NUM_ROOTS 4
+
+/* Roots held by the tests. */
+static Cell * roots[NUM_ROOTS];
+
+static
+void
+VisitRoots(
+    Gc * gc,
+    void * ctx,
+    GcVisitFn visit
+) {
+    (void)ctx;
+
+    for (usize i = 0; i < NUM_ROOTS; i++) {
+        visit(gc, (void **)&roots[i]);
+    }
+}
+
+/* Creates a heap with a small nursery and cleared roots. */
+static
+Gc *
+NewGc(void) {
+    for (usize i = 0; i < NUM_ROOTS; i++) {
+        roots[i] = NULL;
+    }
+
+    Gc * gc = Gc_New(4096);
+    if (gc != NULL) {
+        Gc_SetRoots(gc, VisitRoots, NULL);
+    }
+
+    return gc;
+}
+
+/* Prepends a cell to the list in a root. */
+static
+bool
+Push(
+    Gc * gc,
+    usize root,
+    usize val
+) {
+    Cell * cell = (Cell *)Gc_Alloc(gc, &cell_type, sizeof(Cell));
+    if (cell == NULL) {
+        return false;
+    }
+
+    cell->next = roots[root];
+    cell->val = val;
+    roots[root] = cell;
+
+    return true;
+}
+
+/* Checks that a list holds `num` down to 1. */
+static
+bool
+CheckList(
+    Cell * cell,
+    usize num
+) {
+    for (usize i = num; i > 0; i--) {
+        if (cell == NULL || cell->val != i) {
+            return false;
+        }
+
+        cell = cell->next;
+    }
+
+    return cell == NULL;
+}
+
+TEST MinorCopiesReachableObjects(void) {
+    Gc * gc = NewGc();
+    ASSERT_NEQ(NULL, gc);
+
+    for (usize i = 1; i <= 10; i++) {
+        ASSERT(Push(gc, 0, i));
+        ASSERT(Push(gc, 1, i));
+    }
+
+    Cell * before = roots[0];
+    roots[1] = NULL;
+
+    ASSERT(Gc_Collect(gc, false));
+    ASSERT_NEQ(before, roots[0]);
+    ASSERT(CheckList(roots[0], 10));
+
+    GcStats stats;
+    Gc_Stats(gc, &stats);
+
+    ASSERT_EQ(1, stats.num_minor);
+    ASSERT_EQ(0, stats.num_major);
+    ASSERT_EQ(stats.bytes_allocated / 2, stats.bytes_freed);
+    ASSERT_EQ(stats.bytes_allocated / 2, stats.young_bytes);
+    ASSERT_EQ(0, stats.old_bytes);
+
+    Gc_Free(gc);
+    PASS();
+}
+
+TEST SurvivorsArePromoted(void) {
+    Gc * gc = NewGc();
+    ASSERT_NEQ(NULL, gc);
+
+    ASSERT(Push(gc, 0, 1));
+
+    for (usize i = 0; i < ME_GC_PROMOTE_AGE; i++) {
+        ASSERT(Gc_Collect(gc, false));
+    }
+
+    GcStats stats;
+    Gc_Stats(gc, &stats);
+
+    ASSERT_EQ(0, stats.young_bytes);
+    ASSERT_EQ(stats.bytes_allocated, stats.bytes_promoted);
+    ASSERT_EQ(stats.bytes_allocated, stats.old_bytes);
+    ASSERT(CheckList(roots[0], 1));
+
+    Gc_Free(gc);
+    PASS();
+}
+
+TEST NurseryOverflowWaitsForSafepoint(void) {
+    Gc * gc = NewGc();
+    ASSERT_NEQ(NULL, gc);
+
+    /* Twice the nursery, the overflow goes to the old generation. */
+    for (usize i = 1; i <= 8192 / sizeof(Cell); i++) {
+        ASSERT(Push(gc, 0, i));
+    }
+
+    GcStats stats;
+    Gc_Stats(gc, &stats);
+
+    ASSERT_EQ(0, stats.num_minor);
+    ASSERT(stats.old_bytes > 0);
+
+    ASSERT(Gc_Poll(gc));
+    Gc_Stats(gc, &stats);
+
+    ASSERT_EQ(1, stats.num_minor);
+    ASSERT(CheckList(roots[0], 8192 / sizeof(Cell)));
+
+    ASSERT(Gc_Poll(gc));
+    Gc_Stats(gc, &stats);
+
+    ASSERT_EQ(1, stats.num_minor);
+
+    Gc_Free(gc);
+    PASS();
+}
+
+TEST WriteBarrierKeepsYoungReferents(void) {
+    Gc * gc = NewGc();
+    ASSERT_NEQ(NULL, gc);
+
+    Cell * holder = (Cell *)Gc_AllocOld(gc, &cell_type, sizeof(Cell));
+    ASSERT_NEQ(NULL, holder);
+    roots[0] = holder;
+
+    ASSERT(Push(gc, 1, 7));
+    holder->next = roots[1];
+    Gc_WriteBarrier(gc, holder, roots[1]);
+    roots[1] = NULL;
+
+    /* Only reachable through the old holder. */
+    ASSERT(Gc_Collect(gc, false));
+    ASSERT_EQ(holder, roots[0]);
+    ASSERT_NEQ(NULL, holder->next);
+    ASSERT_EQ(7, holder->next->val);
+
+    /* Still remembered while the referent is young. */
+    ASSERT(Gc_Collect(gc, false));
+    ASSERT_EQ(7, holder->next->val);
+
+    Gc_Free(gc);
+    PASS();
+}
+
+TEST MajorSweepsUnreachableOldObjects(void) {
+    Gc * gc = NewGc();
+    ASSERT_NEQ(NULL, gc);
+
+    for (usize i = 1; i <= 3; i++) {
+        ASSERT(Push(gc, 0, i));
+        ASSERT(Push(gc, 1, i));
+    }
+
+    for (usize i = 0; i < ME_GC_PROMOTE_AGE; i++) {
+        ASSERT(Gc_Collect(gc, false));
+    }
+
+    GcStats stats;
+    Gc_Stats(gc, &stats);
+    usize old_bytes = stats.old_bytes;
+
+    roots[1] = NULL;
+
+    ASSERT(Gc_Collect(gc, true));
+    Gc_Stats(gc, &stats);
+
+    ASSERT_EQ(1, stats.num_major);
+    ASSERT_EQ(old_bytes / 2, stats.old_bytes);
+    ASSERT_EQ(stats.bytes_allocated / 2, stats.bytes_freed);
+    ASSERT(CheckList(roots[0], 3));
+
+    Gc_Clear(gc);
+    Gc_Stats(gc, &stats);
+
+    ASSERT_EQ(0, stats.old_bytes);
+    ASSERT_EQ(stats.bytes_allocated, stats.bytes_freed);
+
+    Gc_Free(gc);
+    PASS();
+}
+
+/* Runs an incremental major collection while the mutator relinks a list of
+   old cells. */
+static
+enum greatest_test_res
+IncrementalCycle(
+    bool background
+) {
+    Gc * gc = NewGc();
+    ASSERT_NEQ(NULL, gc);
+
+    Gc_SetStepBudget(gc, 64);
+    Gc_SetBackgroundSweep(gc, background);
+
+    for (usize i = 1; i <= 64; i++) {
+        Cell * cell = (Cell *)Gc_AllocOld(gc, &cell_type, sizeof(Cell));
+        ASSERT_NEQ(NULL, cell);
+
+        cell->next = roots[0];
+        cell->val = i;
+        Gc_WriteBarrier(gc, cell, roots[0]);
+        roots[0] = cell;
+    }
+
+    /* Unreachable, enough to start a cycle. */
+    for (usize i = 0; i < ME_GC_OLD_MIN_BYTES / (1024 * 1024) + 1; i++) {
+        ASSERT_NEQ(NULL, Gc_AllocOld(gc, &blob_type, 1024 * 1024));
+    }
+
+    for (usize i = 0; i < 3; i++) {
+        ASSERT(Gc_Poll(gc));
+    }
+
+    GcStats stats;
+    Gc_Stats(gc, &stats);
+    ASSERT_EQ(0, stats.num_major);
+
+    /* Cut the list at 32, the rest only stays reachable through a new old
+       cell, which is not traced again. */
+    Cell * cut = roots[0];
+    while (cut->val != 32) {
+        cut = cut->next;
+    }
+
+    Cell * holder = (Cell *)Gc_AllocOld(gc, &cell_type, sizeof(Cell));
+    ASSERT_NEQ(NULL, holder);
+
+    holder->next = cut->next;
+    holder->val = 32;
+    Gc_WriteBarrier(gc, holder, cut->next);
+    cut->next = NULL;
+    roots[1] = holder;
+
+    for (usize i = 0; i < 1000000 && stats.num_major == 0; i++) {
+        ASSERT(Gc_Poll(gc));
+        Gc_Stats(gc, &stats);
+        sched_yield();
+    }
+
+    ASSERT_EQ(1, stats.num_major);
+    ASSERT(stats.num_steps > 1);
+    ASSERT(stats.bytes_freed >= ME_GC_OLD_MIN_BYTES);
+    ASSERT(stats.old_bytes < 64 * 1024);
+
+    Cell * cell = roots[0];
+    for (usize i = 64; i >= 32; i--) {
+        ASSERT_EQ(i, cell->val);
+        cell = cell->next;
+    }
+    ASSERT_EQ(NULL, cell);
+
+    ASSERT(CheckList(roots[1]->next, 31));
+
+    Gc_Free(gc);
+    PASS();
+}
+
+TEST IncrementalMarkingKeepsReachableObjects(void) {
+    CHECK_CALL(IncrementalCycle(false));
+    PASS();
+}
+
+TEST BackgroundSweepKeepsReachableObjects(void) {
+    CHECK_CALL(IncrementalCycle(true));
+    PASS();
+}
+
+SUITE(GcSuite) {
+    RUN_TEST(MinorCopiesReachableObjects);
+    RUN_TEST(SurvivorsArePromoted);
+    RUN_TEST(NurseryOverflowWaitsForSafepoint);
+    RUN_TEST(WriteBarrierKeepsYoungReferents);
+    RUN_TEST(MajorSweepsUnreachableOldObjects);
+    RUN_TEST(IncrementalMarkingKeepsReachableObjects);
+    RUN_TEST(BackgroundSweepKeepsReachableObjects);
+}
\ No newline at end of file
@@ -0,0 +1,733 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "greatest.h"
+#include "menos.h"
+#include "config.h"
+#include "lexer/lexer.h"
+#include "memory/pool.h"
+#include "parser/parser.h"
+#include "runtime/interp.h"
+#include "runtime/prof.h"
+#include "runtime/snapshot.h"
+#include "util/fixed_buf.h"
+#include "util/map_file.h"
+
+typedef struct _RunRes {
+    Lexer * lex;
+    LexOut * lo;
+    Parser * par;
+    AstNode * tree;
+    Interp * interp;
+} RunRes;
+
+/* Scans, parses and loads a program, runs it if `run` is set. */
+static
+bool
+RunStr(
+    const char * str,
+    bool run,
+    RunRes * res
+) {
+    memset(res, 0, sizeof(RunRes));
+
+    if (res->lex = Lexer_New(), res->lex == NULL ||
+        Lexer_ScanBuf(res->lex, str, strlen(str), &res->lo) == false ||
+        (res->par = Parser_New(), res->par == NULL)) {
+
+        return false;
+    }
+
+    Parser_Link(res->par, res->lo);
+
+    if (Parser_Parse(res->par, &res->tree) == false ||
+        (res->interp = Interp_New(), res->interp == NULL) ||
+        Interp_Load(res->interp, res->tree) == false) {
+
+        return false;
+    }
+
+    return run == false || Interp_Run(res->interp);
+}
+
+static
+void
+RunRes_Free(
+    RunRes * res
+) {
+    if (res->interp != NULL) {
+        Interp_Free(res->interp);
+    }
+
+    if (res->tree != NULL) {
+        AstNode_FreeTree(res->tree);
+    }
+
+    if (res->lo != NULL) {
+        LexOut_Free(res->lo);
+    }
+
+    if (res->par != NULL) {
+        Parser_Free(res->par);
+    }
+
+    if (res->lex != NULL) {
+        Lexer_Free(res->lex);
+    }
+}
+
+#define ASSERT_GLOBAL_NUM(interp, name, expected)                   \
+    do {                                                            \
+        Value * _val = Interp_Global(interp, name);                 \
+        ASSERT_NEQ(NULL, _val);                                     \
+        ASSERT_EQ(ValTag_Num, _val->tag);                           \
+        ASSERT_EQ_FMT((ssize)(expected), _val->ext.num, "%zd");     \
+    } while (false)
+
+/* Checks a global that holds an integer beyond `ssize`. */
+#define ASSERT_GLOBAL_BIG(interp, name, expected)                   \
+    do {                                                            \
+        Value * _val = Interp_Global(interp, name);                 \
+        ASSERT_NEQ(NULL, _val);                                     \
+        ASSERT_EQ(ValTag_Big, _val->tag);                           \
+        FlexBuf * _buf = FlexBuf_New();                             \
+        ASSERT_NEQ(NULL, _buf);                                     \
+        ASSERT(Value_PushAsStr(_val, _buf));                        \
+        ASSERT_EQ(strlen(expected), FlexBuf_Size(_buf));            \
+        ASSERT_MEM_EQ(expected, FlexBuf_Data(_buf), strlen(expected)); \
+        FlexBuf_Free(_buf);                                         \
+    } while (false)
+
+/* Checks a global that holds a string. */
+#define ASSERT_GLOBAL_STR(interp, name, expected)                   \
+    do {                                                            \
+        Value * _val = Interp_Global(interp, name);                 \
+        ASSERT_NEQ(NULL, _val);                                     \
+        ASSERT_EQ(ValTag_Str, _val->tag);                           \
+        FlexBuf * _buf = FlexBuf_New();                             \
+        ASSERT_NEQ(NULL, _buf);                                     \
+        ASSERT(Value_PushAsStr(_val, _buf));                        \
+        ASSERT_EQ(strlen(expected), FlexBuf_Size(_buf));            \
+        ASSERT_MEM_EQ(expected, FlexBuf_Data(_buf), strlen(expected)); \
+        FlexBuf_Free(_buf);                                         \
+    } while (false)
+
+TEST ArithmeticAndGlobals(void) {
+    const char * INPUT_STR =
+        "a = 2 + 3 * 4;\n"
+        "b = a ^ 2;\n"
+        "c = -a % 5;\n"
+        "if a > 10 and not (b == 0) { d = 1; } else { d = 2; }\n";
+
+    RunRes res;
+    ASSERT(RunStr(INPUT_STR, true, &res));
+
+    ASSERT_GLOBAL_NUM(res.interp, "a", 14);
+    ASSERT_GLOBAL_NUM(res.interp, "b", 196);
+    ASSERT_GLOBAL_NUM(res.interp, "c", -4);
+    ASSERT_GLOBAL_NUM(res.interp, "d", 1);
+
+    RunRes_Free(&res);
+
+    PASS();
+}
+
+TEST RecursiveCalls(void) {
+    const char * INPUT_STR =
+        "fn fib(n) {\n"
+        "    if n < 2 { return n; }\n"
+        "    return fib(n - 1) + fib(n - 2);\n"
+        "}\n"
+        "r = fib(20);\n";
+
+    RunRes res;
+    ASSERT(RunStr(INPUT_STR, true, &res));
+
+    ASSERT_GLOBAL_NUM(res.interp, "r", 6765);
+
+    RunRes_Free(&res);
+
+    PASS();
+}
+
+TEST TailCallsReuseFrame(void) {
+    const char * INPUT_STR =
+        "fn sum(n, acc) {\n"
+        "    if n == 0 { return acc; }\n"
+        "    return sum(n - 1, acc + n);\n"
+        "}\n"
+        "r = sum(100000, 0);\n";
+
+    RunRes res;
+    ASSERT(RunStr(INPUT_STR, true, &res));
+
+    ASSERT_GLOBAL_NUM(res.interp, "r", 5000050000L);
+
+    RunRes_Free(&res);
+
+    PASS();
+}
+
+TEST DeepRecursionOverflows(void) {
+    const char * INPUT_STR =
+        "fn depth(n) {\n"
+        "    if n == 0 { return 0; }\n"
+        "    return 1 + depth(n - 1);\n"
+        "}\n"
+        "r = depth(100000);\n";
+
+    RunRes res;
+    ASSERT_FALSE(RunStr(INPUT_STR, true, &res));
+    ASSERT_EQ(InterpErr_StackOverflow, Interp_ErrorType(res.interp));
+
+    RunRes_Free(&res);
+
+    PASS();
+}
+
+TEST MatchDispatchInFunction(void) {
+    const char * INPUT_STR =
+        "fn code(m) {\n"
+        "    match m {\n"
+        "        \"get\" { c = 1; }\n"
+        "        \"put\" { c = 2; }\n"
+        "        else { c = 0; }\n"
+        "    }\n"
+        "    return c;\n"
+        "}\n"
+        "a = code(\"put\");\n"
+        "b = code(\"post\");\n";
+
+    RunRes res;
+    ASSERT(RunStr(INPUT_STR, true, &res));
+
+    ASSERT_GLOBAL_NUM(res.interp, "a", 2);
+    ASSERT_GLOBAL_NUM(res.interp, "b", 0);
+
+    RunRes_Free(&res);
+
+    PASS();
+}
+
+TEST ResolveErrors(void) {
+    RunRes res;
+
+    ASSERT_FALSE(RunStr("fn f(a) { return a; } r = f(1, 2);", false, &res));
+    ASSERT_EQ(InterpErr_ArityMismatch, Interp_ErrorType(res.interp));
+    RunRes_Free(&res);
+
+    ASSERT_FALSE(RunStr("r = g(1);", false, &res));
+    ASSERT_EQ(InterpErr_UndefinedFunction, Interp_ErrorType(res.interp));
+    RunRes_Free(&res);
+
+    ASSERT_FALSE(RunStr("r = x + 1;", false, &res));
+    ASSERT_EQ(InterpErr_UndefinedVariable, Interp_ErrorType(res.interp));
+    RunRes_Free(&res);
+
+    ASSERT_FALSE(RunStr("return 1;", false, &res));
+    ASSERT_EQ(InterpErr_ReturnOutsideFunction, Interp_ErrorType(res.interp));
+    RunRes_Free(&res);
+
+    PASS();
+}
+
+TEST JitMatchesInterpreter(void) {
+    const char * INPUT_STR =
+        "fn step(n, acc) {\n"
+        "    if n == 0 { return acc; }\n"
+        "    if n % 3 == 0 and not (n < 10) { acc = acc - n / 2; }\n"
+        "    return step(n - 1, (acc * 31 + n) % 1000003);\n"
+        "}\n"
+        "fn mul(a, b) { return a * b; }\n"
+        "fn add(a, b) { return a + b; }\n"
+        "fn warm(n) {\n"
+        "    if n == 0 { return 0; }\n"
+        "    mul(n, n);\n"
+        "    add(n, n);\n"
+        "    return warm(n - 1);\n"
+        "}\n"
+        "r = step(10000, 7);\n"
+        "w = warm(1000);\n"
+        "big = mul(4611686018427387904, 4);\n"
+        "s = add(\"ab\", \"cd\");\n";
+
+    ssize expected = 0;
+
+    for (int jit = 1; jit >= 0; jit--) {
+        RunRes res;
+        ASSERT(RunStr(INPUT_STR, false, &res));
+
+        Interp_SetJit(res.interp, jit == 1);
+        ASSERT(Interp_Run(res.interp));
+
+        Value * r = Interp_Global(res.interp, "r");
+        ASSERT_EQ(ValTag_Num, r->tag);
+
+        if (jit == 1) {
+            expected = r->ext.num;
+#if ME_JIT_ENABLED
+            ASSERT(Interp_JitCount(res.interp) > 0);
+#endif
+        } else {
+            ASSERT_EQ_FMT(expected, r->ext.num, "%zd");
+            ASSERT_EQ(0, Interp_JitCount(res.interp));
+        }
+
+        /* The overflow and the strings are left to the interpreter. */
+        ASSERT_GLOBAL_BIG(res.interp, "big", "18446744073709551616");
+
+        ASSERT_GLOBAL_STR(res.interp, "s", "abcd");
+
+        RunRes_Free(&res);
+    }
+
+    PASS();
+}
+
+TEST JitBailsOutOnErrors(void) {
+    const char * INPUT_STR =
+        "fn div(a, b) { return a / b; }\n"
+        "fn warm(n) {\n"
+        "    if n == 0 { return 0; }\n"
+        "    div(n, 7);\n"
+        "    return warm(n - 1);\n"
+        "}\n"
+        "w = warm(1000);\n"
+        "q = div(-9223372036854775807 - 1, -1);\n"
+        "r = div(1, 0);\n";
+
+    RunRes res;
+    ASSERT_FALSE(RunStr(INPUT_STR, true, &res));
+    ASSERT_EQ(InterpErr_DivisionByZero, Interp_ErrorType(res.interp));
+
+    /* The quotient that does not fit is promoted by the interpreter. */
+    ASSERT_GLOBAL_BIG(res.interp, "q", "9223372036854775808");
+
+    RunRes_Free(&res);
+
+    PASS();
+}
+
+TEST BigIntegers(void) {
+    const char * INPUT_STR =
+        "fn fact(n, acc) {\n"
+        "    if n == 0 { return acc; }\n"
+        "    return fact(n - 1, acc * n);\n"
+        "}\n"
+        "fn name(n) {\n"
+        "    match n {\n"
+        "        -9223372036854775808 { s = \"min\"; }\n"
+        "        18446744073709551616 { s = \"two to the 64\"; }\n"
+        "        else { s = \"other\"; }\n"
+        "    }\n"
+        "    return s;\n"
+        "}\n"
+        "lit = 123456789012345678901234567890;\n"
+        "min = -9223372036854775808;\n"
+        "p = 2 ^ 100;\n"
+        "f = fact(30, 1);\n"
+        "neg = -(2 ^ 63);\n"
+        "back = (2 ^ 64 + 5) - 2 ^ 64;\n"
+        "x = 3 ^ 3000;\n"
+        "sq = x * x == 3 ^ 6000;\n"
+        "q = x * x / x == x;\n"
+        "m = (x * x + 7) % x;\n"
+        "tq = -(2 ^ 100) / 3;\n"
+        "tr = -(2 ^ 100) % 3;\n"
+        "lt = 2 ^ 70 > 2 ^ 69 and -(2 ^ 70) < 1;\n"
+        "a = name(-9223372036854775807 - 1);\n"
+        "b = name(2 ^ 64);\n"
+        "c = name(2 ^ 65);\n";
+
+    RunRes res;
+    ASSERT(RunStr(INPUT_STR, true, &res));
+
+    ASSERT_GLOBAL_BIG(res.interp, "lit", "123456789012345678901234567890");
+    ASSERT_GLOBAL_NUM(res.interp, "min", INT64_MIN);
+    ASSERT_GLOBAL_BIG(res.interp, "p", "1267650600228229401496703205376");
+    ASSERT_GLOBAL_BIG(res.interp, "f", "265252859812191058636308480000000");
+    ASSERT_GLOBAL_NUM(res.interp, "neg", INT64_MIN);
+    ASSERT_GLOBAL_NUM(res.interp, "back", 5);
+    ASSERT_GLOBAL_NUM(res.interp, "m", 7);
+    ASSERT_GLOBAL_BIG(res.interp, "tq", "-422550200076076467165567735125");
+    ASSERT_GLOBAL_NUM(res.interp, "tr", -1);
+
+    const char * TRUE_NAMES[] = { "sq", "q", "lt" };
+    for (usize i = 0; i < sizeof(TRUE_NAMES) / sizeof(TRUE_NAMES[0]); i++) {
+        Value * val = Interp_Global(res.interp, TRUE_NAMES[i]);
+        ASSERT_EQ(ValTag_Bool, val->tag);
+        ASSERT(val->ext.val);
+    }
+
+    const char * ARMS[][2] = {
+        { "a", "min" }, { "b", "two to the 64" }, { "c", "other" },
+    };
+    for (usize i = 0; i < sizeof(ARMS) / sizeof(ARMS[0]); i++) {
+        ASSERT_GLOBAL_STR(res.interp, ARMS[i][0], ARMS[i][1]);
+    }
+
+    RunRes_Free(&res);
+
+    PASS();
+}
+
+TEST HugePowerFailsUpFront(void) {
+    const char * INPUT_STR =
+        "ok = 2 ^ 100;\n"
+        "x = 3 ^ 9223372036854775807;\n";
+
+    RunRes res;
+    ASSERT_FALSE(RunStr(INPUT_STR, true, &res));
+    ASSERT_EQ(InterpErr_NoEnoughMemory, Interp_ErrorType(res.interp));
+    ASSERT_GLOBAL_BIG(res.interp, "ok", "1267650600228229401496703205376");
+
+    RunRes_Free(&res);
+
+    PASS();
+}
+
+TEST StringsSurviveCollections(void) {
+    const char * INPUT_STR =
+        "keep = \"ke\" + \"ep\";\n"
+        "fn churn(n, s) {\n"
+        "    if n == 0 { return s; }\n"
+        "    t = s + \"abcdefghijklmnopqrstuvwxyz\";\n"
+        "    return churn(n - 1, \"k\" + \"v\");\n"
+        "}\n"
+        "r = keep + churn(50000, \"\");\n";
+    RunRes res;
+    GcStats stats;
+
+    ASSERT(RunStr(INPUT_STR, true, &res));
+
+    /* The left operand is held while the call collects. */
+    ASSERT_GLOBAL_STR(res.interp, "r", "keepkv");
+
+    Interp_GcStats(res.interp, &stats);
+    ASSERT(stats.num_minor > 0);
+    ASSERT(stats.bytes_freed > 0);
+    ASSERT(stats.max_pause_ns <= stats.total_pause_ns);
+
+    RunRes_Free(&res);
+
+    PASS();
+}
+
+#define AB_32 "abababababababababababababababab"
+
+TEST RopeConcatenation(void) {
+    const char * INPUT_STR =
+        "fn app(n, s) {\n"
+        "    if n == 0 { return s; }\n"
+        "    return app(n - 1, s + \"ab\");\n"
+        "}\n"
+        "fn pre(n, s) {\n"
+        "    if n == 0 { return s; }\n"
+        "    return pre(n - 1, \"ab\" + s);\n"
+        "}\n"
+        "a = app(20000, \"\");\n"
+        "p = pre(20000, \"\");\n"
+        "same = a == p;\n"
+        "differ = a == p + \"x\";\n"
+        "fn kind(m) {\n"
+        "    match m {\n"
+        "        \"ab\" { k = 1; }\n"
+        "        \"" AB_32 AB_32 AB_32 AB_32 "ab\" { k = 2; }\n"
+        "        else { k = 0; }\n"
+        "    }\n"
+        "    return k;\n"
+        "}\n"
+        "k = kind(app(65, \"\"));\n"
+        "l = kind(pre(65, \"\"));\n"
+        "o = kind(app(66, \"\"));\n"
+        "t = \"in\" + \"line\";\n";
+    RunRes res;
+
+    ASSERT(RunStr(INPUT_STR, true, &res));
+
+    Value * val = Interp_Global(res.interp, "a");
+    ASSERT_EQ(ValTag_Str, val->tag);
+    ASSERT_EQ(40000, StrObj_Size(val->ext.str));
+    ASSERT_FALSE(StrObj_IsInline(val->ext.str));
+
+    val = Interp_Global(res.interp, "same");
+    ASSERT_EQ(ValTag_Bool, val->tag);
+    ASSERT(val->ext.val);
+
+    val = Interp_Global(res.interp, "differ");
+    ASSERT_EQ(ValTag_Bool, val->tag);
+    ASSERT_FALSE(val->ext.val);
+
+    ASSERT_GLOBAL_NUM(res.interp, "k", 2);
+    ASSERT_GLOBAL_NUM(res.interp, "l", 2);
+    ASSERT_GLOBAL_NUM(res.interp, "o", 0);
+
+    ASSERT_GLOBAL_STR(res.interp, "t", "inline");
+    ASSERT(StrObj_IsInline(Interp_Global(res.interp, "t")->ext.str));
+
+    RunRes_Free(&res);
+
+    PASS();
+}
+
+/* Run of a shared program by an isolate of its own. */
+typedef struct _IsolateRun {
+    const InterpProg * prog;
+    bool ok;
+    ssize r;
+    usize s_size;
+} IsolateRun;
+
+static
+void *
+RunIsolate(
+    void * arg
+) {
+    IsolateRun * run = (IsolateRun *)arg;
+
+    MemPool * pool = MemPool_New();
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    /* The interpreter takes all of its memory from the pool. */
+    const MemAllocator * prev = MeMem_Use(MemPool_Allocator(pool));
+    Interp * interp = Interp_New();
+    MeMem_Use(prev);
+
+    if (interp == NULL) {
+        goto FreePool;
+    }
+
+    for (usize i = 0; i < 3; i++) {
+        if (Interp_LoadProg(interp, run->prog) == false ||
+            Interp_Run(interp) == false) {
+
+            goto FreeInterp;
+        }
+    }
+
+    Value * r = Interp_Global(interp, "r");
+    Value * s = Interp_Global(interp, "s");
+
+    if (r->tag == ValTag_Num &&
+        s->tag == ValTag_Str) {
+
+        run->r = r->ext.num;
+        run->s_size = StrObj_Size(s->ext.str);
+        run->ok = true;
+    }
+
+FreeInterp:
+    Interp_Free(interp);
+
+FreePool:
+    MemPool_Free(pool);
+
+    return NULL;
+}
+
+TEST IsolatesShareProgram(void) {
+    const char * INPUT_STR =
+        "fn step(n, acc) {\n"
+        "    if n == 0 { return acc; }\n"
+        "    t = \"x\" + \"y\";\n"
+        "    return step(n - 1, (acc * 31 + n) % 1000003);\n"
+        "}\n"
+        "r = step(5000, 7);\n"
+        "s = \"ab\" + \"cd\";\n";
+    const usize NUM_THREADS = 4;
+
+    pthread_t threads[4];
+    IsolateRun runs[4];
+
+    RunRes res;
+    ASSERT(RunStr(INPUT_STR, true, &res));
+    ssize expected = Interp_Global(res.interp, "r")->ext.num;
+
+    /* The tree was resolved by `Interp_Load`, resolving it again yields the
+       same annotations. */
+    InterpProg * prog = InterpProg_New();
+    ASSERT_NEQ(NULL, prog);
+    ASSERT(InterpProg_Compile(prog, res.tree));
+    ASSERT_FALSE(InterpProg_Compile(prog, res.tree));
+
+    for (usize i = 0; i < NUM_THREADS; i++) {
+        runs[i].prog = prog;
+        runs[i].ok = false;
+        ASSERT_EQ(0, pthread_create(threads + i, NULL, RunIsolate, runs + i));
+    }
+
+    for (usize i = 0; i < NUM_THREADS; i++) {
+        ASSERT_EQ(0, pthread_join(threads[i], NULL));
+    }
+
+    for (usize i = 0; i < NUM_THREADS; i++) {
+        ASSERT(runs[i].ok);
+        ASSERT_EQ_FMT(expected, runs[i].r, "%zd");
+        ASSERT_EQ_FMT(4UL, runs[i].s_size, "%zu");
+    }
+
+    InterpProg_Free(prog);
+    RunRes_Free(&res);
+
+    PASS();
+}
+
+TEST SnapshotRestoresGlobals(void) {
+    const char * INPUT_STR =
+        "fn kind(n) {\n"
+        "    match n % 3 {\n"
+        "        0 { return \"zero\"; }\n"
+        "        1 { return \"one\"; }\n"
+        "        else { return \"two\"; }\n"
+        "    }\n"
+        "}\n"
+        "fn sum(n, acc) {\n"
+        "    if n == 0 { return acc; } else { return sum(n - 1, acc + n); }\n"
+        "}\n"
+        "total = sum(100, 0);\n"
+        "name = kind(total) + \" of many\";\n"
+        "big = 2 ^ 80 + -123456789012345678901234567890;\n"
+        "flag = not (total < 0);\n";
+
+    char dir[] = "/tmp/menos-snap-XXXXXX";
+    char path[64];
+
+    ASSERT_NEQ(NULL, mkdtemp(dir));
+    snprintf(path, sizeof(path), "%s/init.snap", dir);
+
+    RunRes res;
+    ASSERT(RunStr(INPUT_STR, true, &res));
+    ASSERT(Snapshot_Save(res.interp, path));
+
+    Snapshot * snap = Snapshot_Load(path);
+    ASSERT_NEQ(NULL, snap);
+
+    Interp * interp = Interp_New();
+    ASSERT_NEQ(NULL, interp);
+    ASSERT(Snapshot_Restore(snap, interp));
+
+    ASSERT_GLOBAL_NUM(interp, "total", 5050);
+    ASSERT_GLOBAL_STR(interp, "name", "one of many");
+    ASSERT_GLOBAL_BIG(interp, "big", "-123455580086526064272059861714");
+    ASSERT_EQ(ValTag_Bool, Interp_Global(interp, "flag")->tag);
+    ASSERT(Interp_Global(interp, "flag")->ext.val);
+
+    /* The tree was rebuilt whole, with positions. */
+    AstNode * stmt_1 = AstSeq_At(res.tree->ext.block.seq, 3);
+    AstNode * stmt_2 = AstSeq_At(Interp_Program(interp)->ext.block.seq, 3);
+    ASSERT(stmt_1->row != 0);
+    ASSERT_EQ_FMT(stmt_1->row, stmt_2->row, "%zu");
+    ASSERT_EQ_FMT(stmt_1->col, stmt_2->col, "%zu");
+
+    FlexBuf * buf_1 = FlexBuf_New();
+    FlexBuf * buf_2 = FlexBuf_New();
+    ASSERT_NEQ(NULL, buf_1);
+    ASSERT_NEQ(NULL, buf_2);
+    ASSERT(AstNode_PushAsStr(res.tree, buf_1, 0));
+    ASSERT(AstNode_PushAsStr(Interp_Program(interp), buf_2, 0));
+    ASSERT_EQ(FlexBuf_Size(buf_1), FlexBuf_Size(buf_2));
+    ASSERT_MEM_EQ(FlexBuf_Data(buf_1), FlexBuf_Data(buf_2),
+        FlexBuf_Size(buf_1));
+    FlexBuf_Free(buf_2);
+    FlexBuf_Free(buf_1);
+
+    /* The restored code runs like the original. */
+    ASSERT(Interp_Run(interp));
+    ASSERT_GLOBAL_NUM(interp, "total", 5050);
+    ASSERT_GLOBAL_STR(interp, "name", "one of many");
+
+    Interp_Free(interp);
+    Snapshot_Free(snap);
+
+    /* Damaged and truncated files are rejected. */
+    FixedBuf * file = FixedBuf_NewFromFile(path);
+    ASSERT_NEQ(NULL, file);
+
+    usize size = FixedBuf_Size(file);
+    u8 * data = (u8 *)FixedBuf_Data(file);
+
+    data[size / 2] ^= 0x20;
+    ASSERT(MapFile_WriteAtomic(path, data, size));
+    ASSERT_EQ(NULL, Snapshot_Load(path));
+
+    data[size / 2] ^= 0x20;
+    ASSERT(MapFile_WriteAtomic(path, data, size - 1));
+    ASSERT_EQ(NULL, Snapshot_Load(path));
+
+    FixedBuf_Free(file);
+    unlink(path);
+    rmdir(dir);
+    RunRes_Free(&res);
+
+    PASS();
+}
+
+#if defined(__linux__)
+
+TEST ProfilerSamplesStatements(void) {
+    const char * INPUT_STR =
+        "fn fib(n) {\n"
+        "    if n < 2 { return n; }\n"
+        "    return fib(n - 1) + fib(n - 2);\n"
+        "}\n"
+        "r = fib(22);\n";
+
+    RunRes res;
+    ASSERT(RunStr(INPUT_STR, false, &res));
+
+    Prof * prof = Prof_New();
+    ASSERT_NEQ(NULL, prof);
+    ASSERT(Prof_Start(prof, res.interp, 1000));
+
+    /* Samples come with CPU time, so run until a few were taken. */
+    for (usize i = 0; i < 1000 && Prof_NumSamples(prof) < 5; i++) {
+        ASSERT(Interp_Run(res.interp));
+    }
+
+    Prof_Stop(prof);
+    ASSERT(Prof_NumSamples(prof) >= 5);
+    ASSERT_EQ(0, Prof_NumDropped(prof));
+
+    FlexBuf * buf = FlexBuf_New();
+    ASSERT_NEQ(NULL, buf);
+    ASSERT(Prof_PushFolded(prof, buf));
+    ASSERT(FlexBuf_PushByte(buf, '\0'));
+
+    /* Every stack starts at the call on row 5 and ends in `fib`. */
+    const char * folded = (const char *)FlexBuf_Data(buf);
+    ASSERT_EQ(0, strncmp(folded, "(top):5:1;fib:", 14));
+    ASSERT(strstr(folded, ";fib:3:5 ") != NULL ||
+        strstr(folded, ";fib:2:5 ") != NULL);
+
+    FlexBuf_Free(buf);
+    Prof_Free(prof);
+    RunRes_Free(&res);
+
+    PASS();
+}
+
+#endif
+
+SUITE(InterpSuite) {
+    RUN_TEST(ArithmeticAndGlobals);
+    RUN_TEST(RecursiveCalls);
+    RUN_TEST(TailCallsReuseFrame);
+    RUN_TEST(DeepRecursionOverflows);
+    RUN_TEST(MatchDispatchInFunction);
+    RUN_TEST(ResolveErrors);
+    RUN_TEST(JitMatchesInterpreter);
+    RUN_TEST(JitBailsOutOnErrors);
+    RUN_TEST(BigIntegers);
+    RUN_TEST(HugePowerFailsUpFront);
+    RUN_TEST(StringsSurviveCollections);
+    RUN_TEST(RopeConcatenation);
+    RUN_TEST(IsolatesShareProgram);
+    RUN_TEST(SnapshotRestoresGlobals);
+#if defined(__linux__)
+    RUN_TEST(ProfilerSamplesStatements);
+#endif
+}
\ No newline at end of file
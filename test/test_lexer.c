@@ -3,6 +3,7 @@
 #include "greatest.h"
 #include "menos.h"
 #include "lexer/lexer.h"
+#include "memory/limit.h"
 
 const char *
 TokTag_ToStr_Intf(
@@ -400,10 +401,131 @@ TEST LinebreakTerminatedStringLiteral(void) {
     PASS();
 }
 
+TEST MemoryLimitFailsCleanly(void) {
+    const char * INPUT_STR =
+        "fn greet(name) { return \"Hello, \" + name; }\n"
+        "x = greet(\"world\"); y = 123456789012345678901234567890;\n";
+    const usize INPUT_LEN = strlen(INPUT_STR);
+    bool done = false;
+
+    /* Raise the limit until scanning succeeds, every failure must be an out
+       of memory error that leaks nothing. */
+    for (usize limit = 0; done == false; limit += 64) {
+        MemLimit * lim = MemLimit_New(NULL, limit);
+        ASSERT_NEQ(NULL, lim);
+
+        const MemAllocator * prev = MeMem_Use(MemLimit_Allocator(lim));
+        Lexer * lex = Lexer_New();
+        MeMem_Use(prev);
+
+        if (lex != NULL) {
+            LexOut * lo;
+
+            done = Lexer_ScanBuf(lex, INPUT_STR, INPUT_LEN, &lo);
+            if (done) {
+                LexOut_Free(lo);
+            } else {
+                ASSERT_LEX_ERR_EQ(LexErr_NoEnoughMemory,
+                    Lexer_ErrorType(lex));
+            }
+
+            Lexer_Free(lex);
+        }
+
+        ASSERT_EQ_FMT(0UL, MemLimit_Used(lim), "%zu");
+        MemLimit_Free(lim);
+    }
+
+    PASS();
+}
+
+TEST LongLiteralFitsMemoryLimit(void) {
+    const usize LIT_LEN = 1024 * 1024;
+
+    /* A source of few tokens takes memory in proportion to its size, not to
+       the tokens its size could hold. */
+    FlexBuf * src = FlexBuf_New();
+    ASSERT_NEQ(NULL, src);
+    ASSERT(FlexBuf_PushStr(src, "s = \""));
+    ASSERT(FlexBuf_PushDupByte(src, 'a', LIT_LEN));
+    ASSERT(FlexBuf_PushStr(src, "\";\n"));
+
+    MemLimit * lim = MemLimit_New(NULL, 6 * LIT_LEN);
+    ASSERT_NEQ(NULL, lim);
+
+    const MemAllocator * prev = MeMem_Use(MemLimit_Allocator(lim));
+    Lexer * lex = Lexer_New();
+    MeMem_Use(prev);
+
+    ASSERT_NEQ(NULL, lex);
+
+    LexOut * lo;
+    ASSERT(Lexer_ScanBuf(lex, FlexBuf_Data(src), FlexBuf_Size(src), &lo));
+    ASSERT_EQ_FMT(5UL, TokSeq_Count(LexOut_Tokens(lo)), "%zu");
+
+    LexOut_Free(lo);
+    Lexer_Free(lex);
+
+    ASSERT_EQ_FMT(0UL, MemLimit_Used(lim), "%zu");
+    MemLimit_Free(lim);
+    FlexBuf_Free(src);
+
+    PASS();
+}
+
+TEST ChunkedFeedMatchesWholeBuffer(void) {
+    const char * INPUT_STR =
+        "long_variable_name = \"a string literal\" + other_name_2;\n"
+        "print(long_variable_name)\n";
+    const usize INPUT_LEN = strlen(INPUT_STR);
+
+    Lexer * lex = Lexer_New();
+    ASSERT_NEQ(NULL, lex);
+
+    LexOut * lo;
+    ASSERT(Lexer_ScanBuf(lex, INPUT_STR, INPUT_LEN, &lo));
+
+    FlexBuf * expected = FlexBuf_New();
+    ASSERT_NEQ(NULL, expected);
+    ASSERT(TokSeq_PushAsStr(LexOut_Tokens(lo), expected, -1));
+
+    LexOut_Free(lo);
+
+    /* Runs of name and string bytes are split across every chunk size. */
+    for (usize chunk = 1; chunk <= 7; chunk++) {
+        for (usize off = 0; off < INPUT_LEN; off += chunk) {
+            usize len = INPUT_LEN - off < chunk ? INPUT_LEN - off : chunk;
+            ASSERT(Lexer_Feed(lex, INPUT_STR + off, len));
+        }
+
+        TokSeq * seq;
+        ASSERT(Lexer_Finalize(lex, &seq));
+
+        FlexBuf * actual = FlexBuf_New();
+        ASSERT_NEQ(NULL, actual);
+        ASSERT(TokSeq_PushAsStr(seq, actual, -1));
+
+        ASSERT_EQ_FMT(FlexBuf_Size(expected), FlexBuf_Size(actual), "%zu");
+        ASSERT_MEM_EQ(FlexBuf_Data(expected), FlexBuf_Data(actual),
+            FlexBuf_Size(expected));
+
+        FlexBuf_Free(actual);
+        TokSeq_Free(seq);
+    }
+
+    FlexBuf_Free(expected);
+    Lexer_Free(lex);
+
+    PASS();
+}
+
 SUITE(LexerSuite) {
     RUN_TEST(NameTokens);
     RUN_TEST(ComparisonOperatorTokens);
     RUN_TEST(AllKindsOfBracketsTokens);
     RUN_TEST(ScanMultiLineInput);
     RUN_TEST(LinebreakTerminatedStringLiteral);
+    RUN_TEST(MemoryLimitFailsCleanly);
+    RUN_TEST(LongLiteralFitsMemoryLimit);
+    RUN_TEST(ChunkedFeedMatchesWholeBuffer);
 }
\ No newline at end of file
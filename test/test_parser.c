@@ -0,0 +1,939 @@
+#include <dirent.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "greatest.h"
+#include "menos.h"
+#include "lexer/lexer.h"
+#include "memory/limit.h"
+#include "parser/parser.h"
+#include "parser/ast_img.h"
+#include "parser/code_cache.h"
+#include "parser/match_tab.h"
+#include "parser/par_pool.h"
+#include "parser/project.h"
+#include "util/metrics.h"
+#include "util/trace.h"
+
+typedef struct _ParseRes {
+    Lexer * lex;
+    LexOut * lo;
+    Parser * par;
+    AstNode * tree;
+    bool ok;
+} ParseRes;
+
+static
+bool
+ParseStr(
+    const char * str,
+    ParseRes * res
+) {
+    res->lex = Lexer_New();
+    res->lo = NULL;
+    res->par = Parser_New();
+    res->tree = NULL;
+    res->ok = false;
+
+    if (res->lex == NULL ||
+        res->par == NULL ||
+        Lexer_ScanBuf(res->lex, str, strlen(str), &res->lo) == false) {
+
+        return false;
+    }
+
+    Parser_Link(res->par, res->lo);
+    res->ok = Parser_Parse(res->par, &res->tree);
+
+    return true;
+}
+
+static
+void
+ParseRes_Free(
+    ParseRes * res
+) {
+    if (res->tree != NULL) {
+        AstNode_FreeTree(res->tree);
+    }
+
+    if (res->lo != NULL) {
+        LexOut_Free(res->lo);
+    }
+
+    if (res->par != NULL) {
+        Parser_Free(res->par);
+    }
+
+    if (res->lex != NULL) {
+        Lexer_Free(res->lex);
+    }
+}
+
+TEST MatchDenseNumberArms(void) {
+    const char * INPUT_STR =
+        "match x {\n"
+        "    3 { y = 3; }\n"
+        "    1 { y = 1; }\n"
+        "    2 { y = 2; }\n"
+        "    5 { y = 5; }\n"
+        "    else { y = 0; }\n"
+        "}\n";
+
+    ParseRes res;
+    ASSERT(ParseStr(INPUT_STR, &res));
+    ASSERT(res.ok);
+
+    AstNode * node = AstSeq_At(res.tree->ext.block.seq, 0);
+    ASSERT_NEQ(NULL, node);
+    ASSERT_EQ(AstTag_MatchStmt, node->tag);
+    ASSERT_EQ_FMT(4UL, AstSeq_Count(node->ext.match_stmt.arms), "%zu");
+    ASSERT_NEQ(NULL, node->ext.match_stmt.else_br);
+
+    MatchTab * tab = node->ext.match_stmt.tab;
+    ASSERT_EQ(MatchNumKind_Dense, MatchTab_NumKind(tab));
+
+    usize idx;
+    ASSERT(MatchTab_FindNum(tab, 3, &idx));
+    ASSERT_EQ_FMT(0UL, idx, "%zu");
+    ASSERT(MatchTab_FindNum(tab, 1, &idx));
+    ASSERT_EQ_FMT(1UL, idx, "%zu");
+    ASSERT(MatchTab_FindNum(tab, 5, &idx));
+    ASSERT_EQ_FMT(3UL, idx, "%zu");
+    ASSERT_FALSE(MatchTab_FindNum(tab, 4, &idx));
+    ASSERT_FALSE(MatchTab_FindNum(tab, 0, &idx));
+    ASSERT_FALSE(MatchTab_FindNum(tab, -1, &idx));
+    ASSERT_FALSE(MatchTab_FindBool(tab, true, &idx));
+
+    ParseRes_Free(&res);
+
+    PASS();
+}
+
+TEST MatchSparseNumberArms(void) {
+    const char * INPUT_STR =
+        "match x {\n"
+        "    100000 { y = 1; }\n"
+        "    -7 { y = 2; }\n"
+        "    42 { y = 3; }\n"
+        "}\n";
+
+    ParseRes res;
+    ASSERT(ParseStr(INPUT_STR, &res));
+    ASSERT(res.ok);
+
+    AstNode * node = AstSeq_At(res.tree->ext.block.seq, 0);
+    ASSERT_NEQ(NULL, node);
+    ASSERT_EQ(AstTag_MatchStmt, node->tag);
+    ASSERT_EQ(NULL, node->ext.match_stmt.else_br);
+
+    MatchTab * tab = node->ext.match_stmt.tab;
+    ASSERT_EQ(MatchNumKind_Sparse, MatchTab_NumKind(tab));
+
+    usize idx;
+    ASSERT(MatchTab_FindNum(tab, 100000, &idx));
+    ASSERT_EQ_FMT(0UL, idx, "%zu");
+    ASSERT(MatchTab_FindNum(tab, -7, &idx));
+    ASSERT_EQ_FMT(1UL, idx, "%zu");
+    ASSERT(MatchTab_FindNum(tab, 42, &idx));
+    ASSERT_EQ_FMT(2UL, idx, "%zu");
+    ASSERT_FALSE(MatchTab_FindNum(tab, 7, &idx));
+
+    ParseRes_Free(&res);
+
+    PASS();
+}
+
+TEST MatchExtremeNumberArms(void) {
+    const char * INPUT_STR =
+        "match x {\n"
+        "    -4611686018427387904 { y = 1; }\n"
+        "    4611686018427387904 { y = 2; }\n"
+        "}\n"
+        "match x {\n"
+        "    -9223372036854775807 { y = 1; }\n"
+        "    9223372036854775807 { y = 2; }\n"
+        "}\n";
+
+    ParseRes res;
+    ASSERT(ParseStr(INPUT_STR, &res));
+    ASSERT(res.ok);
+
+    /* The key ranges overflow when scaled, they must stay sparse. */
+    for (usize i = 0; i < 2; i++) {
+        AstNode * node = AstSeq_At(res.tree->ext.block.seq, i);
+        ASSERT_NEQ(NULL, node);
+        ASSERT_EQ(AstTag_MatchStmt, node->tag);
+
+        MatchTab * tab = node->ext.match_stmt.tab;
+        ASSERT_EQ(MatchNumKind_Sparse, MatchTab_NumKind(tab));
+
+        usize idx;
+        ASSERT(MatchTab_FindNum(tab, i == 0 ?
+            -4611686018427387904L : -9223372036854775807L, &idx));
+        ASSERT_EQ_FMT(0UL, idx, "%zu");
+        ASSERT(MatchTab_FindNum(tab, i == 0 ?
+            4611686018427387904L : 9223372036854775807L, &idx));
+        ASSERT_EQ_FMT(1UL, idx, "%zu");
+        ASSERT_FALSE(MatchTab_FindNum(tab, 0, &idx));
+    }
+
+    ParseRes_Free(&res);
+
+    PASS();
+}
+
+TEST MatchStringAndBooleanArms(void) {
+    const char * INPUT_STR =
+        "match x {\n"
+        "    \"get\" { y = 1; }\n"
+        "    \"put\" { y = 2; }\n"
+        "    true { y = 3; }\n"
+        "    \"\" { y = 4; }\n"
+        "}\n";
+
+    ParseRes res;
+    ASSERT(ParseStr(INPUT_STR, &res));
+    ASSERT(res.ok);
+
+    AstNode * node = AstSeq_At(res.tree->ext.block.seq, 0);
+    ASSERT_NEQ(NULL, node);
+
+    MatchTab * tab = node->ext.match_stmt.tab;
+    ASSERT_EQ(MatchNumKind_None, MatchTab_NumKind(tab));
+
+    usize idx;
+    ASSERT(MatchTab_FindStr(tab, (const u8 *)"put", 3, &idx));
+    ASSERT_EQ_FMT(1UL, idx, "%zu");
+    ASSERT(MatchTab_FindStr(tab, (const u8 *)"", 0, &idx));
+    ASSERT_EQ_FMT(3UL, idx, "%zu");
+    ASSERT_FALSE(MatchTab_FindStr(tab, (const u8 *)"post", 4, &idx));
+    ASSERT(MatchTab_FindBool(tab, true, &idx));
+    ASSERT_EQ_FMT(2UL, idx, "%zu");
+    ASSERT_FALSE(MatchTab_FindBool(tab, false, &idx));
+    ASSERT_FALSE(MatchTab_FindNum(tab, 0, &idx));
+
+    ParseRes_Free(&res);
+
+    PASS();
+}
+
+TEST MatchDuplicateArm(void) {
+    const char * INPUT_STRS[] = {
+        "match x {\n"
+        "    1 { y = 1; }\n"
+        "    2 { y = 2; }\n"
+        "    1 { y = 3; }\n"
+        "}\n",
+
+        "match x {\n"
+        "    \"a\" { y = 1; }\n"
+        "    true { y = 2; }\n"
+        "    \"a\" { y = 3; }\n"
+        "}\n",
+
+        "match x {\n"
+        "    false { y = 1; }\n"
+        "    -99999999999999999999 { y = 2; }\n"
+        "    -99999999999999999999 { y = 3; }\n"
+        "}\n",
+
+        "match x {\n"
+        "    true { y = 1; }\n"
+        "    1 { y = 2; }\n"
+        "    true { y = 3; }\n"
+        "    1 { y = 4; }\n"
+        "}\n",
+    };
+
+    for (usize i = 0; i < sizeof(INPUT_STRS) / sizeof(INPUT_STRS[0]); i++) {
+        ParseRes res;
+        ASSERT(ParseStr(INPUT_STRS[i], &res));
+        ASSERT_FALSE(res.ok);
+        ASSERT_EQ(ParErr_DuplicateMatchArm, Parser_ErrorType(res.par));
+
+        /* The first repeated key is reported. */
+        FlexBuf * msg = Parser_ErrorMessage(res.par);
+        ASSERT(FlexBuf_PushByte(msg, '\0'));
+        ASSERT_NEQ(NULL, strstr((const char *)FlexBuf_Data(msg), ":4:5: "));
+
+        ParseRes_Free(&res);
+    }
+
+    PASS();
+}
+
+TEST MemoryLimitFailsCleanly(void) {
+    const char * INPUT_STR =
+        "fn kind(x) {\n"
+        "    match x {\n"
+        "        1 { k = \"one\"; }\n"
+        "        \"two\" { k = 2; }\n"
+        "        else { k = -x * (x + 1); }\n"
+        "    }\n"
+        "    return k;\n"
+        "}\n"
+        "if kind(3) == 0 { y = true; } else { y = not false; }\n";
+    bool done = false;
+
+    for (usize limit = 0; done == false; limit += 64) {
+        MemLimit * lim = MemLimit_New(NULL, limit);
+        ASSERT_NEQ(NULL, lim);
+
+        /* Only the parser allocates under the limit. */
+        ParseRes res = { Lexer_New(), NULL, Parser_New(), NULL, false };
+        ASSERT(res.lex != NULL && res.par != NULL);
+        ASSERT(Lexer_ScanBuf(res.lex, INPUT_STR, strlen(INPUT_STR),
+            &res.lo));
+
+        Parser_Link(res.par, res.lo);
+        Parser_SetAllocator(res.par, MemLimit_Allocator(lim));
+
+        done = Parser_Parse(res.par, &res.tree);
+        if (done == false) {
+            ASSERT_EQ(ParErr_NoEnoughMemory, Parser_ErrorType(res.par));
+            ASSERT_EQ(NULL, res.tree);
+        }
+
+        ParseRes_Free(&res);
+
+        ASSERT_EQ_FMT(0UL, MemLimit_Used(lim), "%zu");
+        MemLimit_Free(lim);
+    }
+
+    PASS();
+}
+
+TEST CountTreeNodes(void) {
+    const char * INPUT_STR =
+        "x = 1 + 2;\n"
+        "print(x, -x);\n";
+
+    ParseRes res;
+    ASSERT(ParseStr(INPUT_STR, &res));
+    ASSERT(res.ok);
+
+    /* The program, an assignment of a sum and a call statement with a
+       variable and a negation as arguments. */
+    ASSERT_EQ_FMT(11UL, AstNode_CountTree(res.tree), "%zu");
+
+    ParseRes_Free(&res);
+
+    PASS();
+}
+
+TEST AstImgRoundTrip(void) {
+    const char * INPUT_STR =
+        "fn f(a, b) {\n"
+        "    match a {\n"
+        "        \"s\" { return; }\n"
+        "        -99999999999999999999 { b = not true; }\n"
+        "        false { return g(a, -b, +1) ^ 2; }\n"
+        "        else { if a <= b or a != 0 and a > b { x = 1; } }\n"
+        "    }\n"
+        "    if a >= b { return a % b; } else { return a / b * 2 - 1; }\n"
+        "}\n"
+        "fn g(x, y, z) { return x == y and x < z; }\n"
+        "{ f(1, 2); }\n";
+
+    ParseRes res;
+    ASSERT(ParseStr(INPUT_STR, &res));
+    ASSERT(res.ok);
+
+    FlexBuf * img = FlexBuf_New();
+    ASSERT_NEQ(NULL, img);
+    ASSERT(AstImg_Push(res.tree, img));
+
+    const u8 * data = FlexBuf_Data(img);
+    usize size = FlexBuf_Size(img);
+
+    AstNode * tree;
+    ASSERT(AstImg_Load(data, size, &tree));
+
+    FlexBuf * buf_1 = FlexBuf_New();
+    FlexBuf * buf_2 = FlexBuf_New();
+    ASSERT_NEQ(NULL, buf_1);
+    ASSERT_NEQ(NULL, buf_2);
+    ASSERT(AstNode_PushAsStr(res.tree, buf_1, 0));
+    ASSERT(AstNode_PushAsStr(tree, buf_2, 0));
+    ASSERT_EQ(FlexBuf_Size(buf_1), FlexBuf_Size(buf_2));
+    ASSERT_MEM_EQ(FlexBuf_Data(buf_1), FlexBuf_Data(buf_2),
+        FlexBuf_Size(buf_1));
+    FlexBuf_Free(buf_2);
+    FlexBuf_Free(buf_1);
+    AstNode_FreeTree(tree);
+
+    /* Truncated images fail, damaged ones fail or yield a valid tree. */
+    for (usize i = 0; i < size; i++) {
+        ASSERT_FALSE(AstImg_Load(data, i, &tree));
+    }
+
+    u8 * copy = (u8 *)malloc(size);
+    ASSERT_NEQ(NULL, copy);
+
+    for (usize i = 0; i < size; i++) {
+        memcpy(copy, data, size);
+        copy[i] ^= 0x81;
+
+        if (AstImg_Load(copy, size, &tree)) {
+            AstNode_FreeTree(tree);
+        }
+    }
+
+    free(copy);
+    FlexBuf_Free(img);
+    ParseRes_Free(&res);
+
+    PASS();
+}
+
+TEST AstImgRejectsEmptyNames(void) {
+    const char * INPUT_STR =
+        "fn f(a) { return b; }\n"
+        "{ c = f(a); }\n";
+    const u8 NAME_REC[] = {1, 0, 0, 0, 0, 0, 0, 0};
+
+    ParseRes res;
+    ASSERT(ParseStr(INPUT_STR, &res));
+    ASSERT(res.ok);
+
+    FlexBuf * img = FlexBuf_New();
+    ASSERT_NEQ(NULL, img);
+    ASSERT(AstImg_Push(res.tree, img));
+
+    const u8 * data = FlexBuf_Data(img);
+    usize size = FlexBuf_Size(img);
+    usize num_names = 0;
+    AstNode * tree;
+
+    u8 * copy = (u8 *)malloc(size);
+    ASSERT_NEQ(NULL, copy);
+
+    /* Empties each pooled one byte name in turn, that of the function,
+       its parameter, the variables and the call. */
+    for (usize i = 0; i + sizeof(NAME_REC) < size; i++) {
+        if (memcmp(data + i, NAME_REC, sizeof(NAME_REC)) != 0 ||
+            memchr("abcf", data[i + sizeof(NAME_REC)], 4) == NULL) {
+
+            continue;
+        }
+
+        memcpy(copy, data, size);
+        copy[i] = 0;
+
+        ASSERT_FALSE(AstImg_Load(copy, size, &tree));
+        num_names++;
+    }
+
+    ASSERT_EQ_FMT(6UL, num_names, "%zu");
+
+    free(copy);
+    FlexBuf_Free(img);
+    ParseRes_Free(&res);
+
+    PASS();
+}
+
+static
+const char *
+TokTagName(
+    usize tag
+) {
+    return TokTag_ToStr((TokTag)tag);
+}
+
+static
+const char *
+AstTagName(
+    usize tag
+) {
+    return AstTag_ToStr((AstTag)tag);
+}
+
+TEST MetricsCountTokensAndNodes(void) {
+    const char * INPUT_STR =
+        "x = 1 + 2;\n"
+        "if x { y = (x * 3); }\n";
+    const usize INPUT_LEN = strlen(INPUT_STR);
+
+    Metrics m;
+    Metrics_Clear(&m);
+
+    Lexer * lex = Lexer_New();
+    ASSERT_NEQ(NULL, lex);
+    Lexer_SetMetrics(lex, &m);
+
+    LexOut * lo;
+    ASSERT(Lexer_ScanBuf(lex, INPUT_STR, INPUT_LEN, &lo));
+
+    ASSERT_EQ_FMT((u64)INPUT_LEN, m.bytes_scanned, "%" PRIu64);
+    ASSERT_EQ_FMT((u64)4, m.toks[TokTag_Name], "%" PRIu64);
+    ASSERT_EQ_FMT((u64)3, m.toks[TokTag_NumLit], "%" PRIu64);
+    ASSERT_EQ_FMT((u64)1, m.toks[TokTag_Eof], "%" PRIu64);
+    ASSERT(m.phase_allocs[MetricsPhase_Lex] > 0);
+
+    Parser * par = Parser_New();
+    ASSERT_NEQ(NULL, par);
+    Parser_SetMetrics(par, &m);
+    Parser_Link(par, lo);
+
+    AstNode * tree;
+    ASSERT(Parser_Parse(par, &tree));
+
+    ASSERT_EQ_FMT((u64)2, m.nodes[AstTag_AsgnStmt], "%" PRIu64);
+    ASSERT_EQ_FMT((u64)1, m.nodes[AstTag_IfStmt], "%" PRIu64);
+    ASSERT_EQ_FMT((u64)1, m.nodes[AstTag_BinMulOp], "%" PRIu64);
+
+    /* Program, if statement, block, assignment, product, operand. */
+    ASSERT_EQ_FMT(6UL, m.max_depth, "%zu");
+
+    FlexBuf * buf = FlexBuf_New();
+    ASSERT_NEQ(NULL, buf);
+    ASSERT(Metrics_PushAsStr(&m, buf));
+    ASSERT(Metrics_PushCounts(m.toks, TOK_NUM_TAGS, "token", TokTagName,
+        buf));
+    ASSERT(Metrics_PushCounts(m.nodes, AST_NUM_TAGS, "node", AstTagName,
+        buf));
+    ASSERT(FlexBuf_PushByte(buf, '\0'));
+    ASSERT_NEQ(NULL, strstr((const char *)FlexBuf_Data(buf), "parse: "));
+    ASSERT_NEQ(NULL, strstr((const char *)FlexBuf_Data(buf), "node "));
+    FlexBuf_Free(buf);
+
+    AstNode_FreeTree(tree);
+    Parser_Free(par);
+    LexOut_Free(lo);
+    Lexer_Free(lex);
+
+    PASS();
+}
+
+static
+void
+CountJob(
+    ParJob * job,
+    void * ctx
+) {
+    (void)job;
+
+    atomic_fetch_add((atomic_size_t *)ctx, 1);
+}
+
+TEST ParPoolParsesBatches(void) {
+    const char * GOOD_STR = "x = 1 + 2;\nprint(x, -x);\n";
+    const char * BAD_STR = "x = (1 + ;\n";
+    const usize NUM_JOBS = 64;
+
+    ParJob jobs[64];
+    atomic_size_t num_done = 0;
+
+    ParPool * pool = ParPool_New(3);
+    ASSERT_NEQ(NULL, pool);
+    ASSERT_EQ_FMT(3UL, ParPool_NumWorkers(pool), "%zu");
+
+    for (usize i = 0; i < NUM_JOBS; i++) {
+        const char * str = i % 8 == 7 ? BAD_STR : GOOD_STR;
+        ParJob_Init(jobs + i, str, strlen(str), NULL);
+    }
+
+    /* Two batches, queued behind each other. */
+    ParPool_Submit(pool, jobs, NUM_JOBS / 2, CountJob, &num_done);
+    ParPool_Submit(pool, jobs + NUM_JOBS / 2, NUM_JOBS / 2, CountJob,
+        &num_done);
+    ParPool_Wait(pool);
+
+    ASSERT_EQ_FMT(NUM_JOBS, atomic_load(&num_done), "%zu");
+
+    for (usize i = 0; i < NUM_JOBS; i++) {
+        if (i % 8 == 7) {
+            ASSERT_FALSE(jobs[i].ok);
+            ASSERT_EQ(NULL, jobs[i].tree);
+            ASSERT_NEQ(NULL, jobs[i].err_msg);
+            ASSERT(FlexBuf_Size(jobs[i].err_msg) > 0);
+        } else {
+            ASSERT(jobs[i].ok);
+            ASSERT_EQ_FMT(11UL, AstNode_CountTree(jobs[i].tree), "%zu");
+        }
+
+        ParJob_Clear(jobs + i);
+    }
+
+    /* Files that cannot be read fail with a message of their own. */
+    ParJob_Init(jobs, NULL, 0, "/nonexistent/script.me");
+    ParPool_Submit(pool, jobs, 1, NULL, NULL);
+    ParPool_Wait(pool);
+
+    ASSERT_FALSE(jobs[0].ok);
+    ASSERT_NEQ(NULL, jobs[0].err_msg);
+    ParJob_Clear(jobs);
+
+    ParPool_Free(pool);
+
+    PASS();
+}
+
+static
+bool
+WriteFile(
+    const char * dir,
+    const char * name,
+    const char * str
+) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+    FILE * file = fopen(path, "w");
+    if (file == NULL) {
+        return false;
+    }
+
+    bool res = fputs(str, file) >= 0;
+
+    return fclose(file) == 0 && res;
+}
+
+static
+void
+RemoveFile(
+    const char * dir,
+    const char * name
+) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    unlink(path);
+}
+
+TEST ProjectBuildsDirectory(void) {
+    const char * GOOD_STR = "x = 1 + 2;\nprint(x, -x);\n";
+    const char * BAD_STR = "x = (1 + ;\n";
+
+    char dir[] = "/tmp/menos_project_XXXXXX";
+    ASSERT_NEQ(NULL, mkdtemp(dir));
+
+    ASSERT(WriteFile(dir, "a.me", GOOD_STR));
+    ASSERT(WriteFile(dir, "b.me", "fn f(a) { return a; }\n"));
+    ASSERT(WriteFile(dir, "c.me", GOOD_STR));
+    ASSERT(WriteFile(dir, "d.me", BAD_STR));
+    ASSERT(WriteFile(dir, "e.me", BAD_STR));
+    ASSERT(WriteFile(dir, "notes.txt", BAD_STR));
+
+    Project * proj = Project_New();
+    ASSERT_NEQ(NULL, proj);
+    ASSERT(Project_AddDir(proj, dir, ".me"));
+    ASSERT(Project_AddFile(proj, "/nonexistent/script.me"));
+    ASSERT_EQ_FMT(6UL, Project_NumFiles(proj), "%zu");
+
+    Sched * sched = Sched_New(2, false);
+    ASSERT_NEQ(NULL, sched);
+
+    ASSERT_FALSE(Project_Build(proj, sched));
+    Sched_Free(sched);
+
+    /* Files are listed by name, equal contents are parsed once. */
+    ASSERT_EQ_FMT(3UL, Project_NumUnique(proj), "%zu");
+
+    const ProjFile * a = Project_File(proj, 0);
+    const ProjFile * c = Project_File(proj, 2);
+    const ProjFile * e = Project_File(proj, 4);
+
+    ASSERT(a->ok);
+    ASSERT(Project_File(proj, 1)->ok);
+    ASSERT(c->ok);
+    ASSERT_EQ_FMT(0UL, c->dup_of, "%zu");
+    ASSERT_EQ_FMT(11UL, AstNode_CountTree(a->tree), "%zu");
+    ASSERT_FALSE(e->ok);
+    ASSERT_EQ_FMT(3UL, e->dup_of, "%zu");
+    ASSERT_FALSE(Project_File(proj, 5)->ok);
+
+    FlexBuf * buf = FlexBuf_New();
+    ASSERT_NEQ(NULL, buf);
+    ASSERT(Project_PushDiagnostics(proj, buf));
+    ASSERT(FlexBuf_PushByte(buf, '\0'));
+
+    /* Diagnostics name their files. */
+    const char * diag = (const char *)FlexBuf_Data(buf);
+    ASSERT_NEQ(NULL, strstr(diag, "d.me"));
+    ASSERT_NEQ(NULL, strstr(diag, "e.me: same contents as"));
+    ASSERT_NEQ(NULL, strstr(diag, "cannot read file /nonexistent/"));
+    ASSERT_EQ(NULL, strstr(diag, "a.me"));
+
+    FlexBuf_Free(buf);
+    Project_Free(proj);
+
+    RemoveFile(dir, "a.me");
+    RemoveFile(dir, "b.me");
+    RemoveFile(dir, "c.me");
+    RemoveFile(dir, "d.me");
+    RemoveFile(dir, "e.me");
+    RemoveFile(dir, "notes.txt");
+    rmdir(dir);
+
+    PASS();
+}
+
+/* Builds the scripts of a directory with a code cache. */
+static
+Project *
+BuildCached(
+    const char * dir,
+    CodeCache * cache
+) {
+    Project * proj = Project_New();
+    if (proj == NULL) {
+        return NULL;
+    }
+
+    Project_SetCache(proj, cache);
+
+    if (Project_AddDir(proj, dir, ".me") == false ||
+        Project_Build(proj, NULL) == false) {
+
+        Project_Free(proj);
+        return NULL;
+    }
+
+    return proj;
+}
+
+/* Counts the entries of a directory, applying `fn` to their paths unless it
+   is `NULL`. */
+static
+usize
+ForEachEntry(
+    const char * dir,
+    void (* fn)(const char * path)
+) {
+    char path[512];
+    usize num = 0;
+
+    DIR * d = opendir(dir);
+    if (d == NULL) {
+        return 0;
+    }
+
+    for (struct dirent * ent; (ent = readdir(d)) != NULL;) {
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+
+        if (fn != NULL) {
+            snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+            fn(path);
+        }
+
+        num++;
+    }
+
+    closedir(d);
+
+    return num;
+}
+
+/* Flips the last byte of a file. */
+static
+void
+DamageFile(
+    const char * path
+) {
+    FILE * file = fopen(path, "r+b");
+    if (file == NULL) {
+        return;
+    }
+
+    if (fseek(file, -1, SEEK_END) == 0) {
+        int byte = fgetc(file);
+
+        fseek(file, -1, SEEK_END);
+        fputc(byte ^ 0x01, file);
+    }
+
+    fclose(file);
+}
+
+static
+void
+UnlinkFile(
+    const char * path
+) {
+    unlink(path);
+}
+
+TEST CodeCacheSkipsParsing(void) {
+    const char * A_STR = "fn f(a) { return a * \"x\"; }\nx = f(2) + 1;\n";
+    CodeCacheStats stats;
+
+    char dir[] = "/tmp/menos_cache_XXXXXX";
+    char cache_dir[64];
+
+    ASSERT_NEQ(NULL, mkdtemp(dir));
+    snprintf(cache_dir, sizeof(cache_dir), "%s/cache", dir);
+
+    ASSERT(WriteFile(dir, "a.me", A_STR));
+    ASSERT(WriteFile(dir, "b.me", "y = 2 ^ 100;\n"));
+
+    /* The first run parses and stores every file. */
+    CodeCache * cache = CodeCache_New(cache_dir);
+    ASSERT_NEQ(NULL, cache);
+
+    Project * proj_1 = BuildCached(dir, cache);
+    ASSERT_NEQ(NULL, proj_1);
+
+    CodeCache_Stats(cache, &stats);
+    ASSERT_EQ(0, stats.hits);
+    ASSERT_EQ(2, stats.misses);
+    ASSERT_EQ(2, stats.stores);
+    ASSERT_EQ_FMT(2UL, ForEachEntry(cache_dir, NULL), "%zu");
+    CodeCache_Free(cache);
+
+    /* A restart finds the trees without scanning. */
+    cache = CodeCache_New(cache_dir);
+    ASSERT_NEQ(NULL, cache);
+
+    Project * proj_2 = BuildCached(dir, cache);
+    ASSERT_NEQ(NULL, proj_2);
+
+    CodeCache_Stats(cache, &stats);
+    ASSERT_EQ(2, stats.hits);
+    ASSERT_EQ(0, stats.misses);
+    ASSERT_EQ(NULL, Project_File(proj_2, 0)->lo);
+
+    FlexBuf * buf_1 = FlexBuf_New();
+    FlexBuf * buf_2 = FlexBuf_New();
+    ASSERT_NEQ(NULL, buf_1);
+    ASSERT_NEQ(NULL, buf_2);
+    ASSERT(AstNode_PushAsStr(Project_File(proj_1, 0)->tree, buf_1, 0));
+    ASSERT(AstNode_PushAsStr(Project_File(proj_2, 0)->tree, buf_2, 0));
+    ASSERT_EQ(FlexBuf_Size(buf_1), FlexBuf_Size(buf_2));
+    ASSERT_MEM_EQ(FlexBuf_Data(buf_1), FlexBuf_Data(buf_2),
+        FlexBuf_Size(buf_1));
+    FlexBuf_Free(buf_2);
+    FlexBuf_Free(buf_1);
+
+    Project_Free(proj_2);
+    Project_Free(proj_1);
+
+    /* A changed source misses, so does a damaged entry. */
+    ASSERT(WriteFile(dir, "b.me", "y = 3;\n"));
+    ASSERT_EQ_FMT(2UL, ForEachEntry(cache_dir, DamageFile), "%zu");
+
+    Project * proj_3 = BuildCached(dir, cache);
+    ASSERT_NEQ(NULL, proj_3);
+    Project_Free(proj_3);
+
+    CodeCache_Stats(cache, &stats);
+    ASSERT_EQ(2, stats.hits);
+    ASSERT_EQ(2, stats.misses);
+    ASSERT_EQ(2, stats.stores);
+
+    CodeCache_Free(cache);
+
+    ForEachEntry(cache_dir, UnlinkFile);
+    rmdir(cache_dir);
+    RemoveFile(dir, "a.me");
+    RemoveFile(dir, "b.me");
+    rmdir(dir);
+
+    PASS();
+}
+
+#if ME_TRACE
+
+TEST TraceRecordsStages(void) {
+    const char * INPUT_STR =
+        "fn f(a) { return a; }\n"
+        "x = f(1);\n";
+
+    FlexBuf * buf = FlexBuf_New();
+    ASSERT_NEQ(NULL, buf);
+
+    /* Drop the events of earlier tests. */
+    ASSERT(Trace_Flush(buf));
+    FlexBuf_Clear(buf);
+
+    Trace_Enable(true);
+
+    ParseRes res;
+    bool scanned = ParseStr(INPUT_STR, &res);
+
+    Trace_Enable(false);
+    ASSERT(scanned && res.ok);
+    ParseRes_Free(&res);
+
+    ASSERT(Trace_Flush(buf));
+    ASSERT(FlexBuf_PushByte(buf, '\0'));
+
+    const char * json = (const char *)FlexBuf_Data(buf);
+    ASSERT_EQ(0, strncmp(json, "{\"traceEvents\":[", 16));
+    ASSERT_NEQ(NULL, strstr(json, "\"Lexer_ScanBuf\",\"ph\":\"B\""));
+    ASSERT_NEQ(NULL, strstr(json, "\"Parser_Parse\",\"ph\":\"E\""));
+    ASSERT_NEQ(NULL, strstr(json, "\"name\":\"ParRule_FuncDef\""));
+    ASSERT_NEQ(NULL, strstr(json, "\"name\":\"ParRule_Stmt\""));
+
+    /* Flushed events are not written again. */
+    FlexBuf_Clear(buf);
+    ASSERT(Trace_Flush(buf));
+    ASSERT(FlexBuf_PushByte(buf, '\0'));
+    ASSERT_STR_EQ("{\"traceEvents\":[\n]}\n",
+        (const char *)FlexBuf_Data(buf));
+
+    FlexBuf_Free(buf);
+
+    PASS();
+}
+
+TEST TraceKeepsSpansBalanced(void) {
+    FlexBuf * buf = FlexBuf_New();
+    ASSERT_NEQ(NULL, buf);
+
+    /* Drop the events of earlier tests. */
+    ASSERT(Trace_Flush(buf));
+    FlexBuf_Clear(buf);
+
+    /* Spans keep whether their start was recorded across toggling. */
+    bool traced_1 = Trace_Begin("Unrecorded");
+    Trace_Enable(true);
+    bool traced_2 = Trace_Begin("Recorded");
+    Trace_End("Unrecorded", traced_1);
+    Trace_Enable(false);
+    Trace_End("Recorded", traced_2);
+
+    ASSERT_FALSE(traced_1);
+    ASSERT(traced_2);
+
+    ASSERT(Trace_Flush(buf));
+    ASSERT(FlexBuf_PushByte(buf, '\0'));
+
+    const char * json = (const char *)FlexBuf_Data(buf);
+    ASSERT_EQ(NULL, strstr(json, "\"Unrecorded\""));
+    ASSERT_NEQ(NULL, strstr(json, "\"Recorded\",\"ph\":\"B\""));
+    ASSERT_NEQ(NULL, strstr(json, "\"Recorded\",\"ph\":\"E\""));
+
+    FlexBuf_Free(buf);
+
+    PASS();
+}
+
+#endif
+
+SUITE(ParserSuite) {
+    RUN_TEST(MatchDenseNumberArms);
+    RUN_TEST(MatchSparseNumberArms);
+    RUN_TEST(MatchExtremeNumberArms);
+    RUN_TEST(MatchStringAndBooleanArms);
+    RUN_TEST(MatchDuplicateArm);
+    RUN_TEST(MemoryLimitFailsCleanly);
+    RUN_TEST(CountTreeNodes);
+    RUN_TEST(AstImgRoundTrip);
+    RUN_TEST(AstImgRejectsEmptyNames);
+    RUN_TEST(MetricsCountTokensAndNodes);
+    RUN_TEST(ParPoolParsesBatches);
+    RUN_TEST(ProjectBuildsDirectory);
+    RUN_TEST(CodeCacheSkipsParsing);
+#if ME_TRACE
+    RUN_TEST(TraceRecordsStages);
+    RUN_TEST(TraceKeepsSpansBalanced);
+#endif
+}
\ No newline at end of file
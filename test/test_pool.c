@@ -0,0 +1,261 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "greatest.h"
+#include "menos.h"
+#include "config.h"
+#include "lexer/lexer.h"
+#include "memory/allocate.h"
+#include "memory/limit.h"
+#include "memory/pool.h"
+#include "memory/stats.h"
+#include "util/flex_buf.h"
+
+TEST PoolKeepsContents(void) {
+    const usize SIZES[] = { 1, 16, 17, 128, 129, 700, 4096, 4097, 20000 };
+    const usize NUM_SIZES = sizeof(SIZES) / sizeof(SIZES[0]);
+    u8 * ptrs[sizeof(SIZES) / sizeof(SIZES[0])];
+
+    MemPool * pool = MemPool_New();
+    ASSERT_NEQ(NULL, pool);
+
+    const MemAllocator * prev = MeMem_Use(MemPool_Allocator(pool));
+
+    for (usize i = 0; i < NUM_SIZES; i++) {
+        ptrs[i] = (u8 *)MeMem_Malloc(SIZES[i]);
+        ASSERT_NEQ(NULL, ptrs[i]);
+        memset(ptrs[i], (int)i, SIZES[i]);
+    }
+
+    /* Grow every block into the next size, crossing classes and the limit
+       of small blocks. */
+    for (usize i = 0; i + 1 < NUM_SIZES; i++) {
+        ptrs[i] = (u8 *)MeMem_Realloc(ptrs[i], SIZES[i + 1]);
+        ASSERT_NEQ(NULL, ptrs[i]);
+
+        for (usize j = 0; j < SIZES[i]; j++) {
+            ASSERT_EQ(i, ptrs[i][j]);
+        }
+    }
+
+    for (usize i = 1; i < NUM_SIZES; i++) {
+        for (usize j = 0; j < SIZES[i]; j++) {
+            ASSERT_EQ(i, ptrs[i][j]);
+        }
+    }
+
+    MeMem_Use(prev);
+
+    /* Blocks return to their pool wherever they are freed. */
+    for (usize i = 0; i < NUM_SIZES; i++) {
+        MeMem_Free(ptrs[i]);
+    }
+
+    MemPool_Free(pool);
+
+    PASS();
+}
+
+TEST PoolReusesFreedBlocks(void) {
+    MemPool * pool = MemPool_New();
+    ASSERT_NEQ(NULL, pool);
+
+    const MemAllocator * prev = MeMem_Use(MemPool_Allocator(pool));
+
+    void * ptr_1 = MeMem_Malloc(40);
+    ASSERT_NEQ(NULL, ptr_1);
+    MeMem_Free(ptr_1);
+
+    void * ptr_2 = MeMem_Malloc(48);
+    ASSERT_EQ(ptr_1, ptr_2);
+    MeMem_Free(ptr_2);
+
+    MeMem_Use(prev);
+
+    MemPool_Free(pool);
+
+    PASS();
+}
+
+TEST LimitFailsPastLimit(void) {
+    MemLimit * lim = MemLimit_New(NULL, 1024);
+    ASSERT_NEQ(NULL, lim);
+
+    const MemAllocator * prev = MeMem_Use(MemLimit_Allocator(lim));
+
+    void * ptr_1 = MeMem_Malloc(512);
+    ASSERT_NEQ(NULL, ptr_1);
+    ASSERT(MemLimit_Used(lim) >= 512);
+
+    ASSERT_EQ(NULL, MeMem_Malloc(512));
+    ASSERT_EQ(NULL, MeMem_Realloc(ptr_1, 1024));
+
+    ptr_1 = MeMem_Realloc(ptr_1, 16);
+    ASSERT_NEQ(NULL, ptr_1);
+
+    void * ptr_2 = MeMem_Malloc(512);
+    ASSERT_NEQ(NULL, ptr_2);
+
+    MeMem_Use(prev);
+
+    MeMem_Free(ptr_1);
+    MeMem_Free(ptr_2);
+    ASSERT_EQ_FMT(0UL, MemLimit_Used(lim), "%zu");
+
+    MemLimit_Free(lim);
+
+    PASS();
+}
+
+static
+_Thread_local MemCache
+test_cache = MEM_CACHE_INIT(48);
+
+TEST CacheRecyclesBlocks(void) {
+    void * ptr_1 = MeMem_CacheAlloc(&test_cache);
+    ASSERT_NEQ(NULL, ptr_1);
+    MeMem_CacheFree(&test_cache, ptr_1);
+
+    void * ptr_2 = MeMem_CacheAlloc(&test_cache);
+    ASSERT_NEQ(NULL, ptr_2);
+
+#if ME_MEM_CACHE_MAX > 0
+    ASSERT_EQ(ptr_1, ptr_2);
+#endif
+
+    /* Blocks of other allocators go back to them at once. */
+    MemLimit * lim = MemLimit_New(NULL, 1024);
+    ASSERT_NEQ(NULL, lim);
+
+    const MemAllocator * prev = MeMem_Use(MemLimit_Allocator(lim));
+
+    void * ptr_3 = MeMem_CacheAlloc(&test_cache);
+    ASSERT_NEQ(NULL, ptr_3);
+    MeMem_CacheFree(&test_cache, ptr_3);
+    ASSERT_EQ_FMT(0UL, MemLimit_Used(lim), "%zu");
+
+    MeMem_Use(prev);
+
+    MemLimit_Free(lim);
+
+    MeMem_CacheFree(&test_cache, ptr_2);
+    MeMem_FlushCaches();
+
+    PASS();
+}
+
+static
+void *
+CacheChurn(
+    void * arg
+) {
+    (void)arg;
+
+    for (usize i = 0; i < 1000; i++) {
+        MeMem_CacheFree(&test_cache, MeMem_CacheAlloc(&test_cache));
+    }
+
+    /* The cached block is freed as the thread exits. */
+    return NULL;
+}
+
+TEST CacheFlushedOnThreadExit(void) {
+    pthread_t thread;
+
+    ASSERT_EQ(0, pthread_create(&thread, NULL, CacheChurn, NULL));
+    ASSERT_EQ(0, pthread_join(thread, NULL));
+
+    PASS();
+}
+
+#if ME_MEM_STATS
+
+TEST StatsTrackLiveAndPeak(void) {
+    MemStats before;
+    MemStats after;
+
+    MeMem_Stats(&before);
+
+    void * ptr = MeMem_MallocTagged(1000, MemTag_ErrMsg);
+    ASSERT_NEQ(NULL, ptr);
+    ASSERT_EQ(MemTag_ErrMsg, MeMem_TagOf(ptr));
+
+    ptr = MeMem_Realloc(ptr, 3000);
+    ASSERT_NEQ(NULL, ptr);
+
+    MeMem_Stats(&after);
+
+    const MemTagStats * b = before.tags + MemTag_ErrMsg;
+    const MemTagStats * a = after.tags + MemTag_ErrMsg;
+
+    ASSERT_EQ_FMT(b->live_bytes + 3000, a->live_bytes, "%zu");
+    ASSERT(a->peak_bytes >= a->live_bytes);
+    ASSERT_EQ(b->num_allocs + 2, a->num_allocs);
+    ASSERT_EQ(b->num_frees + 1, a->num_frees);
+
+    /* 1000 bytes fall in the bucket up to 1024 bytes, 3000 in the one up to
+       4096 bytes. */
+    ASSERT_EQ(b->hist[6] + 1, a->hist[6]);
+    ASSERT_EQ(b->hist[8] + 1, a->hist[8]);
+
+    MeMem_Free(ptr);
+    MeMem_Stats(&after);
+    ASSERT_EQ_FMT(b->live_bytes, a->live_bytes, "%zu");
+
+    PASS();
+}
+
+TEST StatsTagLexerMemory(void) {
+    const char * INPUT_STR = "names = [\"alice\", \"bob\"]\nprint(names)\n";
+    const usize INPUT_LEN = strlen(INPUT_STR);
+
+    MemStats before;
+    MemStats after;
+
+    MeMem_Stats(&before);
+
+    Lexer * lex = Lexer_New();
+    ASSERT_NEQ(NULL, lex);
+
+    LexOut * lo;
+    ASSERT(Lexer_ScanBuf(lex, INPUT_STR, INPUT_LEN, &lo));
+
+    MeMem_Stats(&after);
+
+    ASSERT(after.tags[MemTag_Token].live_bytes >
+        before.tags[MemTag_Token].live_bytes);
+    ASSERT(after.tags[MemTag_Lexer].num_allocs >
+        before.tags[MemTag_Lexer].num_allocs);
+    ASSERT(after.tags[MemTag_ErrMsg].num_allocs >
+        before.tags[MemTag_ErrMsg].num_allocs);
+
+    FlexBuf * buf = FlexBuf_New();
+    ASSERT_NEQ(NULL, buf);
+    ASSERT(MemStats_PushAsStr(&after, buf));
+    ASSERT(FlexBuf_PushByte(buf, '\0'));
+    ASSERT_NEQ(NULL, strstr((const char *)FlexBuf_Data(buf), "token: live"));
+    FlexBuf_Free(buf);
+
+    LexOut_Free(lo);
+    Lexer_Free(lex);
+
+    MeMem_Stats(&after);
+    ASSERT_EQ_FMT(before.tags[MemTag_Token].live_bytes,
+        after.tags[MemTag_Token].live_bytes, "%zu");
+
+    PASS();
+}
+
+#endif
+
+SUITE(PoolSuite) {
+    RUN_TEST(PoolKeepsContents);
+    RUN_TEST(PoolReusesFreedBlocks);
+    RUN_TEST(LimitFailsPastLimit);
+    RUN_TEST(CacheRecyclesBlocks);
+    RUN_TEST(CacheFlushedOnThreadExit);
+#if ME_MEM_STATS
+    RUN_TEST(StatsTrackLiveAndPeak);
+    RUN_TEST(StatsTagLexerMemory);
+#endif
+}
\ No newline at end of file
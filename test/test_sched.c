@@ -0,0 +1,128 @@
+#include <stdatomic.h>
+
+#include "greatest.h"
+#include "menos.h"
+#include "util/sched.h"
+
+typedef struct _Marks {
+    atomic_uchar * marks;
+    atomic_size_t num_calls;
+} Marks;
+
+static
+void
+MarkRange(
+    void * ctx,
+    usize begin,
+    usize end
+) {
+    Marks * m = (Marks *)ctx;
+
+    for (usize i = begin; i < end; i++) {
+        atomic_fetch_add(m->marks + i, 1);
+    }
+
+    atomic_fetch_add(&m->num_calls, 1);
+}
+
+TEST ParallelForCoversRange(void) {
+    const usize NUM = 100000;
+    static atomic_uchar marks[100000];
+
+    Sched * sched = Sched_New(4, false);
+    ASSERT_NEQ(NULL, sched);
+    ASSERT_EQ_FMT(4UL, Sched_NumWorkers(sched), "%zu");
+
+    Marks m;
+    m.marks = marks;
+    atomic_init(&m.num_calls, 0);
+
+    Sched_ParallelFor(sched, 0, NUM, 1000, MarkRange, &m);
+
+    for (usize i = 0; i < NUM; i++) {
+        ASSERT_EQ(1, atomic_load(marks + i));
+    }
+
+    /* Parts are no larger than the grain, nor split below half of it. */
+    ASSERT(atomic_load(&m.num_calls) >= NUM / 1000);
+    ASSERT(atomic_load(&m.num_calls) <= NUM / 500);
+
+    /* An empty range calls nothing. */
+    Sched_ParallelFor(sched, 10, 10, 0, MarkRange, &m);
+    ASSERT(atomic_load(&m.num_calls) <= NUM / 500);
+
+    Sched_Free(sched);
+
+    PASS();
+}
+
+typedef struct _Fib {
+    Sched * sched;
+    usize n;
+    usize res;
+} Fib;
+
+static
+void
+FibTask(
+    void * arg
+) {
+    Fib * fib = (Fib *)arg;
+
+    if (fib->n < 12) {
+        usize a = 0;
+        usize b = 1;
+
+        for (usize i = 0; i < fib->n; i++) {
+            usize c = a + b;
+            a = b;
+            b = c;
+        }
+
+        fib->res = a;
+        return;
+    }
+
+    Fib lhs = { fib->sched, fib->n - 1, 0 };
+    Fib rhs = { fib->sched, fib->n - 2, 0 };
+    SchedGroup group = SCHED_GROUP_INIT;
+
+    /* Nested fork and join, joining runs other tasks meanwhile. */
+    Sched_Spawn(fib->sched, &group, FibTask, &lhs);
+    FibTask(&rhs);
+    Sched_Join(fib->sched, &group);
+
+    fib->res = lhs.res + rhs.res;
+}
+
+TEST ForkJoinNests(void) {
+    Sched * sched = Sched_New(3, true);
+    ASSERT_NEQ(NULL, sched);
+
+    Fib fibs[4];
+    SchedGroup group = SCHED_GROUP_INIT;
+
+    for (usize i = 0; i < 4; i++) {
+        fibs[i].sched = sched;
+        fibs[i].n = 20 + i;
+        fibs[i].res = 0;
+
+        Sched_Spawn(sched, &group, FibTask, fibs + i);
+    }
+
+    Sched_Join(sched, &group);
+
+    ASSERT_EQ_FMT(6765UL, fibs[0].res, "%zu");
+    ASSERT_EQ_FMT(10946UL, fibs[1].res, "%zu");
+    ASSERT_EQ_FMT(17711UL, fibs[2].res, "%zu");
+    ASSERT_EQ_FMT(28657UL, fibs[3].res, "%zu");
+
+    Sched_Free(sched);
+
+    PASS();
+}
+
+SUITE(SchedSuite) {
+    RUN_TEST(ParallelForCoversRange);
+    RUN_TEST(ForkJoinNests);
+}
\ No newline at end of file